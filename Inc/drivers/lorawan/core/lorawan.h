@@ -58,6 +58,25 @@ typedef enum lorawan_driver_sendState_e {
 
 #define	LORAWAN_DRIVER_INVALID_RSSI	0xFFFF
 
+/**
+ * Downlink buffer of the reception pool
+ */
+typedef struct {
+	uint8_t		port;
+	uint8_t 	size;
+	uint8_t 	data[ITSDK_LORAWAN_MAX_DWNLNKSZ];
+} lorawan_driver_downlink_t;
+
+/**
+ * Link quality sample, one per uplink with a known outcome
+ */
+#define LORAWAN_DRIVER_LINK_DRS		8						// History kept for DR_0 to DR_7
+typedef struct {
+	int16_t		rssi;										// Downlink Rssi (LORAWAN_DRIVER_INVALID_RSSI when not acked)
+	int8_t		snr;										// Downlink Snr
+	uint8_t		acked;										// Ack or downlink received for this uplink
+} lorawan_driver_linkSample_t;
+
 /**
  * This structure maintains the abstraction layer internal state
  */
@@ -75,6 +94,7 @@ typedef struct lorawan_driver_state_s {
     uint8_t								lastRetries;		// Number of retry on last acked transmision
 
 	uint8_t 							txDatarate;			// default transmission rate
+	uint16_t							region;				// __LORAWAN_REGION_xxx in use
     uint8_t   							JoinType;			// OTAA / ABP
     union {
 		   struct s_otaa1 {
@@ -146,6 +166,16 @@ itsdk_lorawan_send_t lorawan_driver_LORA_Send(
 
 
 lorawan_driver_sendState lorawan_driver_LORA_getSendState();
+uint8_t lorawan_driver_LORA_GetMaxPayloadSize(uint8_t dataRate);
+itsdk_lorawan_return_t lorawan_driver_LORA_GetTxPlan(uint8_t dataRate, uint8_t size, itsdk_lorawan_txplan_t * plan);
+bool lorawan_driver_downlink_hold(uint8_t * data);
+void lorawan_driver_downlink_release(uint8_t * data);
+void lorawan_driver_downlink_getStats(itsdk_lorawan_downlinkStats_t * stats);
+#if ITSDK_LORAWAN_LINK_HISTORY > 0
+itsdk_lorawan_return_t lorawan_driver_LORA_GetLinkStats(uint8_t dataRate, itsdk_lorawan_linkStats_t * stats);
+void lorawan_driver_LORA_ClearLinkStats();
+#endif
+itsdk_lorawan_return_t lorawan_driver_LORA_DeviceTimeReq();
 lorawan_driver_joinState lorawan_driver_LORA_getJoinState();
 void lorawan_driver_LORA_ChangeDefaultRate(uint8_t newRate);
 itsdk_lorawan_rssisnr_t lorawan_driver_LORA_GetLastRssiSnr(int16_t *rssi, uint8_t *snr);
@@ -153,6 +183,7 @@ bool lorawan_driver_LORA_SetTxPower(itsdk_lorawan_txpower txPwr );
 itsdk_lorawan_txpower lorawan_driver_LORA_GetTxPower();
 uint16_t lorawan_driver_LORA_GetDownlinkFrameCounter();
 uint16_t lorawan_driver_LORA_GetUplinkFrameCounter();
+uint32_t lorawan_driver_LORA_GetNextUplinkFrameCounter32();
 itsdk_lorawan_channel_t lorawan_driver_LORA_RemoveChannel(uint8_t channelId);
 itsdk_lorawan_channel_t lorawan_driver_LORA_AddChannel(
 		uint8_t		channelId,
@@ -174,8 +205,10 @@ void lorawan_driver_onSendAckSuccess();
 void lorawan_driver_onSendSuccess();
 void lorawan_driver_onJoinSuccess();
 void lorawan_driver_onJoinFailed();
+void lorawan_driver_onNewSession();
 void lorawan_driver_onDataReception(uint8_t port, uint8_t * data, uint8_t size);
 void lorawan_driver_onPendingDownlink();
+void lorawan_driver_onDeviceTime(bool success, uint32_t epochS, uint16_t ms);
 
 
 // ===========================================================================
@@ -2417,6 +2417,22 @@ void LoRaMacProcess( void );
  */
 LoRaMacStatus_t LoRaMacQueryTxPossible( uint8_t size, LoRaMacTxInfo_t* txInfo );
 
+/*!
+ * \brief   Queries the LoRaMAC for the time to wait before a frame can be sent
+ *          on the given datarate. The band time-off and the aggregated time-off
+ *          are computed as the next transmission would do.
+ *
+ * \param   [IN] datarate - Datarate of the next transmission
+ *
+ * \param   [OUT] delay - Time to wait in ms, 0 when the transmission is possible now
+ *
+ * \retval  LoRaMacStatus_t Status of the operation. Possible returns are:
+ *          \ref LORAMAC_STATUS_OK,
+ *          \ref LORAMAC_STATUS_PARAMETER_INVALID,
+ *          \ref LORAMAC_STATUS_NO_CHANNEL_FOUND.
+ */
+LoRaMacStatus_t LoRaMacQueryNextTxDelay( int8_t datarate, TimerTime_t* delay );
+
 /*!
  * \brief   LoRaMAC channel add service
  *
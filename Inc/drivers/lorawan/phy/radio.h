@@ -352,6 +352,15 @@ struct Radio_s
      * \brief Process radio irq
      */
     void ( *IrqProcess )( void );
+    /*!
+     * \brief Gets the time of the radio irq being processed. Optional (NULL)
+     *
+     * \remark When the irq are processed from the main loop the MAC uses this
+     *         time to compensate the rx windows and the timeouts
+     *
+     * \retval time Irq time in ms, TimerGetCurrentTime reference
+     */
+    uint32_t ( *GetIrqTime )( void );
     /*
      * The next functions are available only on SX126x radios.
      */
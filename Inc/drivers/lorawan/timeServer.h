@@ -50,13 +50,14 @@ Maintainer: Miguel Luis and Gregory Cristian
  */
 typedef struct TimerEvent_s
 {
-    uint32_t Timestamp;                  //! Expiring timer value in ticks from TimerContext
+    uint32_t Timestamp;                  //! Expiration time in ms (TimerGetCurrentTime base)
     uint32_t ReloadValue;                //! Reload Value when Timer is restarted
     bool IsStarted;                      //! Is the timer currently running
     bool IsNext2Expire;                  //! Is the next timer to expire
     void ( *Callback )( void* context ); //! Timer IRQ callback function
     void *Context;                       //! User defined data object pointer to pass back
     struct TimerEvent_s *Next;           //! Pointer to the next Timer object.
+    struct TimerEvent_s *Prev;           //! Pointer to the previous Timer object.
 }TimerEvent_t;
 
 
@@ -73,10 +73,34 @@ typedef struct s2lp_config_s {
 	uint8_t		payload_encryption; // encrypt the payload
 	uint8_t		lastReadRssi;		// Last RSSI read from S2LP (can be an invalid message) rssi = value -146
 	uint8_t		lastReceptionRssi;  // Last RSSI corresponding to a valid downlink rssi = value - 146
+	uint8_t		fromCache;			// 1 when loaded from the secure store cache, the ST retriever is not initialized
 
 }  s2lp_config_t;
 
 
+// Configuration cache stored in the secure store (3 blocks) with ITSDK_S2LP_CNF_CACHE
+// Change the version when the structure or the eeprom parsing is modified.
+#define S2LP_CNF_CACHE_VERSION		0x5301
+
+typedef struct s2lp_cnf_cache_s {
+	// ITSDK_SS_S2LP_CNF
+	uint16_t	version;			// S2LP_CNF_CACHE_VERSION
+	uint8_t		tcxo;
+	uint8_t		range;
+	uint8_t		band;
+	uint8_t		rcz;
+	uint32_t	xtalFreq;
+	int32_t		offset;
+	uint16_t	checksum;			// sum of the structure bytes, checksum excluded
+	// ITSDK_SS_S2LP_IDPAC
+	uint32_t	id;
+	uint8_t		pac[8];
+	int32_t		rssiOffset;
+	// ITSDK_SS_S2LP_KEY
+	uint8_t		key[16];			// ciffered like in s2lp_config_t
+}  __attribute__ ((__packed__)) s2lp_cnf_cache_t;
+
+
 #define S2LP_RANGE_EXT_NONE 		0
 #define S2LP_RANGE_SKYWORKS_868		1
 
@@ -95,4 +119,6 @@ void s2lp_printConfig(
 		s2lp_config_t * s2lpConf
 );
 
+void s2lp_invalidateConfigCache();
+
 #endif /* IT_SDK_DRIVERS_S2LP_H_ */
@@ -31,7 +31,8 @@
 #include <it_sdk/config.h>
 #include <it_sdk/wrappers.h>
 
-#define S2LP_SPI_DELAY		2	// 2 ms delay between chip select & SPI access
+#define S2LP_SPI_CS_SETUP_US	2	// 2 us delay between chip select & SPI access
+#define S2LP_SPI_BURST_SZ		32	// Max bytes per SPI transfer for the register access (header included)
 
 typedef enum {
 	S2LP_READ_REGISTER	= 0x00,
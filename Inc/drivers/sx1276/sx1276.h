@@ -285,6 +285,12 @@ void SX1276BoardInit( LoRaBoardCallback_t *callbacks );
  * \brief Resets the SX1276
  */
 void SX1276Reset( void );
+
+/*!
+ * \brief Clears the registers shadow, when the chip configuration may have changed
+ *        without the driver (reset, power loss, DMA register access)
+ */
+void SX1276ShadowInvalidate( void );
 /*!
  * \brief Initializes the radio
  *
@@ -567,6 +573,24 @@ void SX1276SetPublicNetwork( bool enable );
  */
 uint32_t SX1276GetWakeupTime( void );
 
+/*!
+ * \brief Process the DIO interrupts posted by the radio IRQ handlers.
+ *
+ * \remark When ITSDK_SX1276_DEFERRED_IRQ is enabled the DIO interrupt handlers
+ *         only record the event, the registers and FIFO access and the radio
+ *         callbacks are executed by this function, called from the main loop.
+ *         Only in LoRa mode, in FSK the DIO are processed in the ISR.
+ */
+void SX1276IrqProcess( void );
+
+/*!
+ * \brief Gets the time of the DIO edge being processed by SX1276IrqProcess,
+ *        the current time when called outside of it.
+ *
+ * \retval time DIO edge time in ms
+ */
+uint32_t SX1276GetIrqTime( void );
+
 void SX1276SetXO( uint8_t state );
 
 uint32_t SX1276GetWakeTime( void );
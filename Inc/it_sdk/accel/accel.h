@@ -152,6 +152,12 @@ typedef enum {
 
 itsdk_accel_ret_e accel_initPowerDown();
 void accel_process_loop(void); // Loop process automatically included in the itsdk_loop
+void accel_getQueueStats(		// Trigger queue and data buffer max usage / dropped elements
+		uint16_t * trigHighWater,
+		uint32_t * trigOverflow,
+		uint16_t * dataHighWater,
+		uint32_t * dataOverflow
+);
 
 // ---
 // Event detection
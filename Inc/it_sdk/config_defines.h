@@ -264,6 +264,19 @@
 #define __SFX_NVM_M95640		2					// External EEPROM type M95640
 #define __SFX_NVM_CONFIG_STATIC	3					// Configuration stored in the #define
 
+/**
+ * NVM source for LoRaWan MAC contexts
+ */
+#define __LORAWAN_NVM_NONE			0				// Contexts are not saved, join after each reset
+#define __LORAWAN_NVM_LOCALEPROM	1				// MCU internal EEPROM
+
+/**
+ * Storage for the LoRaWan fragmented data blocks
+ */
+#define __LORAWAN_FRAG_NONE			0				// Fragmentation package disabled
+#define __LORAWAN_FRAG_LOCALEPROM	1				// MCU internal EEPROM, after the MAC contexts
+#define __LORAWAN_FRAG_M95640		2				// External EEPROM type M95640
+
 /**
  * Drivers S2LP Config
  */
@@ -278,6 +291,7 @@
 #define	__PAYLOAD_ENCRYPT_SIGFOX 1					// Sigfox payload encryption
 #define	__PAYLOAD_ENCRYPT_AESCTR 2					// Custom AES-CTR encryption
 #define	__PAYLOAD_ENCRYPT_SPECK  4					// Speck encryption
+#define	__PAYLOAD_ENCRYPT_SPECKCTR 8				// Speck encryption in CTR mode (any payload length)
 
 
 /**
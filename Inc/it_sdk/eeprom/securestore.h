@@ -28,6 +28,7 @@
 #ifndef IT_SDK_EEPROM_SECURESTORE_H_
 #define IT_SDK_EEPROM_SECURESTORE_H_
 
+#include <stdbool.h>
 #include <it_sdk/config.h>
 
 #if ITSDK_WITH_SECURESTORE == __ENABLE
@@ -72,15 +73,29 @@ typedef enum {
 	ITSDK_SS_USER4,
 	ITSDK_SS_USER5,
 	ITSDK_SS_USER6,
-	ITSDK_SS_USER7
+	ITSDK_SS_USER7,
+	ITSDK_SS_S2LP_CNF,
+	ITSDK_SS_S2LP_IDPAC,
+	ITSDK_SS_S2LP_KEY
 } itsdk_secStoreBlocks_e;
 
 #define ITSDK_SECSTORE_BLOCKSZ			16
+
+// S2LP configuration cache, the blocks are after the user blocks to keep the
+// other blocks offset when enabled.
+#if defined(ITSDK_WITH_SIGFOX_LIB) && ITSDK_WITH_SIGFOX_LIB == __ENABLE && ITSDK_SIGFOX_LIB == __SIGFOX_S2LP \
+	&& defined(ITSDK_S2LP_CNF_CACHE) && ITSDK_S2LP_CNF_CACHE == __ENABLE
+  #define ITSDK_SECSTORE_S2LP_CACHE		__ENABLE
+#else
+  #define ITSDK_SECSTORE_S2LP_CACHE		__DISABLE
+#endif
 #define ITSDK_SECSTORE_EEPROM_OFFSET	0
 #define ITSDK_SECSTORE_EEPROM_MAGIC		0xC
 
 #define ITSDK_SECSTORE_CRYPT_SHARED_ID	0
 #define ITSDK_SECSTORE_CRYPT_NONCE_ID	4
+#define ITSDK_SECSTORE_CRYPT_SFXEPOCH_ID	5			// 8b SPECK-CTR Sigfox epoch
+#define ITSDK_SECSTORE_CRYPT_LOREPOCH_ID	6			// 16b SPECK-CTR LoRaWan epoch
 #define ITSDK_SECSTORE_CRYPT_SPECK_ID	8
 
 #define ITSDK_SECSTORE_OTAA_DEV_ID		0
@@ -99,6 +114,24 @@ typedef struct __itsdk_secureStoreHead_s {
 } __attribute__((packed)) itsdk_secStoreHead_t;
 
 
+// Rekey journal, stored in the last 32B of the EEPROM (ITSDK_SECSTORE_REKEY_JOURNAL). The first
+// word is always written in one EEPROM word operation so the state / current / phase are consistent
+#define ITSDK_SECSTORE_JOURNAL_MAGIC	0x5A3C		// A rekey job is running
+#define ITSDK_SECSTORE_JOURNAL_PREPARE	0x01		// The current block has not been modified
+#define ITSDK_SECSTORE_JOURNAL_WRITE	0x02		// The current block is under rewrite, backup is valid
+#define ITSDK_SECSTORE_JOURNAL_HEADER	0x03		// All blocks migrated, the header key is under rewrite
+
+typedef struct __itsdk_secureStoreJournal_s {
+
+	uint16_t	magic;						// ITSDK_SECSTORE_JOURNAL_MAGIC when a rekey job is running
+	uint8_t		current;					// block under migration, the lower blocks are using the new key
+	uint8_t		phase;						// migration phase of the current block
+	uint8_t		newKey[12];					// new dynamic key (protected with ITSDK_PROTECT_KEY)
+	uint8_t		backup[ITSDK_SECSTORE_BLOCKSZ];	// encrypted content of the current block before migration
+
+} __attribute__((packed)) itsdk_secStoreJournal_t;
+
+
 
 // blocks
 typedef struct {
@@ -134,6 +167,9 @@ typedef struct {
 	#if ITSDK_SECSTORE_USRBLOCK > 0
 		uint8_t user[ITSDK_SECSTORE_USRBLOCK][ITSDK_SECSTORE_BLOCKSZ];	// User defined blocks
 	#endif
+	#if ITSDK_SECSTORE_S2LP_CACHE == __ENABLE
+		uint8_t	s2lpCache[3][ITSDK_SECSTORE_BLOCKSZ];						// S2LP config / ID & PAC / Key (s2lp_cnf_cache_t)
+	#endif
 } itsdk_secStoreBlocks_t;
 
 
@@ -145,7 +181,12 @@ itsdk_secStoreReturn_e itsdk_secstore_init();
 itsdk_secStoreReturn_e itsdk_secstore_isInit();
 itsdk_secStoreReturn_e itsdk_secstore_writeBlock(itsdk_secStoreBlocks_e blockType, uint8_t * buffer);
 itsdk_secStoreReturn_e itsdk_secstore_readBlock(itsdk_secStoreBlocks_e blockType, uint8_t * buffer);
+itsdk_secStoreReturn_e itsdk_secstore_cipher(uint8_t * data, uint16_t len, uint32_t iv);
 itsdk_secStoreReturn_e itsdk_secStore_RegisterConsole();
+itsdk_secStoreReturn_e itsdk_secstore_rekey(uint8_t * newKey);
+itsdk_secStoreReturn_e itsdk_secstore_recover();
+bool itsdk_secstore_loop();
+bool itsdk_secstore_isRekeyRunning();
 // ----------------------------
 // Function to Override
 void itsdk_secstore_generateMasterKey(uint8_t * dynamicKey,uint8_t * masterKey);
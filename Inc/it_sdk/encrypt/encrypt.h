@@ -29,12 +29,14 @@
 #define IT_SDK_ENCRYPT_H_
 
 #include <it_sdk/config.h>
+#include <it_sdk/encrypt/speck/speck.h>
 
 typedef enum {												// Encryption mode are cumulative
 	PAYLOAD_ENCRYPT_NONE = __PAYLOAD_ENCRYPT_NONE,			// Clear text payload
 	PAYLOAD_ENCRYPT_SIGFOX = __PAYLOAD_ENCRYPT_SIGFOX,		// Sigfox native encryption
 	PAYLOAD_ENCRYPT_AESCTR = __PAYLOAD_ENCRYPT_AESCTR,		// Software AES-CTR (like sigfox) encryption
-	PAYLOAD_ENCRYPT_SPECK = __PAYLOAD_ENCRYPT_SPECK			// SPECK32 encryption
+	PAYLOAD_ENCRYPT_SPECK = __PAYLOAD_ENCRYPT_SPECK,		// SPECK32 encryption
+	PAYLOAD_ENCRYPT_SPECKCTR = __PAYLOAD_ENCRYPT_SPECKCTR	// SPECK32-CTR encryption (any length)
 } itdsk_payload_encrypt_t;
 
 typedef enum {
@@ -56,6 +58,10 @@ itsdk_encrypt_return_t itsdk_encrypt_aes_getNonce(uint8_t * nonce);
 itsdk_encrypt_return_t itsdk_encrypt_aes_getSharedKey(uint32_t * sharedKey);
 itsdk_encrypt_return_t itsdk_encrypt_aes_getMasterKey(uint8_t * masterKey);
 itsdk_encrypt_return_t itsdk_encrypt_speck_getMasterKey(uint64_t * masterKey);
+itsdk_encrypt_return_t itsdk_encrypt_speck_getEpoch(uint8_t domain, uint16_t * epoch);
+itsdk_encrypt_return_t itsdk_encrypt_speck_setEpoch(uint8_t domain, uint16_t epoch);
+void itsdk_encrypt_keyChanged();
+uint8_t itsdk_encrypt_getKeyGeneration();
 
 // uint64_t ciffer/unciffer function
 #define itsdk_encrypt_cifferKey64(v) ( \
@@ -83,6 +89,54 @@ void itsdk_speck_encrypt(
 		uint64_t  masterKey				// 64B key used for encryption (hidden with ITSDK_PROTECT_KEY)
 );
 
+// SPECK32-CTR session, the master key is expanded once when the session
+// is opened. A frame key is derived from the master key for each domain,
+// epoch and 64M frames, the counter block is made of the 26 low bits of
+// the frame counter and a 6b block index (256B max per frame).
+typedef struct {
+	speck32_ctx_t	master;				// Expanded master key, derives the frame keys
+	speck32_ctx_t	ctx;				// Expanded frame key for keyTag
+	uint32_t		keyTag;				// Domain / epoch / frame counter high bits of ctx
+	uint32_t		iv;					// Frame counter low 26b, shifted for the block index
+	uint8_t			counter;			// Block index in the frame
+	uint8_t			domain;				// ITSDK_SPECK_CTR_DOMAIN_xx
+	uint8_t			keyGen;				// Key generation when opened, see itsdk_encrypt_keyChanged()
+	uint8_t			keystream[4];		// Current keystream block
+	uint8_t			ksUsed;				// Number of keystream bytes already consumed
+	uint8_t			ready;				// Session has been initialized
+} itsdk_speck_session_t;
+
+#define ITSDK_SPECK_CTR_DOMAIN_LORAWAN	0	// Separates the keystreams of the stacks sharing the key
+#define ITSDK_SPECK_CTR_DOMAIN_SIGFOX	1
+#define ITSDK_SPECK_CTR_NOKEY			0xFFFFFFFF
+
+void itsdk_speck_ctr_open(
+		itsdk_speck_session_t * session,
+		uint64_t  masterKey,			// 64B key used for encryption (hidden with ITSDK_PROTECT_KEY)
+		uint8_t   domain				// ITSDK_SPECK_CTR_DOMAIN_xx
+);
+
+bool itsdk_speck_ctr_isOpen(			// False when closed or when the key has changed since opened
+		itsdk_speck_session_t * session
+);
+
+void itsdk_speck_ctr_setIv(
+		itsdk_speck_session_t * session,
+		uint16_t  epoch,				// Incremented each time the frame counter restarts
+		uint32_t  frameCounter			// 32b per frame value (sequenceId / frame counter)
+);
+
+void itsdk_speck_ctr_encrypt(
+		itsdk_speck_session_t * session,
+		uint8_t	* clearData,			// Data to be encrypted
+		uint8_t * encryptedData,		// Can be the same as clearData
+		uint16_t  dataLen				// Any size, can be called multiple time for a stream
+);
+
+void itsdk_speck_ctr_close(
+		itsdk_speck_session_t * session
+);
+
 
 void itsdk_aes_ecb_encrypt_128B(
 		uint8_t	* clearData,			// Data to be encrypted
@@ -28,7 +28,16 @@
 #ifndef ITSDK_ENCRYPT_SPECK_H
 #define ITSDK_ENCRYPT_SPECK_H
 
+#include <stdint.h>
 
+#define SPECK32_ROUNDS	22
+
+typedef struct {
+	uint16_t	subkeys[SPECK32_ROUNDS];	// Expanded round keys
+} speck32_ctx_t;
+
+void speck32_expandKey(speck32_ctx_t * ctx, uint8_t * key);
+void speck32_encryptBlock(speck32_ctx_t * ctx, uint16_t * p1, uint16_t * p2);
 void speck32_encrypt(uint8_t * key, uint8_t * data, uint8_t len);
 
 #endif //ITSDK_ENCRYPT_SPECK_H
@@ -80,6 +80,7 @@ int16_t itdt_convertDecChar4Int(char * v);
 uint16_t itdt_convertDecChar3UInt(char * v);
 int32_t itdt_convertDecCharNInt(char * v, int sz);
 void itdt_convertHexStr2IntTab(char * hexstr,uint8_t * tab, int len);
+bool itdt_convertHexStr2IntTabChk(char * hexstr,uint8_t * tab, int len, itsdk_bool_e upper);
 void itdt_macToString(char * str, uint8_t * mac);
 uint32_t itdt_align_32b(uint32_t v);
 uint8_t itdt_count_bits_1(uint32_t v);
@@ -106,6 +106,7 @@ typedef struct {
 #define ITSDK_ERROR_STIMER_LIST_FULL		0x00000012 | (ITSDK_ERROR_LEVEL_ERROR | ITSDK_ERROR_TYPE_SDK | ITSDK_ERROR_WOUT_VALUE)  // The timer list is full, timer creation rejected
 #define ITSDK_ERROR_ENCRYP_INVALID_DATALEN	0x00000020 | (ITSDK_ERROR_LEVEL_FATAL | ITSDK_ERROR_TYPE_SDK | ITSDK_ERROR_WITH_VALUE)	// The datalen is invalid should be 32B blocs
 #define ITSDK_ERROR_ENCRYP_DATA_TOOLARGE    0x00000021 | (ITSDK_ERROR_LEVEL_FATAL | ITSDK_ERROR_TYPE_SDK | ITSDK_ERROR_WITH_VALUE)	// The datalen is too large
+#define ITSDK_ERROR_ENCRYP_NOSESSION        0x00000022 | (ITSDK_ERROR_LEVEL_ERROR | ITSDK_ERROR_TYPE_SDK | ITSDK_ERROR_WOUT_VALUE)	// The encryption session has not been opened
 #define	ITSDK_ERROR_EEPROM_OUTOFBOUNDS		0x00000030 | (ITSDK_ERROR_LEVEL_FATAL | ITSDK_ERROR_TYPE_SDK | ITSDK_ERROR_WITH_VALUE)	// Try to Read/Write out of eprom area
 #define	ITSDK_ERROR_EEPROM_NOTALIGNED		0x00000031 | (ITSDK_ERROR_LEVEL_FATAL | ITSDK_ERROR_TYPE_SDK | ITSDK_ERROR_WITH_VALUE)	// Try to Read/Write out of eprom area
 #define	ITSDK_ERROR_WDG_OUTOFBOUNDS			0x00000040 | (ITSDK_ERROR_LEVEL_FATAL | ITSDK_ERROR_TYPE_SDK | ITSDK_ERROR_WITH_VALUE)	// Watchdog duration setting os outof bounds
@@ -130,8 +131,13 @@ typedef struct {
 #define ITSDK_ERROR_LORAWAN_TIME_NOCALLBACK 0x00000104 | (ITSDK_ERROR_LEVEL_FATAL | ITSDK_ERROR_TYPE_SDK | ITSDK_ERROR_WOUT_VALUE)	// TimerServer Callback function is null
 #define ITSDK_ERROR_LORAWAN_TIME_INITFLD    0x00000105 | (ITSDK_ERROR_LEVEL_FATAL | ITSDK_ERROR_TYPE_SDK | ITSDK_ERROR_WITH_VALUE)	// TimerServer Timer init failed
 #define ITSDK_ERROR_LORAWAN_SS_INVALID      0x00000106 | (ITSDK_ERROR_LEVEL_ERROR | ITSDK_ERROR_TYPE_SDK | ITSDK_ERROR_WITH_VALUE)	// Impossible to access SecureStore Data
+#define ITSDK_ERROR_LORAWAN_NVM_TOOSMALL    0x00000107 | (ITSDK_ERROR_LEVEL_WARN  | ITSDK_ERROR_TYPE_SDK | ITSDK_ERROR_WITH_VALUE)	// ITSDK_LORAWAN_NVM_SIZE too small for the MAC contexts, value is the needed size
+#define ITSDK_ERROR_LORAWAN_DWNLNK_DROPPED  0x00000108 | (ITSDK_ERROR_LEVEL_WARN  | ITSDK_ERROR_TYPE_SDK | ITSDK_ERROR_WITH_VALUE)	// Downlink lost, all the buffers are hold, value is the drop count
+#define ITSDK_ERROR_LORAWAN_FRAG_TOOMANYLOST 0x00000109 | (ITSDK_ERROR_LEVEL_WARN  | ITSDK_ERROR_TYPE_SDK | ITSDK_ERROR_WITH_VALUE)	// Fragmented data block can't be recovered, value is the lost fragments
+#define ITSDK_ERROR_LORAWAN_FRAG_STORAGE    0x0000010A | (ITSDK_ERROR_LEVEL_WARN  | ITSDK_ERROR_TYPE_SDK | ITSDK_ERROR_WITH_VALUE)	// Fragment storage access failed, value is the fragment index
 
 #define ITSDK_ERROR_SIGFOX_SS_INVALID       0x00000120 | (ITSDK_ERROR_LEVEL_ERROR | ITSDK_ERROR_TYPE_SDK | ITSDK_ERROR_WITH_VALUE)	// Impossible to access SecureStore Data
+#define ITSDK_ERROR_SIGFOX_MEM_OVERFLOW     0x00000121 | (ITSDK_ERROR_LEVEL_ERROR | ITSDK_ERROR_TYPE_SDK | ITSDK_ERROR_WITH_VALUE)	// ITSDK_SIGFOX_MEM_SIZE too small for the sigfox lib, value is the needed size
 
 
 #define ITSDK_ERROR_SIGFOX_RCZ_NOTSUPPORTED 0x00000200 | (ITSDK_ERROR_LEVEL_FATAL | ITSDK_ERROR_TYPE_SDK | ITSDK_ERROR_WITH_VALUE)	// This RCZ is not supported
@@ -0,0 +1,92 @@
+/* ==========================================================
+ * fragmentation.h - LoRaWan fragmented data block transport
+ * Project : Disk91 SDK
+ * ----------------------------------------------------------
+ * Created on: 18 oct. 2020
+ *     Author: Paul Pinault aka Disk91
+ * ----------------------------------------------------------
+ * Copyright (C) 2020 Disk91
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU LESSER General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ * ----------------------------------------------------------
+ * Fragmented data block transport, compatible with the LoRaWAN
+ * fragmentation package (TS004 v1.0.0): the network server sends
+ * a data block as M uncoded fragments followed by coded fragments
+ * (XOR of M/2 uncoded ones) allowing to recover the lost fragments
+ * without retransmission.
+ * The data block is reassembled into the EEPROM or into the M95640.
+ * ==========================================================
+ */
+
+#ifndef IT_SDK_LORAWAN_FRAGMENTATION_H_
+#define IT_SDK_LORAWAN_FRAGMENTATION_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <it_sdk/config.h>
+
+#if ITSDK_WITH_LORAWAN_LIB == __ENABLE && ITSDK_LORAWAN_FRAG_STORAGE != __LORAWAN_FRAG_NONE
+
+#define ITSDK_LORAWAN_FRAG_PACKAGE_ID		3				// Package identifier of the fragmentation package
+#define ITSDK_LORAWAN_FRAG_PACKAGE_VERSION	1
+
+// Package commands
+#define ITSDK_LORAWAN_FRAG_PKG_VERSION		0x00
+#define ITSDK_LORAWAN_FRAG_SESSION_STATUS	0x01
+#define ITSDK_LORAWAN_FRAG_SESSION_SETUP	0x02
+#define ITSDK_LORAWAN_FRAG_SESSION_DELETE	0x03
+#define ITSDK_LORAWAN_FRAG_DATA_FRAGMENT	0x08
+
+typedef enum {
+	LORAWAN_FRAG_NONE = 0,					// No session
+	LORAWAN_FRAG_RUNNING,					// Receiving the fragments
+	LORAWAN_FRAG_COMPLETED,					// Data block reassembled
+	LORAWAN_FRAG_TOOMANYLOST,				// More lost fragments than the decoder can recover
+	LORAWAN_FRAG_STORAGE_ERROR				// The storage read or write failed
+} itsdk_lorawan_frag_state_e;
+
+typedef struct {
+	itsdk_lorawan_frag_state_e	state;
+	uint16_t	nbFrag;						// Number of uncoded fragments
+	uint8_t		fragSize;					// Size of a fragment
+	uint32_t	size;						// Data block size (without padding)
+	uint32_t	descriptor;					// Application descriptor given by the server
+	uint16_t	received;					// Fragments received, uncoded and coded
+	uint16_t	lost;						// Uncoded fragments lost when the coded fragments started
+	uint16_t	missing;					// Fragments still needed to complete the block
+} itsdk_lorawan_frag_status_t;
+
+// ===============================================================
+// PUBLIC API
+// ===============================================================
+
+void itsdk_lorawan_frag_setup();										// Init, called by itsdk_lorawan_setup()
+void itsdk_lorawan_frag_onDownlink(uint8_t * data, uint8_t size);		// Process a downlink received on ITSDK_LORAWAN_FRAG_PORT
+void itsdk_lorawan_frag_getStatus(itsdk_lorawan_frag_status_t * status);
+bool itsdk_lorawan_frag_read(uint32_t offset, uint8_t * data, uint16_t size);	// Read the reassembled data block
+
+// Decoder, used by the package, can be used directly
+bool itsdk_lorawan_frag_init(uint16_t nbFrag, uint8_t fragSize, uint8_t padding, uint32_t descriptor);
+itsdk_lorawan_frag_state_e itsdk_lorawan_frag_process(uint16_t n, uint8_t * data);	// n is the fragment number starting at 1
+
+// ===============================================================
+// CAN BE OVERRIDDED
+// ===============================================================
+
+void itsdk_lorawan_frag_onComplete(uint32_t descriptor, uint32_t size);	// Data block ready to be read
+bool itsdk_lorawan_frag_storageWrite(uint32_t offset, uint8_t * data, uint16_t size);
+bool itsdk_lorawan_frag_storageRead(uint32_t offset, uint8_t * data, uint16_t size);
+
+#endif
+#endif // IT_SDK_LORAWAN_FRAGMENTATION_H_
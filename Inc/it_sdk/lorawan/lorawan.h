@@ -139,6 +139,33 @@ typedef struct {
 	} channels[];
 } itsdk_lorawan_channelInit_t;
 
+typedef struct {
+	uint8_t		dataRate;						// __LORAWAN_DR_x
+	uint8_t		maxSize;						// Max application payload at this datarate
+	uint32_t	delayMs;						// Time to wait before the transmission is allowed (duty cycle)
+	uint32_t	toaMs;							// Time on air of the frame
+	uint32_t	chargeUC;						// Estimated radio charge for TX and RX windows in uC (mA.ms)
+} itsdk_lorawan_txplan_t;
+
+typedef struct {
+	uint32_t	received;						// Downlinks received from the MAC
+	uint32_t	dropped;						// Downlinks lost because all the buffers were hold
+	uint32_t	truncated;						// Downlinks larger than ITSDK_LORAWAN_MAX_DWNLNKSZ
+	uint8_t		highWater;						// Max number of buffers used at the same time
+} itsdk_lorawan_downlinkStats_t;
+
+#define ITSDK_LORAWAN_LINK_NOMARGIN		-128				// Margin not available (no ack received or not a LoRa datarate)
+typedef struct {
+	uint8_t		dataRate;						// __LORAWAN_DR_x
+	uint8_t		samples;						// Uplinks with a known outcome in the history
+	uint8_t		acked;							// Uplinks acked or followed by a downlink
+	int16_t		rssiAvg;						// Average downlink Rssi on the acked uplinks (dBm)
+	int8_t		snrAvg;							// Average downlink Snr on the acked uplinks (dB)
+	int8_t		snrMin;							// Worst downlink Snr on the acked uplinks (dB)
+	int8_t		snrFloor;						// Demodulation floor of the datarate (dB)
+	int8_t		margin;							// snrAvg - snrFloor (dB) or ITSDK_LORAWAN_LINK_NOMARGIN
+} itsdk_lorawan_linkStats_t;
+
 // ===============================================================
 // PUBLIC API
 // ===============================================================
@@ -179,6 +206,23 @@ itsdk_lorawan_send_t itsdk_lorawan_send_async(
 		itdsk_payload_encrypt_t encrypt										// End to End encryption mode
 );
 itsdk_lorawan_send_t itsdk_lorawan_getSendState();						// Send state for polling
+#if ITSDK_LORAWAN_UPLINK_QUEUE_SZ > 0
+itsdk_lorawan_send_t itsdk_lorawan_send_queue(							// Queue an uplink, sent from itsdk_lorawan_loop()
+		uint8_t * payload,
+		uint8_t   payloadSize,												// Max ITSDK_LORAWAN_UPLINK_QUEUE_MSGSZ
+		uint8_t   port,
+		uint8_t	  dataRate,
+		itsdk_lorawan_sendconf_t confirm,
+		uint8_t	  retry,
+		uint8_t	  priority,													// Higher priority is sent first
+		uint32_t  expireMs,													// Dropped when not sent within this time (0 = never)
+		bool	  coalesce,													// Can share a frame with other messages on the same port
+		void (*callback_func)(itsdk_lorawan_send_t status, uint8_t port, uint8_t size, uint8_t * rxData),
+		itdsk_payload_encrypt_t encrypt										// End to End encryption mode
+);
+uint8_t itsdk_lorawan_queue_count();										// Messages waiting in the uplink queue
+void itsdk_lorawan_queue_flush();											// Drop the messages not yet transmitted
+#endif
 
 itsdk_lorawan_return_t itsdk_lorawan_changeDefaultRate(uint8_t newRate);
 itsdk_lorawan_rssisnr_t itsdk_lorawan_getLastRssiSnr(int16_t *rssi, uint8_t *snr);
@@ -188,6 +232,35 @@ itsdk_lorawan_return_t itsdk_lorawan_getDownlinkFrameCounter(uint16_t * counter)
 itsdk_lorawan_return_t itsdk_lorawan_getUplinkFrameCounter(uint16_t * counter);
 itsdk_lorawan_return_t itsdk_lorawan_getNextUplinkFrameCounter(uint16_t * counter);
 itsdk_lorawan_return_t itsdk_lorawan_resetFactoryDefaults(bool force);
+itsdk_lorawan_return_t itsdk_lorawan_getNvmSize(uint32_t * sz);				// EEPROM size reserved for the MAC contexts
+itsdk_lorawan_return_t itsdk_lorawan_getNvmOffset(uint32_t * offset);		// EEPROM offset of the MAC contexts
+itsdk_lorawan_return_t itsdk_lorawan_clearNvm();								// Invalidate the saved MAC contexts
+itsdk_lorawan_return_t itsdk_lorawan_getTxPlan(								// Duty cycle delay, time on air and charge for a datarate
+		uint8_t dataRate,
+		uint8_t payloadSize,
+		itsdk_lorawan_txplan_t * plan
+);
+itsdk_lorawan_return_t itsdk_lorawan_planTx(								// Cheapest datarate in [minDr,maxDr] transmitting within deadlineMs
+		uint8_t payloadSize,
+		uint32_t deadlineMs,
+		uint8_t minDr,
+		uint8_t maxDr,
+		itsdk_lorawan_txplan_t * plan
+);
+bool itsdk_lorawan_holdDownlink(uint8_t * rxData);							// Keep a received downlink buffer after the callback returns
+void itsdk_lorawan_releaseDownlink(uint8_t * rxData);						// Give back a hold downlink buffer
+void itsdk_lorawan_getDownlinkStats(itsdk_lorawan_downlinkStats_t * stats);	// Downlink pool counters
+#if ITSDK_LORAWAN_LINK_HISTORY > 0
+itsdk_lorawan_return_t itsdk_lorawan_getLinkStats(							// Link quality history summary for a datarate
+		uint8_t dataRate,
+		itsdk_lorawan_linkStats_t * stats
+);
+void itsdk_lorawan_clearLinkStats();										// Reset the link quality history
+uint8_t itsdk_lorawan_getOptimalDr(uint8_t minDr, uint8_t maxDr);			// Fastest datarate in [minDr,maxDr] meeting the link targets
+#endif
+itsdk_lorawan_return_t itsdk_lorawan_requestTime();						// Piggyback a DeviceTimeReq on the next uplink to sync the EPOC/UTC time
+uint32_t itsdk_lorawan_getTimeSyncPeriod();									// Seconds between syncs to stay under ITSDK_LORAWAN_TIMESYNC_MAXERR
+uint64_t itsdk_lorawan_getLastTimeSync();									// Local time (ms) of the last network time sync, 0 if never
 void itsdk_lorawan_loop();													// LoRaWan stack processing loop - MUST be in project_loop()
 
 
@@ -221,5 +294,7 @@ void itsdk_lorawan_onConfirmClass(itsdk_lorawan_dev_class class);
 void itsdk_lorawan_onTxNeeded();
 // Function automatically fired when the network server has confirmed ack reception
 void itsdk_lorawan_uplinkAckConfirmed();
+// Function automatically fired when the EPOC/UTC time has been synced from the network
+void itsdk_lorawan_onTimeSync(uint32_t epochS);
 
 #endif
@@ -0,0 +1,77 @@
+/* ==========================================================
+ * network.h - LoRaWan / Sigfox arbitration per message
+ * Project : Disk91 SDK
+ * ----------------------------------------------------------
+ * Created on: 18 oct. 2026
+ *     Author: Paul Pinault aka Disk91
+ * ----------------------------------------------------------
+ * Copyright (C) 2026 Disk91
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU LESSER General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ * ----------------------------------------------------------
+ *
+ * Messages are sent on the network with the lowest expected
+ * charge meeting their deadline and reliability, through the
+ * LoRaWan and Sigfox uplink queues. A failed message is sent
+ * again on the other network.
+ *
+ * ==========================================================
+ */
+#ifndef IT_SDK_NETWORK_H_
+#define IT_SDK_NETWORK_H_
+
+#include <it_sdk/config.h>
+#include <it_sdk/encrypt/encrypt.h>
+#include <it_sdk/network/network_policy.h>
+
+typedef enum {
+	NETWORK_SEND_QUEUED = 0,					// Message accepted, the result is reported to the callback
+	NETWORK_SEND_SENT,							// Message sent, no acknowledgment requested
+	NETWORK_SEND_ACKED,							// LoRaWan ack or Sigfox downlink received
+	NETWORK_SEND_FAILED							// Refused, or failed on all the networks
+} itsdk_network_send_e;
+
+typedef struct {
+	itsdk_network_req_t		req;
+	itsdk_network_option_t	lorawan;
+	itsdk_network_option_t	sigfox;
+	uint8_t					exclude;
+	uint8_t					network;			// Decision, to be compared on replay
+} itsdk_network_trace_t;
+
+void itsdk_network_setup();
+void itsdk_network_loop();													// Called by itsdk_loop()
+itsdk_network_send_e itsdk_network_send(
+		uint8_t * payload,
+		uint8_t   size,														// Max ITSDK_NETWORK_MSGSZ
+		uint8_t   port,														// LoRaWan port
+		uint32_t  deadlineMs,												// Max time before the transmission starts
+		itsdk_network_rel_e reliability,
+		itdsk_payload_encrypt_t encrypt,
+		void (*callback_func)(itsdk_network_send_e status, uint8_t network, uint8_t size, uint8_t * rxData)
+);
+uint8_t itsdk_network_queue_count();										// Messages waiting or in progress
+void itsdk_network_getOptions(												// Current LoRaWan and Sigfox options for a request
+		const itsdk_network_req_t * req,
+		itsdk_network_option_t * lorawan,
+		itsdk_network_option_t * sigfox
+);
+uint8_t itsdk_network_getTrace(itsdk_network_trace_t * trace, uint8_t max);	// Last decisions, oldest first
+
+// --------------------------------------------------------------------
+// Function to be overloaded in the main program
+// --------------------------------------------------------------------
+bool itsdk_network_activate(uint8_t network);								// Switch a shared radio to the network, true when ready
+
+#endif /* IT_SDK_NETWORK_H_ */
@@ -0,0 +1,81 @@
+/* ==========================================================
+ * network_policy.h - LoRaWan / Sigfox selection per message
+ * Project : Disk91 SDK
+ * ----------------------------------------------------------
+ * Created on: 18 oct. 2026
+ *     Author: Paul Pinault aka Disk91
+ * ----------------------------------------------------------
+ * Copyright (C) 2026 Disk91
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU LESSER General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ * ----------------------------------------------------------
+ *
+ * Decision part of the network arbitration. The function only
+ * depends on its parameters: the traced decisions can be replayed
+ * on host by compiling network_policy.c alone.
+ *
+ * ==========================================================
+ */
+#ifndef IT_SDK_NETWORK_POLICY_H_
+#define IT_SDK_NETWORK_POLICY_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define ITSDK_NETWORK_NET_NONE		0x00		// Same values as __ACTIV_NETWORK_x
+#define ITSDK_NETWORK_NET_SIGFOX	0x01
+#define ITSDK_NETWORK_NET_LORAWAN	0x02
+
+#define ITSDK_NETWORK_LINK_UNKNOWN	0xFF		// No outcome recorded for the network
+#define ITSDK_NETWORK_LINK_DEFAULT	90			// Success rate (%) assumed when unknown
+
+typedef enum {
+	ITSDK_NETWORK_REL_LOW = 0,					// Single transmission (Sigfox without repetition)
+	ITSDK_NETWORK_REL_NORMAL,					// Unconfirmed LoRaWan, Sigfox with repetitions
+	ITSDK_NETWORK_REL_ACKED						// Confirmed LoRaWan, Sigfox with downlink
+} itsdk_network_rel_e;
+
+typedef struct {
+	uint32_t	deadlineMs;						// Max time before the transmission starts
+	uint8_t		size;							// Payload size
+	uint8_t		reliability;					// itsdk_network_rel_e
+} itsdk_network_req_t;
+
+typedef struct {
+	uint8_t		available;						// Stack ready (joined, quota left...)
+	uint8_t		maxSize;						// Max payload size
+	uint8_t		param;							// LoRaWan datarate or Sigfox repetitions
+	uint8_t		linkRate;						// Recent success rate in % or ITSDK_NETWORK_LINK_UNKNOWN
+	uint32_t	delayMs;						// Time to wait before the transmission is allowed
+	uint32_t	toaMs;							// Time on air
+	uint32_t	chargeUC;						// Estimated radio charge in uC (mA.ms)
+} itsdk_network_option_t;
+
+typedef struct {
+	uint8_t		network;						// ITSDK_NETWORK_NET_x, NONE when no option can carry the message
+	uint8_t		param;							// Option param
+	bool		late;							// The deadline can't be met, earliest option selected
+	uint32_t	delayMs;
+	uint32_t	costUC;							// Charge per delivered message (charge / success rate)
+} itsdk_network_decision_t;
+
+uint8_t itsdk_network_decide(
+		const itsdk_network_req_t * req,
+		const itsdk_network_option_t * lorawan,
+		const itsdk_network_option_t * sigfox,
+		uint8_t exclude,						// ITSDK_NETWORK_NET_x already tried for this message
+		itsdk_network_decision_t * decision
+);
+
+#endif /* IT_SDK_NETWORK_POLICY_H_ */
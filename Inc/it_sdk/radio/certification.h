@@ -21,6 +21,9 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  * ----------------------------------------------------------
  * 
+ * The test sequencer runs a plan of continuous waves on each
+ * frequency / power and RSSI windows on each frequency from the
+ * soft timers and streams one result line per step on the console.
  *
  * ==========================================================
  */
@@ -28,7 +31,29 @@
 #ifndef IT_SDK_RADIO_CERTIFICATION_H_
 #define IT_SDK_RADIO_CERTIFICATION_H_
 
+#include <it_sdk/config.h>
+#include <it_sdk/console/console.h>
+
+#define ITSDK_CERTIF_SEQ_MAXFREQ	6			// Max frequencies in a test plan
+#define ITSDK_CERTIF_SEQ_MAXPOWER	6			// Max powers in a test plan
+#define ITSDK_CERTIF_SEQ_RSSI_MS	10			// RSSI sampling period during the RX windows
+
+typedef struct {
+	uint32_t	frequency[ITSDK_CERTIF_SEQ_MAXFREQ];	// Hz
+	int8_t		power[ITSDK_CERTIF_SEQ_MAXPOWER];		// dBm
+	uint8_t		nbFrequency;
+	uint8_t		nbPower;
+	uint16_t	dwellMs;								// Continuous wave duration per frequency / power
+	uint16_t	rxMs;									// RSSI window per frequency, 0 for none
+	int16_t		minRssi;								// Min RSSI in the window to pass, dBm
+} itsdk_certif_plan_t;
+
 itsdk_bool_e startContinousWaveTransmission(uint32_t frequency, int8_t power, uint32_t durationMs );
 itsdk_bool_e stopContinousWaveTransmission( void );
 
+itsdk_bool_e itsdk_certif_seq_start(const itsdk_certif_plan_t * plan);	// Run the plan in background
+void itsdk_certif_seq_stop();
+bool itsdk_certif_seq_isRunning();
+itsdk_console_return_e itsdk_certif_seq_console(char * buffer, uint8_t sz);	// c:x commands, see Doc/certification.md
+
 #endif /* IT_SDK_RADIO_CERTIFICATION_H_ */
@@ -0,0 +1,53 @@
+/* ==========================================================
+ * random.h - Random number service
+ * Project : Disk91 SDK
+ * ----------------------------------------------------------
+ * Created on: 18 oct. 2020
+ *     Author: Paul Pinault aka Disk91
+ * ----------------------------------------------------------
+ * Copyright (C) 2020 Disk91
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU LESSER General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ * ----------------------------------------------------------
+ *
+ *
+ * ==========================================================
+ */
+#ifndef IT_SDK_RANDOM_H_
+#define IT_SDK_RANDOM_H_
+
+#include <stdint.h>
+#include <it_sdk/encrypt/speck/speck.h>
+
+#define ITSDK_RANDOM_POOL_BITS		64					// Estimated entropy bits needed before rekeying from the pool
+#define ITSDK_RANDOM_RESEED_OUT		1024				// Max number of 32b output before a forced rekey
+
+typedef struct {
+	speck32_ctx_t	ctx;				// Generator key (expanded)
+	uint16_t		pool[4];			// Entropy pool, used as next generator key
+	uint32_t		counter;			// Generator counter
+	uint16_t		poolBits;			// Estimated entropy bits added since the last rekey
+	uint16_t		outputs;			// Number of output since the last rekey
+	uint8_t			ready;				// Generator has been seeded
+} itsdk_random_state_t;
+
+void itsdk_random_init();
+void itsdk_random_seed(uint64_t seed);
+void itsdk_random_loop();
+void itsdk_random_addEntropy(uint32_t value, uint8_t bits);
+uint32_t itsdk_random_getU32();
+int32_t itsdk_random_getRange(int32_t min, int32_t max);
+void itsdk_random_getBytes(uint8_t * dest, uint16_t len);
+
+#endif /* IT_SDK_RANDOM_H_ */
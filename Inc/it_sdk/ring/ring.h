@@ -0,0 +1,62 @@
+/* ==========================================================
+ * ring.h - Single producer / single consumer ring buffer
+ * Project : Disk91 SDK
+ * ----------------------------------------------------------
+ * Created on: 18 oct. 2020
+ *     Author: Paul Pinault aka Disk91
+ * ----------------------------------------------------------
+ * Copyright (C) 2020 Disk91
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU LESSER General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ * ----------------------------------------------------------
+ *
+ *
+ * ==========================================================
+ */
+#ifndef IT_SDK_RING_H_
+#define IT_SDK_RING_H_
+
+#include <stdint.h>
+
+// Indexes are free running and only written by their owner (wr by the
+// producer, rd by the consumer) so no critical section is needed as long
+// as there is one producer and one consumer. Element count must be a
+// power of two, up to 32768.
+typedef struct {
+	volatile uint16_t	wr;					// Write index, owned by the producer
+	volatile uint16_t	rd;					// Read index, owned by the consumer
+	uint16_t			mask;				// Element count - 1
+	uint16_t			elemSz;				// Size of one element in bytes
+	uint16_t			highWater;			// Max number of elements seen in the ring
+	uint32_t			overflow;			// Number of elements dropped on push
+	uint8_t			*	data;				// Element storage
+} itsdk_ring_t;
+
+#define ITSDK_RING_DECLARE(_name,_type,_count)											\
+				_type _name##_data[_count];												\
+				itsdk_ring_t _name = { 0, 0, (_count)-1, sizeof(_type), 0, 0, (uint8_t *)_name##_data }
+
+#define ITSDK_RING_BARRIER()		__sync_synchronize()
+
+void itsdk_ring_init(itsdk_ring_t * ring);
+uint16_t itsdk_ring_push(itsdk_ring_t * ring, const void * elems, uint16_t count);
+uint16_t itsdk_ring_pop(itsdk_ring_t * ring, void * elems, uint16_t count);
+uint16_t itsdk_ring_peek(itsdk_ring_t * ring, void * elems, uint16_t count);
+uint16_t itsdk_ring_count(itsdk_ring_t * ring);
+uint16_t itsdk_ring_free(itsdk_ring_t * ring);
+void itsdk_ring_flush(itsdk_ring_t * ring);
+void itsdk_ring_getStats(itsdk_ring_t * ring, uint16_t * highWater, uint32_t * overflow);
+void itsdk_ring_resetStats(itsdk_ring_t * ring);
+
+#endif /* IT_SDK_RING_H_ */
@@ -49,6 +49,8 @@ typedef enum {
 	SIGFOX_TXRX_DOWLINK_RECEIVED,			// Uplink / Downlink success, backend retruned downlink value
 	SIGFOX_ERROR_PARAMS,					// Wrong parameters used when calling the function
 	SIGFOX_TXRX_ERROR,						// Underlaying sigfox stack returned an error
+	SIGFOX_TRANSMIT_QUEUED,					// Message queued, the result is reported to the callback
+	SIGFOX_TRANSMIT_DWN_SKIPPED,			// Uplink success, downlink request removed by ITSDK_SIGFOX_DOWNLINK_PERIOD_S
 } itdsk_sigfox_txrx_t;
 
 typedef enum {
@@ -93,6 +95,13 @@ typedef struct {
 	uint8_t		reserved;
 } itsdk_sigfox_nvm_header_t;
 
+// Sigfox quota window of the network arbitration, after the Secure Element area
+typedef struct {
+	uint32_t	windowS;				// Time elapsed in the 24h window at the last update
+	uint16_t	count;					// Uplinks sent in the window
+	uint16_t	reserved;
+} itsdk_sigfox_nvm_quota_t;
+
 
 // --------------------------------------------------------------------
 // Public Functions
@@ -144,6 +153,39 @@ itdsk_sigfox_txrx_t itsdk_sigfox_sendOob(
 		int8_t power
 );
 
+// Uplink queue, when ITSDK_SIGFOX_UPLINK_QUEUE_SZ > 0
+// The messages are sent one per call of itsdk_sigfox_loop() with the blocking itsdk_sigfox_sendFrame:
+// the loop does not return before the end of the transmission and of the downlink window (20 to 45s)
+itdsk_sigfox_txrx_t itsdk_sigfox_sendFrame_queue(						// Queue a frame, sent from itsdk_sigfox_loop()
+		uint8_t * buf,
+		uint8_t len,
+		uint8_t repeat,
+		itdsk_sigfox_speed_t speed,
+		int8_t power,
+		itdsk_payload_encrypt_t encrypt,
+		bool ack,
+		void (*callback_func)(itdsk_sigfox_txrx_t status, uint8_t * dwn)	// dwn is valid during the callback only
+);
+
+itdsk_sigfox_txrx_t itsdk_sigfox_sendBit_queue(
+		bool bitValue,
+		uint8_t repeat,
+		itdsk_sigfox_speed_t speed,
+		int8_t power,
+		bool ack,
+		void (*callback_func)(itdsk_sigfox_txrx_t status, uint8_t * dwn)
+);
+
+itdsk_sigfox_txrx_t itsdk_sigfox_sendOob_queue(
+		itdsk_sigfox_oob_t oobType,
+		itdsk_sigfox_speed_t speed,
+		int8_t power,
+		void (*callback_func)(itdsk_sigfox_txrx_t status, uint8_t * dwn)
+);
+uint8_t itsdk_sigfox_queue_count();										// Messages waiting in the uplink queue
+void itsdk_sigfox_queue_flush();											// Drop the messages not yet transmitted
+bool itsdk_sigfox_isDownlinkAllowed();										// False until ITSDK_SIGFOX_DOWNLINK_PERIOD_S after the last downlink request
+
 itsdk_sigfox_init_t itsdk_sigfox_continuousModeStart(
 		uint32_t				frequency,
 		itdsk_sigfox_speed_t 	speed,
@@ -158,6 +200,7 @@ itsdk_sigfox_init_t itsdk_sigfox_getNvmSize(uint32_t * sz);
 itsdk_sigfox_init_t itsdk_sigfox_getNvmOffset(uint32_t * offset);
 itsdk_sigfox_init_t itsdk_sigfox_getSeNvmOffset(uint32_t * offset);
 itsdk_sigfox_init_t itsdk_sigfox_getSigfoxNvmOffset(uint32_t * offset);
+itsdk_sigfox_init_t itsdk_sigfox_getQuotaNvmOffset(uint32_t * offset);
 itsdk_sigfox_init_t __itsdk_sigfox_resetNvmToFactory(bool force);
 
 // --------------------------------------------------------------------
@@ -0,0 +1,68 @@
+/* ==========================================================
+ * sigfox_mem.h - Static memory arena for the sigfox libraries
+ * Project : Disk91 SDK
+ * ----------------------------------------------------------
+ * Created on: 18 oct. 2020
+ *     Author: Paul Pinault aka Disk91
+ * ----------------------------------------------------------
+ * Copyright (C) 2020 Disk91
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU LESSER General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ * ----------------------------------------------------------
+ *
+ * MCU_API_malloc / MCU_API_free backend. The ITSDK_SIGFOX_MEM_SIZE
+ * buffer is allocated as a stack, the peak use is traced to
+ * size the buffer for a given product (RCZ, Monarch...).
+ * This file has no hardware dependency and can be compiled on host.
+ *
+ * ==========================================================
+ */
+#ifndef IT_SDK_SIGFOX_MEM_H_
+#define IT_SDK_SIGFOX_MEM_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define ITSDK_SIGFOX_MEM_MAXALLOC	4				// Max simultaneous allocations
+#define ITSDK_SIGFOX_MEM_TRACESZ	8				// Number of requests kept in the trace
+
+#if ITSDK_SIGFOX_MEM_MAXALLOC > 8
+#error "ITSDK_SIGFOX_MEM_MAXALLOC is limited to 8, the freed blocks are tracked in an uint8_t"
+#endif
+
+typedef struct {
+	uint16_t	size;				// requested size
+	uint16_t	used;				// memory used after the request
+	uint32_t	caller;				// return address of MCU_API_malloc
+	bool		success;
+} itsdk_sigfox_memTrace_t;
+
+typedef struct {
+	uint16_t	size;				// arena size (ITSDK_SIGFOX_MEM_SIZE)
+	uint16_t	used;				// current use
+	uint16_t	peak;				// high-water mark since boot / reset
+	uint16_t	maxReq;				// largest single request
+	uint16_t	allocs;				// number of successful allocations
+	uint16_t	failures;			// number of refused allocations
+	uint32_t	peakCaller;			// caller of the allocation reaching the peak
+} itsdk_sigfox_memStats_t;
+
+bool itsdk_sigfox_memAlloc(uint16_t size, uint32_t caller, uint8_t ** ptr);
+bool itsdk_sigfox_memFree(uint8_t * ptr);
+void itsdk_sigfox_memGetStats(itsdk_sigfox_memStats_t * stats);
+uint8_t itsdk_sigfox_memGetTrace(itsdk_sigfox_memTrace_t * trace, uint8_t max);
+void itsdk_sigfox_memResetStats();
+void itsdk_sigfox_memReset();
+
+#endif /* IT_SDK_SIGFOX_MEM_H_ */
@@ -40,6 +40,7 @@ void itsdk_time_init();
 
 // UTC time (HH:MM:SS) when the reference has been set by an external driver
 void itsdk_time_sync_UTC_s( uint32_t utc_s );				// Access time with reference MIDNIGHT UTC when set (otherwise startup)
+void itsdk_time_sync_UTC_ms( uint32_t utc_s, uint16_t ms );
 uint32_t itsdk_time_get_UTC_s();
 itsdk_bool_e itsdk_time_is_UTC_s(uint32_t * destTime);
 uint8_t itsdk_time_get_UTC_sec();
@@ -50,5 +51,9 @@ uint8_t itsdk_time_get_UTC_hour();
 void itsdk_time_sync_EPOC_s( uint32_t utc_s );				// Access time with reference EPOC when set (otherwise startup)
 uint32_t itsdk_time_get_EPOC_s();
 itsdk_bool_e itsdk_time_is_EPOC_s(uint32_t * destTime);
+void itsdk_time_sync_EPOC_ms( uint32_t epoc_s, uint16_t ms );	// Sync with a ms precision source, measures the clock drift
+int32_t itsdk_time_get_drift_ppb();
+uint32_t itsdk_time_get_EPOC_at_ms(uint64_t local_ms);		// EPOC time of a local timestamp
+uint32_t itsdk_time_gps2Epoc_s(uint32_t gps_s);				// GPS time (no leap second) to EPOC
 
 #endif /* IT_SDK_TIME_TIME_H_ */
@@ -88,6 +88,9 @@ typedef enum {
 itsdk_bool_e serial1_changeBaudRate(serial_baudrate_e bd);
 itsdk_bool_e serial2_changeBaudRate(serial_baudrate_e bd);
 
+void serial1_getRxStats(uint16_t * highWater, uint32_t * overflow);	// RX ring usage, 0 when RX IRQ not enabled
+void serial2_getRxStats(uint16_t * highWater, uint32_t * overflow);
+
 
 
 // ================================================
@@ -208,6 +211,25 @@ _SPI_Status spi_write_byte(
 		uint8_t Value
 );
 
+_SPI_Status spi_transmit(								// Burst write, one transaction
+		ITSDK_SPI_HANDLER_TYPE * spi,
+		uint8_t	* toTransmit,
+		uint16_t  size
+);
+
+_SPI_Status spi_receive(								// Burst read, one transaction
+		ITSDK_SPI_HANDLER_TYPE * spi,
+		uint8_t	* toReceive,
+		uint16_t  size
+);
+
+void spi_getStats(										// Transactions & bytes counters
+		uint32_t * transactions,
+		uint32_t * bytes
+);
+
+void spi_resetStats();
+
 _SPI_Status spi_transmit_dma_start(
 		SPI_HandleTypeDef * spi,
 		uint8_t * 			pData,
@@ -329,6 +351,9 @@ itsdk_reset_cause_t itsdk_getResetCause();
 // misc_wrapper
 void itsdk_reset();
 void itsdk_delayMs(uint32_t ms);
+void itsdk_delayUs(uint32_t us);							// Active delay, at least us microseconds
+void itsdk_sleepMs(uint32_t ms);							// Delay with the core in sleep mode, clocks and peripherals running
+void itsdk_waitForInterrupt();								// Core in sleep mode until the next interrupt
 
 uint32_t itsdk_getIrqMask();
 void itsdk_setIrqMask(uint32_t mask);
@@ -38,11 +38,18 @@
 #include <it_sdk/logger/logger.h>
 #include <it_sdk/logger/error.h>
 #include <it_sdk/time/timer.h>
+#include <it_sdk/time/time.h>
 #include <it_sdk/lorawan/lorawan.h>
 #include <drivers/lorawan/core/lorawan.h>
 #include <drivers/lorawan/mac/LoRaMac.h>
+#include <drivers/lorawan/mac/LoRaMacFCntHandler.h>
+#include <drivers/lorawan/systime.h>
 #include <drivers/lorawan/core/lora-test.h>
 #include <drivers/lorawan/compiled_region.h>
+#include <it_sdk/eeprom/eeprom.h>
+#if ITSDK_LORAWAN_NVM_SOURCE == __LORAWAN_NVM_LOCALEPROM
+#include <it_sdk/eeprom/securestore.h>
+#endif
 
 
 /**
@@ -85,6 +92,280 @@ static void McpsIndication( McpsIndication_t *mcpsIndication );
 static void MlmeConfirm( MlmeConfirm_t *mlmeConfirm );
 static void MlmeIndication( MlmeIndication_t *MlmeIndication );
 
+// =======================================================================================
+// NVM contexts persistence
+// =======================================================================================
+
+#if ITSDK_LORAWAN_NVM_SOURCE == __LORAWAN_NVM_LOCALEPROM
+
+#define LORAWAN_DRIVER_NVM_MAGIC	0x4C4D4331				// LMC1
+#define LORAWAN_DRIVER_NVM_MODULES	(LORAMAC_NVMCTXMODULE_FCNT_HANDLER+1)
+#define LORAWAN_DRIVER_NVM_FCNT_GAP	1						// Uplinks possibly sent after the last save (reset during TX)
+#define LORAWAN_DRIVER_NVM_KCV_IV	0xFFFFFFFF				// Secure store cipher iv for the key check value
+
+/**
+ * EEPROM zone is : header, one slot per module, ITSDK_LORAWAN_NVM_FCNT_SLOTS for the frame
+ * counters. A slot is a slot header followed by the context data 32b aligned.
+ */
+typedef struct {
+	uint32_t	magic;
+	uint32_t	fingerprint;								// crc of the join configuration the contexts belong to
+	uint16_t	size[LORAWAN_DRIVER_NVM_MODULES];			// context size of each module
+} lorawan_driver_nvmHeader_t;
+
+typedef struct {
+	uint32_t	crc32;										// crc of the context data
+	uint16_t	size;										// context data size
+	uint16_t	seq;										// write sequence, the last one is the valid one for fcnt slots
+} lorawan_driver_nvmSlot_t;
+
+static struct {
+	uint32_t	offset[LORAWAN_DRIVER_NVM_MODULES];			// slot offset for each module (first slot for fcnt)
+	uint16_t	slotSz[LORAWAN_DRIVER_NVM_MODULES];			// slot size including header
+	uint16_t	dirty;										// bit field of the modules to be written
+	uint16_t	fcntSeq;									// last frame counter slot sequence
+	uint16_t	seSeq;										// secure element slot sequence, used as cipher iv
+	uint8_t		fcntSlot;									// last frame counter slot written
+	bool		enabled;									// zone is valid and large enough
+	bool		restored;									// session has been restored on init
+} __lorawan_driver_nvm;
+
+/**
+ * Get a module context pointer and size
+ */
+static void * __lorawan_driver_nvmGetCtx(LoRaMacCtxs_t * ctxs, uint8_t module, size_t * size) {
+	switch (module) {
+	case LORAMAC_NVMCTXMODULE_MAC:				*size = ctxs->MacNvmCtxSize; return ctxs->MacNvmCtx;
+	case LORAMAC_NVMCTXMODULE_REGION:			*size = ctxs->RegionNvmCtxSize; return ctxs->RegionNvmCtx;
+	case LORAMAC_NVMCTXMODULE_CRYPTO:			*size = ctxs->CryptoNvmCtxSize; return ctxs->CryptoNvmCtx;
+	case LORAMAC_NVMCTXMODULE_SECURE_ELEMENT:	*size = ctxs->SecureElementNvmCtxSize; return ctxs->SecureElementNvmCtx;
+	case LORAMAC_NVMCTXMODULE_COMMANDS:			*size = ctxs->CommandsNvmCtxSize; return ctxs->CommandsNvmCtx;
+	case LORAMAC_NVMCTXMODULE_CLASS_B:			*size = ctxs->ClassBNvmCtxSize; return ctxs->ClassBNvmCtx;
+	case LORAMAC_NVMCTXMODULE_CONFIRM_QUEUE:	*size = ctxs->ConfirmQueueNvmCtxSize; return ctxs->ConfirmQueueNvmCtx;
+	case LORAMAC_NVMCTXMODULE_FCNT_HANDLER:		*size = ctxs->FCntHandlerNvmCtxSize; return ctxs->FCntHandlerNvmCtx;
+	default:
+		*size = 0;
+		return NULL;
+	}
+}
+
+static LoRaMacCtxs_t * __lorawan_driver_nvmGetCtxs() {
+	MibRequestConfirm_t mibReq;
+	mibReq.Type = MIB_NVM_CTXS;
+	LoRaMacMibGetRequestConfirm( &mibReq );
+	return mibReq.Param.Contexts;
+}
+
+/**
+ * Compute the slot organization from the current context sizes
+ * Fill the expected header.
+ */
+static bool __lorawan_driver_nvmSetup(lorawan_driver_nvmHeader_t * header) {
+	LoRaMacCtxs_t * ctxs = __lorawan_driver_nvmGetCtxs();
+	uint32_t offset;
+	itsdk_lorawan_getNvmOffset(&offset);
+	uint32_t start = offset;
+	offset += sizeof(lorawan_driver_nvmHeader_t);
+
+	header->magic = LORAWAN_DRIVER_NVM_MAGIC;
+	for ( int m = 0 ; m < LORAWAN_DRIVER_NVM_MODULES ; m++ ) {
+		size_t sz;
+		__lorawan_driver_nvmGetCtx(ctxs, m, &sz);
+		header->size[m] = (uint16_t)sz;
+		__lorawan_driver_nvm.slotSz[m] = sizeof(lorawan_driver_nvmSlot_t) + itdt_align_32b(sz);
+		__lorawan_driver_nvm.offset[m] = offset;
+		offset += ( m == LORAMAC_NVMCTXMODULE_FCNT_HANDLER )?
+				ITSDK_LORAWAN_NVM_FCNT_SLOTS * __lorawan_driver_nvm.slotSz[m] :
+				__lorawan_driver_nvm.slotSz[m];
+	}
+	if ( offset - start > ITSDK_LORAWAN_NVM_SIZE ) {
+		ITSDK_ERROR_REPORT(ITSDK_ERROR_LORAWAN_NVM_TOOSMALL,(uint16_t)(offset - start));
+		return false;
+	}
+	return true;
+}
+
+/**
+ * Verify a slot against its crc without loading it in RAM
+ */
+static bool __lorawan_driver_nvmCheckSlot(uint32_t offset, uint16_t size, lorawan_driver_nvmSlot_t * slot) {
+	_eeprom_read(ITDT_EEPROM_BANK0, offset, (void *) slot, sizeof(lorawan_driver_nvmSlot_t));
+	if ( slot->size != size ) return false;
+	offset += sizeof(lorawan_driver_nvmSlot_t);
+	uint32_t crc = 0;
+	uint8_t  w[4];
+	itsdk_inlineCRC32_init();
+	for ( int i = 0 ; i < size ; i+=4 ) {
+		_eeprom_read(ITDT_EEPROM_BANK0, offset+i, (void *) w, 4);
+		for ( int j = 0 ; j < 4 && i+j < size ; j++ ) crc = itsdk_inlineCRC32_next(w[j],8);
+	}
+	return ( crc == slot->crc32 );
+}
+
+/**
+ * Write a context into a slot, data first then the slot header
+ */
+static void __lorawan_driver_nvmWriteSlot(uint32_t offset, uint16_t seq, void * ctx, uint16_t size) {
+	lorawan_driver_nvmSlot_t slot;
+	_eeprom_write(ITDT_EEPROM_BANK0, offset+sizeof(lorawan_driver_nvmSlot_t), ctx, size);
+	slot.crc32 = itsdk_computeCRC32((uint8_t *)ctx, size);
+	slot.size = size;
+	slot.seq = seq;
+	_eeprom_write(ITDT_EEPROM_BANK0, offset, (void *) &slot, sizeof(lorawan_driver_nvmSlot_t));
+}
+
+/**
+ * The secure element context holds the root and session keys, it is never
+ * written in clear: it is encrypted with a key derived from the secure store.
+ * The other contexts are left unchanged.
+ */
+static bool __lorawan_driver_nvmCipher(uint8_t module, void * ctx, size_t size, uint16_t seq) {
+	if ( module != LORAMAC_NVMCTXMODULE_SECURE_ELEMENT ) return true;
+	return ( itsdk_secstore_cipher((uint8_t *)ctx, (uint16_t)size, ((uint32_t)module << 16) | seq) == SS_SUCCESS );
+}
+
+/**
+ * Fingerprint of the configuration : the saved session is only valid for
+ * the same region and credentials, and the same secure store key
+ */
+static uint32_t __lorawan_driver_nvmFingerprint(lorawan_driver_config_t * config) {
+	uint8_t b[16];
+	b[0] = (uint8_t)(config->region >> 8);
+	b[1] = (uint8_t)config->region;
+	b[2] = config->JoinType;
+	b[3] = 0;
+	uint32_t crc = itsdk_computeCRC32(b, 4);
+	if ( config->devEui != NULL ) crc ^= itsdk_computeCRC32(config->devEui, 8);
+	if ( config->JoinType == __LORAWAN_OTAA ) {
+		crc ^= itsdk_computeCRC32(config->config.otaa.appEui, 8) << 1;
+		crc ^= itsdk_computeCRC32(config->config.otaa.appKey, 16) << 2;
+	} else {
+		crc ^= config->config.abp.devAddr;
+		crc ^= itsdk_computeCRC32(config->config.abp.appSKey, 16) << 1;
+		crc ^= itsdk_computeCRC32(config->config.abp.nwkSEncKey, 16) << 2;
+	}
+	// Key check value, the secure element slot can't be decrypted after a rekey
+	uint32_t kcv = 0;
+	itsdk_secstore_cipher((uint8_t *)&kcv, 4, LORAWAN_DRIVER_NVM_KCV_IV);
+	crc ^= kcv;
+	bzero(b,16);
+	return crc;
+}
+
+/**
+ * Restore the contexts from the EEPROM. Return true when a valid session has
+ * been restored. Called on init, the MAC must be stopped.
+ */
+static bool __lorawan_driver_nvmRestore(uint32_t fingerprint) {
+	lorawan_driver_nvmHeader_t expected, header;
+	lorawan_driver_nvmSlot_t slot;
+	uint32_t offset;
+
+	__lorawan_driver_nvm.restored = false;
+	__lorawan_driver_nvm.fcntSlot = ITSDK_LORAWAN_NVM_FCNT_SLOTS-1;
+	__lorawan_driver_nvm.fcntSeq = 0;
+	__lorawan_driver_nvm.seSeq = 0;
+	bzero(&expected,sizeof(expected));
+	__lorawan_driver_nvm.enabled = __lorawan_driver_nvmSetup(&expected);
+	if ( ! __lorawan_driver_nvm.enabled ) return false;
+	expected.fingerprint = fingerprint;
+
+	itsdk_lorawan_getNvmOffset(&offset);
+	_eeprom_read(ITDT_EEPROM_BANK0, offset, (void *) &header, sizeof(header));
+	if ( memcmp(&header,&expected,sizeof(header)) != 0 ) {
+		LOG_INFO_LORAWAN(("[LoRaWAN] Nvm empty or outdated\r\n"));
+		_eeprom_write(ITDT_EEPROM_BANK0, offset, (void *) &expected, sizeof(expected));
+		__lorawan_driver_nvm.dirty = 0xFFFF;
+		return false;
+	}
+
+	// Verify all the slots before touching the live contexts
+	int fcnt = -1;
+	for ( int m = 0 ; m < LORAWAN_DRIVER_NVM_MODULES ; m++ ) {
+		if ( m == LORAMAC_NVMCTXMODULE_FCNT_HANDLER ) {
+			for ( int s = 0 ; s < ITSDK_LORAWAN_NVM_FCNT_SLOTS ; s++ ) {
+				if ( __lorawan_driver_nvmCheckSlot(__lorawan_driver_nvm.offset[m]+s*__lorawan_driver_nvm.slotSz[m],expected.size[m],&slot) ) {
+					if ( fcnt < 0 || (int16_t)(slot.seq - __lorawan_driver_nvm.fcntSeq) > 0 ) {
+						fcnt = s;
+						__lorawan_driver_nvm.fcntSeq = slot.seq;
+					}
+				}
+			}
+			if ( fcnt < 0 ) break;
+		} else if ( ! __lorawan_driver_nvmCheckSlot(__lorawan_driver_nvm.offset[m],expected.size[m],&slot) ) {
+			fcnt = -1;
+			break;
+		} else if ( m == LORAMAC_NVMCTXMODULE_SECURE_ELEMENT ) {
+			__lorawan_driver_nvm.seSeq = slot.seq;
+		}
+	}
+	if ( fcnt < 0 ) {
+		LOG_WARN_LORAWAN(("[LoRaWAN] Nvm corrupted\r\n"));
+		__lorawan_driver_nvm.fcntSeq = 0;
+		__lorawan_driver_nvm.dirty = 0xFFFF;
+		return false;
+	}
+	__lorawan_driver_nvm.fcntSlot = fcnt;
+
+	// Load the contexts and apply them
+	LoRaMacCtxs_t * ctxs = __lorawan_driver_nvmGetCtxs();
+	for ( int m = 0 ; m < LORAWAN_DRIVER_NVM_MODULES ; m++ ) {
+		size_t sz;
+		void * ctx = __lorawan_driver_nvmGetCtx(ctxs, m, &sz);
+		uint32_t o = __lorawan_driver_nvm.offset[m];
+		if ( m == LORAMAC_NVMCTXMODULE_FCNT_HANDLER ) o += fcnt * __lorawan_driver_nvm.slotSz[m];
+		_eeprom_read(ITDT_EEPROM_BANK0, o+sizeof(lorawan_driver_nvmSlot_t), ctx, sz);
+		__lorawan_driver_nvmCipher(m, ctx, sz, __lorawan_driver_nvm.seSeq);
+	}
+	MibRequestConfirm_t mibReq;
+	mibReq.Type = MIB_NVM_CTXS;
+	mibReq.Param.Contexts = ctxs;
+	if ( LoRaMacMibSetRequestConfirm( &mibReq ) != LORAMAC_STATUS_OK ) {
+		LOG_WARN_LORAWAN(("[LoRaWAN] Nvm restore failed\r\n"));
+		__lorawan_driver_nvm.dirty = 0xFFFF;
+		return false;
+	}
+	__lorawan_driver_nvm.dirty = 0;
+	__lorawan_driver_nvm.restored = true;
+	return true;
+}
+
+/**
+ * Write the modules with a pending change
+ */
+static void __lorawan_driver_nvmFlush() {
+	if ( ! __lorawan_driver_nvm.enabled ) return;
+	LoRaMacCtxs_t * ctxs = __lorawan_driver_nvmGetCtxs();
+	for ( int m = 0 ; m < LORAWAN_DRIVER_NVM_MODULES ; m++ ) {
+		if ( (__lorawan_driver_nvm.dirty & (1 << m)) == 0 ) continue;
+		size_t sz;
+		void * ctx = __lorawan_driver_nvmGetCtx(ctxs, m, &sz);
+		if ( m == LORAMAC_NVMCTXMODULE_FCNT_HANDLER ) {
+			// Rotate over the slots to spread the EEPROM writes
+			__lorawan_driver_nvm.fcntSlot = (__lorawan_driver_nvm.fcntSlot + 1) % ITSDK_LORAWAN_NVM_FCNT_SLOTS;
+			__lorawan_driver_nvm.fcntSeq++;
+			__lorawan_driver_nvmWriteSlot(
+					__lorawan_driver_nvm.offset[m]+__lorawan_driver_nvm.fcntSlot*__lorawan_driver_nvm.slotSz[m],
+					__lorawan_driver_nvm.fcntSeq, ctx, sz
+			);
+		} else if ( m == LORAMAC_NVMCTXMODULE_SECURE_ELEMENT ) {
+			// Encrypted in place for the write then restored
+			__lorawan_driver_nvm.seSeq++;
+			if ( ! __lorawan_driver_nvmCipher(m, ctx, sz, __lorawan_driver_nvm.seSeq) ) {
+				LOG_WARN_LORAWAN(("[LoRaWAN] Nvm secure element not saved\r\n"));
+				continue;
+			}
+			__lorawan_driver_nvmWriteSlot(__lorawan_driver_nvm.offset[m], __lorawan_driver_nvm.seSeq, ctx, sz);
+			__lorawan_driver_nvmCipher(m, ctx, sz, __lorawan_driver_nvm.seSeq);
+		} else {
+			__lorawan_driver_nvmWriteSlot(__lorawan_driver_nvm.offset[m], 0, ctx, sz);
+		}
+	}
+	__lorawan_driver_nvm.dirty = 0;
+}
+
+#endif
+
 // ======================================================================================
 // Synchronous loop -> this function is called until we terminate the operation
 //                     this function can be override to switch into async mode
@@ -101,6 +382,11 @@ static void MlmeIndication( MlmeIndication_t *MlmeIndication );
  */
 void lorawan_driver_loop() {
 
+	// Radio interrupts are deferred, process them first, this notifies the MAC
+	if ( Radio.IrqProcess != NULL ) {
+		Radio.IrqProcess();
+	}
+
 	while (    __loraWanState.joinState != LORAWAN_STATE_NONE
 			&& __loraWanState.joinState != LORAWAN_STATE_INITIALIZED
 			&& __loraWanState.reqPending ) {
@@ -108,6 +394,13 @@ void lorawan_driver_loop() {
         LoRaMacProcess( );
 	}
 
+	#if ITSDK_LORAWAN_NVM_SOURCE == __LORAWAN_NVM_LOCALEPROM
+	if (    __lorawan_driver_nvm.dirty != 0
+		 && __loraWanState.joinState != LORAWAN_STATE_JOINING
+		 && __loraWanState.sendState != LORAWAN_SEND_STATE_RUNNING ) {
+		__lorawan_driver_nvmFlush();
+	}
+	#endif
 }
 
 __weak void lorawan_driver_waitUntilEndOfExecution() {
@@ -140,6 +433,13 @@ __weak void lorawan_driver_onJoinSuccess() {
 	LOG_INFO_LORAWAN(("[LoRaWAN] Join success\r\n"));
 }
 
+/**
+ * Callback function when the frame counters restart: OTAA join accepted or ABP
+ * activation. Not called when the session is resumed from the NVM.
+ */
+__weak void lorawan_driver_onNewSession() {
+}
+
 /**
  * Callback function on JOIN Failed
  */
@@ -176,6 +476,15 @@ __weak void lorawan_driver_onSendSuccessAckFailed() {
 	LOG_INFO_LORAWAN(("[LoRaWAN] Send sucess Ack failed\r\n"));
 }
 
+/**
+ * Callback function on DeviceTimeAns reception (success) or when the uplink
+ * carrying the DeviceTimeReq got no answer (failed)
+ * epochS / ms is the network time (Unix EPOC) at the callback time
+ */
+__weak void lorawan_driver_onDeviceTime(bool success, uint32_t epochS, uint16_t ms) {
+	LOG_INFO_LORAWAN(("[LoRaWAN] Device time %s\r\n",(success)?"received":"failed"));
+}
+
 
 // =======================================================================================
 // Callback used by the LoRaMac
@@ -211,11 +520,17 @@ void lorawan_driver_macProcessNotify(void) {
   __loraWanState.reqPending=true;
 }
 
+
 /**
  * Called after attribute change for NVM storage
+ * The module is marked to be written from the lorawan loop when
+ * the stack is idle.
  */
 void lorawan_driver_nvmContextChange(LoRaMacNvmCtxModule_t module) {
-	LOG_INFO_LORAWAN(("[LoRaWAN] Nvm Change\r\n"));
+	LOG_DEBUG_LORAWAN(("[LoRaWAN] Nvm Change %d\r\n",module));
+	#if ITSDK_LORAWAN_NVM_SOURCE == __LORAWAN_NVM_LOCALEPROM
+	__lorawan_driver_nvm.dirty |= (1 << module);
+	#endif
 }
 
 /**
@@ -320,12 +635,86 @@ const char* EventInfoStatusStrings[] =
 };
 #endif
 
+// =======================================================================================
+// Downlink pool
+// =======================================================================================
+
+/**
+ * Downlinks are copied once from the MAC buffer to a slot of the pool, then passed by
+ * pointer. A slot is referenced by the driver during the reception callback, by the
+ * application when it holds it, and by a synchronous send waiting for its result.
+ */
 static struct {
-	uint8_t		port;
-	uint8_t 	size;
-	uint8_t 	data[ITSDK_LORAWAN_MAX_DWNLNKSZ];
+	lorawan_driver_downlink_t	slot[ITSDK_LORAWAN_DWNLNK_SLOTS];
+	uint8_t						refs[ITSDK_LORAWAN_DWNLNK_SLOTS];
+	int8_t						syncSlot;			// Slot kept for the running synchronous send (-1 none)
+	bool						syncWait;			// A synchronous send is waiting for a downlink
+	itsdk_lorawan_downlinkStats_t stats;
+} __lorawan_driver_downlinks;
+
+static int8_t __lorawan_driver_downlinkSlot(uint8_t * data) {
+	for ( int8_t i = 0 ; i < ITSDK_LORAWAN_DWNLNK_SLOTS ; i++ ) {
+		if ( data == __lorawan_driver_downlinks.slot[i].data ) return i;
+	}
+	return -1;
+}
+
+static void __lorawan_driver_downlinkUnref(int8_t id) {
+	if ( id >= 0 && __lorawan_driver_downlinks.refs[id] > 0 ) __lorawan_driver_downlinks.refs[id]--;
+}
+
+/**
+ * Keep a downlink buffer received in the onDataReception callback after the callback
+ * returns. Returns false if the pointer is not a downlink buffer.
+ * The buffer must be released with lorawan_driver_downlink_release()
+ */
+bool lorawan_driver_downlink_hold(uint8_t * data) {
+	int8_t id = __lorawan_driver_downlinkSlot(data);
+	if ( id < 0 || __lorawan_driver_downlinks.refs[id] == 0 ) return false;
+	__lorawan_driver_downlinks.refs[id]++;
+	return true;
+}
+
+/**
+ * Release a downlink buffer previously hold
+ */
+void lorawan_driver_downlink_release(uint8_t * data) {
+	__lorawan_driver_downlinkUnref(__lorawan_driver_downlinkSlot(data));
+}
+
+/**
+ * Get the downlink pool counters
+ */
+void lorawan_driver_downlink_getStats(itsdk_lorawan_downlinkStats_t * stats) {
+	*stats = __lorawan_driver_downlinks.stats;
+}
 
-} __lorawan_driver_lastDownlink;
+/**
+ * Store a downlink from the MAC into a free slot, returns NULL when the pool is full
+ */
+static lorawan_driver_downlink_t * __lorawan_driver_downlinkStore(uint8_t port, uint8_t * data, uint8_t size) {
+	__lorawan_driver_downlinks.stats.received++;
+	for ( int8_t i = 0 ; i < ITSDK_LORAWAN_DWNLNK_SLOTS ; i++ ) {
+		if ( __lorawan_driver_downlinks.refs[i] == 0 ) {
+			lorawan_driver_downlink_t * d = &__lorawan_driver_downlinks.slot[i];
+			if ( size > ITSDK_LORAWAN_MAX_DWNLNKSZ ) {
+				__lorawan_driver_downlinks.stats.truncated++;
+				size = ITSDK_LORAWAN_MAX_DWNLNKSZ;
+			}
+			d->port = port;
+			d->size = size;
+			bcopy(data,d->data,size);
+			__lorawan_driver_downlinks.refs[i] = 1;
+			uint8_t used = 0;
+			for ( int8_t j = 0 ; j < ITSDK_LORAWAN_DWNLNK_SLOTS ; j++ ) if ( __lorawan_driver_downlinks.refs[j] > 0 ) used++;
+			if ( used > __lorawan_driver_downlinks.stats.highWater ) __lorawan_driver_downlinks.stats.highWater = used;
+			return d;
+		}
+	}
+	__lorawan_driver_downlinks.stats.dropped++;
+	ITSDK_ERROR_REPORT(ITSDK_ERROR_LORAWAN_DWNLNK_DROPPED,(uint16_t)__lorawan_driver_downlinks.stats.dropped);
+	return NULL;
+}
 
 // =======================================================================================
 // Init the LoRaMac
@@ -341,6 +730,12 @@ void lorawan_driver_LORA_Init(
   LOG_INFO_LORAWAN(("lorawan_driver_LORA_Init\r\n"));
 
   __loraWanState.joinState = LORAWAN_STATE_NONE;
+  __loraWanState.region = config->region;
+  bzero(&__lorawan_driver_downlinks,sizeof(__lorawan_driver_downlinks));
+  __lorawan_driver_downlinks.syncSlot = -1;
+  #if ITSDK_LORAWAN_LINK_HISTORY > 0
+  lorawan_driver_LORA_ClearLinkStats();
+  #endif
   __loraWanState.upLinkCounter = 0;
   __loraWanState.downlinkCounter = 0;
   __loraWanState.lastRssi = LORAWAN_DRIVER_INVALID_RSSI;
@@ -351,6 +746,7 @@ void lorawan_driver_LORA_Init(
   LoRaMacCallbacks.GetBatteryLevel = lorawan_driver_battery_level;
   LoRaMacCallbacks.GetTemperatureLevel = lorawan_driver_temperature;
   LoRaMacCallbacks.MacProcessNotify = lorawan_driver_macProcessNotify;
+  LoRaMacCallbacks.NvmContextChange = lorawan_driver_nvmContextChange;
 
 
 
@@ -518,10 +914,35 @@ void lorawan_driver_LORA_Init(
 		#endif
 
 
+		#if ITSDK_LORAWAN_NVM_SOURCE == __LORAWAN_NVM_LOCALEPROM
+		 // Resume the previous session when the contexts have been saved
+		 bool restored = __lorawan_driver_nvmRestore(__lorawan_driver_nvmFingerprint(config));
+		#endif
+
          // Init the Mac layer
          LoRaMacStart();
          __loraWanState.joinState = LORAWAN_STATE_INITIALIZED;
 
+		#if ITSDK_LORAWAN_NVM_SOURCE == __LORAWAN_NVM_LOCALEPROM
+         if ( restored ) {
+        	 mibReq.Type = MIB_NETWORK_ACTIVATION;
+        	 LoRaMacMibGetRequestConfirm( &mibReq );
+        	 if ( mibReq.Param.NetworkActivation != ACTIVATION_TYPE_NONE ) {
+        		 LOG_INFO_LORAWAN(("[LoRaWAN] Session restored\r\n"));
+        		 __loraWanState.joinState = LORAWAN_STATE_JOIN_SUCCESS;
+        		 __loraWanState.joinTime = (uint32_t)(itsdk_time_get_ms()/1000);
+        		 // Skip the frame counters possibly used after the last save and
+        		 // save now, a reset before the next save would reuse them
+        		 uint32_t fCntUp;
+        		 LoRaMacGetFCntUp( &fCntUp );
+        		 LoRaMacSetFCntUp( fCntUp - 1 + LORAWAN_DRIVER_NVM_FCNT_GAP );
+        		 __lorawan_driver_nvmFlush();
+        	 } else {
+        		 __lorawan_driver_nvm.restored = false;
+        	 }
+         }
+		#endif
+
 }
 
 
@@ -535,6 +956,16 @@ itsdk_lorawan_join_t lorawan_driver_LORA_Join(
 ){
 	LOG_INFO_LORAWAN(("lorawan_driver_LORA_Join (mode:%d)\r\n",runMode));
 
+	#if ITSDK_LORAWAN_NVM_SOURCE == __LORAWAN_NVM_LOCALEPROM
+	if ( __lorawan_driver_nvm.restored && __loraWanState.joinState == LORAWAN_STATE_JOIN_SUCCESS ) {
+		// Session resumed from the NVM, the first join request is not needed
+		// next ones will force a new join
+		__lorawan_driver_nvm.restored = false;
+		lorawan_driver_onJoinSuccess();
+		return (runMode==LORAWAN_RUN_SYNC)?LORAWAN_JOIN_SUCCESS:LORAWAN_JOIN_PENDING;
+	}
+	#endif
+
     switch (__loraWanState.JoinType) {
     case __LORAWAN_OTAA:
     	{
@@ -572,7 +1003,7 @@ itsdk_lorawan_join_t lorawan_driver_LORA_Join(
 			__loraWanState.joinState = LORAWAN_STATE_JOIN_SUCCESS;
 			__loraWanState.joinTime = (uint32_t)(itsdk_time_get_ms()/1000);
 
-
+			lorawan_driver_onNewSession();
 			lorawan_driver_onJoinSuccess();
     	}
         break;
@@ -665,7 +1096,15 @@ itsdk_lorawan_send_t lorawan_driver_LORA_Send(
             mcpsReq.Req.Confirmed.Datarate = __convertDR(dataRate);
         }
     }
+	#if ITSDK_LORAWAN_NVM_SOURCE == __LORAWAN_NVM_LOCALEPROM
+    // Save the frame counter before the transmission, the contexts are not
+    // written while the send is running
+    if ( __lorawan_driver_nvm.dirty != 0 ) __lorawan_driver_nvmFlush();
+	#endif
     __loraWanState.sendState = LORAWAN_SEND_STATE_RUNNING;
+    __lorawan_driver_downlinkUnref(__lorawan_driver_downlinks.syncSlot);
+    __lorawan_driver_downlinks.syncSlot = -1;
+    __lorawan_driver_downlinks.syncWait = ( runMode==LORAWAN_RUN_SYNC );
     LoRaMacStatus_t r = LoRaMacMcpsRequest( &mcpsReq );
     switch ( r ) {
     	case LORAMAC_STATUS_OK:
@@ -673,31 +1112,22 @@ itsdk_lorawan_send_t lorawan_driver_LORA_Send(
     	    	while(  __loraWanState.sendState == LORAWAN_SEND_STATE_RUNNING ) {
     	    		lorawan_driver_waitUntilEndOfExecution();
     	    	}
+    	    	__lorawan_driver_downlinks.syncWait = false;
     	    	switch(__loraWanState.sendState) {
     	    	case LORAWAN_SEND_STATE_SENT:
     	    		return LORAWAN_SEND_SENT;
     	    	case LORAWAN_SEND_STATE_ACKED_WITH_DOWNLINK:
     	    	case LORAWAN_SEND_STATE_ACKED_DOWNLINK_PENDING:
-    	    		if ( rData != NULL && rPort != NULL && rSize != NULL) {
-						*rPort = __lorawan_driver_lastDownlink.port;
-						if ( *rSize >= __lorawan_driver_lastDownlink.size) {
-							*rSize = __lorawan_driver_lastDownlink.size;
-							bcopy(
-								__lorawan_driver_lastDownlink.data,
-								rData,
-								((ITSDK_LORAWAN_MAX_DWNLNKSZ<__lorawan_driver_lastDownlink.size)?ITSDK_LORAWAN_MAX_DWNLNKSZ:__lorawan_driver_lastDownlink.size)
-							);
-						} else {
-							bcopy(
-								__lorawan_driver_lastDownlink.data,
-								rData,
-								*rSize
-							);
-							*rSize = __lorawan_driver_lastDownlink.size;
-						}
+    	    		if ( rData != NULL && rPort != NULL && rSize != NULL && __lorawan_driver_downlinks.syncSlot >= 0 ) {
+    	    			lorawan_driver_downlink_t * d = &__lorawan_driver_downlinks.slot[__lorawan_driver_downlinks.syncSlot];
+						*rPort = d->port;
+						bcopy(d->data,rData,(( *rSize < d->size )?*rSize:d->size));
+						*rSize = d->size;
     	    		} else {
     	    			LOG_WARN_LORAWAN(("[LoRaWan] Receiving downlink but can't return it\r\n"));
     	    		}
+    	    		__lorawan_driver_downlinkUnref(__lorawan_driver_downlinks.syncSlot);
+    	    		__lorawan_driver_downlinks.syncSlot = -1;
     	    		return (__loraWanState.sendState ==LORAWAN_SEND_STATE_ACKED_WITH_DOWNLINK)?LORAWAN_SEND_ACKED_WITH_DOWNLINK:LORAWAN_SEND_ACKED_WITH_DOWNLINK_PENDING;
     	    	case LORAWAN_SEND_STATE_ACKED_NO_DOWNLINK:
     	    		return LORAWAN_SEND_ACKED;
@@ -818,6 +1248,17 @@ uint16_t lorawan_driver_LORA_GetUplinkFrameCounter(){
 	return __loraWanState.upLinkCounter;
 }
 
+/**
+ * Returns the 32b frame counter of the next uplink from the MAC context
+ * (restored from the NVM when persisted)
+ */
+uint32_t lorawan_driver_LORA_GetNextUplinkFrameCounter32(){
+	LOG_INFO_LORAWAN(("lorawan_driver_LORA_GetNextUplinkFrameCounter32\r\n"));
+	uint32_t fCntUp = 0;
+	if ( LoRaMacGetFCntUp( &fCntUp ) != LORAMAC_FCNT_HANDLER_SUCCESS ) return 0;
+	return fCntUp;
+}
+
 /**
  * Returns the last downlink frame counter
  */
@@ -896,6 +1337,200 @@ lorawan_driver_joinState lorawan_driver_LORA_getJoinState(){
 	return __loraWanState.joinState;
 }
 
+/**
+ * Return the max application payload size for the given datarate, once the pending
+ * MAC commands are removed. Returns 0 when no payload can be sent.
+ * The current MAC datarate is not modified.
+ */
+uint8_t lorawan_driver_LORA_GetMaxPayloadSize(uint8_t dataRate) {
+	LOG_DEBUG_LORAWAN(("lorawan_driver_LORA_GetMaxPayloadSize\r\n"));
+    LoRaMacTxInfo_t txInfo;
+    MibRequestConfirm_t get, set;
+    get.Type = MIB_CHANNELS_DATARATE;
+    LoRaMacMibGetRequestConfirm(&get);
+    set.Type = MIB_CHANNELS_DATARATE;
+    set.Param.ChannelsDatarate = __convertDR(dataRate);
+    LoRaMacMibSetRequestConfirm(&set);
+    uint8_t sz = 0;
+    if( LoRaMacQueryTxPossible( 0, &txInfo ) == LORAMAC_STATUS_OK ) sz = txInfo.MaxPossibleApplicationDataSize;
+    LoRaMacMibSetRequestConfirm(&get);
+    return sz;
+}
+
+/**
+ * Spreading factor and bandwidth (kHz) of a LoRa datarate (Semtech format) in the current
+ * region. Returns false for FSK or when the datarate does not exist for uplink.
+ */
+static bool __lorawan_driver_loraModulation(uint8_t dr, uint32_t * sf, uint32_t * bw) {
+	switch ( __loraWanState.region ) {
+	case __LORAWAN_REGION_US915:
+		if ( dr > DR_4 ) return false;
+		*sf = ( dr == DR_4 )?8:10-dr;
+		*bw = ( dr == DR_4 )?500:125;
+		break;
+	case __LORAWAN_REGION_AU915:
+		if ( dr > DR_6 ) return false;
+		*sf = ( dr == DR_6 )?8:12-dr;
+		*bw = ( dr == DR_6 )?500:125;
+		break;
+	default:
+		if ( dr > DR_6 ) return false;
+		*sf = ( dr == DR_6 )?7:12-dr;
+		*bw = ( dr == DR_6 )?250:125;
+		break;
+	}
+	return true;
+}
+
+/**
+ * Time on air in ms of a frame carrying size bytes of application payload.
+ * The symbol duration is returned in tSymUs. Returns 0 when the datarate
+ * (Semtech format) does not exist for uplink in the current region.
+ */
+static uint32_t __lorawan_driver_timeOnAir(uint8_t dr, uint8_t size, uint32_t * tSymUs) {
+	uint32_t sf, bw;
+	uint32_t pl = size + 13;						// MHDR + FHDR + FPort + MIC
+	if ( !__lorawan_driver_loraModulation(dr,&sf,&bw) ) {
+		if ( dr == DR_7 && __loraWanState.region != __LORAWAN_REGION_US915 && __loraWanState.region != __LORAWAN_REGION_AU915 ) {
+			// FSK 50kbps : preamble 5B, sync 3B, length 1B, CRC 2B - 160us per Byte
+			*tSymUs = 160;
+			return ( (pl + 11) * 160 + 999 ) / 1000;
+		}
+		return 0;
+	}
+	uint32_t ts = ((1 << sf) * 1000) / bw;
+	uint32_t de = ( ts >= 16000 )?1:0;				// Low datarate optimization
+	int32_t  num = 8*pl - 4*sf + 28 + 16;			// explicit header, CRC on
+	int32_t  den = 4*(sf - 2*de);
+	uint32_t nb = ( num > 0 )?((num + den - 1)/den):0;
+	uint32_t nsym = 8 + nb*5;						// CR 4/5
+	*tSymUs = ts;
+	return ( (49*ts)/4 + nsym*ts + 999 ) / 1000;	// preamble 8 + 4.25 symbols
+}
+
+/**
+ * Compute the transmission plan of a frame for a given datarate:
+ * earliest transmission delay according to the band and aggregated time-off,
+ * time on air and estimated radio charge (TX + two 8 symbols RX windows).
+ */
+itsdk_lorawan_return_t lorawan_driver_LORA_GetTxPlan(uint8_t dataRate, uint8_t size, itsdk_lorawan_txplan_t * plan) {
+	LOG_DEBUG_LORAWAN(("lorawan_driver_LORA_GetTxPlan\r\n"));
+	uint32_t tSymUs;
+	TimerTime_t delay;
+	uint8_t dr = __convertDR(dataRate);
+
+	plan->dataRate = dataRate;
+	plan->toaMs = __lorawan_driver_timeOnAir(dr,size,&tSymUs);
+	if ( plan->toaMs == 0 ) return LORAWAN_RETURN_FAILED;
+	if ( LoRaMacQueryNextTxDelay(dr,&delay) != LORAMAC_STATUS_OK ) return LORAWAN_RETURN_FAILED;
+	plan->delayMs = delay;
+	plan->maxSize = lorawan_driver_LORA_GetMaxPayloadSize(dataRate);
+	plan->chargeUC = plan->toaMs * ITSDK_LORAWAN_TX_CURRENT + ( 2 * 8 * tSymUs * ITSDK_LORAWAN_RX_CURRENT ) / 1000;
+	return LORAWAN_RETURN_SUCESS;
+}
+
+// =======================================================================================
+// Link quality history
+// =======================================================================================
+
+#if ITSDK_LORAWAN_LINK_HISTORY > 0
+/**
+ * For each datarate, ring of the last uplink outcomes: Rssi/Snr of the Ack or downlink
+ * received after the uplink, or a failure when a confirmed uplink has not been acked.
+ * Unconfirmed uplinks without downlink give no information and are not recorded.
+ */
+static struct {
+	lorawan_driver_linkSample_t	sample[LORAWAN_DRIVER_LINK_DRS][ITSDK_LORAWAN_LINK_HISTORY];
+	uint8_t						wr[LORAWAN_DRIVER_LINK_DRS];
+	uint8_t						count[LORAWAN_DRIVER_LINK_DRS];
+	uint8_t						pendingDr;			// Datarate of the uplink waiting for its downlink (0xFF none)
+} __lorawan_driver_link;
+
+static void __lorawan_driver_linkRecord(uint8_t dr, int16_t rssi, int8_t snr, bool acked) {
+	if ( dr >= LORAWAN_DRIVER_LINK_DRS ) return;
+	lorawan_driver_linkSample_t * e = &__lorawan_driver_link.sample[dr][__lorawan_driver_link.wr[dr]];
+	e->rssi = rssi;
+	e->snr = snr;
+	e->acked = (acked)?1:0;
+	__lorawan_driver_link.wr[dr] = (__lorawan_driver_link.wr[dr] + 1) % ITSDK_LORAWAN_LINK_HISTORY;
+	if ( __lorawan_driver_link.count[dr] < ITSDK_LORAWAN_LINK_HISTORY ) __lorawan_driver_link.count[dr]++;
+}
+
+/**
+ * Uplink done, failure are recorded immediately, success wait for the McpsIndication
+ * following the McpsConfirm to get the Rssi/Snr.
+ */
+static void __lorawan_driver_linkConfirm(McpsConfirm_t *mcpsConfirm) {
+	__lorawan_driver_link.pendingDr = 0xFF;
+	switch ( mcpsConfirm->Status ) {
+	case LORAMAC_EVENT_INFO_STATUS_OK:
+		if ( mcpsConfirm->McpsRequest == MCPS_UNCONFIRMED || mcpsConfirm->AckReceived ) {
+			__lorawan_driver_link.pendingDr = mcpsConfirm->Datarate;
+			return;
+		}
+		break;
+	case LORAMAC_EVENT_INFO_STATUS_RX2_TIMEOUT:
+		break;
+	default:
+		return;
+	}
+	if ( mcpsConfirm->McpsRequest == MCPS_CONFIRMED ) {
+		__lorawan_driver_linkRecord(mcpsConfirm->Datarate,LORAWAN_DRIVER_INVALID_RSSI,0,false);
+	}
+}
+
+static void __lorawan_driver_linkIndication(McpsIndication_t *mcpsIndication) {
+	if ( __lorawan_driver_link.pendingDr == 0xFF ) return;
+	__lorawan_driver_linkRecord(__lorawan_driver_link.pendingDr,mcpsIndication->Rssi,mcpsIndication->Snr,true);
+	__lorawan_driver_link.pendingDr = 0xFF;
+}
+
+/**
+ * Summary of the link history for a datarate. The Snr floor is the demodulation limit of
+ * the spreading factor (-7.5dB at SF7 to -20dB at SF12, rounded toward 0), the margin is
+ * the average Snr above this floor. Returns LORAWAN_RETURN_FAILED when the datarate is not
+ * a LoRa uplink datarate in the current region.
+ */
+itsdk_lorawan_return_t lorawan_driver_LORA_GetLinkStats(uint8_t dataRate, itsdk_lorawan_linkStats_t * stats) {
+	LOG_DEBUG_LORAWAN(("lorawan_driver_LORA_GetLinkStats\r\n"));
+	uint32_t sf, bw;
+	uint8_t dr = __convertDR(dataRate);
+	bzero(stats,sizeof(itsdk_lorawan_linkStats_t));
+	stats->dataRate = dataRate;
+	stats->margin = ITSDK_LORAWAN_LINK_NOMARGIN;
+	if ( dr >= LORAWAN_DRIVER_LINK_DRS || !__lorawan_driver_loraModulation(dr,&sf,&bw) ) return LORAWAN_RETURN_FAILED;
+	stats->snrFloor = - (int8_t)((15 + 5*(sf-7))/2);
+
+	int32_t rssi = 0, snr = 0;
+	stats->snrMin = INT8_MAX;
+	stats->samples = __lorawan_driver_link.count[dr];
+	for ( uint8_t i = 0 ; i < stats->samples ; i++ ) {
+		lorawan_driver_linkSample_t * e = &__lorawan_driver_link.sample[dr][i];
+		if ( !e->acked ) continue;
+		stats->acked++;
+		rssi += e->rssi;
+		snr += e->snr;
+		if ( e->snr < stats->snrMin ) stats->snrMin = e->snr;
+	}
+	if ( stats->acked > 0 ) {
+		stats->rssiAvg = (int16_t)(rssi / stats->acked);
+		stats->snrAvg = (int8_t)(snr / stats->acked);
+		stats->margin = stats->snrAvg - stats->snrFloor;
+	} else {
+		stats->snrMin = 0;
+	}
+	return LORAWAN_RETURN_SUCESS;
+}
+
+/**
+ * Clear the link history
+ */
+void lorawan_driver_LORA_ClearLinkStats() {
+	bzero(&__lorawan_driver_link,sizeof(__lorawan_driver_link));
+	__lorawan_driver_link.pendingDr = 0xFF;
+}
+#endif // ITSDK_LORAWAN_LINK_HISTORY > 0
+
 /**
  * Return the current/last SendState - use to follow the async send procedure
  * if used in polling mode
@@ -905,6 +1540,22 @@ lorawan_driver_sendState lorawan_driver_LORA_getSendState(){
 	return __loraWanState.sendState;
 }
 
+/**
+ * Request the network time, the DeviceTimeReq MAC command is piggybacked on the
+ * next uplink and lorawan_driver_onDeviceTime() is called with the answer
+ */
+itsdk_lorawan_return_t lorawan_driver_LORA_DeviceTimeReq() {
+	LOG_DEBUG_LORAWAN(("lorawan_driver_LORA_DeviceTimeReq\r\n"));
+	MlmeReq_t mlmeReq;
+	mlmeReq.Type = MLME_DEVICE_TIME;
+	LoRaMacStatus_t r = LoRaMacMlmeRequest( &mlmeReq );
+	if ( r != LORAMAC_STATUS_OK ) {
+		LOG_WARN_LORAWAN(("LoRaMacMlmeRequest return error(%d)\r\n",r));
+		return LORAWAN_RETURN_FAILED;
+	}
+	return LORAWAN_RETURN_SUCESS;
+}
+
 
 // =============================================================================================
 // MCPS ( TX & RX Operations ) LAYER
@@ -970,6 +1621,9 @@ static void McpsConfirm( McpsConfirm_t *mcpsConfirm )
 
     __loraWanState.upLinkCounter = mcpsConfirm->UpLinkCounter;
     __loraWanState.lastRetries = mcpsConfirm->NbRetries;
+	#if ITSDK_LORAWAN_LINK_HISTORY > 0
+    __lorawan_driver_linkConfirm(mcpsConfirm);
+	#endif
 
     //implicitely desactivated when VERBOSE_LEVEL < 2
     //TraceUpLinkFrame(mcpsConfirm);
@@ -1038,18 +1692,22 @@ static void McpsIndication( McpsIndication_t *mcpsIndication )
         default:
 
           LOG_INFO_LORAWAN(("### Data received\r\n"));
-          __lorawan_driver_lastDownlink.size = mcpsIndication->BufferSize;
-          __lorawan_driver_lastDownlink.port = mcpsIndication->Port;
-		  bcopy(
-				mcpsIndication->Buffer,
-				__lorawan_driver_lastDownlink.data,
-				((mcpsIndication->BufferSize<=ITSDK_LORAWAN_MAX_DWNLNKSZ)?mcpsIndication->BufferSize:ITSDK_LORAWAN_MAX_DWNLNKSZ)
-          );
-          lorawan_driver_onDataReception(
-        		  mcpsIndication->Port,
-				  mcpsIndication->Buffer,
-				  mcpsIndication->BufferSize
-          );
+          {
+        	  lorawan_driver_downlink_t * d = __lorawan_driver_downlinkStore(
+        			  	  	  	  	  	  	  mcpsIndication->Port,
+											  mcpsIndication->Buffer,
+											  mcpsIndication->BufferSize
+			  	  	  	  	  	  	  	  );
+        	  if ( d != NULL ) {
+        		  int8_t id = __lorawan_driver_downlinkSlot(d->data);
+        		  if ( __lorawan_driver_downlinks.syncWait && __lorawan_driver_downlinks.syncSlot < 0 ) {
+        			  __lorawan_driver_downlinks.refs[id]++;
+        			  __lorawan_driver_downlinks.syncSlot = id;
+        		  }
+        		  lorawan_driver_onDataReception(d->port,d->data,d->size);
+        		  __lorawan_driver_downlinkUnref(id);
+        	  }
+          }
           __loraWanState.sendState = LORAWAN_SEND_STATE_ACKED_WITH_DOWNLINK;
           break;
       }
@@ -1074,6 +1732,9 @@ static void McpsIndication( McpsIndication_t *mcpsIndication )
     __loraWanState.lastRssi = mcpsIndication->Rssi;
     __loraWanState.downlinkCounter = mcpsIndication->DownLinkCounter;
     __loraWanState.lastSnr = mcpsIndication->Snr;
+	#if ITSDK_LORAWAN_LINK_HISTORY > 0
+    __lorawan_driver_linkIndication(mcpsIndication);
+	#endif
 
 }
 
@@ -1098,6 +1759,7 @@ static void MlmeConfirm( MlmeConfirm_t *mlmeConfirm )
               // Status is OK, node has joined the network
               __loraWanState.joinState = LORAWAN_STATE_JOIN_SUCCESS;
               __loraWanState.joinTime = (uint32_t)(itsdk_time_get_ms()/1000);
+              lorawan_driver_onNewSession();
               lorawan_driver_onJoinSuccess();
 
 #ifdef LORAMAC_CLASSB_ENABLED
@@ -1174,16 +1836,25 @@ static void MlmeConfirm( MlmeConfirm_t *mlmeConfirm )
             }
             break;
         }
-#if defined( USE_DEVICE_TIMING )
+#endif /* LORAMAC_CLASSB_ENABLED */
         case MLME_DEVICE_TIME:
         {
-            if( mlmeConfirm->Status != LORAMAC_EVENT_INFO_STATUS_OK )
+            if( mlmeConfirm->Status == LORAMAC_EVENT_INFO_STATUS_OK )
+            {
+              // The MAC has applied the network time as SysTime offset, the SysTime
+              // is the GPS time shifted by UNIX_GPS_EPOCH_OFFSET, without leap seconds
+              SysTime_t t = SysTimeGet();
+              lorawan_driver_onDeviceTime(true, itsdk_time_gps2Epoc_s(t.Seconds - UNIX_GPS_EPOCH_OFFSET), (uint16_t)t.SubSeconds);
+            }
+            else
             {
+              lorawan_driver_onDeviceTime(false, 0, 0);
+#if defined( LORAMAC_CLASSB_ENABLED ) && defined( USE_DEVICE_TIMING )
               LORA_DeviceTimeReq();
+#endif
             }
+            break;
         }
-#endif /* USE_DEVICE_TIMING */
-#endif /* LORAMAC_CLASSB_ENABLED */
         default:
             break;
     }
@@ -27,6 +27,7 @@ Maintainer: Miguel Luis ( Semtech ), Gregory Cristian ( Semtech ),
 #include <drivers/lorawan/crypto/aes.h>
 #include <drivers/lorawan/crypto/cmac.h>
 #include <drivers/lorawan/phy/radio.h>
+#include <it_sdk/random/random.h>
 
 #define NUM_OF_KEYS      22
 #define KEY_SIZE         16
@@ -363,6 +364,6 @@ SecureElementStatus_t SecureElementRandomNumber( uint32_t* randomNum )
     {
         return SECURE_ELEMENT_ERROR_NPE;
     }
-    *randomNum = Radio.Random( );
+    *randomNum = itsdk_random_getU32( );
     return SECURE_ELEMENT_SUCCESS;
 }
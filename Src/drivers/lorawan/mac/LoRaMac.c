@@ -816,10 +816,31 @@ struct
     int8_t Snr;
 }RxDoneParams;
 
+/*!
+ * \brief Time of the radio event, the radio driver can report it later than
+ *        the DIO edge when its interrupts are processed from the main loop
+ */
+static TimerTime_t GetRadioIrqTime( void )
+{
+    if( Radio.GetIrqTime != NULL )
+    {
+        return Radio.GetIrqTime( );
+    }
+    return TimerGetCurrentTime( );
+}
+
+/*!
+ * \brief Reduce a delay counted from the TxDone edge by the time already elapsed
+ */
+static uint32_t GetTxDoneDelay( uint32_t delay, TimerTime_t elapsed )
+{
+    return ( delay > elapsed + 1 ) ? delay - elapsed : 1;
+}
+
 static void OnRadioTxDone( void )
 {
-    TxDoneParams.CurTime = TimerGetCurrentTime( );
-    uint64_t tm = itsdk_time_get_ms();
+    TxDoneParams.CurTime = GetRadioIrqTime( );
+    uint64_t tm = itsdk_time_get_ms() - TimerGetElapsedTime( TxDoneParams.CurTime );
     MacCtx.LastTxSysTime.Seconds = tm/1000;
     MacCtx.LastTxSysTime.SubSeconds = tm % 1000;
 
@@ -836,7 +857,7 @@ static void OnRadioTxDone( void )
 
 static void OnRadioRxDone( uint8_t *payload, uint16_t size, int16_t rssi, int8_t snr )
 {
-    RxDoneParams.LastRxDone = TimerGetCurrentTime( );
+    RxDoneParams.LastRxDone = GetRadioIrqTime( );
     RxDoneParams.Payload = payload;
     RxDoneParams.Size = size;
     RxDoneParams.Rssi = rssi;
@@ -904,15 +925,17 @@ static void ProcessRadioTxDone( void )
         OpenContinuousRx2Window( );
     }
 
-    // Setup timers
-    TimerSetValue( &MacCtx.RxWindowTimer1, MacCtx.RxWindow1Delay );
+    // Setup timers, the windows are relative to the TxDone edge, remove the
+    // irq and processing latency already spent
+    TimerTime_t elapsed = TimerGetElapsedTime( TxDoneParams.CurTime );
+    TimerSetValue( &MacCtx.RxWindowTimer1, GetTxDoneDelay( MacCtx.RxWindow1Delay, elapsed ) );
     TimerStart( &MacCtx.RxWindowTimer1 );
     if( MacCtx.NvmCtx->DeviceClass != CLASS_C )
     {
 		#ifdef ITSDK_LORAWAN_RX2DELAY_MOD
-        TimerSetValue( &MacCtx.RxWindowTimer2, MacCtx.RxWindow2Delay + ITSDK_LORAWAN_RX2DELAY_MOD );
+        TimerSetValue( &MacCtx.RxWindowTimer2, GetTxDoneDelay( MacCtx.RxWindow2Delay + ITSDK_LORAWAN_RX2DELAY_MOD, elapsed ) );
 		#else
-        TimerSetValue( &MacCtx.RxWindowTimer2, MacCtx.RxWindow2Delay );
+        TimerSetValue( &MacCtx.RxWindowTimer2, GetTxDoneDelay( MacCtx.RxWindow2Delay, elapsed ) );
 		#endif
         TimerStart( &MacCtx.RxWindowTimer2 );
     }
@@ -920,7 +943,7 @@ static void ProcessRadioTxDone( void )
     {
         getPhy.Attribute = PHY_ACK_TIMEOUT;
         phyParam = RegionGetPhyParam( MacCtx.NvmCtx->Region, &getPhy );
-        TimerSetValue( &MacCtx.AckTimeoutTimer, MacCtx.RxWindow2Delay + phyParam.Value );
+        TimerSetValue( &MacCtx.AckTimeoutTimer, GetTxDoneDelay( MacCtx.RxWindow2Delay + phyParam.Value, elapsed ) );
         TimerStart( &MacCtx.AckTimeoutTimer );
     }
 
@@ -2183,6 +2206,10 @@ static void ProcessMacCommands( uint8_t *payload, uint8_t macIndex, uint8_t comm
                 // Apply the new system time.
                 SysTimeSet( sysTime );
                 LoRaMacClassBDeviceTimeAns( );
+                if( LoRaMacConfirmQueueIsCmdActive( MLME_DEVICE_TIME ) == true )
+                {
+                    LoRaMacConfirmQueueSetStatus( LORAMAC_EVENT_INFO_STATUS_OK, MLME_DEVICE_TIME );
+                }
                 break;
             }
             case SRV_MAC_PING_SLOT_INFO_ANS:
@@ -3391,6 +3418,43 @@ LoRaMacStatus_t LoRaMacQueryTxPossible( uint8_t size, LoRaMacTxInfo_t* txInfo )
     }
 }
 
+LoRaMacStatus_t LoRaMacQueryNextTxDelay( int8_t datarate, TimerTime_t* delay )
+{
+    NextChanParams_t nextChan;
+    TimerTime_t aggregatedTimeOff = 0;
+    uint8_t channel = 0;
+    LoRaMacStatus_t status;
+
+    if( delay == NULL )
+    {
+        return LORAMAC_STATUS_PARAMETER_INVALID;
+    }
+    *delay = 0;
+
+    // Same back-off computation as ScheduleTx, the selected channel is dropped
+    CalculateBackOff( MacCtx.NvmCtx->LastTxChannel );
+
+    nextChan.AggrTimeOff = MacCtx.AggregatedTimeOff;
+    nextChan.Datarate = datarate;
+    nextChan.DutyCycleEnabled = MacCtx.NvmCtx->DutyCycleOn;
+    if( MacCtx.NvmCtx->NetworkActivation == ACTIVATION_TYPE_NONE )
+    {
+        nextChan.Joined = false;
+    }
+    else
+    {
+        nextChan.Joined = true;
+    }
+    nextChan.LastAggrTx = MacCtx.AggregatedLastTxDoneTime;
+
+    status = RegionNextChannel( MacCtx.NvmCtx->Region, &nextChan, &channel, delay, &aggregatedTimeOff );
+    if( status == LORAMAC_STATUS_DUTYCYCLE_RESTRICTED )
+    {
+        return LORAMAC_STATUS_OK;
+    }
+    return status;
+}
+
 LoRaMacStatus_t LoRaMacMibGetRequestConfirm( MibRequestConfirm_t* mibGet )
 {
     LoRaMacStatus_t status = LORAMAC_STATUS_OK;
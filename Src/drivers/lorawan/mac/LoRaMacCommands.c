@@ -32,43 +32,44 @@ Maintainer: Miguel Luis ( Semtech ), Daniel Jaeckle ( STACKFORCE ), Johannes Bru
  */
 #define CID_FIELD_SIZE  1
 
-/*
- * List of all stick MAC command answers which will be deleted after a receiving downlink
- */
-const uint8_t CIDsStickyAnsCmds[] = { MOTE_MAC_DL_CHANNEL_ANS, MOTE_MAC_RX_PARAM_SETUP_ANS, MOTE_MAC_RX_TIMING_SETUP_ANS };
+#if NUM_OF_MAC_COMMANDS > 16
+#error "NUM_OF_MAC_COMMANDS must fit the 16 bits slot bitmaps"
+#endif
 
 /*
- *  Mac Commands list structure
+ * LoRaMac Commands Context structure
+ *
+ * The MAC commands are stored in fixed slots allocated from a bitmap, the
+ * order they have been added is kept in an index array. The serialized size
+ * and the sticky commands are maintained on add / remove so the queries
+ * don't need to walk the commands.
  */
-typedef struct sMacCommandsList
+typedef struct sLoRaMacCommandsCtx
 {
     /*
-     * First element of MAC command list.
+     * Buffer to store MAC command elements
      */
-    MacCommand_t* First;
+    MacCommand_t MacCommandSlots[NUM_OF_MAC_COMMANDS];
     /*
-     * Last element of MAC command list.
+     * Slot index of the MAC commands in the order they have been added
      */
-    MacCommand_t* Last;
-} MacCommandsList_t;
-
-/*
- * LoRaMac Commands Context structure
- */
-typedef struct sLoRaMacCommandsCtx
-{
+    uint8_t Order[NUM_OF_MAC_COMMANDS];
     /*
-     * List of MAC command elements
+     * Number of MAC commands
      */
-    MacCommandsList_t MacCommandList;
+    uint8_t NumOfCmds;
     /*
-     * Buffer to store MAC command elements
+     * Size of all MAC commands serialized as buffer
      */
-    MacCommand_t MacCommandSlots[NUM_OF_MAC_COMMANDS];
+    uint8_t SerializedCmdsSize;
     /*
-     * Size of all MAC commands serialized as buffer
+     * Bitmap of the used slots
      */
-    size_t SerializedCmdsSize;
+    uint16_t UsedSlots;
+    /*
+     * Bitmap of the slots holding a sticky MAC command
+     */
+    uint16_t StickySlots;
 } LoRaMacCommandsCtx_t;
 
 /*
@@ -81,203 +82,9 @@ static EventNvmCtxChanged CommandsNvmCtxChanged;
  */
 static LoRaMacCommandsCtx_t NvmCtx;
 
-/* Memory management functions */
-
-/*
- * \brief Determines if a MAC command slot is free
- *
- * \param[IN]     slot           - Slot to check
- * \retval                       - Status of the operation
- */
-bool isSlotFree( const MacCommand_t* slot )
-{
-    uint8_t* mem = (uint8_t*) slot;
-
-    for( uint16_t size = 0; size < sizeof( MacCommand_t ); size++ )
-    {
-        if( mem[size] != 0x00 )
-        {
-            return false;
-        }
-    }
-    return true;
-}
-
-/*
- * \brief Allocates a new MAC command memory slot
- *
- * \retval                       - Pointer to slot
- */
-MacCommand_t* mallocNewMacCommandSlot( )
-{
-    uint8_t itr = 0;
-
-    while( isSlotFree( ( const MacCommand_t* ) &NvmCtx.MacCommandSlots[itr]) == false )
-    {
-        itr++;
-        if( itr == NUM_OF_MAC_COMMANDS )
-        {
-            return 0;
-        }
-    }
-
-    return &NvmCtx.MacCommandSlots[itr];
-}
-
-
-/*
- * \brief Free memory slot
- *
- * \param[IN]     slot           - Slot to free
- *
- * \retval                       - Status of the operation
- */
-bool freeMacCommandSlot( MacCommand_t* slot )
-{
-    if( slot == 0 )
-    {
-        return false;
-    }
-
-    memset1( (uint8_t*) slot, 0x00, sizeof( MacCommand_t ));
-
-    return true;
-}
-
-
-/* Linked list functions */
-
-/*
- * \brief Initialize list
- *
- * \param[IN]     list           - List that shall be initialized
- * \retval                       - Status of the operation
- */
-static bool linkedListInit( MacCommandsList_t* list )
-{
-    if( list == 0 )
-    {
-        return false;
-    }
-
-    list->First = 0;
-    list->Last = 0;
-
-    return true;
-}
-
-/*
- * \brief Add an element to the list
- *
- * \param[IN]     list           - List where the element shall be added.
- * \param[IN]     element        - Element to add
- * \retval                       - Status of the operation
- */
-static bool linkedListAdd( MacCommandsList_t* list, MacCommand_t* element )
-{
-    if( ( list == 0 ) && ( element == 0 ) )
-    {
-        return false;
-    }
-
-    /* Check if this is the first entry to enter the list. */
-    if( list->First == 0 )
-    {
-        list->First = element;
-    }
-
-    /* Check if the last entry exists and update its next point. */
-    if( list->Last )
-    {
-        list->Last->Next = element;
-    }
-
-    /* Update the next point of this entry. */
-    element->Next = 0;
-
-    /* Update the last entry of the list. */
-    list->Last = element;
-
-    return true;
-}
-
-/*
- * \brief Return the previous element in the list.
- *
- * \param[IN]     list           - List
- * \param[IN]     element        - Element where the previous element shall be searched
- * \retval                       - Status of the operation
- */
-static MacCommand_t* linkedListGetPrevious( MacCommandsList_t* list, MacCommand_t* element )
-{
-    if( ( list == 0 ) && ( element == 0 ) )
-    {
-        return NULL;
-    }
-
-    MacCommand_t* curElement;
-
-    // Start at the head of the list
-    curElement = list->First;
-
-    /*
-     * When current element is the first of the list, there's no previous element so we can return NULL immediately.
-     */
-    if( element != curElement)
-    {
-
-        // Loop through all elements until the end is reached or the next of current is the current element.
-        while(curElement && (curElement->Next != element))
-        {
-            curElement = curElement->Next;
-        }
-    }
-    else
-    {
-        curElement = NULL;
-    }
-
-    return curElement;
-}
-
-/*
- * \brief Remove an element from the list
- *
- * \param[IN]     list           - List where the element shall be removed from.
- * \param[IN]     element        - Element to remove
- * \retval                       - Status of the operation
- */
-static bool linkedListRemove( MacCommandsList_t* list, MacCommand_t* element )
-{
-    if( ( list == 0 ) && ( element == 0 ) )
-    {
-        return false;
-    }
-
-    MacCommand_t* PrevElement = linkedListGetPrevious( list, element );
-
-    if( list->First == element )
-    {
-        list->First = element->Next;
-    }
-
-    if( list->Last == element )
-    {
-        list->Last = PrevElement;
-    }
-
-    if( PrevElement )
-    {
-        PrevElement->Next = element->Next;
-    }
-
-    element->Next = 0;
-
-    return true;
-}
-
 /*
  * \brief Determines if a MAC command is sticky or not
+ *        The sticky MAC commands are the answers removed after receiving a downlink
  *
  * \param[IN]   cid                - MAC command identifier
  *
@@ -307,14 +114,45 @@ static void NvmCtxCallback( void )
     }
 }
 
+/*
+ * \brief Remove the MAC commands of the given slots, keeping the order of the others
+ *
+ * \param[IN]   slots              - Bitmap of the slots to free
+ */
+static void RemoveSlots( uint16_t slots )
+{
+    uint8_t kept = 0;
+
+    slots &= NvmCtx.UsedSlots;
+    if( slots == 0 )
+    {
+        return;
+    }
+    for( uint8_t i = 0; i < NvmCtx.NumOfCmds; i++ )
+    {
+        uint8_t slot = NvmCtx.Order[i];
+        if( ( slots & ( 1 << slot ) ) != 0 )
+        {
+            NvmCtx.SerializedCmdsSize -= ( CID_FIELD_SIZE + NvmCtx.MacCommandSlots[slot].PayloadSize );
+        }
+        else
+        {
+            NvmCtx.Order[kept++] = slot;
+        }
+    }
+    NvmCtx.NumOfCmds = kept;
+    NvmCtx.UsedSlots &= ~slots;
+    NvmCtx.StickySlots &= ~slots;
+
+    NvmCtxCallback( );
+}
+
 LoRaMacCommandStatus_t LoRaMacCommandsInit( EventNvmCtxChanged commandsNvmCtxChanged )
 {
 
     // Initialize with default
     memset1( (uint8_t*)&NvmCtx, 0, sizeof( NvmCtx ) );
 
-    linkedListInit( &NvmCtx.MacCommandList );
-
     // Assign callback
     CommandsNvmCtxChanged = commandsNvmCtxChanged;
 
@@ -347,28 +185,31 @@ LoRaMacCommandStatus_t LoRaMacCommandsAddCmd( uint8_t cid,  uint8_t* payload, si
     {
         return LORAMAC_COMMANDS_ERROR_NPE;
     }
-    MacCommand_t* newCmd;
-
-    // Allocate a memory slot
-    newCmd = mallocNewMacCommandSlot( );
-
-    if( newCmd == 0 )
+    if( payloadSize > LORAMAC_COMMADS_MAX_NUM_OF_PARAMS )
     {
-        return LORAMAC_COMMANDS_ERROR_MEMORY;
+        return LORAMAC_COMMANDS_ERROR;
     }
 
-    // Add it to the list of Mac commands
-    if( linkedListAdd( &NvmCtx.MacCommandList, newCmd ) == false )
+    // Allocate the first free slot
+    uint16_t freeSlots = ~NvmCtx.UsedSlots & ( ( 1 << NUM_OF_MAC_COMMANDS ) - 1 );
+    if( freeSlots == 0 )
     {
-        return LORAMAC_COMMANDS_ERROR;
+        return LORAMAC_COMMANDS_ERROR_MEMORY;
     }
+    uint8_t slot = __builtin_ctz( freeSlots );
+    MacCommand_t* newCmd = &NvmCtx.MacCommandSlots[slot];
 
     // Set Values
     newCmd->CID = cid;
     newCmd->PayloadSize = payloadSize;
     memcpy1( ( uint8_t* ) newCmd->Payload, payload, payloadSize );
-    newCmd->IsSticky = IsSticky( cid );
 
+    NvmCtx.UsedSlots |= ( 1 << slot );
+    if( IsSticky( cid ) == true )
+    {
+        NvmCtx.StickySlots |= ( 1 << slot );
+    }
+    NvmCtx.Order[NvmCtx.NumOfCmds++] = slot;
     NvmCtx.SerializedCmdsSize += ( CID_FIELD_SIZE + payloadSize );
 
     NvmCtxCallback( );
@@ -382,105 +223,47 @@ LoRaMacCommandStatus_t LoRaMacCommandsRemoveCmd( MacCommand_t* macCmd )
     {
         return LORAMAC_COMMANDS_ERROR_NPE;
     }
-
-    // Remove the Mac command element from MacCommandList
-    if( linkedListRemove( &NvmCtx.MacCommandList, macCmd ) == false )
+    if( ( macCmd < NvmCtx.MacCommandSlots ) || ( macCmd >= &NvmCtx.MacCommandSlots[NUM_OF_MAC_COMMANDS] ) )
     {
         return LORAMAC_COMMANDS_ERROR_CMD_NOT_FOUND;
     }
-
-    NvmCtx.SerializedCmdsSize -= ( CID_FIELD_SIZE + macCmd->PayloadSize );
-
-    // Free the MacCommand Slot
-    if( freeMacCommandSlot( macCmd ) == false )
+    uint16_t slot = 1 << ( macCmd - NvmCtx.MacCommandSlots );
+    if( ( NvmCtx.UsedSlots & slot ) == 0 )
     {
-        return LORAMAC_COMMANDS_ERROR;
+        return LORAMAC_COMMANDS_ERROR_CMD_NOT_FOUND;
     }
 
-    NvmCtxCallback( );
+    RemoveSlots( slot );
 
     return LORAMAC_COMMANDS_SUCCESS;
 }
 
 LoRaMacCommandStatus_t LoRaMacCommandsGetCmd( uint8_t cid, MacCommand_t** macCmd )
 {
-    MacCommand_t* curElement;
-
-    // Start at the head of the list
-    curElement = NvmCtx.MacCommandList.First;
-
-    // Loop through all elements until we find the element with the given CID
-    while(curElement && ( curElement->CID != cid ) )
+    // Loop through the commands in order until we find the element with the given CID
+    for( uint8_t i = 0; i < NvmCtx.NumOfCmds; i++ )
     {
-        curElement = curElement->Next;
-    }
-
-    // Handle error in case if we reached the end without finding it.
-    if( curElement == NULL )
-    {
-        return LORAMAC_COMMANDS_ERROR_CMD_NOT_FOUND;
+        if( NvmCtx.MacCommandSlots[NvmCtx.Order[i]].CID == cid )
+        {
+            *macCmd = &NvmCtx.MacCommandSlots[NvmCtx.Order[i]];
+            return LORAMAC_COMMANDS_SUCCESS;
+        }
     }
 
-    *macCmd = curElement;
-
-    return LORAMAC_COMMANDS_SUCCESS;
+    return LORAMAC_COMMANDS_ERROR_CMD_NOT_FOUND;
 }
 
 LoRaMacCommandStatus_t LoRaMacCommandsRemoveNoneStickyCmds( void )
 {
-    MacCommand_t* curElement;
-    MacCommand_t* nexElement;
-
-    // Start at the head of the list
-    curElement = NvmCtx.MacCommandList.First;
-
-    // Loop through all elements
-    while( curElement )
-    {
-        if( curElement->IsSticky == false )
-        {
-            nexElement = curElement->Next;
-            LoRaMacCommandsRemoveCmd( curElement );
-            curElement = nexElement;
-        }
-        else
-        {
-            curElement = curElement->Next;
-        }
-    }
-
-    NvmCtxCallback( );
+    RemoveSlots( NvmCtx.UsedSlots & ~NvmCtx.StickySlots );
 
     return LORAMAC_COMMANDS_SUCCESS;
 }
 
 LoRaMacCommandStatus_t LoRaMacCommandsRemoveStickyAnsCmds( void )
 {
-    MacCommand_t* curElement;
-    MacCommand_t* nexElement;
-
-    // Start at the head of the list
-    curElement = NvmCtx.MacCommandList.First;
-
-    // Loop through all elements
-    while( curElement != NULL )
-    {
-        nexElement = curElement->Next;
-        if( curElement->IsSticky == true )
-        {
-            for( uint8_t i = 0; i < sizeof( CIDsStickyAnsCmds ); i++)
-            {
-                if( curElement->CID == CIDsStickyAnsCmds[i] )
-                {
-                    LoRaMacCommandsRemoveCmd( curElement );
-                    break;
-                }
-            }
-        }
-        curElement = nexElement;
-    }
-
-    NvmCtxCallback( );
+    // All the sticky MAC commands are answers
+    RemoveSlots( NvmCtx.StickySlots );
 
     return LORAMAC_COMMANDS_SUCCESS;
 }
@@ -502,26 +285,21 @@ LoRaMacCommandStatus_t LoRaMacCommandsSerializeCmds( size_t availableSize, size_
     {
         return LORAMAC_COMMANDS_ERROR_NPE;
     }
-    MacCommand_t* curElement;
-    curElement = NvmCtx.MacCommandList.First;
     uint8_t itr = 0;
 
-    // Loop through all elements
-    while( curElement )
+    // Copy the commands in order, as long as the next one fits into the buffer
+    for( uint8_t i = 0; i < NvmCtx.NumOfCmds; i++ )
     {
-        // If the next MAC command still fits into the buffer, add it.
-        if( ( availableSize - itr ) >= ( CID_FIELD_SIZE + curElement->PayloadSize ) )
-        {
-            buffer[itr++] = curElement->CID;
-            memcpy1( &buffer[itr], curElement->Payload, curElement->PayloadSize );
-            itr = itr + curElement->PayloadSize;
-        }
-        else
+        MacCommand_t* cmd = &NvmCtx.MacCommandSlots[NvmCtx.Order[i]];
+        if( ( availableSize - itr ) < ( CID_FIELD_SIZE + cmd->PayloadSize ) )
         {
             break;
         }
-        curElement = curElement->Next;
+        buffer[itr++] = cmd->CID;
+        memcpy1( &buffer[itr], cmd->Payload, cmd->PayloadSize );
+        itr = itr + cmd->PayloadSize;
     }
+    *effectiveSize = itr;
 
     return LORAMAC_COMMANDS_SUCCESS;
 }
@@ -532,22 +310,7 @@ LoRaMacCommandStatus_t LoRaMacCommandsStickyCmdsPending( bool* cmdsPending )
     {
         return LORAMAC_COMMANDS_ERROR_NPE;
     }
-    MacCommand_t* curElement;
-    curElement = NvmCtx.MacCommandList.First;
-
-    *cmdsPending = false;
-
-    // Loop through all elements
-    while( curElement )
-    {
-        if( curElement->IsSticky == true )
-        {
-            // Found one sticky MAC command
-            *cmdsPending = true;
-            return LORAMAC_COMMANDS_SUCCESS;
-        }
-        curElement = curElement->Next;
-    }
+    *cmdsPending = ( NvmCtx.StickySlots != 0 );
 
     return LORAMAC_COMMANDS_SUCCESS;
 }
@@ -104,13 +104,20 @@ SysTime_t SysTimeSub( SysTime_t a, SysTime_t b )
 }
 
 
+/*
+ * The system time (itsdk_time) is a monotonic time since reset used by the timers,
+ * the network time (DeviceTimeAns, ClassB beacons) is kept as an offset on it
+ * like the original implementation did with the RTC backup registers.
+ */
+static int64_t __sysTimeOffset_ms = 0;
+
 void SysTimeSet( SysTime_t sysTime )
 {
 
-	uint64_t t = sysTime.Seconds;
+	int64_t t = sysTime.Seconds;
 	t *= 1000;
 	t += sysTime.SubSeconds;
-    itsdk_time_set_ms(t);
+	__sysTimeOffset_ms = t - (int64_t)itsdk_time_get_ms();
 
 	/*
     SysTime_t DeltaTime;
@@ -131,7 +138,7 @@ SysTime_t SysTimeGet( void )
 {
 
     SysTime_t sysTime = { .Seconds = 0, .SubSeconds = 0 };
-	uint64_t t = itsdk_time_get_ms();
+	uint64_t t = (uint64_t)((int64_t)itsdk_time_get_ms() + __sysTimeOffset_ms);
 	sysTime.Seconds = t / 1000;
 	sysTime.SubSeconds = t - (sysTime.Seconds*1000);
 
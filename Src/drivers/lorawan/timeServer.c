@@ -42,46 +42,27 @@ Maintainer: Miguel Luis, Gregory Cristian and Wael Guibene
 
 /*!
  * Timers list head pointer
+ * The running timers are kept in a list sorted by deadline, the head is the next
+ * timer to expire. A single it_sdk soft timer is armed on the head deadline.
  */
 static TimerEvent_t *TimerListHead = NULL;
 
 /*!
- * \brief Adds or replace the head timer of the list.
+ * \brief Inserts a timer in the list according to its deadline
  *
  * \remark The list is automatically sorted. The list head always contains the
- *         next timer to expire.
- *
- * \param [IN]  obj Timer object to be become the new head
- * \param [IN]  remainingTime Remaining time of the previous head to be replaced
- */
-//static void TimerInsertNewHeadTimer( TimerEvent_t *obj );
-
-/*!
- * \brief Adds a timer to the list.
- *
- * \remark The list is automatically sorted. The list head always contains the
- *         next timer to expire.
+ *         next timer to expire. Timers with the same deadline are kept in start order.
  *
  * \param [IN]  obj Timer object to be added to the list
- * \param [IN]  remainingTime Remaining time of the running head after which the object may be added
  */
 static void TimerInsertTimer( TimerEvent_t *obj );
 
 /*!
- * \brief Sets a timeout with the duration "timestamp"
- *
- * \param [IN] timestamp Delay duration
+ * \brief Arms the it_sdk soft timer on the head deadline
  */
-//static void TimerSetTimeout( TimerEvent_t *obj );
-
-/*!
- * \brief Check if the Object to be added is not already in the list
- *
- * \param [IN] timestamp Delay duration
- * \retval true (the object is already in the list) or false
- */
-static bool TimerExists( TimerEvent_t *obj );
+static void TimerSetTimeout( void );
 
+static void TimerCallback( uint32_t value );
 
 
 /** ***********************************************************************
@@ -89,65 +70,88 @@ static bool TimerExists( TimerEvent_t *obj );
  */
 
 /**
- * Remove a element from the list
+ * Remove a element from the list - O(1) with the Prev link
  */
 static void removeFromList( TimerEvent_t *obj ) {
-	if( TimerListHead == obj ) {
-		TimerListHead = TimerListHead->Next;
+	if ( obj->Prev != NULL ) {
+		obj->Prev->Next = obj->Next;
 	} else {
-		TimerEvent_t* cur = TimerListHead;
-		while( cur != NULL ) {
-		   if( cur->Next == obj ) {
-			   cur->Next = obj->Next;
-			   break;
-		   }
-		   cur = cur->Next;
-		}
+		TimerListHead = obj->Next;
 	}
+	if ( obj->Next != NULL ) {
+		obj->Next->Prev = obj->Prev;
+	}
+	obj->Next = NULL;
+	obj->Prev = NULL;
 }
 
 /**
- * Check if the Object to be added is not already in the list
+ * Insert the timer at its deadline position, deadlines are compared with
+ * a signed difference to support the 32b time wrap.
  */
-static bool TimerExists( TimerEvent_t *obj )
+static void TimerInsertTimer( TimerEvent_t *obj)
 {
-  TimerEvent_t* cur = TimerListHead;
-
-  while( cur != NULL ) {
-    if( cur == obj ) {
-      return true;
-    }
-    cur = cur->Next;
-  }
-  return false;
-
+	TimerEvent_t* prev = NULL;
+	TimerEvent_t* cur = TimerListHead;
+	while ( cur != NULL && (int32_t)(cur->Timestamp - obj->Timestamp) <= 0 ) {
+		prev = cur;
+		cur = cur->Next;
+	}
+	obj->Prev = prev;
+	obj->Next = cur;
+	if ( cur != NULL ) cur->Prev = obj;
+	if ( prev != NULL ) {
+		prev->Next = obj;
+	} else {
+		TimerListHead = obj;
+	}
 }
 
 /**
- * Insert the timer, as we manage it with no order, just put it on the head
+ * Arm the soft timer on the head deadline, the previous one is cancelled
  */
-static void TimerInsertTimer( TimerEvent_t *obj)
+static void TimerSetTimeout( void )
 {
-	obj->Next = TimerListHead;
-	TimerListHead = obj;
-}
+	itsdk_stimer_stop(TimerCallback,0);
+	if ( TimerListHead == NULL ) return;
+	TimerListHead->IsNext2Expire = true;
 
+	int32_t remaining = (int32_t)(TimerListHead->Timestamp - TimerGetCurrentTime());
+	itsdk_timer_return_t ret = itsdk_stimer_register(
+									( remaining > 0 )?(uint32_t)remaining:0,
+									TimerCallback,
+									0,
+									TIMER_ACCEPT_LOWPOWER
+		 	 	 	 	 	   );
+	if ( ret != TIMER_INIT_SUCCESS ) {
+		ITSDK_ERROR_REPORT(ITSDK_ERROR_LORAWAN_TIME_INITFLD,(uint16_t)ret);
+	}
+}
 
 
 /** *********************************************************************************
- * This is the callback used for all the timer, it calls the callback function
+ * This is the soft timer callback, it fires all the expired timers from the head
+ * of the list then re-arms the soft timer on the next deadline.
  */
 static void TimerCallback( uint32_t value ) {
 
-	TimerEvent_t *obj = (TimerEvent_t *)value;
-	LOG_DEBUG_LORAWAN(("TimerCallback (%d)\r\n",obj->ReloadValue));
-	obj->IsStarted = false;
-	if (obj->Callback != NULL) {
-		obj->Callback(obj->Context);
-	} else {
-		ITSDK_ERROR_REPORT(ITSDK_ERROR_LORAWAN_TIME_NOCALLBACK,0);
+	TimerTime_t now = TimerGetCurrentTime();
+	itsdk_enterCriticalSection();
+	while ( TimerListHead != NULL && (int32_t)(TimerListHead->Timestamp - now) <= 0 ) {
+		TimerEvent_t *obj = TimerListHead;
+		removeFromList(obj);
+		obj->IsStarted = false;
+		itsdk_leaveCriticalSection();
+		LOG_DEBUG_LORAWAN(("TimerCallback (%d)\r\n",obj->ReloadValue));
+		if (obj->Callback != NULL) {
+			obj->Callback(obj->Context);
+		} else {
+			ITSDK_ERROR_REPORT(ITSDK_ERROR_LORAWAN_TIME_NOCALLBACK,0);
+		}
+		itsdk_enterCriticalSection();
 	}
-	removeFromList(obj);
+	TimerSetTimeout();
+	itsdk_leaveCriticalSection();
 }
 
 /** ***********************************************************************************
@@ -165,14 +169,13 @@ void TimerInit( TimerEvent_t *obj, void ( *callback )( void *context ) )
   obj->Callback = callback;
   obj->Context = NULL;
   obj->Next = NULL;
+  obj->Prev = NULL;
 }
 
 
 
 /**
  * This is changing the parameter pass to the callback function at timer expiration
- * Here we search the itsdk timer structure based on previous context value then we
- * change it. Both structure are kept up-to-date.
  */
 void TimerSetContext( TimerEvent_t *obj, void* context )
 {
@@ -182,35 +185,24 @@ void TimerSetContext( TimerEvent_t *obj, void* context )
 
 /**
  * This is changing the duration of the timer. The value is given in ms.
- * We search for the itsdk timer structure and update it when running.
- * If not running the timestamp field will keep the value in ms.
+ * When the timer is running, it is restarted with the new duration.
  */
 void TimerSetValue( TimerEvent_t *obj, uint32_t value )
 {
 	LOG_DEBUG_LORAWAN(("TimerSetValue %d\r\n",value));
-	// search the real timer based on the context
-	itsdk_stimer_slot_t * t = itsdk_stimer_get(TimerCallback,(uint32_t)obj);
-	if ( t != NULL ) {
-		// best is to stop the timer and restart it with the new duration
+	if ( obj->IsStarted ) {
 		TimerStop(obj);
-		obj->Timestamp = value;
 		obj->ReloadValue = value;
 		TimerStart(obj);
 	} else {
-		// the timer is not running, so we just need to update the local structure
-		obj->Timestamp = value;
 		obj->ReloadValue = value;
 	}
 }
 
-/**
- * Sets a timeout with the duration "timestamp"
- * Assuming this is just called internally for setting up the RTC Alarm on next event
- */
-
 
 /**
- * Add a Timer in the list and start it using the it_sdk timer module
+ * Add a Timer in the list, the deadline is computed from the current time.
+ * The soft timer is only re-armed when the new timer becomes the head.
  */
 void TimerStart( TimerEvent_t *obj )
 {
@@ -218,30 +210,18 @@ void TimerStart( TimerEvent_t *obj )
 
 	itsdk_enterCriticalSection();
 	// do not add a timer already existing
-	if( ( obj == NULL ) || ( TimerExists( obj ) == true ) ) {
+	if( ( obj == NULL ) || obj->IsStarted ) {
 		itsdk_leaveCriticalSection();
 		ITSDK_ERROR_REPORT(ITSDK_ERROR_STIMER_ALREADY_SET,0);
 	    return;
 	}
-	obj->Timestamp = obj->ReloadValue;
+	obj->Timestamp = TimerGetCurrentTime() + obj->ReloadValue;
 	obj->IsStarted = true;
+	TimerInsertTimer( obj );
 	obj->IsNext2Expire = false;
-
-	if( TimerListHead == NULL ) {
-		obj->Next = NULL;
-		TimerListHead = obj;
-	} else {
-	  // obj->Timestamp += elapsedTime; Not needed
-      TimerInsertTimer( obj);
-	}
-	itsdk_timer_return_t ret = itsdk_stimer_register(
-									obj->ReloadValue,
-									TimerCallback,
-									(uint32_t)obj,
-									TIMER_ACCEPT_LOWPOWER
-		 	 	 	 	 	   );
-	if ( ret != TIMER_INIT_SUCCESS ) {
-		ITSDK_ERROR_REPORT(ITSDK_ERROR_LORAWAN_TIME_INITFLD,(uint16_t)ret);
+	if ( TimerListHead == obj ) {
+		if ( obj->Next != NULL ) obj->Next->IsNext2Expire = false;
+		TimerSetTimeout();
 	}
 	itsdk_leaveCriticalSection();
 
@@ -249,7 +229,7 @@ void TimerStart( TimerEvent_t *obj )
 
 
 /**
- *
+ * Remove a Timer from the list, the soft timer is re-armed when the head changes
  */
 void TimerStop( TimerEvent_t *obj ) 
 {
@@ -257,19 +237,15 @@ void TimerStop( TimerEvent_t *obj )
 
 	itsdk_enterCriticalSection();
 	// do not stop a non existing
-	if( ( obj == NULL ) || ( TimerExists( obj ) == false ) ) {
+	if( ( obj == NULL ) || !obj->IsStarted ) {
 		itsdk_leaveCriticalSection();
 	    return;
 	}
-
-	if (obj->IsStarted) {
-		itsdk_stimer_stop(
-							TimerCallback,
-							(uint32_t)obj
-						);
-		obj->IsStarted = false;
-	}
+	bool wasHead = ( TimerListHead == obj );
 	removeFromList(obj);
+	obj->IsStarted = false;
+	obj->IsNext2Expire = false;
+	if ( wasHead ) TimerSetTimeout();
 	itsdk_leaveCriticalSection();
 }  
 
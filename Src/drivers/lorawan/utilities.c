@@ -16,31 +16,30 @@ Maintainer: Miguel Luis and Gregory Cristian
 #include <stdio.h>
 #include <stdint.h>
 #include <drivers/lorawan/utilities.h>
+#include <it_sdk/random/random.h>
 
 /*!
  * Redefinition of rand() and srand() standard C functions.
- * These functions are redefined in order to get the same behavior across
- * different compiler toolchains implementations.
+ * [ITSDK] These functions delegate to the itsdk random service, the
+ * seed is added to the entropy pool instead of resetting the sequence.
  */
 // Standard random functions redefinition start
 #define RAND_LOCAL_MAX 2147483647L
 
-static uint32_t next = 1;
-
 int32_t rand1( void )
 {
-    return ( ( next = next * 1103515245L + 12345L ) % RAND_LOCAL_MAX );
+    return ( int32_t )( itsdk_random_getU32( ) & RAND_LOCAL_MAX );
 }
 
 void srand1( uint32_t seed )
 {
-    next = seed;
+    itsdk_random_addEntropy( seed, 0 );
 }
 // Standard random functions redefinition end
 
 int32_t randr( int32_t min, int32_t max )
 {
-    return ( int32_t )rand1( ) % ( max - min + 1 ) + min;
+    return itsdk_random_getRange( min, max );
 }
 
 void memcpy1( uint8_t *dst, const uint8_t *src, uint16_t size )
@@ -43,6 +43,11 @@
 #if ITSDK_SIGFOX_NVM_SOURCE	== __SFX_NVM_M95640
 	#include <drivers/eeprom/m95640/m95640.h>
 #endif
+#if ITSDK_S2LP_CNF_CACHE == __ENABLE
+	#include <it_sdk/eeprom/securestore.h>
+#endif
+#include <stddef.h>
+#include <string.h>
 
 void s2lp_shutdown() {
 	gpio_set(ITSDK_S2LP_SDN_BANK,ITSDK_S2LP_SDN_PIN);
@@ -138,8 +143,10 @@ void s2lp_loadConfigFromEeprom(
 
 
 
+#if ITSDK_SIGFOX_NVM_SOURCE	== __SFX_NVM_M95640
 /**
- * Load the configuration according to the source setting in the configuration file
+ * Load the configuration from the M95640 eeprom and search the private key
+ * Return false when the eeprom content is invalid or the key has not been found
  * ----------------------------------------------------------------------------------
  * enc_utils_retrieve_data
  *   use 3 zone in the nvram
@@ -153,41 +160,150 @@ void s2lp_loadConfigFromEeprom(
  *  The function verify the checksum validity, the device ID compliance (not 0x00...0 | 0xFF...F)
  *
  */
+static bool s2lp_loadConfigFromM95640(
+		s2lp_config_t * s2lpConf
+) {
+	s2lp_eprom_config_t eepromConf1;
+	eeprom_m95640_read(&ITSDK_DRIVERS_M95640_SPI,0x0000, 32, (uint8_t *)&eepromConf1);
+
+	s2lp_eprom_offset_t eepromConf2;
+	eeprom_m95640_read(&ITSDK_DRIVERS_M95640_SPI,0x0021, 4, (uint8_t *)&eepromConf2);
+
+	// S2lp_hw config
+	s2lp_loadConfigFromEeprom(
+			&eepromConf1,
+			&eepromConf2,
+			s2lpConf
+	);
+
+	// Not clear why => when passing &(s2lpConf->id) it crash...
+	// retrieve_data also extract the SigfoxID key and store it in RAM for internal use.
+	uint32_t id;
+	uint8_t rcz;
+	bool valid = ( enc_utils_retrieve_data(&id, s2lpConf->pac, &rcz) == RETR_OK );
+	s2lpConf->id = id;
+	s2lpConf->rcz = rcz;
+
+	// Clean the key and aux not provided with this NVM source
+	for (int i= 0 ; i < 16 ; i++) {
+		s2lpConf->key[i]=0xFF;
+		s2lpConf->aux[i]=0xFF;
+	}
+
+	// Search for the private key in the memory to fill the structure
+	valid = s2lp_sigfox_retreive_key(s2lpConf->id, s2lpConf->pac, s2lpConf->key) && valid;
+	s2lp_sigfox_cifferKey(s2lpConf);
+	s2lpConf->fromCache = 0;
+	return valid;
+}
+#endif
+
+#if ITSDK_S2LP_CNF_CACHE == __ENABLE
+
+static uint16_t s2lp_cacheChecksum(s2lp_cnf_cache_t * c) {
+	uint16_t sum = 0;
+	uint8_t * p = (uint8_t *)c;
+	for ( int i = 0 ; i < sizeof(s2lp_cnf_cache_t) ; i++ ) {
+		if ( i < offsetof(s2lp_cnf_cache_t,checksum) || i >= offsetof(s2lp_cnf_cache_t,id) ) sum += p[i];
+	}
+	return sum;
+}
+
+/**
+ * Load the configuration previously parsed from the secure store.
+ * Return false when the cache is not set, invalid or from another version.
+ */
+static bool s2lp_loadConfigFromCache(
+		s2lp_config_t * s2lpConf
+) {
+	s2lp_cnf_cache_t c;
+	uint8_t * p = (uint8_t *)&c;
+	bool valid = (     itsdk_secstore_readBlock(ITSDK_SS_S2LP_CNF, p) == SS_SUCCESS
+				    && itsdk_secstore_readBlock(ITSDK_SS_S2LP_IDPAC, p+ITSDK_SECSTORE_BLOCKSZ) == SS_SUCCESS
+				    && itsdk_secstore_readBlock(ITSDK_SS_S2LP_KEY, p+2*ITSDK_SECSTORE_BLOCKSZ) == SS_SUCCESS
+				    && c.version == S2LP_CNF_CACHE_VERSION
+				    && c.checksum == s2lp_cacheChecksum(&c)
+				  );
+	if ( valid ) {
+		s2lpConf->xtalFreq = c.xtalFreq;
+		s2lpConf->tcxo = c.tcxo;
+		s2lpConf->range = c.range;
+		s2lpConf->band = c.band;
+		s2lpConf->rcz = c.rcz;
+		s2lpConf->offset = c.offset;
+		s2lpConf->rssiOffset = c.rssiOffset;
+		s2lpConf->id = c.id;
+		memcpy(s2lpConf->pac,c.pac,8);
+		memcpy(s2lpConf->key,c.key,16);
+		for (int i= 0 ; i < 16 ; i++) s2lpConf->aux[i]=0xFF;
+		s2lpConf->fromCache = 1;
+	}
+	bzero(&c,sizeof(c));
+	return valid;
+}
+
+/**
+ * Save the configuration parsed from the eeprom in the secure store.
+ * The first block holding the version is written last.
+ */
+static void s2lp_storeConfigToCache(
+		s2lp_config_t * s2lpConf
+) {
+	s2lp_cnf_cache_t c;
+	uint8_t * p = (uint8_t *)&c;
+	c.version = S2LP_CNF_CACHE_VERSION;
+	c.xtalFreq = s2lpConf->xtalFreq;
+	c.tcxo = s2lpConf->tcxo;
+	c.range = s2lpConf->range;
+	c.band = s2lpConf->band;
+	c.rcz = s2lpConf->rcz;
+	c.offset = s2lpConf->offset;
+	c.rssiOffset = s2lpConf->rssiOffset;
+	c.id = s2lpConf->id;
+	memcpy(c.pac,s2lpConf->pac,8);
+	memcpy(c.key,s2lpConf->key,16);
+	c.checksum = s2lp_cacheChecksum(&c);
+	itsdk_secstore_writeBlock(ITSDK_SS_S2LP_IDPAC, p+ITSDK_SECSTORE_BLOCKSZ);
+	itsdk_secstore_writeBlock(ITSDK_SS_S2LP_KEY, p+2*ITSDK_SECSTORE_BLOCKSZ);
+	itsdk_secstore_writeBlock(ITSDK_SS_S2LP_CNF, p);
+	bzero(&c,sizeof(c));
+}
+
+/**
+ * Force the configuration to be parsed from the eeprom on next init
+ * (eeprom content changed)
+ */
+void s2lp_invalidateConfigCache() {
+	uint8_t b[ITSDK_SECSTORE_BLOCKSZ];
+	bzero(b,ITSDK_SECSTORE_BLOCKSZ);
+	itsdk_secstore_writeBlock(ITSDK_SS_S2LP_CNF, b);
+}
+
+#else
+void s2lp_invalidateConfigCache() {
+}
+#endif
+
+/**
+ * Load the configuration according to the source setting in the configuration file
+ * With ITSDK_S2LP_CNF_CACHE the M95640 configuration is parsed and the key searched
+ * on the first boot only, then loaded from the secure store.
+ */
 void s2lp_loadConfiguration(
 		s2lp_config_t * s2lpConf
 ) {
 
 	#if ITSDK_SIGFOX_NVM_SOURCE	== __SFX_NVM_M95640
-		s2lp_eprom_config_t eepromConf1;
-		eeprom_m95640_read(&ITSDK_DRIVERS_M95640_SPI,0x0000, 32, (uint8_t *)&eepromConf1);
-
-		s2lp_eprom_offset_t eepromConf2;
-		eeprom_m95640_read(&ITSDK_DRIVERS_M95640_SPI,0x0021, 4, (uint8_t *)&eepromConf2);
-
-		// S2lp_hw config
-		s2lp_loadConfigFromEeprom(
-				&eepromConf1,
-				&eepromConf2,
-				s2lpConf
-		);
-
-		// Not clear why => when passing &(s2lpConf->id) it crash...
-		// retrieve_data also extract the SigfoxID key and store it in RAM for internal use.
-		uint32_t id;
-		uint8_t rcz;
-		enc_utils_retrieve_data(&id, s2lpConf->pac, &rcz);
-		s2lpConf->id = id;
-		s2lpConf->rcz = rcz;
-
-		// Clean the key and aux not provided with this NVM source
-		for (int i= 0 ; i < 16 ; i++) {
-			s2lpConf->key[i]=0xFF;
-			s2lpConf->aux[i]=0xFF;
+	  #if ITSDK_S2LP_CNF_CACHE == __ENABLE
+		if ( ! s2lp_loadConfigFromCache(s2lpConf) ) {
+			LOG_INFO_S2LP(("S2LP - Config - parse eeprom\r\n"));
+			if ( s2lp_loadConfigFromM95640(s2lpConf) ) {
+				s2lp_storeConfigToCache(s2lpConf);
+			}
 		}
-
-		// Search for the private key in the memory to fill the structure
-		s2lp_sigfox_retreive_key(s2lpConf->id, s2lpConf->pac, s2lpConf->key);
-		s2lp_sigfox_cifferKey(s2lpConf);
+	  #else
+		s2lp_loadConfigFromM95640(s2lpConf);
+	  #endif
 
 		s2lpConf->low_power_flag = ITSDK_SIGFOX_LOWPOWER;
 		s2lpConf->payload_encryption = (( ITSDK_SIGFOX_ENCRYPTION & __PAYLOAD_ENCRYPT_SIGFOX) > 0)?1:0;
@@ -43,6 +43,7 @@
 #endif
 
 #include <drivers/s2lp/s2lp_spi.h>
+#include <string.h>
 
 
 /**
@@ -58,6 +59,9 @@ void s2lp_spi_setCsHigh() {
 
 /**
  * Access the S2LP registers
+ * The header, the address and the register bytes are exchanged by bursts
+ * of S2LP_SPI_BURST_SZ bytes with the chip select kept low, the bytes on
+ * the bus are the same as a byte per byte access.
  */
 S2LP_SPI_StatusBytes s2lp_spi_accessRegisters(
 		ITSDK_SPI_HANDLER_TYPE * spi,
@@ -66,55 +70,45 @@ S2LP_SPI_StatusBytes s2lp_spi_accessRegisters(
         uint8_t* pcBuffer,
 		S2LP_ACCESS	 access					// true for read, false for
 ) {
-  uint8_t v=0;
-  uint8_t r=0;
+  uint8_t tx[S2LP_SPI_BURST_SZ];
+  uint8_t rx[S2LP_SPI_BURST_SZ];
   uint16_t status = 0x0000;
+  uint16_t done = 0;
+  uint16_t len;
+  uint8_t  hdr = 2;
 
   // When accessing the SPI interface, the two status bytes of the MC_STATE
   // registers are sent to the MISO pin.
   S2LP_SPI_StatusBytes *pStatus=(S2LP_SPI_StatusBytes *)&status;
 
   // Disable S2LP Interrupt
-  gpio_interruptPriority(ITSDK_S2LP_GPIO3_BANK, ITSDK_S2LP_GPIO3_PIN, 4, 4);
   gpio_interruptDisable(ITSDK_S2LP_GPIO3_BANK, ITSDK_S2LP_GPIO3_PIN);
 
   s2lp_spi_setCsLow();
-  itsdk_delayMs(S2LP_SPI_DELAY);
-
-  // Write the aHeader bytes and read the S2-LP status bytes
-  v = (access==S2LP_READ_REGISTER)?READ_HEADER:WRITE_HEADER;
-  spi_readRegister(
-		  spi,
-          (uint8_t *)&v,
-          (uint8_t *)&(r),
-		  1
-  );
-  status = r << 8;
-
-  // Write the aHeader bytes and read the S2-LP status bytes
-  v = cRegAddress;
-  spi_readRegister(
-		  spi,
-          (uint8_t *)&v,
-          (uint8_t *)&(r),
-		  1
-  );
-  status+=r;
-
-  // Writes the registers according to the number of bytes
-  v=0xFF;
-  for (int index = 0; index < cNbBytes; index++) {
+  itsdk_delayUs(S2LP_SPI_CS_SETUP_US);
+
+  // Write the header and address bytes and read the S2-LP status bytes
+  // then the registers, 0xFF is sent when reading
+  tx[0] = (access==S2LP_READ_REGISTER)?READ_HEADER:WRITE_HEADER;
+  tx[1] = cRegAddress;
+  do {
+	  len = cNbBytes - done;
+	  if ( len > S2LP_SPI_BURST_SZ - hdr ) len = S2LP_SPI_BURST_SZ - hdr;
 	  if ( access==S2LP_READ_REGISTER ) {
-		  spi_readRegister(
-		 	  spi,
-		 	  (uint8_t *)&v,
-		 	  (uint8_t *)&(pcBuffer)[index],
-		 	  1
-		  );
+		  memset(&tx[hdr],0xFF,len);
 	  } else {
-		  spi_write_byte(spi,pcBuffer[index]);
+		  memcpy(&tx[hdr],&pcBuffer[done],len);
 	  }
-  }
+	  spi_rwRegister(spi,tx,rx,hdr+len);
+	  if ( hdr > 0 ) {
+		  status = ((uint16_t)rx[0] << 8) + rx[1];
+	  }
+	  if ( access==S2LP_READ_REGISTER ) {
+		  memcpy(&pcBuffer[done],&rx[hdr],len);
+	  }
+	  done += len;
+	  hdr = 0;
+  } while ( done < cNbBytes );
 
   // To be sure to don't rise the Chip Select before the end of last sending
   spi_wait4TransactionEnd(spi);
@@ -123,7 +117,6 @@ S2LP_SPI_StatusBytes s2lp_spi_accessRegisters(
   s2lp_spi_setCsHigh();
 
   // Re-enable S2LP Interrupt
-  gpio_interruptPriority(ITSDK_S2LP_GPIO3_BANK, ITSDK_S2LP_GPIO3_PIN, 4, 4);
   gpio_interruptEnable(ITSDK_S2LP_GPIO3_BANK, ITSDK_S2LP_GPIO3_PIN);
 
   return *pStatus;
@@ -148,9 +141,8 @@ S2LP_SPI_StatusBytes s2lp_spi_accessRaw(
   }
 
   // Disable S2LP Interrupt
-  s2lp_spi_setCsLow();
-  gpio_interruptPriority(ITSDK_S2LP_GPIO3_BANK, ITSDK_S2LP_GPIO3_PIN, 4, 4);
   gpio_interruptDisable(ITSDK_S2LP_GPIO3_BANK, ITSDK_S2LP_GPIO3_PIN);
+  s2lp_spi_setCsLow();
 
   spi_rwRegister(
 		  spi,
@@ -166,7 +158,6 @@ S2LP_SPI_StatusBytes s2lp_spi_accessRaw(
   s2lp_spi_setCsHigh();
 
   // Re-enable S2LP Interrupt
-  gpio_interruptPriority(ITSDK_S2LP_GPIO3_BANK, ITSDK_S2LP_GPIO3_PIN, 4, 4);
   gpio_interruptEnable(ITSDK_S2LP_GPIO3_BANK, ITSDK_S2LP_GPIO3_PIN);
 
   return status;
@@ -46,6 +46,7 @@
 #include <drivers/s2lp/s2lp_spi.h>
 #include <drivers/s2lp/sigfox_retriever.h>
 #include <drivers/s2lp/sigfox_helper.h>
+#include <it_sdk/sigfox/sigfox_mem.h>
 #if ITSDK_SIGFOX_NVM_SOURCE == __SFX_NVM_M95640
 	#include <drivers/eeprom/m95640/m95640.h>
 #endif
@@ -53,6 +54,7 @@
 #include <string.h>
 
 #include <it_sdk/encrypt/tiny-AES-c/aes.h>
+#include <it_sdk/encrypt/encrypt.h>
 
 
 
@@ -70,7 +72,7 @@ void ST_MCU_API_SetSysClock(void) {
  */
 static void priv_ST_MCU_API_delay(uint32_t delay_ms) {
 	LOG_DEBUG_S2LP((">> priv_ST_MCU_API_delay\r\n"));
-	itsdk_delayMs(delay_ms);
+	itsdk_sleepMs(delay_ms);
 }
 
 /**
@@ -78,24 +80,22 @@ static void priv_ST_MCU_API_delay(uint32_t delay_ms) {
  */
 sfx_u8 MCU_API_malloc(sfx_u16 size, sfx_u8 **returned_pointer)
 {
-  static sfx_u8 mem[ITSDK_SIGFOX_MEM_SIZE];
-  
   LOG_DEBUG_S2LP(("Sigfox lib mem req: %dB\r\n",size));
-  if(size>ITSDK_SIGFOX_MEM_SIZE) {
-	  LOG_ERROR_S2LP(("Requesting more memory than maximum allowable\r\n"));
+  if ( !itsdk_sigfox_memAlloc(size, (uint32_t)__builtin_return_address(0), returned_pointer) ) {
 	  return MCU_ERR_API_MALLOC;
-  } else {
-    (*returned_pointer)=mem;
   }
   return SFX_ERR_NONE;
 }
 
 /**
- * Fake memory deallocation
+ * Static memory deallocation
  */
 sfx_u8 MCU_API_free(sfx_u8 *ptr)
 {
   LOG_DEBUG_S2LP((">> MCU_API_free\r\n"));
+  if ( !itsdk_sigfox_memFree(ptr) ) {
+	  return MCU_ERR_API_FREE;
+  }
   return SFX_ERR_NONE;
 }
 
@@ -196,6 +196,22 @@ sfx_u8 MCU_API_aes_128_cbc_encrypt(sfx_u8 *encrypted_data,
 		tiny_AES_init_ctx(&ctx,key);
 		tiny_AES_CBC_encrypt_buffer(&ctx, encrypted_data, 16);
   } else
+#endif
+#if ITSDK_S2LP_CNF_CACHE == __ENABLE
+  if (use_key==CREDENTIALS_PRIVATE_KEY && _s2lp_sigfox_config->fromCache ) {
+	    // The configuration has been loaded from the secure store, the retriever
+	    // has not been initialized and does not know the private key.
+		struct AES_ctx ctx;
+		uint8_t pkey[16];
+		memcpy(pkey,_s2lp_sigfox_config->key,16);
+		itsdk_encrypt_unCifferKey(pkey,16);
+		memcpy(encrypted_data,data_to_encrypt,aes_block_len);
+		bzero(ctx.Iv,16);
+		tiny_AES_init_ctx(&ctx,pkey);
+		tiny_AES_CBC_encrypt_buffer(&ctx, encrypted_data, aes_block_len);
+		bzero(pkey,16);
+		bzero(&ctx,sizeof(ctx));
+  } else
 #endif
 	  enc_utils_encrypt(encrypted_data, data_to_encrypt, aes_block_len, key, use_key);
 
@@ -322,6 +338,13 @@ sfx_u8 MCU_API_get_device_id_and_payload_encryption_flag(
 	LOG_DEBUG_S2LP((">> MCU_API_get_device_id_and_payload_encryption_flag\r\n"));
 #if ITSDK_SIGFOX_NVM_SOURCE == __SFX_NVM_M95640
 
+  #if ITSDK_S2LP_CNF_CACHE == __ENABLE
+	if ( _s2lp_sigfox_config->fromCache ) {
+		for (int i=0; i< ID_LENGTH ; i++) {
+			dev_id[i] = (_s2lp_sigfox_config->id >> (8*i)) & 0xFF;
+		}
+	} else
+  #endif
 	// from Sigfox Retriever library
 	enc_utils_get_id(dev_id);
    (*payload_encryption_enabled) = _s2lp_sigfox_config->payload_encryption;
@@ -349,6 +372,11 @@ sfx_u8 MCU_API_get_initial_pac(sfx_u8 initial_pac[PAC_LENGTH])
 	LOG_DEBUG_S2LP((">> MCU_API_get_initial_pac\r\n"));
 #if ITSDK_SIGFOX_NVM_SOURCE == __SFX_NVM_M95640
 
+  #if ITSDK_S2LP_CNF_CACHE == __ENABLE
+	if ( _s2lp_sigfox_config->fromCache ) {
+		memcpy(initial_pac,_s2lp_sigfox_config->pac,PAC_LENGTH);
+	} else
+  #endif
 	// from Sigfox Retriever library
 	enc_utils_get_initial_pac(initial_pac);
 
@@ -604,6 +632,9 @@ void ST_MCU_API_WaitForInterrupt(void)
 	  // other actions
 	  #if ( ITSDK_LOWPOWER_MOD & __LOWPWR_MODE_WAKE_GPIO ) > 0
 		 lowPower_switch();
+	  #else
+		 // sleep until the next interrupt, the loop count is used to time the voltage measurement
+		 if ( __s2lp_voltageInTxPending == 0 && !__pendingIrqDelayed ) itsdk_waitForInterrupt();
 	  #endif
 	  itsdk_stimer_run();
 	  #if ITSDK_WDG_MS > 0
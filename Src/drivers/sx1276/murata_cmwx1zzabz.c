@@ -94,7 +94,9 @@ const struct Radio_s Radio =
     SX1276ReadBuffer,
     SX1276SetMaxPayloadLength,
     SX1276SetPublicNetwork,
-    SX1276GetWakeupTime
+    SX1276GetWakeupTime,
+    SX1276IrqProcess,
+    SX1276GetIrqTime
 };
 
 
@@ -36,6 +36,7 @@
 #include <drivers/sigfox/sigfox_api.h>
 #include <drivers/sigfox/se_nvm.h>
 #include <it_sdk/sigfox/sigfox.h>
+#include <it_sdk/sigfox/sigfox_mem.h>
 #include <it_sdk/eeprom/eeprom.h>
 #include <it_sdk/eeprom/sdk_config.h>
 #include <it_sdk/wrappers.h>
@@ -47,34 +48,27 @@
 // MCU API
 // =============================================================================================
 
-// The new version of the compiler was protecting memory access against static elements
-// Making a hardfault in the sigfox api init function when it tried to write into this zone.
-// Non static declaration solve this issue
-// Next issue was on alignement, if not aligned on 4 it is possible that the first address is out of the
-// authorized area.
-sfx_u8 __sigfox_mem[ITSDK_SIGFOX_MEM_SIZE] __attribute((aligned(4)));
-
 /**
  * Static memory allocation
  */
 sfx_u8 MCU_API_malloc(sfx_u16 size, sfx_u8 **returned_pointer)
 {
   LOG_DEBUG_SFXSX1276(("Sigfox lib mem req: %dB \r\n",size));
-  if(size>ITSDK_SIGFOX_MEM_SIZE) {
-	  LOG_ERROR_SFXSX1276(("Requesting more memory than maximum allowable\r\n"));
+  if ( !itsdk_sigfox_memAlloc(size, (uint32_t)__builtin_return_address(0), returned_pointer) ) {
 	  return MCU_ERR_API_MALLOC;
-  } else {
-    (*returned_pointer)=__sigfox_mem;
   }
   return SFX_ERR_NONE;
 }
 
 /**
- * Fake memory deallocation
+ * Static memory deallocation
  */
 sfx_u8 MCU_API_free(sfx_u8 *ptr)
 {
 	LOG_DEBUG_SFXSX1276((">> MCU_API_free\r\n"));
+	if ( !itsdk_sigfox_memFree(ptr) ) {
+		return MCU_ERR_API_FREE;
+	}
     return SFX_ERR_NONE;
 }
 
@@ -118,7 +112,6 @@ sfx_u8 MCU_API_get_voltage_temperature(sfx_u16 *voltage_idle, sfx_u16 *voltage_t
 /**
  * Wait for the given delay_type..
  */
-#warning "We could optimize long stop with going to sleep..."
 sfx_u8 MCU_API_delay(sfx_delay_t delay_type)
 {
 	LOG_DEBUG_SFXSX1276((">> MCU_API_delay(%d)\r\n",delay_type));
@@ -132,14 +125,14 @@ sfx_u8 MCU_API_delay(sfx_delay_t delay_type)
         /* Delay  is 500ms  in FCC and ETSI
          * In ARIB : minimum delay is 50 ms */
         if( rcz == SIGFOX_RCZ3C ) {
-        	itsdk_delayMs(ITSDK_SIGFOX_IF_TXRX_RCZ3);
+        	itsdk_sleepMs(ITSDK_SIGFOX_IF_TXRX_RCZ3);
         } else {
         	// Measure (frame to frame) is 721ms for 500ms requested
         	// due to code around assuming with 50ms TCXO wakeup
 			#if ITSDK_SIGFOX_IF_TXRX_RCZ1 < ITSDK_SX1276_SFXWAKEUP_TIME
 			#error "ITSDK_SIGFOX_IF_TXRX_RCZ1 can't be lower than ITSDK_SX1276_SFXWAKEUP_TIME"
 			#endif
-        	itsdk_delayMs(ITSDK_SIGFOX_IF_TXRX_RCZ1 - ITSDK_SX1276_SFXWAKEUP_TIME);	// spec is 500 - 525ms
+        	itsdk_sleepMs(ITSDK_SIGFOX_IF_TXRX_RCZ1 - ITSDK_SX1276_SFXWAKEUP_TIME);	// spec is 500 - 525ms
         }
         break;
 
@@ -147,25 +140,25 @@ sfx_u8 MCU_API_delay(sfx_delay_t delay_type)
         /* Start delay 0 seconds to 2 seconds in FCC and ETSI*/
         /* In ARIB : minimum delay is 50 ms */
         if( rcz == SIGFOX_RCZ3C ) {
-        	itsdk_delayMs(50);
+        	itsdk_sleepMs(50);
         } else {
 			#if ITSDK_SIGFOX_IF_TX_RCZ1 < ITSDK_SX1276_SFXWAKEUP_TIME
 			#error "ITSDK_SIGFOX_IF_TX_RCZ1 can't be lower than ITSDK_SX1276_SFXWAKEUP_TIME"
 			#endif
         	// was 1s but many different devices like sensit are 100ms sounds more efficient
         	// but 100 ms do not work really good
-        	itsdk_delayMs(ITSDK_SIGFOX_IF_TX_RCZ1 - ITSDK_SX1276_SFXWAKEUP_TIME);
+        	itsdk_sleepMs(ITSDK_SIGFOX_IF_TX_RCZ1 - ITSDK_SX1276_SFXWAKEUP_TIME);
         }
         break;
 
     case SFX_DLY_OOB_ACK :
         /* Start delay between 1.4 seconds to 4 seconds in FCC and ETSI */
-    	itsdk_delayMs(1400);
+    	itsdk_sleepMs(1400);
        /*comment from sigfox iso 1400 was measured 1300, spec={1,4-4s}so added 200*/
         break;
 
     case SFX_DLY_CS_SLEEP :
-    	itsdk_delayMs(500);
+    	itsdk_sleepMs(500);
         break;
 
     default :
@@ -174,6 +174,7 @@ void STLL_RadioPowerSetBoard( int8_t power)
  * have some action during this wait phase. The processor can goes to idle
  * mode only is the related setting is authorizing it. Basically it should be
  * a bit complicated as during this wait the DMA is transferring orders from the memory to the SPI.
+ * The core sleeps between the interrupts, the clocks and the DMA are kept running.
  */
 STLL_flag STLL_WaitEndOfTxFrame( void )
 {
@@ -186,6 +187,7 @@ STLL_flag STLL_WaitEndOfTxFrame( void )
 	  #if ITSDK_WITH_WDG != __WDG_NONE && ITSDK_WDG_MS > 0
         wdg_refresh();
 	  #endif
+      if ( sx1276_sigfox_state.endOfTxEvent == SIGFOX_EVENT_CLEAR ) itsdk_waitForInterrupt();
   }
   LOG_DEBUG_SFXSX1276(("    Wait Done\r\n"));
   
@@ -313,6 +315,9 @@ void STLL_Transmit_DMA_Stop( void )
 #else
 	#error "Please update this part for the use of another spi handler"
 #endif
+
+    // The DMA stream has written the radio registers behind the driver
+    SX1276ShadowInvalidate();
 }
 
 /* =========================================================================
@@ -533,6 +538,7 @@ STLL_flag STLL_WaitEndOfRxFrame( void )
 	  #if ITSDK_WITH_WDG != __WDG_NONE && ITSDK_WDG_MS > 0
          wdg_refresh();
 	  #endif
+      if ( sx1276_sigfox_state.timerEvent == SIGFOX_EVENT_CLEAR ) itsdk_waitForInterrupt();		// radio in RX, wake on DIO or timer
   }
   return sx1276_sigfox_state.rxPacketReceived;
 }
@@ -49,6 +49,7 @@
 #include <drivers/lorawan/phy/radio.h>
 #include <drivers/sx1276/sx1276.h>
 #include <drivers/lorawan/timeServer.h>
+#include <it_sdk/random/random.h>
 
 /*
  * Local types definition
@@ -78,6 +79,11 @@ typedef struct
  * Private functions prototypes
  */
 
+/*!
+ * \brief RegOpMode without the mode bits (LongRangeMode, AccessSharedReg, LowFrequencyModeOn)
+ */
+static uint8_t SX1276ReadOpModeConfig( void );
+
 
 /*!
  * \brief Sets the SX1276 in transmission mode for the given time
@@ -218,12 +224,66 @@ static LoRaBoardCallback_t *LoRaBoardCallbacks;
  */
 SX1276_t SX1276;
 
+#if ITSDK_SX1276_DEFERRED_IRQ == __ENABLE
+/*
+ * Deferred DIO interrupts: the interrupt handlers only record the DIO line and
+ * the time of the first edge, the processing (SPI access, FIFO read, timers,
+ * radio callbacks) is done by SX1276IrqProcess from the main loop.
+ * In FSK the packets larger than the 64B FIFO are refilled / emptied on DIO1
+ * and DIO2 within a few ms, the main loop latency would overflow the FIFO:
+ * the DIO are processed in the ISR as without the deferred mode.
+ */
+static volatile uint8_t SX1276IrqPending = 0;
+static volatile TimerTime_t SX1276IrqTime = 0;
+static TimerTime_t SX1276IrqEdge = 0;
+static bool SX1276IrqInProcess = false;
+
+static void SX1276PostIrq( uint8_t dio, DioIrqHandler *handler )
+{
+    if( SX1276.Settings.Modem == MODEM_FSK )
+    {
+        handler( NULL );
+        return;
+    }
+    if( SX1276IrqPending == 0 )
+    {
+        SX1276IrqTime = TimerGetCurrentTime( );
+    }
+    SX1276IrqPending |= ( 1 << dio );
+}
+
+static void SX1276PostDio0Irq( void* context ) { SX1276PostIrq( 0, SX1276OnDio0Irq ); }
+static void SX1276PostDio1Irq( void* context ) { SX1276PostIrq( 1, SX1276OnDio1Irq ); }
+static void SX1276PostDio2Irq( void* context ) { SX1276PostIrq( 2, SX1276OnDio2Irq ); }
+static void SX1276PostDio3Irq( void* context ) { SX1276PostIrq( 3, SX1276OnDio3Irq ); }
+static void SX1276PostDio4Irq( void* context ) { SX1276PostIrq( 4, SX1276OnDio4Irq ); }
+
+/*!
+ * Processing order of the pending DIO: preamble and sync detection, fifo level,
+ * then the end of operation on DIO0 so a packet is completed after its chunks.
+ */
+static const struct
+{
+    uint8_t Dio;
+    DioIrqHandler *Handler;
+} DioIrqProcess[] = { { 4, SX1276OnDio4Irq }, { 2, SX1276OnDio2Irq },
+                      { 1, SX1276OnDio1Irq }, { 3, SX1276OnDio3Irq },
+                      { 5, SX1276OnDio5Irq }, { 0, SX1276OnDio0Irq } };
+
+/*!
+ * Hardware DIO IRQ callback initialization
+ */
+DioIrqHandler *DioIrq[] = { SX1276PostDio0Irq, SX1276PostDio1Irq,
+                            SX1276PostDio2Irq, SX1276PostDio3Irq,
+                            SX1276PostDio4Irq, NULL };
+#else
 /*!
  * Hardware DIO IRQ callback initialization
  */
 DioIrqHandler *DioIrq[] = { SX1276OnDio0Irq, SX1276OnDio1Irq,
                             SX1276OnDio2Irq, SX1276OnDio3Irq,
                             SX1276OnDio4Irq, NULL };
+#endif
 
 /*!
  * Tx and Rx timers
@@ -293,9 +353,9 @@ void SX1276SetChannel( uint32_t freq )
 
     SX_FREQ_TO_CHANNEL( channel, freq );
 
-    SX1276Write( REG_FRFMSB, ( uint8_t )( ( channel >> 16 ) & 0xFF ) );
-    SX1276Write( REG_FRFMID, ( uint8_t )( ( channel >> 8 ) & 0xFF ) );
-    SX1276Write( REG_FRFLSB, ( uint8_t )( channel & 0xFF ) );
+    // FRF MSB, MID, LSB in one burst
+    uint8_t frf[3] = { ( uint8_t )( ( channel >> 16 ) & 0xFF ), ( uint8_t )( ( channel >> 8 ) & 0xFF ), ( uint8_t )( channel & 0xFF ) };
+    SX1276WriteBuffer( REG_FRFMSB, frf, 3 );
 }
 
 bool SX1276IsChannelFree( RadioModems_t modem, uint32_t freq, int16_t rssiThresh, uint32_t maxCarrierSenseTime )
@@ -365,6 +425,7 @@ uint32_t SX1276Random( void )
     }
 
     SX1276SetSleep( );
+    itsdk_random_addEntropy( rnd, 32 );
 
     return rnd;
 }
@@ -385,9 +446,11 @@ void RxChainCalibration( void )
     // Save context
     regPaConfigInitVal = SX1276Read( REG_PACONFIG );
 
-    channel = ( ( ( uint32_t )SX1276Read( REG_FRFMSB ) << 16 ) |
-                ( ( uint32_t )SX1276Read( REG_FRFMID ) << 8 ) |
-                ( ( uint32_t )SX1276Read( REG_FRFLSB ) ) );
+    uint8_t frf[3];
+    SX1276ReadBuffer( REG_FRFMSB, frf, 3 );
+    channel = ( ( ( uint32_t )frf[0] << 16 ) |
+                ( ( uint32_t )frf[1] << 8 ) |
+                ( ( uint32_t )frf[2] ) );
 
     SX_CHANNEL_TO_FREQ(channel, initialFreq);
 
@@ -465,31 +528,33 @@ void SX1276SetRxConfig( RadioModems_t modem, uint32_t bandwidth,
             SX1276.Settings.Fsk.RxSingleTimeout = ( uint32_t )( symbTimeout * ( ( 1.0 / ( double )datarate ) * 8.0 ) * 1000 );
 
             datarate = ( uint16_t )( ( double )XTAL_FREQ / ( double )datarate );
-            SX1276Write( REG_BITRATEMSB, ( uint8_t )( datarate >> 8 ) );
-            SX1276Write( REG_BITRATELSB, ( uint8_t )( datarate & 0xFF ) );
-
-            SX1276Write( REG_RXBW, GetFskBandwidthRegValue( bandwidth ) );
-            SX1276Write( REG_AFCBW, GetFskBandwidthRegValue( bandwidthAfc ) );
-
-            SX1276Write( REG_PREAMBLEMSB, ( uint8_t )( ( preambleLen >> 8 ) & 0xFF ) );
-            SX1276Write( REG_PREAMBLELSB, ( uint8_t )( preambleLen & 0xFF ) );
-
+            uint8_t bitrate[2] = { ( uint8_t )( datarate >> 8 ), ( uint8_t )( datarate & 0xFF ) };
+            SX1276WriteBuffer( REG_BITRATEMSB, bitrate, 2 );
+
+            uint8_t rxBw[2] = { GetFskBandwidthRegValue( bandwidth ), GetFskBandwidthRegValue( bandwidthAfc ) };
+            SX1276WriteBuffer( REG_RXBW, rxBw, 2 );
+
+            uint8_t preamble[2] = { ( uint8_t )( ( preambleLen >> 8 ) & 0xFF ), ( uint8_t )( preambleLen & 0xFF ) };
+            SX1276WriteBuffer( REG_PREAMBLEMSB, preamble, 2 );
+
+            // Packet config 1 & 2 and payload length (0x30..0x32) in one burst
+            uint8_t packetCfg[3];
+            SX1276ReadBuffer( REG_PACKETCONFIG1, packetCfg, 3 );
+            packetCfg[0] = ( packetCfg[0] &
+                             RF_PACKETCONFIG1_CRC_MASK &
+                             RF_PACKETCONFIG1_PACKETFORMAT_MASK ) |
+                             ( ( fixLen == 1 ) ? RF_PACKETCONFIG1_PACKETFORMAT_FIXED : RF_PACKETCONFIG1_PACKETFORMAT_VARIABLE ) |
+                             ( crcOn << 4 );
+            packetCfg[1] |= RF_PACKETCONFIG2_DATAMODE_PACKET;
             if( fixLen == 1 )
             {
-                SX1276Write( REG_PAYLOADLENGTH, payloadLen );
+                packetCfg[2] = payloadLen;
             }
             else
             {
-                SX1276Write( REG_PAYLOADLENGTH, 0xFF ); // Set payload length to the maximum
+                packetCfg[2] = 0xFF; // Set payload length to the maximum
             }
-
-            SX1276Write( REG_PACKETCONFIG1,
-                         ( SX1276Read( REG_PACKETCONFIG1 ) &
-                           RF_PACKETCONFIG1_CRC_MASK &
-                           RF_PACKETCONFIG1_PACKETFORMAT_MASK ) |
-                           ( ( fixLen == 1 ) ? RF_PACKETCONFIG1_PACKETFORMAT_FIXED : RF_PACKETCONFIG1_PACKETFORMAT_VARIABLE ) |
-                           ( crcOn << 4 ) );
-            SX1276Write( REG_PACKETCONFIG2, ( SX1276Read( REG_PACKETCONFIG2 ) | RF_PACKETCONFIG2_DATAMODE_PACKET ) );
+            SX1276WriteBuffer( REG_PACKETCONFIG1, packetCfg, 3 );
         }
         break;
     case MODEM_LORA:
@@ -531,37 +596,36 @@ void SX1276SetRxConfig( RadioModems_t modem, uint32_t bandwidth,
                 SX1276.Settings.LoRa.LowDatarateOptimize = 0x00;
             }
 
-            SX1276Write( REG_LR_MODEMCONFIG1,
-                         ( SX1276Read( REG_LR_MODEMCONFIG1 ) &
-                           RFLR_MODEMCONFIG1_BW_MASK &
-                           RFLR_MODEMCONFIG1_CODINGRATE_MASK &
-                           RFLR_MODEMCONFIG1_IMPLICITHEADER_MASK ) |
-                           ( bandwidth << 4 ) | ( coderate << 1 ) |
-                           fixLen );
-
-            SX1276Write( REG_LR_MODEMCONFIG2,
-                         ( SX1276Read( REG_LR_MODEMCONFIG2 ) &
-                           RFLR_MODEMCONFIG2_SF_MASK &
-                           RFLR_MODEMCONFIG2_RXPAYLOADCRC_MASK &
-                           RFLR_MODEMCONFIG2_SYMBTIMEOUTMSB_MASK ) |
-                           ( datarate << 4 ) | ( crcOn << 2 ) |
-                           ( ( symbTimeout >> 8 ) & ~RFLR_MODEMCONFIG2_SYMBTIMEOUTMSB_MASK ) );
+            // Modem config 1 & 2, symbol timeout, preamble and payload length
+            // (0x1D..0x22) in one burst limited to the registers changing
+            uint8_t modemCfg[6];
+            SX1276ReadBuffer( REG_LR_MODEMCONFIG1, modemCfg, 6 );
+            modemCfg[0] = ( modemCfg[0] &
+                            RFLR_MODEMCONFIG1_BW_MASK &
+                            RFLR_MODEMCONFIG1_CODINGRATE_MASK &
+                            RFLR_MODEMCONFIG1_IMPLICITHEADER_MASK ) |
+                            ( bandwidth << 4 ) | ( coderate << 1 ) |
+                            fixLen;
+            modemCfg[1] = ( modemCfg[1] &
+                            RFLR_MODEMCONFIG2_SF_MASK &
+                            RFLR_MODEMCONFIG2_RXPAYLOADCRC_MASK &
+                            RFLR_MODEMCONFIG2_SYMBTIMEOUTMSB_MASK ) |
+                            ( datarate << 4 ) | ( crcOn << 2 ) |
+                            ( ( symbTimeout >> 8 ) & ~RFLR_MODEMCONFIG2_SYMBTIMEOUTMSB_MASK );
+            modemCfg[2] = ( uint8_t )( symbTimeout & 0xFF );
+            modemCfg[3] = ( uint8_t )( ( preambleLen >> 8 ) & 0xFF );
+            modemCfg[4] = ( uint8_t )( preambleLen & 0xFF );
+            if( fixLen == 1 )
+            {
+                modemCfg[5] = payloadLen;
+            }
+            SX1276WriteBuffer( REG_LR_MODEMCONFIG1, modemCfg, 6 );
 
             SX1276Write( REG_LR_MODEMCONFIG3,
                          ( SX1276Read( REG_LR_MODEMCONFIG3 ) &
                            RFLR_MODEMCONFIG3_LOWDATARATEOPTIMIZE_MASK ) |
                            ( SX1276.Settings.LoRa.LowDatarateOptimize << 3 ) );
 
-            SX1276Write( REG_LR_SYMBTIMEOUTLSB, ( uint8_t )( symbTimeout & 0xFF ) );
-
-            SX1276Write( REG_LR_PREAMBLEMSB, ( uint8_t )( ( preambleLen >> 8 ) & 0xFF ) );
-            SX1276Write( REG_LR_PREAMBLELSB, ( uint8_t )( preambleLen & 0xFF ) );
-
-            if( fixLen == 1 )
-            {
-                SX1276Write( REG_LR_PAYLOADLENGTH, payloadLen );
-            }
-
             if( SX1276.Settings.LoRa.FreqHopOn == true )
             {
                 SX1276Write( REG_LR_PLLHOP, ( SX1276Read( REG_LR_PLLHOP ) & RFLR_PLLHOP_FASTHOP_MASK ) | RFLR_PLLHOP_FASTHOP_ON );
@@ -635,24 +699,25 @@ void SX1276SetTxConfig( RadioModems_t modem, int8_t power, uint32_t fdev,
             SX1276.Settings.Fsk.IqInverted = iqInverted;
             SX1276.Settings.Fsk.TxTimeout = timeout;
 
+            // Bitrate and frequency deviation (0x02..0x05) in one burst
             fdev = ( uint16_t )( ( double )fdev / ( double )FREQ_STEP );
-            SX1276Write( REG_FDEVMSB, ( uint8_t )( fdev >> 8 ) );
-            SX1276Write( REG_FDEVLSB, ( uint8_t )( fdev & 0xFF ) );
-
             datarate = ( uint16_t )( ( double )XTAL_FREQ / ( double )datarate );
-            SX1276Write( REG_BITRATEMSB, ( uint8_t )( datarate >> 8 ) );
-            SX1276Write( REG_BITRATELSB, ( uint8_t )( datarate & 0xFF ) );
-
-            SX1276Write( REG_PREAMBLEMSB, ( preambleLen >> 8 ) & 0x00FF );
-            SX1276Write( REG_PREAMBLELSB, preambleLen & 0xFF );
-
-            SX1276Write( REG_PACKETCONFIG1,
-                         ( SX1276Read( REG_PACKETCONFIG1 ) &
-                           RF_PACKETCONFIG1_CRC_MASK &
-                           RF_PACKETCONFIG1_PACKETFORMAT_MASK ) |
-                           ( ( fixLen == 1 ) ? RF_PACKETCONFIG1_PACKETFORMAT_FIXED : RF_PACKETCONFIG1_PACKETFORMAT_VARIABLE ) |
-                           ( crcOn << 4 ) );
-            SX1276Write( REG_PACKETCONFIG2, ( SX1276Read( REG_PACKETCONFIG2 ) | RF_PACKETCONFIG2_DATAMODE_PACKET ) );
+            uint8_t bitrateFdev[4] = { ( uint8_t )( datarate >> 8 ), ( uint8_t )( datarate & 0xFF ),
+                                       ( uint8_t )( fdev >> 8 ), ( uint8_t )( fdev & 0xFF ) };
+            SX1276WriteBuffer( REG_BITRATEMSB, bitrateFdev, 4 );
+
+            uint8_t preamble[2] = { ( uint8_t )( ( preambleLen >> 8 ) & 0x00FF ), ( uint8_t )( preambleLen & 0xFF ) };
+            SX1276WriteBuffer( REG_PREAMBLEMSB, preamble, 2 );
+
+            uint8_t packetCfg[2];
+            SX1276ReadBuffer( REG_PACKETCONFIG1, packetCfg, 2 );
+            packetCfg[0] = ( packetCfg[0] &
+                             RF_PACKETCONFIG1_CRC_MASK &
+                             RF_PACKETCONFIG1_PACKETFORMAT_MASK ) |
+                             ( ( fixLen == 1 ) ? RF_PACKETCONFIG1_PACKETFORMAT_FIXED : RF_PACKETCONFIG1_PACKETFORMAT_VARIABLE ) |
+                             ( crcOn << 4 );
+            packetCfg[1] |= RF_PACKETCONFIG2_DATAMODE_PACKET;
+            SX1276WriteBuffer( REG_PACKETCONFIG1, packetCfg, 2 );
         }
         break;
     case MODEM_LORA:
@@ -699,28 +764,29 @@ void SX1276SetTxConfig( RadioModems_t modem, int8_t power, uint32_t fdev,
                 SX1276Write( REG_LR_HOPPERIOD, SX1276.Settings.LoRa.HopPeriod );
             }
 
-            SX1276Write( REG_LR_MODEMCONFIG1,
-                         ( SX1276Read( REG_LR_MODEMCONFIG1 ) &
-                           RFLR_MODEMCONFIG1_BW_MASK &
-                           RFLR_MODEMCONFIG1_CODINGRATE_MASK &
-                           RFLR_MODEMCONFIG1_IMPLICITHEADER_MASK ) |
-                           ( bandwidth << 4 ) | ( coderate << 1 ) |
-                           fixLen );
-
-            SX1276Write( REG_LR_MODEMCONFIG2,
-                         ( SX1276Read( REG_LR_MODEMCONFIG2 ) &
-                           RFLR_MODEMCONFIG2_SF_MASK &
-                           RFLR_MODEMCONFIG2_RXPAYLOADCRC_MASK ) |
-                           ( datarate << 4 ) | ( crcOn << 2 ) );
+            // Modem config 1 & 2, symbol timeout and preamble (0x1D..0x21)
+            // in one burst limited to the registers changing
+            uint8_t modemCfg[5];
+            SX1276ReadBuffer( REG_LR_MODEMCONFIG1, modemCfg, 5 );
+            modemCfg[0] = ( modemCfg[0] &
+                            RFLR_MODEMCONFIG1_BW_MASK &
+                            RFLR_MODEMCONFIG1_CODINGRATE_MASK &
+                            RFLR_MODEMCONFIG1_IMPLICITHEADER_MASK ) |
+                            ( bandwidth << 4 ) | ( coderate << 1 ) |
+                            fixLen;
+            modemCfg[1] = ( modemCfg[1] &
+                            RFLR_MODEMCONFIG2_SF_MASK &
+                            RFLR_MODEMCONFIG2_RXPAYLOADCRC_MASK ) |
+                            ( datarate << 4 ) | ( crcOn << 2 );
+            modemCfg[3] = ( uint8_t )( ( preambleLen >> 8 ) & 0x00FF );
+            modemCfg[4] = ( uint8_t )( preambleLen & 0xFF );
+            SX1276WriteBuffer( REG_LR_MODEMCONFIG1, modemCfg, 5 );
 
             SX1276Write( REG_LR_MODEMCONFIG3,
                          ( SX1276Read( REG_LR_MODEMCONFIG3 ) &
                            RFLR_MODEMCONFIG3_LOWDATARATEOPTIMIZE_MASK ) |
                            ( SX1276.Settings.LoRa.LowDatarateOptimize << 3 ) );
 
-            SX1276Write( REG_LR_PREAMBLEMSB, ( preambleLen >> 8 ) & 0x00FF );
-            SX1276Write( REG_LR_PREAMBLELSB, preambleLen & 0xFF );
-
             if( datarate == 6 )
             {
                 SX1276Write( REG_LR_DETECTOPTIMIZE,
@@ -1250,6 +1316,9 @@ void SX1276Reset( void )
 	itsdk_delayMs(2);
 	gpio_configure(ITSDK_SX1276_RESET_BANK,ITSDK_SX1276_RESET_PIN,GPIO_INPUT);
 	itsdk_delayMs(10);
+
+	// Registers are back to their reset value
+	SX1276ShadowInvalidate();
 }
 
 void SX1276SetOpMode( uint8_t opMode )
@@ -1271,7 +1340,7 @@ void SX1276SetOpMode( uint8_t opMode )
 
     if( opMode == RF_OPMODE_SLEEP )
     {
-      SX1276Write( REG_OPMODE, ( SX1276Read( REG_OPMODE ) & RF_OPMODE_MASK ) | opMode );
+      SX1276Write( REG_OPMODE, SX1276ReadOpModeConfig( ) | opMode );
       
       LoRaBoardCallbacks->SX1276BoardSetAntSwLowPower( true );
       
@@ -1285,7 +1354,7 @@ void SX1276SetOpMode( uint8_t opMode )
       
       LoRaBoardCallbacks->SX1276BoardSetAntSw( opMode );
       
-      SX1276Write( REG_OPMODE, ( SX1276Read( REG_OPMODE ) & RF_OPMODE_MASK ) | opMode );
+      SX1276Write( REG_OPMODE, SX1276ReadOpModeConfig( ) | opMode );
     }
 }
 
@@ -1293,7 +1362,7 @@ void SX1276SetModem( RadioModems_t modem )
 {
 	LOG_INFO_SX1276((">> SX1276SetModem (%s)\r\n",((modem==MODEM_LORA)?"LORA":"FSK")));
 
-    if( ( SX1276Read( REG_OPMODE ) & RFLR_OPMODE_LONGRANGEMODE_ON ) != 0 )
+    if( ( SX1276ReadOpModeConfig( ) & RFLR_OPMODE_LONGRANGEMODE_ON ) != 0 )
     {
         SX1276.Settings.Modem = MODEM_LORA;
     }
@@ -1313,14 +1382,14 @@ void SX1276SetModem( RadioModems_t modem )
     default:
     case MODEM_FSK:
         SX1276SetSleep( );
-        SX1276Write( REG_OPMODE, ( SX1276Read( REG_OPMODE ) & RFLR_OPMODE_LONGRANGEMODE_MASK ) | RFLR_OPMODE_LONGRANGEMODE_OFF );
+        SX1276Write( REG_OPMODE, ( SX1276ReadOpModeConfig( ) & RFLR_OPMODE_LONGRANGEMODE_MASK ) | RFLR_OPMODE_LONGRANGEMODE_OFF );
 
         SX1276Write( REG_DIOMAPPING1, 0x00 );
         SX1276Write( REG_DIOMAPPING2, 0x30 ); // DIO5=ModeReady
         break;
     case MODEM_LORA:
         SX1276SetSleep( );
-        SX1276Write( REG_OPMODE, ( SX1276Read( REG_OPMODE ) & RFLR_OPMODE_LONGRANGEMODE_MASK ) | RFLR_OPMODE_LONGRANGEMODE_ON );
+        SX1276Write( REG_OPMODE, ( SX1276ReadOpModeConfig( ) & RFLR_OPMODE_LONGRANGEMODE_MASK ) | RFLR_OPMODE_LONGRANGEMODE_ON );
 
         SX1276Write( REG_DIOMAPPING1, 0x00 );
         SX1276Write( REG_DIOMAPPING2, 0x00 );
@@ -1328,6 +1397,100 @@ void SX1276SetModem( RadioModems_t modem )
     }
 }
 
+/*
+ * Shadow of the static configuration registers
+ * The reads of these registers are served from RAM and the writes of an unchanged
+ * value are skipped. Registers 0x0D to 0x3F have a different meaning in LoRa and
+ * FSK mode, the shadow follows RegOpMode.LongRangeMode / AccessSharedReg and is
+ * cleared when it changes. Status, Fifo, Irq and self clearing registers are
+ * never cached.
+ */
+#define SX1276_SHADOW_REGS		0x50
+#define SX1276_SHADOW_UNKNOWN	0			// Modem not known, nothing cached
+#define SX1276_SHADOW_FSK		1
+#define SX1276_SHADOW_LORA		2
+#define SX1276_SHADOW_SHARED	3			// LoRa with access to the FSK registers, nothing cached
+
+static const uint8_t SX1276ShadowLoRa[SX1276_SHADOW_REGS/8] = {
+	0xC0, 0xCF, 0x02, 0xE0, 0x5F, 0x00, 0x8A, 0x0A, 0x13, 0x28	// Frf, PaConfig, PaRamp, Ocp, Fifo base addr, IrqMask, ModemConfig, SymbTimeout, Preamble, PayloadLength,
+};																// MaxPayload, HopPeriod, DetectOptimize, InvertIQ, DetectionThreshold, SyncWord, DioMapping, PllHop, Tcxo, PaDac
+static const uint8_t SX1276ShadowFsk[SX1276_SHADOW_REGS/8] = {
+	0xFC, 0x0F, 0x0C, 0x80, 0xE0, 0xFF, 0x27, 0x00, 0x13, 0x28	// Bitrate, Fdev, Frf, PaConfig, PaRamp, Ocp, RxBw, AfcBw, PreambleDetect, Preamble, SyncConfig, SyncValue,
+};																// PacketConfig, PayloadLength, FifoThresh, DioMapping, PllHop, Tcxo, PaDac
+
+static struct {
+	uint8_t value[SX1276_SHADOW_REGS];
+	uint8_t valid[SX1276_SHADOW_REGS/8];
+	uint8_t modem;
+	uint8_t opMode;							// Last RegOpMode value, the mode bits can be changed by the chip
+} SX1276Shadow;
+
+/*!
+ * \brief Clear the register shadow, to be called when the chip may have lost
+ *        or changed its configuration without the driver (reset, DMA access)
+ */
+void SX1276ShadowInvalidate( void )
+{
+    memset1( ( uint8_t* )&SX1276Shadow, 0, sizeof( SX1276Shadow ) );
+}
+
+static bool SX1276ShadowIsCached( uint16_t addr )
+{
+    if( addr >= SX1276_SHADOW_REGS ) return false;
+    switch( SX1276Shadow.modem )
+    {
+    case SX1276_SHADOW_LORA:
+        return ( SX1276ShadowLoRa[addr >> 3] & ( 1 << ( addr & 7 ) ) ) != 0;
+    case SX1276_SHADOW_FSK:
+        return ( SX1276ShadowFsk[addr >> 3] & ( 1 << ( addr & 7 ) ) ) != 0;
+    default:
+        return false;
+    }
+}
+
+static bool SX1276ShadowIsValid( uint16_t addr )
+{
+    return SX1276ShadowIsCached( addr ) && ( SX1276Shadow.valid[addr >> 3] & ( 1 << ( addr & 7 ) ) ) != 0;
+}
+
+/*!
+ * \brief Update the shadow with the values written to or read from the chip
+ */
+static void SX1276ShadowUpdate( uint16_t addr, uint8_t *buffer, uint8_t size )
+{
+    for( uint8_t i = 0; i < size; i++, addr++ )
+    {
+        if( addr == REG_OPMODE )
+        {
+            uint8_t modem = ( ( buffer[i] & RFLR_OPMODE_LONGRANGEMODE_ON ) == 0 ) ? SX1276_SHADOW_FSK :
+                            ( ( buffer[i] & RFLR_OPMODE_ACCESSSHAREDREG_ENABLE ) == 0 ) ? SX1276_SHADOW_LORA : SX1276_SHADOW_SHARED;
+            if( modem != SX1276Shadow.modem )
+            {
+                memset1( SX1276Shadow.valid, 0, sizeof( SX1276Shadow.valid ) );
+                SX1276Shadow.modem = modem;
+            }
+            SX1276Shadow.opMode = buffer[i];
+        }
+        else if( SX1276ShadowIsCached( addr ) )
+        {
+            SX1276Shadow.value[addr] = buffer[i];
+            SX1276Shadow.valid[addr >> 3] |= ( 1 << ( addr & 7 ) );
+        }
+    }
+}
+
+/*!
+ * \brief RegOpMode without the mode bits, from the shadow when known
+ */
+static uint8_t SX1276ReadOpModeConfig( void )
+{
+    if( SX1276Shadow.modem != SX1276_SHADOW_UNKNOWN )
+    {
+        return SX1276Shadow.opMode & RF_OPMODE_MASK;
+    }
+    return SX1276Read( REG_OPMODE ) & RF_OPMODE_MASK;
+}
+
 void SX1276Write( uint16_t addr, uint8_t data )
 {
 	//LOG_INFO_SX1276((">> SX1276Write\r\n"));
@@ -1344,23 +1507,57 @@ uint8_t SX1276Read( uint16_t addr )
     return data;
 }
 
+/*!
+ * Register writes up to this size (address included) are sent in one SPI transfer
+ */
+#define SX1276_WRITE_BLOCK_SZ   16
+
 void SX1276WriteBuffer( uint16_t addr, uint8_t *buffer, uint8_t size )
 {
 	//LOG_INFO_SX1276((">> SX1276WriteBuffer\r\n"));
 
-    uint8_t i;
+    if( addr != REG_FIFO )
+    {
+        // Only write the span of registers changing, the registers already
+        // holding these values at both ends of the block are skipped
+        uint8_t first = 0;
+        uint8_t last = size;
+        while( ( first < last ) && SX1276ShadowIsValid( addr + first ) && ( SX1276Shadow.value[addr + first] == buffer[first] ) )
+        {
+            first++;
+        }
+        if( first == last )
+        {
+            return;
+        }
+        while( SX1276ShadowIsValid( addr + last - 1 ) && ( SX1276Shadow.value[addr + last - 1] == buffer[last - 1] ) )
+        {
+            last--;
+        }
+        SX1276ShadowUpdate( addr, buffer, size );
+        addr += first;
+        buffer += first;
+        size = last - first;
+    }
 
     //NSS = 0;
 	gpio_reset(ITSDK_SX1276_NSS_BANK, ITSDK_SX1276_NSS_PIN);
 
-	uint16_t tx = addr | 0x80;
-	uint16_t rx;
-	spi_rwRegister(&ITSDK_SX1276_SPI,(uint8_t*)&tx,(uint8_t*)&rx,1);
-    for( i = 0; i < size; i++ )
-    {
-    	tx = buffer[i];
-    	spi_rwRegister(&ITSDK_SX1276_SPI,(uint8_t*)&tx,(uint8_t*)&rx,1);
-    }
+	// Address then the data in a single burst, the address auto-increments
+	// except for the FIFO. Register blocks are sent in one SPI transfer.
+	if( size < SX1276_WRITE_BLOCK_SZ )
+	{
+		uint8_t tx[SX1276_WRITE_BLOCK_SZ];
+		tx[0] = addr | 0x80;
+		memcpy1( &tx[1], buffer, size );
+		spi_transmit(&ITSDK_SX1276_SPI,tx,size+1);
+	}
+	else
+	{
+		uint8_t tx = addr | 0x80;
+		spi_transmit(&ITSDK_SX1276_SPI,&tx,1);
+		spi_transmit(&ITSDK_SX1276_SPI,buffer,size);
+	}
 
     //NSS = 1;
 	gpio_set(ITSDK_SX1276_NSS_BANK, ITSDK_SX1276_NSS_PIN);
@@ -1370,24 +1567,32 @@ void SX1276ReadBuffer( uint16_t addr, uint8_t *buffer, uint8_t size )
 {
 	//LOG_INFO_SX1276((">> SX1276ReadBuffer\r\n"));
 
-    uint8_t i;
+    if( addr != REG_FIFO )
+    {
+        // Serve the read from the shadow when all the registers are known
+        uint8_t i;
+        for( i = 0; i < size && SX1276ShadowIsValid( addr + i ); i++ );
+        if( i == size )
+        {
+            memcpy1( buffer, &SX1276Shadow.value[addr], size );
+            return;
+        }
+    }
 
     //NSS = 0;
 	gpio_reset(ITSDK_SX1276_NSS_BANK, ITSDK_SX1276_NSS_PIN);
 
-	uint16_t tx = addr & 0x7f;
-	uint16_t rx;
-	spi_rwRegister(&ITSDK_SX1276_SPI,(uint8_t*)&tx,(uint8_t*)&rx,1);
-
-	tx = 0;
-    for( i = 0; i < size; i++ )
-    {
-    	spi_rwRegister(&ITSDK_SX1276_SPI,(uint8_t*)&tx,(uint8_t*)&rx,1);
-    	buffer[i] = rx;
-    }
+	uint8_t tx = addr & 0x7f;
+	spi_transmit(&ITSDK_SX1276_SPI,&tx,1);
+	spi_receive(&ITSDK_SX1276_SPI,buffer,size);
 
     //NSS = 1;
 	gpio_set(ITSDK_SX1276_NSS_BANK, ITSDK_SX1276_NSS_PIN);
+
+    if( addr != REG_FIFO )
+    {
+        SX1276ShadowUpdate( addr, buffer, size );
+    }
 }
 
 void SX1276WriteFifo( uint8_t *buffer, uint8_t size )
@@ -1446,10 +1651,56 @@ uint32_t SX1276GetWakeupTime( void )
     return ( uint32_t )LoRaBoardCallbacks->SX1276BoardGetWakeTime( ) + ITSDK_MURATA_WAKEUP_TIME;
 }
 
+void SX1276IrqProcess( void )
+{
+#if ITSDK_SX1276_DEFERRED_IRQ == __ENABLE
+    uint8_t pending;
+    TimerTime_t edgeTime;
+    uint8_t i;
+
+    while( SX1276IrqPending != 0 )
+    {
+        itsdk_enterCriticalSection( );
+        pending = SX1276IrqPending;
+        edgeTime = SX1276IrqTime;
+        SX1276IrqPending = 0;
+        itsdk_leaveCriticalSection( );
+
+        LOG_INFO_SX1276((">> SX1276IrqProcess 0x%02X (%d ms)\r\n", pending, ( int )TimerGetElapsedTime( edgeTime )));
+
+        // The radio callbacks get the edge time with SX1276GetIrqTime
+        SX1276IrqEdge = edgeTime;
+        SX1276IrqInProcess = true;
+        for( i = 0; i < sizeof( DioIrqProcess ) / sizeof( DioIrqProcess[0] ); i++ )
+        {
+            if( ( pending & ( 1 << DioIrqProcess[i].Dio ) ) != 0 )
+            {
+                DioIrqProcess[i].Handler( NULL );
+            }
+        }
+        SX1276IrqInProcess = false;
+    }
+#endif
+}
+
+uint32_t SX1276GetIrqTime( void )
+{
+#if ITSDK_SX1276_DEFERRED_IRQ == __ENABLE
+    if( SX1276IrqInProcess )
+    {
+        return SX1276IrqEdge;
+    }
+#endif
+    return TimerGetCurrentTime( );
+}
+
 void SX1276OnTimeoutIrq( void* context )
 {
 	LOG_INFO_SX1276((">> SX1276OnTimeoutIrq\r\n"));
 
+    // A DIO event posted before the timeout has precedence over it
+    SX1276IrqProcess( );
+
     switch( SX1276.Settings.State )
     {
     case RF_RX_RUNNING:
@@ -1670,6 +1921,9 @@ void SX1276OnDio0Irq( void* context )
                         }
                     }
 
+                    // Packet RSSI / SNR low bits are noisy, feed the random pool with them
+                    itsdk_random_addEntropy( ( ( uint32_t )rssi << 8 ) | ( uint8_t )SX1276.Settings.LoRaPacketHandler.SnrValue, 2 );
+
                     SX1276.Settings.LoRaPacketHandler.Size = SX1276Read( REG_LR_RXNBBYTES );
                     SX1276Write( REG_LR_FIFOADDRPTR, SX1276Read( REG_LR_FIFORXCURRENTADDR ) );
                     SX1276ReadFifo( RxTxBuffer, SX1276.Settings.LoRaPacketHandler.Size );
@@ -27,6 +27,7 @@
 #include <it_sdk/config.h>
 #include <it_sdk/logger/logger.h>
 #include <it_sdk/time/time.h>
+#include <it_sdk/ring/ring.h>
 #include <math.h>
 
 #if ITSDK_WITH_DRIVERS == __ENABLE
@@ -40,17 +41,12 @@
  * EventQueue for asynchronous processing
  */
 itsdk_bool_e					__accel_setupDone = BOOL_FALSE;
-itsdk_accel_trigger_e 			__triggerQueue[ACCEL_TRIGGER_QUEUE_SIZE];
-uint8_t				  			__triggerQueueRd;
-uint8_t				 			__triggerQueueWr;
+ITSDK_RING_DECLARE(__triggerQueue,itsdk_accel_trigger_e,ACCEL_TRIGGER_QUEUE_SIZE);
 itsdk_accel_eventHandler_t * 	__accel_eventQueue;
 uint64_t						__accel_lastTriggerReportMs;
 uint32_t						__accel_noMovementDuration;
 itsdk_bool_e					__accel_noMovementReported;
-itsdk_accel_data_t				__accel_dataBuffer[ITSDK_DRIVERS_ACCEL_DATABLOCK_BUFFER_SZ];
-uint8_t							__accel_dataBufferRd;
-uint8_t							__accel_dataBufferWr;
-uint8_t							__accel_dataBufferSz;
+ITSDK_RING_DECLARE(__accel_dataBuffer,itsdk_accel_data_t,ITSDK_DRIVERS_ACCEL_DATABLOCK_BUFFER_SZ);
 itsdk_bool_e					__accel_dataOverrun;
 itsdk_bool_e					__accel_running;
 uint16_t						__accel_dataBlockSz;
@@ -83,13 +79,10 @@ itsdk_accel_ret_e accel_initPowerDown() {
 	}
    #endif
 
-	__triggerQueueRd = 0;
-	__triggerQueueWr = 0;
+	itsdk_ring_init(&__triggerQueue);
 	__accel_eventQueue = NULL;
 
-	__accel_dataBufferRd = 0;
-	__accel_dataBufferWr = 0;
-	__accel_dataBufferSz = 0;
+	itsdk_ring_init(&__accel_dataBuffer);
 	__accel_dataOverrun = BOOL_FALSE;
 	__accel_setupDone = BOOL_TRUE;
 
@@ -116,6 +109,20 @@ void accel_process_loop(void) {
 	__accel_asyncMovementCaptureProcess();
 }
 
+/**
+ * Get the trigger queue and data buffer max usage and number of elements
+ * dropped, to size ACCEL_TRIGGER_QUEUE_SIZE and the data buffer.
+ */
+void accel_getQueueStats(
+		uint16_t * trigHighWater,
+		uint32_t * trigOverflow,
+		uint16_t * dataHighWater,
+		uint32_t * dataOverflow
+) {
+	itsdk_ring_getStats(&__triggerQueue,trigHighWater,trigOverflow);
+	itsdk_ring_getStats(&__accel_dataBuffer,dataHighWater,dataOverflow);
+}
+
 
 // ========================================================================================
 // EVENT DETECTION
@@ -250,8 +257,7 @@ itsdk_accel_ret_e accel_stopMovementDetection(itsdk_bool_e removeHandler) {
 		__accel_eventQueue = NULL;
 	}
 	// clear pending events
-	__triggerQueueRd = 0;
-	__triggerQueueWr = 0;
+	itsdk_ring_flush(&__triggerQueue);
 
 	__accel_running = BOOL_FALSE;
 	return ACCEL_SUCCESS;
@@ -376,19 +382,8 @@ static void __accel_movementCaptureCallback(
 ) {
 
 	if ( overrun ) __accel_dataOverrun = BOOL_TRUE;
-	for (int i = 0 ; i < count ; i++ ) {
-		__accel_dataBuffer[__accel_dataBufferWr].x = data[i].x;
-		__accel_dataBuffer[__accel_dataBufferWr].y = data[i].y;
-		__accel_dataBuffer[__accel_dataBufferWr].z = data[i].z;
-		__accel_dataBufferSz++;
-		itsdk_enterCriticalSection();
-		__accel_dataBufferWr = ( __accel_dataBufferWr + 1 ) & (ITSDK_DRIVERS_ACCEL_DATABLOCK_BUFFER_SZ-1);
-		if ( __accel_dataBufferWr == __accel_dataBufferRd ) {
-			__accel_dataBufferRd = ( __accel_dataBufferRd + 1 ) & (ITSDK_DRIVERS_ACCEL_DATABLOCK_BUFFER_SZ-1);
-			__accel_dataOverrun = BOOL_TRUE;
-			__accel_dataBufferSz = (ITSDK_DRIVERS_ACCEL_DATABLOCK_BUFFER_SZ-1);
-		}
-		itsdk_leaveCriticalSection();
+	if ( itsdk_ring_push(&__accel_dataBuffer,data,count) < count ) {
+		__accel_dataOverrun = BOOL_TRUE;
 	}
 }
 
@@ -400,25 +395,17 @@ void __accel_asyncMovementCaptureProcess(void) {
 
 
 	// We move the data as soon as we have the remaining data available or when we touched the watermark
+	uint16_t pending = itsdk_ring_count(&__accel_dataBuffer);
 	if (
-			(__accel_dataBlockSz <= __accel_dataBlockSzTransfered + __accel_dataBufferSz)
-		||  (__accel_dataBufferSz > ITSDK_DRIVERS_ACCEL_DATABLOCK_BUFFER_WTM )
+			(__accel_dataBlockSz <= __accel_dataBlockSzTransfered + pending)
+		||  (pending > ITSDK_DRIVERS_ACCEL_DATABLOCK_BUFFER_WTM )
 	) {
-		uint8_t toRead = (__accel_dataBlockSz <= __accel_dataBlockSzTransfered + __accel_dataBufferSz)?
+		uint16_t toRead = (__accel_dataBlockSz <= __accel_dataBlockSzTransfered + pending)?
 				__accel_dataBlockSz - __accel_dataBlockSzTransfered :
 				ITSDK_DRIVERS_ACCEL_DATABLOCK_BUFFER_WTM;
 
 		// Buffer is ready for copy
-		itsdk_enterCriticalSection();
-		for (int i = 0 ; i < toRead ; i++ ) {
-			__accel_dataDestBuffer[__accel_dataBlockSzTransfered].x = __accel_dataBuffer[__accel_dataBufferRd].x;
-			__accel_dataDestBuffer[__accel_dataBlockSzTransfered].y = __accel_dataBuffer[__accel_dataBufferRd].y;
-			__accel_dataDestBuffer[__accel_dataBlockSzTransfered].z = __accel_dataBuffer[__accel_dataBufferRd].z;
-			__accel_dataBufferRd = ( __accel_dataBufferRd + 1 ) & (ITSDK_DRIVERS_ACCEL_DATABLOCK_BUFFER_SZ-1);
-			__accel_dataBufferSz--;
-			__accel_dataBlockSzTransfered++;
-		}
-		itsdk_leaveCriticalSection();
+		__accel_dataBlockSzTransfered += itsdk_ring_pop(&__accel_dataBuffer,&__accel_dataDestBuffer[__accel_dataBlockSzTransfered],toRead);
 
 		// Is Block completed
 		if ( __accel_dataBlockSzTransfered == __accel_dataBlockSz ) {
@@ -554,33 +541,18 @@ itsdk_bool_e accel_isTriggerCallBack(
  * This callback is fired by the interrupt process.
  * To reduce the interrupt processing time, the trigger will be
  * queued and then process in the accel_process loop.
- * Circular buffer power of 2 sized. Old values are cleared by new
- * values
+ * Circular buffer power of 2 sized. New values are dropped when
+ * the queue is full.
  */
 void __accel_addToQueue(itsdk_accel_trigger_e triggers) {
-	itsdk_enterCriticalSection();
-
-	__triggerQueue[__triggerQueueWr] = triggers;
-	__triggerQueueWr = (__triggerQueueWr + 1) & (ACCEL_TRIGGER_QUEUE_SIZE-1);
-	if ( __triggerQueueWr == __triggerQueueRd ) {
-		// Buffer full
-		__triggerQueueRd = (__triggerQueueRd + 1) & (ACCEL_TRIGGER_QUEUE_SIZE-1);
-	}
-
-	itsdk_leaveCriticalSection();
+	itsdk_ring_push(&__triggerQueue,&triggers,1);
 }
 
 itsdk_accel_trigger_e __accel_getFromQueue(void) {
 	itsdk_accel_trigger_e t;
-
-	itsdk_enterCriticalSection();
-	if ( __triggerQueueWr != __triggerQueueRd ) {
-		 t = __triggerQueue[__triggerQueueRd];
-		__triggerQueueRd = (__triggerQueueRd + 1) & (ACCEL_TRIGGER_QUEUE_SIZE-1);
-	} else {
+	if ( itsdk_ring_pop(&__triggerQueue,&t,1) == 0 ) {
 		t= ACCEL_TRIGGER_ON_NONE;
 	}
-	itsdk_leaveCriticalSection();
 	return t;
 }
 
@@ -26,6 +26,7 @@
  */
 #include <stdio.h>
 #include <stdarg.h>
+#include <inttypes.h>
 #include <sys/types.h>
 #include <string.h>
 #include <stdbool.h>
@@ -48,6 +49,12 @@
 #if ITSDK_RADIO_CERTIF == __ENABLE && (ITSDK_WITH_SIGFOX_LIB == __ENABLE || ITSDK_WITH_LORAWAN_LIB == __ENABLE )
 #include <it_sdk/radio/certification.h>
 #endif
+#if ITSDK_WITH_DRIVERS == __ENABLE
+#include <it_sdk/configDrivers.h>
+  #if ITSDK_DRIVERS_WITH_ACCEL_DRIVER == __ENABLE
+	#include <it_sdk/accel/accel.h>
+  #endif
+#endif
 
 static itsdk_console_state_t __console;
 static itsdk_console_chain_t __console_head_chain;
@@ -77,10 +84,21 @@ static itsdk_console_return_e _itsdk_console_private(char * buffer, uint8_t sz)
 			_itsdk_console_printf("B          : print VCC level\r\n");
 #endif
 			_itsdk_console_printf("r          : print last Reset Cause\r\n");
+			_itsdk_console_printf("u          : print ring buffers max usage / dropped\r\n");
+#if ITSDK_WITH_SPI == __SPI_ENABLED
+			_itsdk_console_printf("p / P      : print / clear SPI transactions & bytes\r\n");
+#endif
 
 #if ITSDK_RADIO_CERTIF == __ENABLE && (ITSDK_WITH_SIGFOX_LIB == __ENABLE || ITSDK_WITH_LORAWAN_LIB == __ENABLE )
 			_itsdk_console_printf("c:0:nnn    : CW for CE tests with power\r\n");
 			_itsdk_console_printf("c:1:nnn    : CW for EU Sigfox tests with power\r\n");
+			_itsdk_console_printf("c:f:f1,..  : test plan frequencies in kHz\r\n");
+			_itsdk_console_printf("c:F:f1,..  : add test plan frequencies\r\n");
+			_itsdk_console_printf("c:p:p1,..  : test plan CW powers in dBm\r\n");
+			_itsdk_console_printf("c:P:p1,..  : add test plan CW powers\r\n");
+			_itsdk_console_printf("c:t:d,r,s  : CW dwell ms, RX window ms, RX min RSSI\r\n");
+			_itsdk_console_printf("c:s / c:x  : start / stop the test plan\r\n");
+			_itsdk_console_printf("c:l        : print the test plan\r\n");
 #endif
 
 			return ITSDK_CONSOLE_SUCCES;
@@ -124,6 +142,38 @@ static itsdk_console_return_e _itsdk_console_private(char * buffer, uint8_t sz)
 				_itsdk_console_printf("UNKNOWN\r\n"); break;
 			}
 			goto success;
+		case 'u':
+			// Ring buffers usage
+			{
+			uint16_t hw;
+			uint32_t ov;
+			serial1_getRxStats(&hw,&ov);
+			_itsdk_console_printf("Serial1 RX : %d / %"PRIu32"\r\n",hw,ov);
+			serial2_getRxStats(&hw,&ov);
+			_itsdk_console_printf("Serial2 RX : %d / %"PRIu32"\r\n",hw,ov);
+		   #if ITSDK_WITH_DRIVERS == __ENABLE && ITSDK_DRIVERS_WITH_ACCEL_DRIVER == __ENABLE
+			uint16_t dhw;
+			uint32_t dov;
+			accel_getQueueStats(&hw,&ov,&dhw,&dov);
+			_itsdk_console_printf("Accel trig : %d / %"PRIu32"\r\n",hw,ov);
+			_itsdk_console_printf("Accel data : %d / %"PRIu32"\r\n",dhw,dov);
+		   #endif
+			goto success;
+			}
+#if ITSDK_WITH_SPI == __SPI_ENABLED
+		case 'p':
+			// SPI counters
+			{
+			uint32_t tr, by;
+			spi_getStats(&tr,&by);
+			_itsdk_console_printf("SPI : %"PRIu32" transactions / %"PRIu32" bytes\r\n",tr,by);
+			goto success;
+			}
+		case 'P':
+			// Clear the SPI counters
+			spi_resetStats();
+			goto success;
+#endif
 		case 'R':
 			// Reset device
 			_itsdk_console_printf("OK\r\n");
@@ -151,7 +201,7 @@ static itsdk_console_return_e _itsdk_console_private(char * buffer, uint8_t sz)
 	}
 #if ITSDK_RADIO_CERTIF == __ENABLE && (ITSDK_WITH_SIGFOX_LIB == __ENABLE || ITSDK_WITH_LORAWAN_LIB == __ENABLE )
 	  else if ( sz==7 ) {
-		if ( buffer[0] == 'c' && buffer[1] == ':' && buffer[3] == ':' ) {
+		if ( buffer[0] == 'c' && buffer[1] == ':' && buffer[3] == ':' && ( buffer[2] == '0' || buffer[2] == '1' ) ) {
 		 int power = itdt_convertDecChar3UInt(&buffer[4]);
 		 if ( power == ITSDK_INVALID_VALUE_16B ) goto failed;
 		 if ( buffer[2] == '0' ) {
@@ -162,9 +212,13 @@ static itsdk_console_return_e _itsdk_console_private(char * buffer, uint8_t sz)
 			 // Sigfox RC1 certification, frequency 868.130.000MHz
 			 if ( startContinousWaveTransmission( 868130000,power,0 ) == BOOL_FALSE ) goto failed;
 			 goto success;
-		 } else goto failed;
+		 }
 		}
 	}
+	if ( sz > 2 && buffer[0] == 'c' ) {
+		// Test plan sequencer
+		return itsdk_certif_seq_console(buffer,sz);
+	}
 #endif
 	return ITSDK_CONSOLE_NOTFOUND;
 
@@ -40,6 +40,16 @@
 #if (ITSDK_WITH_SIGFOX_LIB == __ENABLE)
   #include <it_sdk/sigfox/sigfox.h>
 #endif
+#if (ITSDK_WITH_LORAWAN_LIB == __ENABLE)
+  #include <it_sdk/lorawan/lorawan.h>
+#endif
+
+// The secure store rekey journal is kept in the last bytes of the EEPROM
+#if ITSDK_WITH_SECURESTORE == __ENABLE && ITSDK_SECSTORE_REKEY_JOURNAL == __ENABLE
+  #define __EEPROM_USERLAND_END		(ITSDK_EPROM_SIZE-sizeof(itsdk_secStoreJournal_t))
+#else
+  #define __EEPROM_USERLAND_END		ITSDK_EPROM_SIZE
+#endif
 
 
 /**
@@ -57,7 +67,7 @@ itsdk_bool_e eeprom_write_userland(uint32_t offset, void * data, uint16_t len, i
 	if ( t.magic != ITDT_EEPROM_MAGIC_USERLAND ) {
 		if ( initialize ) {
 			t.magic = ITDT_EEPROM_MAGIC_USERLAND;
-			t.size = ITSDK_EPROM_SIZE - _offset;
+			t.size = __EEPROM_USERLAND_END - _offset;
 			t.version = 0;
 			t.crc32 = 0;
 			// write header
@@ -71,7 +81,7 @@ itsdk_bool_e eeprom_write_userland(uint32_t offset, void * data, uint16_t len, i
 
 	// verify the location
 	_offset = _offset + sizeof(t) + offset;
-	if ( (_offset + len) > ITSDK_EPROM_SIZE ) {
+	if ( (_offset + len) > __EEPROM_USERLAND_END ) {
 		_LOG_EEPROM(("[NVM][E] UL Write out of eeprom area\r\n",len));
 		return BOOL_FALSE;
 	}
@@ -109,7 +119,7 @@ itsdk_bool_e eeprom_read_userland(uint32_t offset, void * data, uint16_t len) {
 
 	// verify the location
 	_offset = _offset + sizeof(t) + offset;
-	if ( (_offset + len) > ITSDK_EPROM_SIZE ) {
+	if ( (_offset + len) > __EEPROM_USERLAND_END ) {
 		_LOG_EEPROM(("[NVM][E] UL Read out of eeprom area\r\n",len));
 		return BOOL_FALSE;
 	}
@@ -218,10 +228,10 @@ itsdk_bool_e eeprom_getUserLandOffset(uint32_t * _offset) {
 
 /**
  * Compute the EEPROM Config offset
- * Memory have SecureStore then Log then Sigfox config, then Device config
+ * Memory have SecureStore then Log then Sigfox config, then LoRaWan contexts, then Device config
  */
 itsdk_bool_e eeprom_getConfigOffset(uint32_t * _offset) {
-  uint32_t sstore=0, ssError=0, sSigfox=0;
+  uint32_t sstore=0, ssError=0, sSigfox=0, sLoRaWan=0;
   #if ITSDK_WITH_SECURESTORE == __ENABLE
 	itsdk_secstore_getStoreSize(&sstore);
   #endif
@@ -231,7 +241,10 @@ itsdk_bool_e eeprom_getConfigOffset(uint32_t * _offset) {
   #if (ITSDK_WITH_SIGFOX_LIB == __ENABLE)
 	itsdk_sigfox_getNvmSize(&sSigfox);
   #endif
-  *_offset += sstore + ssError + sSigfox;
+  #if (ITSDK_WITH_LORAWAN_LIB == __ENABLE)
+	itsdk_lorawan_getNvmSize(&sLoRaWan);
+  #endif
+  *_offset += sstore + ssError + sSigfox + sLoRaWan;
   return BOOL_TRUE;
 }
 
@@ -39,6 +39,9 @@
 	#include <it_sdk/sigfox/sigfox.h>
     #include <drivers/sigfox/se_nvm.h>
 #endif
+#if ITSDK_WITH_LORAWAN_LIB == __ENABLE
+	#include <it_sdk/lorawan/lorawan.h>
+#endif
 
 #if ITSDK_WITH_CONSOLE == __ENABLE
   #include <it_sdk/console/console.h>
@@ -309,14 +312,7 @@ itsdk_config_ret_e itsdk_config_commitConfiguration(itsdk_config_commit_mode_e m
 #if ITSDK_WITH_SIGFOX_LIB == __ENABLE
 static bool __checkAndConvert(char * str,uint8_t start,uint8_t stop,uint8_t sz,uint8_t * buf) {
 	if ( (stop - start) < 2*sz ) return false;
-	int k = 0;
-	for ( int i = start ; i < stop ; i+=2 ) {
-		if ( itdt_isHexChar(str[i],false) && itdt_isHexChar(str[i+1],false) ) {
-			buf[k] = itdt_convertHexChar2Int(&str[i]);
-			k++;
-		} else return false;
-	}
-	return true;
+	return itdt_convertHexStr2IntTabChk(&str[start],buf,sz,BOOL_FALSE);
 }
 #endif
 
@@ -390,16 +386,11 @@ static bool __checkAndConvert(char * str,uint8_t start,uint8_t stop,uint8_t sz,u
 					}
 					_itsdk_console_printf("sdk.sigfox.sgfxKey : %d\r\n",_c->sdk.sigfox.sgfxKey);
 					 #if ITSDK_SIGFOX_NVM_SOURCE == __SFX_NVM_LOCALEPROM
-					 _itsdk_console_printf("sdk.sigfox.initialPac : [%02X%02X%02X%02X%02X%02X%02X%02X]\r\n",
-							_c->sdk.sigfox.initialPac[0],
-							_c->sdk.sigfox.initialPac[1],
-							_c->sdk.sigfox.initialPac[2],
-							_c->sdk.sigfox.initialPac[3],
-							_c->sdk.sigfox.initialPac[4],
-							_c->sdk.sigfox.initialPac[5],
-							_c->sdk.sigfox.initialPac[6],
-							_c->sdk.sigfox.initialPac[7]
-						);
+					 {
+						char _pac[2*8+1];
+						itdt_convertIntTab2Hex(_pac,_c->sdk.sigfox.initialPac,8,BOOL_TRUE);
+						_itsdk_console_printf("sdk.sigfox.initialPac : [%s]\r\n",_pac);
+					 }
 					 _itsdk_console_printf("sdk.sigfox.deviceId : %08X \r\n",_c->sdk.sigfox.deviceId);
 					 _itsdk_console_printf("sdk.sigfox.rssiCal : %d\r\n",_c->sdk.sigfox.rssiCal);
 					 #endif
@@ -489,9 +480,20 @@ static itsdk_console_return_e _itsdk_config_consolePriv(char * buffer, uint8_t s
 			  	offset += size;
 			  	totSize += size;
 			  #endif
+			  #if (ITSDK_WITH_LORAWAN_LIB == __ENABLE)
+			  	itsdk_lorawan_getNvmSize(&size);
+			  	_itsdk_console_printf("LoRaWanContexts: 0x%08X->0x%08X (%dB)\r\n",offset,offset+size,size);
+			  	offset += size;
+			  	totSize += size;
+			  #endif
 			  eeprom_getConfigSize(&size);
   		  	  totSize += size;
 			  _itsdk_console_printf("ApplicationConfig: 0x%08X->0x%08X (%dB)\r\n",offset,offset+size,size);
+			  #if ITSDK_WITH_SECURESTORE == __ENABLE && ITSDK_SECSTORE_REKEY_JOURNAL == __ENABLE
+			  	size = sizeof(itsdk_secStoreJournal_t);
+			  	totSize += size;
+			  	_itsdk_console_printf("RekeyJournal: 0x%08X->0x%08X (%dB)\r\n",ITSDK_EPROM_SIZE-size,ITSDK_EPROM_SIZE,size);
+			  #endif
 			  _itsdk_console_printf("UsedMemory: %dB on %dB\r\n",totSize,ITSDK_EPROM_SIZE);
 			  _itsdk_console_printf("OK\r\n");
 			 return ITSDK_CONSOLE_SUCCES;
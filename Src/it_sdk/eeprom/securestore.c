@@ -205,6 +205,27 @@ static itsdk_secStoreReturn_e _itsdk_secstore_getOffset(uint32_t * offset, uint8
 		return SS_FAILED_NOTEXISTING;
 	  #endif
 		break;
+	case ITSDK_SS_S2LP_CNF:
+	  #if ITSDK_SECSTORE_S2LP_CACHE == __ENABLE
+		_offset = (uint32_t)&fakeStore->s2lpCache[0];
+  	  #else
+		return SS_FAILED_NOTEXISTING;
+	  #endif
+		break;
+	case ITSDK_SS_S2LP_IDPAC:
+	  #if ITSDK_SECSTORE_S2LP_CACHE == __ENABLE
+		_offset = (uint32_t)&fakeStore->s2lpCache[1];
+  	  #else
+		return SS_FAILED_NOTEXISTING;
+	  #endif
+		break;
+	case ITSDK_SS_S2LP_KEY:
+	  #if ITSDK_SECSTORE_S2LP_CACHE == __ENABLE
+		_offset = (uint32_t)&fakeStore->s2lpCache[2];
+  	  #else
+		return SS_FAILED_NOTEXISTING;
+	  #endif
+		break;
 	default:
 		return SS_FAILED_NOTEXISTING;
 
@@ -232,6 +253,9 @@ static itsdk_secStoreReturn_e _itsdk_secstore_getEntries(uint8_t * entries) {
 	_entries+=2;
    #endif
 	_entries+=ITSDK_SECSTORE_USRBLOCK;
+   #if ITSDK_SECSTORE_S2LP_CACHE == __ENABLE
+	_entries+=3;
+   #endif
 	*entries=_entries;
 	return SS_SUCCESS;
 }
@@ -298,6 +322,60 @@ __weak void itsdk_secstore_generateMasterKey(uint8_t * dynamicKey,uint8_t * mast
 	itsdk_encrypt_cifferKey(masterKey,16);
 }
 
+// ============================================================================================================
+// REKEY JOURNAL
+// ============================================================================================================
+
+// The journal is kept in RAM during the job. With ITSDK_SECSTORE_REKEY_JOURNAL it is
+// also written in the last 32B of the EEPROM, after the user land, so no other zone
+// moves. It is read from EEPROM once on boot by itsdk_secstore_recover().
+#define ITSDK_SECSTORE_JOURNAL_OFFSET	(ITSDK_EPROM_SIZE-sizeof(itsdk_secStoreJournal_t))
+
+static itsdk_secStoreJournal_t __secstore_journal;
+
+/**
+ * Return true when a rekey job is running
+ */
+static bool _itsdk_secstore_isJournalRunning() {
+	return ( __secstore_journal.magic == ITSDK_SECSTORE_JOURNAL_MAGIC );
+}
+
+/**
+ * Write the journal first word (magic, current block, phase) in a single
+ * EEPROM word operation.
+ */
+static void _itsdk_secstore_writeJournalState() {
+  #if ITSDK_SECSTORE_REKEY_JOURNAL == __ENABLE
+	_eeprom_write(ITDT_EEPROM_BANK0, ITSDK_SECSTORE_JOURNAL_OFFSET, (void *) &__secstore_journal, 4);
+  #endif
+}
+
+/**
+ * Clear the journal, the new key and the backup must not stay in memory
+ */
+static void _itsdk_secstore_clearJournal() {
+	bzero(&__secstore_journal,sizeof(itsdk_secStoreJournal_t));
+  #if ITSDK_SECSTORE_REKEY_JOURNAL == __ENABLE
+	_eeprom_write(ITDT_EEPROM_BANK0, ITSDK_SECSTORE_JOURNAL_OFFSET, (void *) &__secstore_journal, sizeof(itsdk_secStoreJournal_t));
+  #endif
+}
+
+/**
+ * Compute the masterKey to be used for a given block. During a rekey job
+ * the blocks already migrated are using the new dynamic key.
+ */
+static void _itsdk_secstore_getBlockMasterKey(itsdk_secStoreHead_t * _head, uint8_t _id, uint8_t * masterKey) {
+	if ( _itsdk_secstore_isJournalRunning() && _id < __secstore_journal.current ) {
+		uint8_t _newKey[12];
+		memcpy(_newKey,__secstore_journal.newKey,12);
+		itsdk_encrypt_unCifferKey(_newKey,12);
+		itsdk_secstore_generateMasterKey(_newKey,masterKey);
+		bzero(_newKey,12);
+	} else {
+		itsdk_secstore_generateMasterKey(_head->dynamicKey,masterKey);
+	}
+}
+
 /**
  * Read the given block and returns the decrypted value into the buffer
  */
@@ -320,7 +398,7 @@ itsdk_secStoreReturn_e itsdk_secstore_readBlock(itsdk_secStoreBlocks_e blockType
 
 	// Generate the Master key
 	uint8_t masterKey[16];
-	itsdk_secstore_generateMasterKey(_head.dynamicKey,masterKey);
+	_itsdk_secstore_getBlockMasterKey(&_head,_id,masterKey);
 
 	// Decode with AES-128
 	itsdk_aes_ecb_decrypt_128B(buffer,buffer,ITSDK_SECSTORE_BLOCKSZ,masterKey);
@@ -344,7 +422,7 @@ itsdk_secStoreReturn_e itsdk_secstore_writeBlock(itsdk_secStoreBlocks_e blockTyp
 
 	// Generate the Master key
 	uint8_t masterKey[16];
-	itsdk_secstore_generateMasterKey(_head.dynamicKey,masterKey);
+	_itsdk_secstore_getBlockMasterKey(&_head,_id,masterKey);
 
 	// Encode with AES-128
 	itsdk_aes_ecb_encrypt_128B(buffer,buffer,ITSDK_SECSTORE_BLOCKSZ,masterKey);
@@ -361,6 +439,41 @@ itsdk_secStoreReturn_e itsdk_secstore_writeBlock(itsdk_secStoreBlocks_e blockTyp
 	return SS_SUCCESS;
 }
 
+/**
+ * Encrypt / decrypt (same operation) data kept out of the store, like the
+ * LoRaWan session keys saved with the MAC contexts. AES-128 CTR with a key
+ * derived from the store master key, iv must change on each write of the
+ * same data. The data can't be decrypted anymore once the store is rekeyed.
+ */
+itsdk_secStoreReturn_e itsdk_secstore_cipher(uint8_t * data, uint16_t len, uint32_t iv) {
+	itsdk_secStoreHead_t	_head;
+	uint8_t masterKey[16];
+	uint8_t _b[ITSDK_SECSTORE_BLOCKSZ];
+
+	if ( _itsdk_secstore_controlHeader(&_head) != SS_SUCCESS ) return SS_FAILED_NOTINITIALIZED;
+
+	// Derive a dedicated key, the master key is only used for the blocks
+	itsdk_secstore_generateMasterKey(_head.dynamicKey,masterKey);
+	memset(_b,0xC3,ITSDK_SECSTORE_BLOCKSZ);
+	itsdk_aes_ecb_encrypt_128B(_b,masterKey,ITSDK_SECSTORE_BLOCKSZ,masterKey);
+
+	for ( uint16_t i = 0 ; i < len ; i += ITSDK_SECSTORE_BLOCKSZ ) {
+		bzero(_b,ITSDK_SECSTORE_BLOCKSZ);
+		_b[0] = (uint8_t)(iv >> 24);
+		_b[1] = (uint8_t)(iv >> 16);
+		_b[2] = (uint8_t)(iv >> 8);
+		_b[3] = (uint8_t)iv;
+		_b[4] = (uint8_t)(i >> 12);
+		_b[5] = (uint8_t)(i >> 4);
+		itsdk_aes_ecb_encrypt_128B(_b,_b,ITSDK_SECSTORE_BLOCKSZ,masterKey);
+		for ( int j = 0 ; j < ITSDK_SECSTORE_BLOCKSZ && i+j < len ; j++ ) {
+			data[i+j] ^= _b[j];
+		}
+	}
+	bzero(_b,ITSDK_SECSTORE_BLOCKSZ);
+	bzero(masterKey,16);
+	return SS_SUCCESS;
+}
 
 
 /**
@@ -374,12 +487,16 @@ itsdk_secStoreReturn_e itsdk_secstore_init() {
 	_itsdk_secstore_getEntries(&count);
 	_head.blockCount=count;
 	_head.blockUsed = 0x1;
+	_head.reserved2 = 0;
 	uint8_t _buff[12] = ITSDK_SECSTORE_DEFKEY;
 	memcpy(_head.dynamicKey,_buff,12);
 
 	// Store it
 	_eeprom_write(ITDT_EEPROM_BANK0, ITSDK_SECSTORE_EEPROM_OFFSET, (void *) &_head, sizeof(itsdk_secStoreHead_t));
 
+	// Clear any pending rekey job
+	_itsdk_secstore_clearJournal();
+
 	// Init the console login
 	uint8_t _buff2[16] = ITSDK_SECSTORE_CONSOLEKEY;
 	itsdk_secstore_writeBlock(ITSDK_SS_CONSOLEKEY,_buff2);
@@ -397,163 +514,156 @@ itsdk_secStoreReturn_e itsdk_secstore_isInit() {
 	return _itsdk_secstore_controlHeader(&_head);
 }
 
-
-// ===========================================================================================
-// CONSOLE EXTENSION
-// ===========================================================================================
-
-#if ITSDK_WITH_CONSOLE == __ENABLE
-
-#define __console_print_hex(b,off,sz) {												\
-								   	    for ( int __i = off; __i<off+sz ; __i++ ) {	\
-										     _itsdk_console_printf("%02X",b[__i]);	\
-									    }											\
-									    _itsdk_console_printf("\r\n");				\
-								      }
+// ============================================================================================================
+// REKEY JOB
+// ============================================================================================================
+//
+// The dynamic key change is executed block by block from itsdk_loop. The journal
+// contains the new key, the block under migration and a copy of this block so an
+// interrupted rekey can be resumed after a power loss:
+// - PREPARE : the current block is untouched, the backup is being written
+// - WRITE   : the backup is valid, the current block is being rewritten
+// - HEADER  : all the blocks are migrated, the header dynamic key is being rewritten
+// Blocks lower than current are encrypted with the new key, the others with the old one.
+// Without ITSDK_SECSTORE_REKEY_JOURNAL the job is lost on reset and the blocks already
+// migrated can't be read anymore.
 
 /**
- * Write a block with a specified MasterKey
+ * Start a rekey job with the given 12B dynamic key. The job is executed
+ * in background from itsdk_loop.
  */
-static itsdk_secStoreReturn_e _itsdk_secstore_writeBlockKey(itsdk_secStoreBlocks_e blockType, uint8_t * buffer, uint8_t * masterKey) {
-
-	// Control the blockId validity
-	uint32_t _offset = 0;
-	uint8_t  _id = 0;
-	if ( _itsdk_secstore_getOffset(&_offset,&_id, blockType) != SS_SUCCESS ) return SS_FAILED_NOTEXISTING;
-
-	// Encode with AES-128
-	itsdk_aes_ecb_encrypt_128B(buffer,buffer,ITSDK_SECSTORE_BLOCKSZ,masterKey);
-
-	// Write block
-	_eeprom_write(ITDT_EEPROM_BANK0, ITSDK_SECSTORE_EEPROM_OFFSET+_offset, (void *) buffer, ITSDK_SECSTORE_BLOCKSZ);
+itsdk_secStoreReturn_e itsdk_secstore_rekey(uint8_t * newKey) {
+	itsdk_secStoreHead_t	_head;
 
+	if ( _itsdk_secstore_controlHeader(&_head) != SS_SUCCESS ) return SS_FAILED_NOTINITIALIZED;
+	if ( _itsdk_secstore_isJournalRunning() ) return SS_FAILED;
+
+	// Write the new key before activating the journal
+	bzero(&__secstore_journal,sizeof(itsdk_secStoreJournal_t));
+	memcpy(__secstore_journal.newKey,newKey,12);
+	itsdk_encrypt_cifferKey(__secstore_journal.newKey,12);
+  #if ITSDK_SECSTORE_REKEY_JOURNAL == __ENABLE
+	_eeprom_write(ITDT_EEPROM_BANK0, ITSDK_SECSTORE_JOURNAL_OFFSET+4, (void *) __secstore_journal.newKey, 12);
+  #endif
+
+	__secstore_journal.magic = ITSDK_SECSTORE_JOURNAL_MAGIC;
+	__secstore_journal.current = 0;
+	__secstore_journal.phase = ITSDK_SECSTORE_JOURNAL_PREPARE;
+	_itsdk_secstore_writeJournalState();
 	return SS_SUCCESS;
 }
 
+/**
+ * Load the journal and restore the block under migration when the device has
+ * been reset in the middle of a block rewrite. Must be called on boot before
+ * any block access.
+ */
+itsdk_secStoreReturn_e itsdk_secstore_recover() {
+  #if ITSDK_SECSTORE_REKEY_JOURNAL == __ENABLE
+	_eeprom_read(ITDT_EEPROM_BANK0, ITSDK_SECSTORE_JOURNAL_OFFSET, (void *) &__secstore_journal, sizeof(itsdk_secStoreJournal_t));
+  #endif
+	if ( ! _itsdk_secstore_isJournalRunning() ) {
+		bzero(&__secstore_journal,sizeof(itsdk_secStoreJournal_t));
+		return SS_SUCCESS;
+	}
+	if ( __secstore_journal.phase == ITSDK_SECSTORE_JOURNAL_WRITE ) {
+		uint32_t _offset = sizeof(itsdk_secStoreHead_t)+__secstore_journal.current*ITSDK_SECSTORE_BLOCKSZ;
+		_eeprom_write(ITDT_EEPROM_BANK0, ITSDK_SECSTORE_EEPROM_OFFSET+_offset, (void *) __secstore_journal.backup, ITSDK_SECSTORE_BLOCKSZ);
+		__secstore_journal.phase = ITSDK_SECSTORE_JOURNAL_PREPARE;
+		_itsdk_secstore_writeJournalState();
+	}
+	return SS_SUCCESS;
+}
 
 /**
- * Change the dyn key and update all the encrypted elements
+ * Return true when a rekey job is running
  */
-static itsdk_console_return_e _itsk_secstore_rekey(uint8_t * newKey){
+bool itsdk_secstore_isRekeyRunning() {
+	return _itsdk_secstore_isJournalRunning();
+}
 
+/**
+ * Execute one step of the rekey job. Called from itsdk_loop.
+ * Return true when the job is still running.
+ */
+bool itsdk_secstore_loop() {
 	itsdk_secStoreHead_t	_head;
+	uint8_t masterKey[16];
+	uint8_t newKey[12];
 	uint8_t _b[ITSDK_SECSTORE_BLOCKSZ];
 
-	// Control Header validity & load previous header
-	if ( _itsdk_secstore_controlHeader(&_head) != SS_SUCCESS ) {
-		_itsdk_console_printf("KO\r\n");
-		return ITSDK_CONSOLE_FAILED;
+	if ( ! _itsdk_secstore_isJournalRunning() ) return false;
+	if ( _itsdk_secstore_controlHeader(&_head) != SS_SUCCESS ) return false;
+	memcpy(newKey,__secstore_journal.newKey,12);
+	itsdk_encrypt_unCifferKey(newKey,12);
+
+	if ( __secstore_journal.phase == ITSDK_SECSTORE_JOURNAL_HEADER ) {
+		// Header dynamic key rewrite (the first header word is untouched)
+		memcpy(_head.dynamicKey,newKey,12);
+		_eeprom_write(ITDT_EEPROM_BANK0, ITSDK_SECSTORE_EEPROM_OFFSET+4, (void *) _head.dynamicKey, 12);
+		_itsdk_secstore_clearJournal();
+		bzero(newKey,12);
+		log_info("[SecStore] Rekey done\r\n");
+		return false;
 	}
 
-	// Generate the Master key
-	uint8_t masterKey[16];
-	itsdk_secstore_generateMasterKey(newKey,masterKey);
-
-	if ( itsdk_secstore_readBlock(ITSDK_SS_CONSOLEKEY, _b) != SS_FAILED_NOTSET ) {
-		_itsdk_secstore_writeBlockKey(ITSDK_SS_CONSOLEKEY,_b,masterKey);
+	// Search the next block to migrate. The block ids are the offsets in the
+	// block structure, not a rank in blockCount (LoRaWan blocks are optional)
+	const uint8_t _maxBlock = sizeof(itsdk_secStoreBlocks_t)/ITSDK_SECSTORE_BLOCKSZ;
+	while ( __secstore_journal.current < _maxBlock && (_head.blockUsed & ( 1 << __secstore_journal.current )) == 0 ) {
+		__secstore_journal.current++;
 	}
-#if defined(ITSDK_WITH_SIGFOX_LIB) && ITSDK_WITH_SIGFOX_LIB == __ENABLE
-	if ( itsdk_secstore_readBlock(ITSDK_SS_SIGFOXKEY, _b) != SS_FAILED_NOTSET ) {
-		_itsdk_secstore_writeBlockKey(ITSDK_SS_SIGFOXKEY,_b,masterKey);
-	}
-#endif
-#if defined(ITSDK_WITH_LORAWAN_LIB) && ITSDK_WITH_LORAWAN_LIB == __ENABLE
-	// we have more ABP in the UNION when Staticly compiled
-	if ( itsdk_secstore_readBlock(ITSDK_SS_LORA_ABP_NETIDDEVID, _b) != SS_FAILED_NOTSET ) {
-		_itsdk_secstore_writeBlockKey(ITSDK_SS_LORA_ABP_NETIDDEVID,_b,masterKey);
+	if ( __secstore_journal.current >= _maxBlock ) {
+		__secstore_journal.phase = ITSDK_SECSTORE_JOURNAL_HEADER;
+		_itsdk_secstore_writeJournalState();
+		bzero(newKey,12);
+		return true;
 	}
 
-	if ( itsdk_secstore_readBlock(ITSDK_SS_LORA_ABP_NETKEYF, _b) != SS_FAILED_NOTSET ) {
-		_itsdk_secstore_writeBlockKey(ITSDK_SS_LORA_ABP_NETKEYF,_b,masterKey);
-	}
+	uint32_t _offset = sizeof(itsdk_secStoreHead_t)+__secstore_journal.current*ITSDK_SECSTORE_BLOCKSZ;
+	__secstore_journal.phase = ITSDK_SECSTORE_JOURNAL_PREPARE;
+	_itsdk_secstore_writeJournalState();
 
-	if ( itsdk_secstore_readBlock(ITSDK_SS_LORA_ABP_NETKEYS, _b) != SS_FAILED_NOTSET ) {
-		_itsdk_secstore_writeBlockKey(ITSDK_SS_LORA_ABP_NETKEYS,_b,masterKey);
-	}
+	// Backup the current block
+	_eeprom_read(ITDT_EEPROM_BANK0, ITSDK_SECSTORE_EEPROM_OFFSET+_offset, (void *) __secstore_journal.backup, ITSDK_SECSTORE_BLOCKSZ);
+  #if ITSDK_SECSTORE_REKEY_JOURNAL == __ENABLE
+	_eeprom_write(ITDT_EEPROM_BANK0, ITSDK_SECSTORE_JOURNAL_OFFSET+16, (void *) __secstore_journal.backup, ITSDK_SECSTORE_BLOCKSZ);
+  #endif
+	__secstore_journal.phase = ITSDK_SECSTORE_JOURNAL_WRITE;
+	_itsdk_secstore_writeJournalState();
 
-	if ( itsdk_secstore_readBlock(ITSDK_SS_LORA_ABP_NETSKEY, _b) != SS_FAILED_NOTSET ) {
-		_itsdk_secstore_writeBlockKey(ITSDK_SS_LORA_ABP_NETSKEY,_b,masterKey);
-	}
+	// Re-encrypt the block with the new key
+	itsdk_secstore_generateMasterKey(_head.dynamicKey,masterKey);
+	itsdk_aes_ecb_decrypt_128B(__secstore_journal.backup,_b,ITSDK_SECSTORE_BLOCKSZ,masterKey);
+	itsdk_secstore_generateMasterKey(newKey,masterKey);
+	itsdk_aes_ecb_encrypt_128B(_b,_b,ITSDK_SECSTORE_BLOCKSZ,masterKey);
+	_eeprom_write(ITDT_EEPROM_BANK0, ITSDK_SECSTORE_EEPROM_OFFSET+_offset, (void *) _b, ITSDK_SECSTORE_BLOCKSZ);
 
-	if ( itsdk_secstore_readBlock(ITSDK_SS_LORA_ABP_APPSKEY, _b) != SS_FAILED_NOTSET ) {
-		_itsdk_secstore_writeBlockKey(ITSDK_SS_LORA_ABP_APPSKEY,_b,masterKey);
-	}
-	#if (ITSDK_LORAWAN_ACTTYPE == __LORAWAN_ACTIVATION_DYNAMIC)
-	// in this case the secure store have two different parts for storing ABP & OTAA, otherwise one fit all
-	if ( itsdk_secstore_readBlock(ITSDK_SS_LORA_OTAA_DEVEUIAPPEUI, _b) != SS_FAILED_NOTSET ) {
-		_itsdk_secstore_writeBlockKey(ITSDK_SS_LORA_OTAA_DEVEUIAPPEUI,_b,masterKey);
-	}
+	// Move to next block
+	__secstore_journal.current++;
+	__secstore_journal.phase = ITSDK_SECSTORE_JOURNAL_PREPARE;
+	_itsdk_secstore_writeJournalState();
 
-	if ( itsdk_secstore_readBlock(ITSDK_SS_LORA_OTAA_APPKEY, _b) != SS_FAILED_NOTSET ) {
-		_itsdk_secstore_writeBlockKey(ITSDK_SS_LORA_OTAA_APPKEY,_b,masterKey);
-	}
+	bzero(_b,ITSDK_SECSTORE_BLOCKSZ);
+	bzero(masterKey,16);
+	bzero(newKey,12);
+	return true;
+}
 
-	if ( itsdk_secstore_readBlock(ITSDK_SS_LORA_OTAA_NWKKEY, _b) != SS_FAILED_NOTSET ) {
-		_itsdk_secstore_writeBlockKey(ITSDK_SS_LORA_OTAA_NWKKEY,_b,masterKey);
-	}
-	#endif
 
-	// ITSDK_SS_LORA_OTAA_DEVEUIAPPEUI
-	// ITSDK_SS_LORA_OTAA_APPKEY
-	// ITSDK_SS_LORA_OTAA_NWKKEY
-#endif
-#if ( defined(ITSDK_SIGFOX_ENCRYPTION) && ( ITSDK_SIGFOX_ENCRYPTION > 0 )) || (defined(ITSDK_LORAWAN_ENCRYPTION) && ( ITSDK_LORAWAN_ENCRYPTION > 0))
-	if ( itsdk_secstore_readBlock(ITSDK_SS_AES_MASTERK, _b) != SS_FAILED_NOTSET ) {
-		_itsdk_secstore_writeBlockKey(ITSDK_SS_AES_MASTERK,_b,masterKey);
-	}
-	if ( itsdk_secstore_readBlock(ITSDK_SS_AES_SHARED_NONCE_SPECKKEY, _b) != SS_FAILED_NOTSET ) {
-		_itsdk_secstore_writeBlockKey(ITSDK_SS_AES_SHARED_NONCE_SPECKKEY,_b,masterKey);
-	}
-#endif
-#if ITSDK_SECSTORE_USRBLOCK >= 1
-	if ( itsdk_secstore_readBlock(ITSDK_SS_USER0, _b) != SS_FAILED_NOTSET ) {
-		_itsdk_secstore_writeBlockKey(ITSDK_SS_USER0,_b,masterKey);
-	}
-#endif
-#if ITSDK_SECSTORE_USRBLOCK >= 2
-	if ( itsdk_secstore_readBlock(ITSDK_SS_USER1, _b) != SS_FAILED_NOTSET ) {
-		_itsdk_secstore_writeBlockKey(ITSDK_SS_USER1,_b,masterKey);
-	}
-#endif
-#if ITSDK_SECSTORE_USRBLOCK >= 3
-	if ( itsdk_secstore_readBlock(ITSDK_SS_USER2, _b) != SS_FAILED_NOTSET ) {
-		_itsdk_secstore_writeBlockKey(ITSDK_SS_USER2,_b,masterKey);
-	}
-#endif
-#if ITSDK_SECSTORE_USRBLOCK >= 4
-	if ( itsdk_secstore_readBlock(ITSDK_SS_USER3, _b) != SS_FAILED_NOTSET ) {
-		_itsdk_secstore_writeBlockKey(ITSDK_SS_USER3,_b,masterKey);
-	}
-#endif
-#if ITSDK_SECSTORE_USRBLOCK >= 5
-	if ( itsdk_secstore_readBlock(ITSDK_SS_USER4, _b) != SS_FAILED_NOTSET ) {
-		_itsdk_secstore_writeBlockKey(ITSDK_SS_USER4,_b,masterKey);
-	}
-#endif
-#if ITSDK_SECSTORE_USRBLOCK >= 6
-	if ( itsdk_secstore_readBlock(ITSDK_SS_USER5, _b) != SS_FAILED_NOTSET ) {
-		_itsdk_secstore_writeBlockKey(ITSDK_SS_USER5,_b,masterKey);
-	}
-#endif
-#if ITSDK_SECSTORE_USRBLOCK >= 7
-	if ( itsdk_secstore_readBlock(ITSDK_SS_USER6, _b) != SS_FAILED_NOTSET ) {
-		_itsdk_secstore_writeBlockKey(ITSDK_SS_USER6,_b,masterKey);
-	}
-#endif
-#if ITSDK_SECSTORE_USRBLOCK >= 8
-	if ( itsdk_secstore_readBlock(ITSDK_SS_USER7, _b) != SS_FAILED_NOTSET ) {
-		_itsdk_secstore_writeBlockKey(ITSDK_SS_USER7,_b,masterKey);
-	}
-#endif
+// ===========================================================================================
+// CONSOLE EXTENSION
+// ===========================================================================================
 
-	// Write Header
-	for ( int i = 0 ; i < 12 ; i++) {
-		_head.dynamicKey[i] = newKey[i];
-	}
-	_eeprom_write(ITDT_EEPROM_BANK0, ITSDK_SECSTORE_EEPROM_OFFSET, (void *) &_head, sizeof(itsdk_secStoreHead_t));
-	_itsdk_console_printf("OK\r\n");
-	return ITSDK_CONSOLE_SUCCES;
-}
+#if ITSDK_WITH_CONSOLE == __ENABLE
+
+#define __console_print_hex(b,off,sz) {												\
+										char __s[2*ITSDK_SECSTORE_BLOCKSZ+3];			\
+										itdt_convertIntTab2Hex(__s,&b[off],sz,BOOL_TRUE);\
+										__s[2*(sz)] = '\r'; __s[2*(sz)+1] = '\n';		\
+										__s[2*(sz)+2] = '\0';							\
+										_itsdk_console_printf("%s",__s);				\
+								      }
 
 /**
  * convert and verify a char * hex string into a uint8_t array
@@ -562,14 +672,7 @@ static itsdk_console_return_e _itsk_secstore_rekey(uint8_t * newKey){
  */
 static bool __checkAndConvert(char * str,uint8_t start,uint8_t stop,uint8_t sz,uint8_t * buf) {
 	if ( (stop - start) < 2*sz ) return false;
-	int k = 0;
-	for ( int i = start ; i < stop ; i+=2 ) {
-		if ( itdt_isHexChar(str[i],false) && itdt_isHexChar(str[i+1],false) ) {
-			buf[k] = itdt_convertHexChar2Int(&str[i]);
-			k++;
-		} else return false;
-	}
-	return true;
+	return itdt_convertHexStr2IntTabChk(&str[start],buf,sz,BOOL_FALSE);
 }
 
 static itsdk_console_return_e __updateField(char * buffer, uint8_t sz, uint8_t *b, itsdk_secStoreBlocks_e type) {
@@ -817,8 +920,9 @@ static itsdk_console_return_e _itsdk_secStore_consolePriv(char * buffer, uint8_t
 			switch(buffer[3]) {
 			case '0':
 				// DYNKEY
-				if ( __checkAndConvert(buffer,5,sz,12,b) ) {
-					return _itsk_secstore_rekey(b);
+				if ( __checkAndConvert(buffer,5,sz,12,b) && itsdk_secstore_rekey(b) == SS_SUCCESS ) {
+					_itsdk_console_printf("OK\r\n");
+					return ITSDK_CONSOLE_SUCCES;
 				} else {
 					_itsdk_console_printf("KO\r\n");
 					return ITSDK_CONSOLE_FAILED;
@@ -914,7 +1018,11 @@ static itsdk_console_return_e _itsdk_secStore_consolePriv(char * buffer, uint8_t
 			case 'h':
 			case 'H':
 				// ITSDK_SS_AES_SHARED_NONCE_SPECKKEY
-				return __updateField2(buffer,sz,b,ITSDK_SS_AES_SHARED_NONCE_SPECKKEY,8,8);
+				if ( __updateField2(buffer,sz,b,ITSDK_SS_AES_SHARED_NONCE_SPECKKEY,8,8) == ITSDK_CONSOLE_SUCCES ) {
+					itsdk_encrypt_keyChanged();
+					return ITSDK_CONSOLE_SUCCES;
+				}
+				return ITSDK_CONSOLE_FAILED;
 	#endif
 	#if ITSDK_SECSTORE_USRBLOCK >= 1
 			case 'i':
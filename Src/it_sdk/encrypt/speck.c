@@ -25,13 +25,22 @@
  *   In the firmware / eventually the Sigfox key can be reused but
  *   this is reducing the security level. This key must be chosen to
  *   be uniq per device.
+ * - The CTR mode uses a 32b counter block composed of
+ *   - 26b low bits of the 32b frame counter (sequence id / FCnt)
+ *   - 6b block counter starting at 0 for each frame
+ *   The block is encrypted with a frame key derived from the master key:
+ *   frameKey = E(master, tag<<1) | E(master, tag<<1 | 1) with
+ *   tag = domain(1b) | epoch(16b) | frame counter high 6b
+ *   so the keystream is never reused until the epoch wraps. The keystream
+ *   is xored with the data so any length is supported and the decryption
+ *   is the same operation as the encryption.
  *
  * ==========================================================
  */
 #include <string.h>
 #include <it_sdk/config.h>
 
-#if ( ITSDK_SIGFOX_ENCRYPTION & __PAYLOAD_ENCRYPT_SPECK ) > 0 || ( ITSDK_LORAWAN_ENCRYPTION & __PAYLOAD_ENCRYPT_SPECK ) > 0
+#if ( ITSDK_SIGFOX_ENCRYPTION & (__PAYLOAD_ENCRYPT_SPECK | __PAYLOAD_ENCRYPT_SPECKCTR) ) > 0 || ( ITSDK_LORAWAN_ENCRYPTION & (__PAYLOAD_ENCRYPT_SPECK | __PAYLOAD_ENCRYPT_SPECKCTR) ) > 0
 #include <it_sdk/itsdk.h>
 #include <it_sdk/sigfox/sigfox.h>
 #include <it_sdk/encrypt/encrypt.h>
@@ -88,6 +97,123 @@ void itsdk_speck_encrypt(
 
 }
 
+// ==========================================================================================
+// SPECK32-CTR streaming
+// ==========================================================================================
+
+/**
+ * Open a session : the master key is expanded once here, the frame keys
+ * are derived from it when the epoch or the frame counter high bits change.
+ * Key expansion is the main cost of the SPECK encryption on small frames.
+ * The key is protected by the ITSDK_PROTECT_KEY
+ */
+void itsdk_speck_ctr_open(
+		itsdk_speck_session_t * session,
+		uint64_t  masterKey,			// 64B key used for encryption (hidden with ITSDK_PROTECT_KEY)
+		uint8_t   domain				// ITSDK_SPECK_CTR_DOMAIN_xx
+) {
+	uint64_t _masterKey = itsdk_encrypt_unCifferKey64(masterKey);
+	uint8_t __masterKey[8];
+	for ( int i = 0 ; i < 8 ; i++ ) {
+		__masterKey[i] = (_masterKey >> ((64-8)-i*8) ) & 0xFF;
+	}
+	_masterKey ^= _masterKey;
+
+	speck32_expandKey(&session->master,__masterKey);
+	bzero(__masterKey,8);
+	session->keyTag = ITSDK_SPECK_CTR_NOKEY;
+	session->domain = domain & 1;
+	session->keyGen = itsdk_encrypt_getKeyGeneration();
+	session->iv = 0;
+	session->counter = 0;
+	session->ksUsed = 4;
+	session->ready = 1;
+}
+
+/**
+ * Return true when the session can be used: opened and the key has not been
+ * changed since.
+ */
+bool itsdk_speck_ctr_isOpen(
+		itsdk_speck_session_t * session
+) {
+	return ( session->ready == 1 && session->keyGen == itsdk_encrypt_getKeyGeneration() );
+}
+
+/**
+ * Start a new frame, the block counter is reset.
+ * The (epoch, frameCounter) pair must never be reused with the same key.
+ */
+void itsdk_speck_ctr_setIv(
+		itsdk_speck_session_t * session,
+		uint16_t  epoch,				// Incremented each time the frame counter restarts
+		uint32_t  frameCounter			// 32b per frame value (sequenceId / frame counter)
+) {
+	uint32_t tag = ((uint32_t)session->domain << 22) | ((uint32_t)epoch << 6) | (frameCounter >> 26);
+	if ( session->ready == 1 && tag != session->keyTag ) {
+		uint8_t key[8];
+		for ( int i = 0 ; i < 2 ; i++ ) {
+			uint32_t b = (tag << 1) | i;
+			uint16_t p1 = b >> 16;
+			uint16_t p2 = b & 0xFFFF;
+			speck32_encryptBlock(&session->master,&p1,&p2);
+			key[4*i]   = (p1 & 0xFF00) >> 8;
+			key[4*i+1] = (p1 & 0xFF);
+			key[4*i+2] = (p2 & 0xFF00) >> 8;
+			key[4*i+3] = (p2 & 0xFF);
+		}
+		speck32_expandKey(&session->ctx,key);
+		bzero(key,8);
+		session->keyTag = tag;
+	}
+	session->iv = (frameCounter & 0x03FFFFFF) << 6;
+	session->counter = 0;
+	session->ksUsed = 4;
+}
+
+/**
+ * Encrypt (or decrypt) dataLen bytes. The function can be called multiple
+ * times on the same frame, the keystream continues where it stopped.
+ */
+void itsdk_speck_ctr_encrypt(
+		itsdk_speck_session_t * session,
+		uint8_t	* clearData,			// Data to be encrypted
+		uint8_t * encryptedData,		// Can be the same as clearData
+		uint16_t  dataLen				// Any size, can be called multiple time for a stream
+) {
+	if ( session->ready == 0 || session->keyTag == ITSDK_SPECK_CTR_NOKEY ) {
+		ITSDK_ERROR_REPORT(ITSDK_ERROR_ENCRYP_NOSESSION,0);
+		return;
+	}
+
+	for ( int i = 0 ; i < dataLen ; i++ ) {
+		if ( session->ksUsed == 4 ) {
+			if ( session->counter == 64 ) {
+				ITSDK_ERROR_REPORT(ITSDK_ERROR_ENCRYP_DATA_TOOLARGE,dataLen);
+				return;
+			}
+			uint32_t b = session->iv | session->counter++;
+			uint16_t p1 = b >> 16;
+			uint16_t p2 = b & 0xFFFF;
+			speck32_encryptBlock(&session->ctx,&p1,&p2);
+			session->keystream[0] = (p1 & 0xFF00) >> 8;
+			session->keystream[1] = (p1 & 0xFF);
+			session->keystream[2] = (p2 & 0xFF00) >> 8;
+			session->keystream[3] = (p2 & 0xFF);
+			session->ksUsed = 0;
+		}
+		encryptedData[i] = clearData[i] ^ session->keystream[session->ksUsed++];
+	}
+}
+
+/**
+ * Close the session and clean the round keys from memory
+ */
+void itsdk_speck_ctr_close(
+		itsdk_speck_session_t * session
+) {
+	bzero(session,sizeof(itsdk_speck_session_t));
+}
 
 
 #endif // ITSDK_SIGFOX_ENCRYPTION
@@ -25,58 +25,71 @@
  *
  * ==========================================================
  */
+#include <string.h>
 #include <it_sdk/config.h>
 #include <it_sdk/encrypt/speck/speck.h>
 
 /**
- * Encrypt a bloc of len data with the given key
+ * Expand the 64b key into the 22 round keys. The result can be cached
+ * and reused for any number of blocks encrypted with the same key.
  */
-void speck32_encrypt(uint8_t * key, uint8_t * data, uint8_t len) {
-	uint16_t subkeys[22];
+void speck32_expandKey(speck32_ctx_t * ctx, uint8_t * key) {
 	uint16_t l[24];
 
-	subkeys[0] = ( key[6] << 8 ) + key[7];
+	ctx->subkeys[0] = ( key[6] << 8 ) + key[7];
 	l[0] =  (key[4]<<8) + key[5];
 	l[1] =  (key[2]<<8) + key[3];
 	l[2] =  (key[0]<<8) + key[1];
 	int m = 4;
-	for(int i = 0; i < 21; ++i) {
+	for(int i = 0; i < SPECK32_ROUNDS-1; ++i) {
 	    uint32_t temp1, temp2, temp3;
-	    temp1 = subkeys[i];
+	    temp1 = ctx->subkeys[i];
 	    temp2 = l[i];
         l[i+m-1] = (uint16_t) ((temp1 + ((temp2 >> 7) | (temp2 << (16-7)))) ^ i);
 	    temp3 = l[i+m-1];
-        subkeys[i+1] = (uint16_t) ((uint16_t)((temp1 << 2) | (temp1 >> (16-2))) ^ temp3);
+        ctx->subkeys[i+1] = (uint16_t) ((uint16_t)((temp1 << 2) | (temp1 >> (16-2))) ^ temp3);
     }
+	bzero(l,sizeof(l));
+}
 
-	for ( int i = 0 ; i < len ; i+= 4) {
-		uint32_t block = data[i];
-		block = (block << 8) + data[i+1];
-		block = (block << 8) + data[i+2];
-		block = (block << 8) + data[i+3];
+/**
+ * Encrypt a single 32b block (p1 is the high 16b word, p2 the low one)
+ * with a previously expanded key.
+ */
+void speck32_encryptBlock(speck32_ctx_t * ctx, uint16_t * p1, uint16_t * p2) {
+	uint32_t temp1 = (uint32_t)*p1;
+	uint32_t temp2 = (uint32_t)*p2;
+	uint16_t x = *p1;
+	uint16_t y = *p2;
+    for(int i = 0; i < SPECK32_ROUNDS; ++i) {
+        x = (uint16_t) ((((temp1 >> 7) | (temp1 << (16-7))) + temp2) ^ ctx->subkeys[i]);
+        temp1  = (uint32_t)x;
+        y = (uint16_t) (((temp2 << 2) | (temp2 >> (16-2))) ^ temp1);
+        temp2 = (uint32_t)y;
+    }
+    *p1 = x;
+    *p2 = y;
+}
 
+/**
+ * Encrypt a bloc of len data with the given key
+ */
+void speck32_encrypt(uint8_t * key, uint8_t * data, uint8_t len) {
+	speck32_ctx_t ctx;
+	speck32_expandKey(&ctx,key);
+
+	for ( int i = 0 ; i < len ; i+= 4) {
 		uint16_t p1 = ( data[i  ] << 8 ) + data[i+1];
 		uint16_t p2 = ( data[i+2] << 8 ) + data[i+3];
 
-		uint32_t temp1 = (uint32_t)p1;
-		uint32_t temp2 = (uint32_t)p2;
-		uint32_t temp3;
-        for(int i = 0; i < 22; ++i) {
-            temp3 = (uint32_t)subkeys[i];
-            p1 = (uint16_t) ((((temp1 >> 7) | (temp1 << (16-7))) + temp2) ^ temp3);
-            temp1  = (uint32_t)p1;
-            p2 = (uint16_t) (((temp2 << 2) | (temp2 >> (16-2))) ^ temp1);
-            temp2 = (uint32_t)p2;
-        }
+		speck32_encryptBlock(&ctx,&p1,&p2);
 
         data[i]   = (p1 & 0xFF00) >> 8;
         data[i+1] = (p1 & 0xFF);
         data[i+2] = (p2 & 0xFF00) >> 8;
         data[i+3] = (p2 & 0xFF);
 	}
+	bzero(&ctx,sizeof(speck32_ctx_t));
 
 	return;
 }
-
-
-
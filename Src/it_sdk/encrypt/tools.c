@@ -85,7 +85,15 @@ itsdk_encrypt_return_t itsdk_encrypt_resetFactoryDefaults(itsdk_bool_e force) {
 		masterkey=0;
 		itsdk_secstore_writeBlock(ITSDK_SS_AES_MASTERK, buffer);
 
+		// The SPECK-CTR epochs are kept, the default key may be the one used before
+		uint8_t epochs[3];
+		if ( itsdk_secstore_readBlock(ITSDK_SS_AES_SHARED_NONCE_SPECKKEY, buffer) == SS_SUCCESS ) {
+			memcpy(epochs,&buffer[ITSDK_SECSTORE_CRYPT_SFXEPOCH_ID],3);
+		} else {
+			bzero(epochs,3);
+		}
 		bzero(buffer,16);
+		memcpy(&buffer[ITSDK_SECSTORE_CRYPT_SFXEPOCH_ID],epochs,3);
 		buffer[ITSDK_SECSTORE_CRYPT_NONCE_ID] = ITSDK_ENCRYPT_AES_INITALNONCE;
 		uint32_t shared = ITSDK_ENCRYPT_AES_SHAREDKEY;
 		for ( int i = 0 ; i < 4 ; i++ ) {
@@ -98,6 +106,7 @@ itsdk_encrypt_return_t itsdk_encrypt_resetFactoryDefaults(itsdk_bool_e force) {
 		}
 		masterkey=0;
 		itsdk_secstore_writeBlock(ITSDK_SS_AES_SHARED_NONCE_SPECKKEY, buffer);
+		itsdk_encrypt_keyChanged();
 	}
 	bzero(buffer,16);
 	return ENCRYPT_RETURN_SUCESS;
@@ -197,4 +206,63 @@ __weak itsdk_encrypt_return_t itsdk_encrypt_speck_getMasterKey(uint64_t * master
 	return ENCRYPT_RETURN_SUCESS;
 }
 
+/**
+ * Return the SPECK-CTR epoch of a domain. The epoch is incremented each time the
+ * frame counter of the domain restarts (LoRaWan new session, Sigfox sequence id wrap).
+ * It is stored in the spare bytes of ITSDK_SS_AES_SHARED_NONCE_SPECKKEY: 8b for Sigfox,
+ * 16b for LoRaWan. SPECK-CTR requires the secure store (see config.h), a RAM copy would
+ * restart from 0 with the frame counter after a reset and reuse the keystream.
+ */
+__weak itsdk_encrypt_return_t itsdk_encrypt_speck_getEpoch(uint8_t domain, uint16_t * epoch) {
+#if ITSDK_WITH_SECURESTORE == __ENABLE
+	uint8_t d[16];
+	if ( itsdk_secstore_readBlock(ITSDK_SS_AES_SHARED_NONCE_SPECKKEY, d) != SS_SUCCESS ) {
+		*epoch = 0;
+		return ENCRYPT_RETURN_FAILED;
+	}
+	if ( domain == ITSDK_SPECK_CTR_DOMAIN_SIGFOX ) {
+		*epoch = d[ITSDK_SECSTORE_CRYPT_SFXEPOCH_ID];
+	} else {
+		*epoch = ((uint16_t)d[ITSDK_SECSTORE_CRYPT_LOREPOCH_ID] << 8) | d[ITSDK_SECSTORE_CRYPT_LOREPOCH_ID+1];
+	}
+	bzero(d,16);
+	return ENCRYPT_RETURN_SUCESS;
+#else
+	*epoch = 0;
+	return ENCRYPT_RETURN_FAILED;
+#endif
+}
 
+__weak itsdk_encrypt_return_t itsdk_encrypt_speck_setEpoch(uint8_t domain, uint16_t epoch) {
+#if ITSDK_WITH_SECURESTORE == __ENABLE
+	uint8_t d[16];
+	if ( itsdk_secstore_readBlock(ITSDK_SS_AES_SHARED_NONCE_SPECKKEY, d) != SS_SUCCESS ) {
+		return ENCRYPT_RETURN_FAILED;
+	}
+	if ( domain == ITSDK_SPECK_CTR_DOMAIN_SIGFOX ) {
+		d[ITSDK_SECSTORE_CRYPT_SFXEPOCH_ID] = epoch & 0xFF;
+	} else {
+		d[ITSDK_SECSTORE_CRYPT_LOREPOCH_ID] = epoch >> 8;
+		d[ITSDK_SECSTORE_CRYPT_LOREPOCH_ID+1] = epoch & 0xFF;
+	}
+	itsdk_secStoreReturn_e r = itsdk_secstore_writeBlock(ITSDK_SS_AES_SHARED_NONCE_SPECKKEY, d);
+	bzero(d,16);
+	if ( r != SS_SUCCESS ) return ENCRYPT_RETURN_FAILED;
+	return ENCRYPT_RETURN_SUCESS;
+#else
+	return ENCRYPT_RETURN_FAILED;
+#endif
+}
+
+/**
+ * The key generation is incremented when a key is modified (console) so the
+ * encryption sessions opened with the previous key are reopened.
+ */
+static uint8_t __itsdk_encrypt_keyGen = 0;
+void itsdk_encrypt_keyChanged() {
+	__itsdk_encrypt_keyGen++;
+}
+
+uint8_t itsdk_encrypt_getKeyGeneration() {
+	return __itsdk_encrypt_keyGen;
+}
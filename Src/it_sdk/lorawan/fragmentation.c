@@ -0,0 +1,484 @@
+/* ==========================================================
+ * fragmentation.c - LoRaWan fragmented data block transport
+ * Project : Disk91 SDK
+ * ----------------------------------------------------------
+ * Created on: 18 oct. 2020
+ *     Author: Paul Pinault aka Disk91
+ * ----------------------------------------------------------
+ * Copyright (C) 2020 Disk91
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU LESSER General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ * ----------------------------------------------------------
+ * The uncoded fragments are written at their place in the storage.
+ * When the coded fragments start, the lost fragments list is frozen.
+ * Each coded fragment is reduced with the received fragments, then
+ * with the previous coded rows (gaussian elimination). A row with
+ * its leading one on the lost fragment l is stored in the storage
+ * slot of this lost fragment, so the decoder only needs RAM for the
+ * MAXLOST x MAXLOST bit matrix. Once there are as many rows as lost
+ * fragments, a back substitution gives the lost fragments.
+ * ==========================================================
+ */
+#include <stdbool.h>
+#include <string.h>
+
+#include <it_sdk/config.h>
+#if ITSDK_WITH_LORAWAN_LIB == __ENABLE && ITSDK_LORAWAN_FRAG_STORAGE != __LORAWAN_FRAG_NONE
+#include <it_sdk/itsdk.h>
+#include <it_sdk/logger/logger.h>
+#include <it_sdk/lorawan/lorawan.h>
+#include <it_sdk/lorawan/fragmentation.h>
+#include <it_sdk/wrappers.h>
+#include <it_sdk/logger/error.h>
+#if ITSDK_LORAWAN_FRAG_STORAGE == __LORAWAN_FRAG_LOCALEPROM
+#include <it_sdk/eeprom/eeprom.h>
+#elif ITSDK_LORAWAN_FRAG_STORAGE == __LORAWAN_FRAG_M95640
+#include <drivers/eeprom/m95640/m95640.h>
+#endif
+
+#if ITSDK_LORAWAN_UPLINK_QUEUE_SZ == 0
+#error "The fragmentation package needs the uplink queue (ITSDK_LORAWAN_UPLINK_QUEUE_SZ) for its answers"
+#endif
+
+#define __FRAG_LOSTSZ	((ITSDK_LORAWAN_FRAG_MAXLOST+7)/8)
+
+static struct {
+	itsdk_lorawan_frag_status_t	s;
+	uint8_t		index;													// FragIndex of the session
+	bool		coded;													// Coded fragments started, lost list is frozen
+	uint8_t		solved;													// Rows stored in the matrix
+	uint8_t		rcv[(ITSDK_LORAWAN_FRAG_MAXFRAGS+7)/8];					// Uncoded fragments received
+	uint16_t	lostIdx[ITSDK_LORAWAN_FRAG_MAXLOST];					// Fragment of each lost position
+	uint8_t		matrix[ITSDK_LORAWAN_FRAG_MAXLOST][__FRAG_LOSTSZ];		// Row l has its leading one at l
+	uint8_t		used[__FRAG_LOSTSZ];									// Rows stored
+} __lorawan_frag;
+
+static uint8_t __lorawan_frag_row[(ITSDK_LORAWAN_FRAG_MAXFRAGS+7)/8];
+static uint8_t __lorawan_frag_lost[__FRAG_LOSTSZ];
+static uint8_t __lorawan_frag_data[ITSDK_LORAWAN_FRAG_MAXFRAGSZ];
+static uint8_t __lorawan_frag_tmp[ITSDK_LORAWAN_FRAG_MAXFRAGSZ];
+
+#define __FRAG_GET(t,i)		((((t)[(i)>>3]) >> ((i)&7)) & 1)
+#define __FRAG_SET(t,i)		(t)[(i)>>3] |= (1 << ((i)&7))
+
+// =================================================================================
+// STORAGE
+// =================================================================================
+
+#if ITSDK_LORAWAN_FRAG_STORAGE == __LORAWAN_FRAG_LOCALEPROM
+/**
+ * The data block follows the LoRaMac contexts in the EEPROM
+ */
+static uint32_t __lorawan_frag_storageOffset() {
+	uint32_t offset;
+	itsdk_lorawan_getNvmOffset(&offset);
+	#if ITSDK_LORAWAN_NVM_SOURCE == __LORAWAN_NVM_LOCALEPROM
+	offset += itdt_align_32b(ITSDK_LORAWAN_NVM_SIZE);
+	#endif
+	return offset;
+}
+
+/**
+ * The EEPROM is accessed by 32b words and the fragments are not aligned on
+ * words: the partial first and last words are read, patched and written
+ * back, the full words in between are written directly.
+ */
+static bool __lorawan_frag_eepromWrite(uint32_t offset, uint8_t * data, uint16_t size) {
+	uint8_t w[4];
+	offset += __lorawan_frag_storageOffset();
+	while ( size > 0 ) {
+		uint8_t s = offset & 0x3;
+		uint16_t sz;
+		if ( s == 0 && size >= 4 ) {
+			sz = size & ~0x3;
+			if ( !_eeprom_write(ITDT_EEPROM_BANK0, offset, (void *) data, sz) ) return false;
+		} else {
+			sz = 4 - s;
+			if ( sz > size ) sz = size;
+			if ( !_eeprom_read(ITDT_EEPROM_BANK0, offset - s, (void *) w, 4) ) return false;
+			bcopy(data,&w[s],sz);
+			if ( !_eeprom_write(ITDT_EEPROM_BANK0, offset - s, (void *) w, 4) ) return false;
+		}
+		offset += sz;
+		data += sz;
+		size -= sz;
+	}
+	return true;
+}
+
+static bool __lorawan_frag_eepromRead(uint32_t offset, uint8_t * data, uint16_t size) {
+	uint8_t w[4];
+	offset += __lorawan_frag_storageOffset();
+	while ( size > 0 ) {
+		uint8_t s = offset & 0x3;
+		uint16_t sz;
+		if ( s == 0 && size >= 4 ) {
+			sz = size & ~0x3;
+			if ( !_eeprom_read(ITDT_EEPROM_BANK0, offset, (void *) data, sz) ) return false;
+		} else {
+			sz = 4 - s;
+			if ( sz > size ) sz = size;
+			if ( !_eeprom_read(ITDT_EEPROM_BANK0, offset - s, (void *) w, 4) ) return false;
+			bcopy(&w[s],data,sz);
+		}
+		offset += sz;
+		data += sz;
+		size -= sz;
+	}
+	return true;
+}
+#endif
+
+__weak bool itsdk_lorawan_frag_storageWrite(uint32_t offset, uint8_t * data, uint16_t size) {
+	#if ITSDK_LORAWAN_FRAG_STORAGE == __LORAWAN_FRAG_LOCALEPROM
+	return __lorawan_frag_eepromWrite(offset, data, size);
+	#elif ITSDK_LORAWAN_FRAG_STORAGE == __LORAWAN_FRAG_M95640
+	// A write can't cross a 32B page
+	uint32_t addr = ITSDK_LORAWAN_FRAG_M95640_ADDR + offset;
+	while ( size > 0 ) {
+		uint8_t sz = 32 - (addr & 0x1F);
+		if ( sz > size ) sz = size;
+		eeprom_m95640_write(&ITSDK_DRIVERS_M95640_SPI, (uint16_t)addr, sz, data);
+		addr += sz;
+		data += sz;
+		size -= sz;
+	}
+	return true;
+	#endif
+}
+
+__weak bool itsdk_lorawan_frag_storageRead(uint32_t offset, uint8_t * data, uint16_t size) {
+	#if ITSDK_LORAWAN_FRAG_STORAGE == __LORAWAN_FRAG_LOCALEPROM
+	return __lorawan_frag_eepromRead(offset, data, size);
+	#elif ITSDK_LORAWAN_FRAG_STORAGE == __LORAWAN_FRAG_M95640
+	while ( size > 0 ) {
+		uint8_t sz = ( size > 255 )?255:size;
+		eeprom_m95640_read(&ITSDK_DRIVERS_M95640_SPI, (uint16_t)(ITSDK_LORAWAN_FRAG_M95640_ADDR + offset), sz, data);
+		offset += sz;
+		data += sz;
+		size -= sz;
+	}
+	return true;
+	#endif
+}
+
+/**
+ * Called when the data block has been reassembled, override it to process the block
+ */
+__weak void itsdk_lorawan_frag_onComplete(uint32_t descriptor, uint32_t size) {
+	LOG_INFO_LORAWANSTK(("[LoRaWan] Data block 0x%08X of %dB received\r\n",descriptor,size));
+}
+
+/**
+ * Read the reassembled data block
+ */
+bool itsdk_lorawan_frag_read(uint32_t offset, uint8_t * data, uint16_t size) {
+	if ( __lorawan_frag.s.state != LORAWAN_FRAG_COMPLETED || offset + size > __lorawan_frag.s.size ) return false;
+	return itsdk_lorawan_frag_storageRead(offset,data,size);
+}
+
+// =================================================================================
+// DECODER
+// =================================================================================
+
+/**
+ * Fragment access, a storage failure ends the session
+ */
+static bool __lorawan_frag_storageFailed(uint16_t i) {
+	ITSDK_ERROR_REPORT(ITSDK_ERROR_LORAWAN_FRAG_STORAGE,i);
+	__lorawan_frag.s.state = LORAWAN_FRAG_STORAGE_ERROR;
+	return false;
+}
+
+static bool __lorawan_frag_readFrag(uint16_t i, uint8_t * data) {
+	if ( itsdk_lorawan_frag_storageRead((uint32_t)i*__lorawan_frag.s.fragSize,data,__lorawan_frag.s.fragSize) ) return true;
+	return __lorawan_frag_storageFailed(i);
+}
+
+static bool __lorawan_frag_writeFrag(uint16_t i, uint8_t * data) {
+	if ( itsdk_lorawan_frag_storageWrite((uint32_t)i*__lorawan_frag.s.fragSize,data,__lorawan_frag.s.fragSize) ) return true;
+	return __lorawan_frag_storageFailed(i);
+}
+
+static void __lorawan_frag_xor(uint8_t * dst, uint8_t * src, uint16_t sz) {
+	for ( uint16_t i = 0 ; i < sz ; i++ ) dst[i] ^= src[i];
+}
+
+/**
+ * Pseudo random generator and parity matrix line of the fragmentation package:
+ * coded fragment n is the XOR of M/2 uncoded fragments.
+ */
+static uint32_t __lorawan_frag_prbs23(uint32_t x) {
+	uint32_t b0 = x & 0x01;
+	uint32_t b1 = (x & 0x20) >> 5;
+	return (x >> 1) + ((b0 ^ b1) << 22);
+}
+
+static void __lorawan_frag_parityRow(uint16_t n, uint16_t m, uint8_t * row) {
+	uint32_t mTemp = ( (m & (m-1)) == 0 )?1:0;
+	uint32_t x = 1 + (1001 * (uint32_t)n);
+	bzero(row,(m+7)/8);
+	for ( uint16_t nbCoeff = 0 ; nbCoeff < (m >> 1) ; nbCoeff++ ) {
+		uint32_t r = 1 << 16;
+		while ( r >= m ) {
+			x = __lorawan_frag_prbs23(x);
+			r = x % (m + mTemp);
+		}
+		__FRAG_SET(row,r);
+	}
+}
+
+static void __lorawan_frag_complete() {
+	__lorawan_frag.s.state = LORAWAN_FRAG_COMPLETED;
+	__lorawan_frag.s.missing = 0;
+	itsdk_lorawan_frag_onComplete(__lorawan_frag.s.descriptor,__lorawan_frag.s.size);
+}
+
+/**
+ * Insert a row (lost positions) and its data in the matrix. When the matrix is
+ * full rank, solve it.
+ */
+static void __lorawan_frag_insert(uint8_t * row, uint8_t * data) {
+	uint8_t lost = __lorawan_frag.s.lost;
+	uint16_t sz = __lorawan_frag.s.fragSize;
+	uint8_t l;
+	for ( l = 0 ; l < lost ; l++ ) {
+		if ( !__FRAG_GET(row,l) ) continue;
+		if ( !__FRAG_GET(__lorawan_frag.used,l) ) break;
+		__lorawan_frag_xor(row,__lorawan_frag.matrix[l],__FRAG_LOSTSZ);
+		if ( !__lorawan_frag_readFrag(__lorawan_frag.lostIdx[l],__lorawan_frag_tmp) ) return;
+		__lorawan_frag_xor(data,__lorawan_frag_tmp,sz);
+	}
+	if ( l == lost ) return;		// Redundant row
+
+	bcopy(row,__lorawan_frag.matrix[l],__FRAG_LOSTSZ);
+	if ( !__lorawan_frag_writeFrag(__lorawan_frag.lostIdx[l],data) ) return;
+	__FRAG_SET(__lorawan_frag.used,l);
+	__lorawan_frag.solved++;
+	__lorawan_frag.s.missing--;
+	if ( __lorawan_frag.solved < lost ) return;
+
+	// Back substitution, row l only has ones after l
+	for ( int16_t i = lost - 1 ; i >= 0 ; i-- ) {
+		if ( !__lorawan_frag_readFrag(__lorawan_frag.lostIdx[i],data) ) return;
+		for ( uint8_t j = i + 1 ; j < lost ; j++ ) {
+			if ( !__FRAG_GET(__lorawan_frag.matrix[i],j) ) continue;
+			if ( !__lorawan_frag_readFrag(__lorawan_frag.lostIdx[j],__lorawan_frag_tmp) ) return;
+			__lorawan_frag_xor(data,__lorawan_frag_tmp,sz);
+		}
+		if ( !__lorawan_frag_writeFrag(__lorawan_frag.lostIdx[i],data) ) return;
+	}
+	__lorawan_frag_complete();
+}
+
+/**
+ * Freeze the list of the lost uncoded fragments when the first coded fragment arrives
+ */
+static void __lorawan_frag_startCoded() {
+	uint16_t lost = 0;
+	__lorawan_frag.coded = true;
+	for ( uint16_t i = 0 ; i < __lorawan_frag.s.nbFrag ; i++ ) {
+		if ( __FRAG_GET(__lorawan_frag.rcv,i) ) continue;
+		if ( lost < ITSDK_LORAWAN_FRAG_MAXLOST ) __lorawan_frag.lostIdx[lost] = i;
+		lost++;
+	}
+	__lorawan_frag.s.lost = lost;
+	if ( lost > ITSDK_LORAWAN_FRAG_MAXLOST ) {
+		ITSDK_ERROR_REPORT(ITSDK_ERROR_LORAWAN_FRAG_TOOMANYLOST,lost);
+		__lorawan_frag.s.state = LORAWAN_FRAG_TOOMANYLOST;
+	}
+}
+
+/**
+ * Start a new data block reception of nbFrag fragments of fragSize bytes
+ */
+bool itsdk_lorawan_frag_init(uint16_t nbFrag, uint8_t fragSize, uint8_t padding, uint32_t descriptor) {
+	bzero(&__lorawan_frag,sizeof(__lorawan_frag));
+	if (    nbFrag == 0 || nbFrag > ITSDK_LORAWAN_FRAG_MAXFRAGS
+		 || fragSize == 0 || fragSize > ITSDK_LORAWAN_FRAG_MAXFRAGSZ
+		 || fragSize + 3 > ITSDK_LORAWAN_MAX_DWNLNKSZ							// DataFragment header is 3B
+		 || (uint32_t)nbFrag * fragSize > ITSDK_LORAWAN_FRAG_MAXSIZE
+		 || padding >= (uint32_t)nbFrag * fragSize
+	) return false;
+	__lorawan_frag.s.state = LORAWAN_FRAG_RUNNING;
+	__lorawan_frag.s.nbFrag = nbFrag;
+	__lorawan_frag.s.fragSize = fragSize;
+	__lorawan_frag.s.size = (uint32_t)nbFrag * fragSize - padding;
+	__lorawan_frag.s.descriptor = descriptor;
+	__lorawan_frag.s.missing = nbFrag;
+	return true;
+}
+
+/**
+ * Process the fragment n (1 to nbFrag for the uncoded fragments, coded after)
+ */
+itsdk_lorawan_frag_state_e itsdk_lorawan_frag_process(uint16_t n, uint8_t * data) {
+	uint16_t m = __lorawan_frag.s.nbFrag;
+	uint16_t sz = __lorawan_frag.s.fragSize;
+	if ( __lorawan_frag.s.state != LORAWAN_FRAG_RUNNING || n == 0 ) return __lorawan_frag.s.state;
+	__lorawan_frag.s.received++;
+
+	bcopy(data,__lorawan_frag_data,sz);
+	bzero(__lorawan_frag_lost,__FRAG_LOSTSZ);
+	if ( n <= m ) {
+		if ( __FRAG_GET(__lorawan_frag.rcv,n-1) ) return __lorawan_frag.s.state;
+		if ( !__lorawan_frag.coded ) {
+			if ( !__lorawan_frag_writeFrag(n-1,data) ) return __lorawan_frag.s.state;
+			__FRAG_SET(__lorawan_frag.rcv,n-1);
+			if ( --__lorawan_frag.s.missing == 0 ) __lorawan_frag_complete();
+			return __lorawan_frag.s.state;
+		}
+		// Late uncoded fragment, it is a row with a single one
+		for ( uint8_t l = 0 ; l < __lorawan_frag.s.lost ; l++ ) {
+			if ( __lorawan_frag.lostIdx[l] == n-1 ) __FRAG_SET(__lorawan_frag_lost,l);
+		}
+	} else {
+		if ( !__lorawan_frag.coded ) {
+			__lorawan_frag_startCoded();
+			if ( __lorawan_frag.s.state != LORAWAN_FRAG_RUNNING ) return __lorawan_frag.s.state;
+		}
+		// Remove the received fragments from the coded one, keep the lost positions
+		__lorawan_frag_parityRow(n - m,m,__lorawan_frag_row);
+		for ( uint16_t i = 0, l = 0 ; i < m ; i++ ) {
+			bool rcv = __FRAG_GET(__lorawan_frag.rcv,i);
+			if ( __FRAG_GET(__lorawan_frag_row,i) ) {
+				if ( rcv ) {
+					if ( !__lorawan_frag_readFrag(i,__lorawan_frag_tmp) ) return __lorawan_frag.s.state;
+					__lorawan_frag_xor(__lorawan_frag_data,__lorawan_frag_tmp,sz);
+				} else {
+					__FRAG_SET(__lorawan_frag_lost,l);
+				}
+			}
+			if ( !rcv ) l++;
+		}
+	}
+	__lorawan_frag_insert(__lorawan_frag_lost,__lorawan_frag_data);
+	return __lorawan_frag.s.state;
+}
+
+void itsdk_lorawan_frag_getStatus(itsdk_lorawan_frag_status_t * status) {
+	*status = __lorawan_frag.s;
+}
+
+// =================================================================================
+// FRAGMENTATION PACKAGE
+// =================================================================================
+
+/**
+ * Process the package commands of a downlink, the answers are sent in one uplink
+ * through the uplink queue.
+ */
+void itsdk_lorawan_frag_onDownlink(uint8_t * data, uint8_t size) {
+	uint8_t ans[ITSDK_LORAWAN_UPLINK_QUEUE_MSGSZ];
+	uint8_t a = 0;
+	uint8_t i = 0;
+
+	while ( i < size ) {
+		switch ( data[i] ) {
+		case ITSDK_LORAWAN_FRAG_PKG_VERSION:
+			if ( a + 3 > ITSDK_LORAWAN_UPLINK_QUEUE_MSGSZ ) goto end;
+			ans[a++] = ITSDK_LORAWAN_FRAG_PKG_VERSION;
+			ans[a++] = ITSDK_LORAWAN_FRAG_PACKAGE_ID;
+			ans[a++] = ITSDK_LORAWAN_FRAG_PACKAGE_VERSION;
+			i += 1;
+			break;
+		case ITSDK_LORAWAN_FRAG_SESSION_STATUS:
+			{
+				if ( i + 2 > size ) goto end;
+				uint8_t index = (data[i+1] >> 1) & 0x03;
+				bool all = ( (data[i+1] & 0x01) > 0 );
+				i += 2;
+				if ( __lorawan_frag.s.state == LORAWAN_FRAG_NONE || index != __lorawan_frag.index ) break;
+				if ( !all && __lorawan_frag.s.state == LORAWAN_FRAG_COMPLETED ) break;
+				if ( a + 5 > ITSDK_LORAWAN_UPLINK_QUEUE_MSGSZ ) goto end;
+				uint16_t rcv = (__lorawan_frag.s.received & 0x3FFF) | ((uint16_t)index << 14);
+				ans[a++] = ITSDK_LORAWAN_FRAG_SESSION_STATUS;
+				ans[a++] = rcv & 0xFF;
+				ans[a++] = rcv >> 8;
+				ans[a++] = ( __lorawan_frag.s.missing > 255 )?255:__lorawan_frag.s.missing;
+				ans[a++] = (    __lorawan_frag.s.state == LORAWAN_FRAG_TOOMANYLOST
+						     || __lorawan_frag.s.state == LORAWAN_FRAG_STORAGE_ERROR )?0x01:0x00;
+			}
+			break;
+		case ITSDK_LORAWAN_FRAG_SESSION_SETUP:
+			{
+				if ( i + 11 > size || a + 2 > ITSDK_LORAWAN_UPLINK_QUEUE_MSGSZ ) goto end;
+				uint8_t index = (data[i+1] >> 4) & 0x03;
+				uint16_t nbFrag = data[i+2] | ((uint16_t)data[i+3] << 8);
+				uint8_t fragSize = data[i+4];
+				uint8_t matrix = (data[i+5] >> 3) & 0x07;
+				uint8_t padding = data[i+6];
+				uint32_t desc = data[i+7] | ((uint32_t)data[i+8] << 8) | ((uint32_t)data[i+9] << 16) | ((uint32_t)data[i+10] << 24);
+				uint8_t status = 0;
+				i += 11;
+				if ( matrix != 0 ) status |= 0x01;								// Encoding unsupported
+				if ( index != 0 ) status |= 0x04;								// One session, FragIndex 0 only
+				if ( status == 0 ) {
+					if ( itsdk_lorawan_frag_init(nbFrag,fragSize,padding,desc) ) {
+						__lorawan_frag.index = index;
+						LOG_INFO_LORAWANSTK(("[LoRaWan] Frag session %d x %dB\r\n",nbFrag,fragSize));
+					} else status |= 0x02;										// Not enough memory
+				}
+				ans[a++] = ITSDK_LORAWAN_FRAG_SESSION_SETUP;
+				ans[a++] = status | (index << 6);
+			}
+			break;
+		case ITSDK_LORAWAN_FRAG_SESSION_DELETE:
+			{
+				if ( i + 2 > size || a + 2 > ITSDK_LORAWAN_UPLINK_QUEUE_MSGSZ ) goto end;
+				uint8_t index = data[i+1] & 0x03;
+				uint8_t status = index;
+				i += 2;
+				if ( __lorawan_frag.s.state == LORAWAN_FRAG_NONE || index != __lorawan_frag.index ) {
+					status |= 0x04;												// Session does not exist
+				} else {
+					bzero(&__lorawan_frag,sizeof(__lorawan_frag));
+				}
+				ans[a++] = ITSDK_LORAWAN_FRAG_SESSION_DELETE;
+				ans[a++] = status;
+			}
+			break;
+		case ITSDK_LORAWAN_FRAG_DATA_FRAGMENT:
+			{
+				// The fragment uses the end of the frame
+				if ( i + 3 + __lorawan_frag.s.fragSize > size ) goto end;
+				uint16_t indexAndN = data[i+1] | ((uint16_t)data[i+2] << 8);
+				if ( (indexAndN >> 14) == __lorawan_frag.index ) {
+					itsdk_lorawan_frag_process(indexAndN & 0x3FFF,&data[i+3]);
+				}
+			}
+			goto end;
+		default:
+			goto end;
+		}
+	}
+end:
+	if ( a > 0 ) {
+		itsdk_lorawan_send_queue(ans,a,ITSDK_LORAWAN_FRAG_PORT,ITSDK_LORAWAN_DEFAULT_DR,LORAWAN_SEND_UNCONFIRMED,0,
+								 255,0,true,NULL,PAYLOAD_ENCRYPT_NONE);
+	}
+}
+
+/**
+ * Init the fragmentation package
+ */
+void itsdk_lorawan_frag_setup() {
+	bzero(&__lorawan_frag,sizeof(__lorawan_frag));
+	#if ITSDK_LORAWAN_FRAG_STORAGE == __LORAWAN_FRAG_M95640
+	eeprom_m95640_hwInit();
+	eeprom_m95640_init(&ITSDK_DRIVERS_M95640_SPI);
+	#endif
+}
+
+#endif
@@ -31,6 +31,7 @@
 #include <it_sdk/itsdk.h>
 #include <it_sdk/logger/logger.h>
 #include <it_sdk/encrypt/encrypt.h>
+#include <it_sdk/time/time.h>
 
 #if ITSDK_WITH_LORAWAN_LIB == __ENABLE
 #include <drivers/lorawan/core/lorawan.h>
@@ -50,6 +51,20 @@
 #include <it_sdk/logger/error.h>
 #endif
 
+#if ITSDK_WITH_SIGFOX_LIB == __ENABLE
+#include <it_sdk/sigfox/sigfox.h>
+#endif
+#include <it_sdk/eeprom/eeprom.h>
+#include <it_sdk/wrappers.h>
+#if ITSDK_LORAWAN_FRAG_STORAGE != __LORAWAN_FRAG_NONE
+#include <it_sdk/lorawan/fragmentation.h>
+#endif
+#if ITSDK_WITH_CONSOLE == __ENABLE && ITSDK_LORAWAN_LINK_HISTORY > 0
+#include <it_sdk/console/console.h>
+static itsdk_console_chain_t __console_lorawan;
+static itsdk_console_return_e __itsdk_lorawan_consolePriv(char * buffer, uint8_t sz);
+#endif
+
 
 // =================================================================================
 // INIT
@@ -132,6 +147,17 @@ itsdk_lorawan_init_t itsdk_lorawan_setup(uint16_t region, itsdk_lorawan_channelI
 	lorawan_driver_LORA_Init(&__config);
 	bzero(&__config,sizeof(__config));
 
+	#if ITSDK_LORAWAN_FRAG_STORAGE != __LORAWAN_FRAG_NONE
+	itsdk_lorawan_frag_setup();
+	#endif
+
+	#if ITSDK_WITH_CONSOLE == __ENABLE && ITSDK_LORAWAN_LINK_HISTORY > 0
+	__console_lorawan.console_private = __itsdk_lorawan_consolePriv;
+	__console_lorawan.console_public = NULL;
+	__console_lorawan.next = NULL;
+	itsdk_console_registerCommand(&__console_lorawan);
+	#endif
+
 	if ( channelConfig != NULL ) {
 		switch (region) {
 		case __LORAWAN_REGION_US915:
@@ -244,6 +270,18 @@ itsdk_lorawan_join_t itsdk_lorawan_getJoinState() {
 // SEND
 // =================================================================================
 
+/**
+ * With the datarate optimizer, __LORAWAN_DR_UNDEFINED selects the datarate from the link history
+ */
+static uint8_t __itsdk_lorawan_selectDr(uint8_t dataRate) {
+	#if ITSDK_LORAWAN_LINK_HISTORY > 0 && ITSDK_LORAWAN_LINK_DR_OPTIM == __ENABLE
+	if ( dataRate == __LORAWAN_DR_UNDEFINED ) {
+		return itsdk_lorawan_getOptimalDr(ITSDK_LORAWAN_LINK_MIN_DR,ITSDK_LORAWAN_LINK_MAX_DR);
+	}
+	#endif
+	return dataRate;
+}
+
 /**
  * Send a LoRaWAN frame containing the Payload of the given payloadSize bytes on given port.
  * This first simple uplink is reducing the number of options...
@@ -256,11 +294,25 @@ itsdk_lorawan_send_t itsdk_lorawan_send_simple_uplink_sync(
 		uint8_t	  dataRate
 ) {
 	LOG_INFO_LORAWANSTK(("itsdk_lorawan_send_simple_uplink_sync\r\n"));
-	return lorawan_driver_LORA_Send(payload,payloadSize,port,dataRate,LORAWAN_SEND_UNCONFIRMED,0,LORAWAN_RUN_SYNC, NULL,NULL,NULL);
+	return lorawan_driver_LORA_Send(payload,payloadSize,port,__itsdk_lorawan_selectDr(dataRate),LORAWAN_SEND_UNCONFIRMED,0,LORAWAN_RUN_SYNC, NULL,NULL,NULL);
 }
 
 
 
+#if ( ITSDK_LORAWAN_ENCRYPTION & __PAYLOAD_ENCRYPT_SPECKCTR ) > 0
+static itsdk_speck_session_t __lorawan_speck_session = { .ready = 0 };
+
+/**
+ * The frame counter restarts, the SPECK-CTR epoch is incremented so the
+ * keystream of the previous session is not reused.
+ */
+void lorawan_driver_onNewSession() {
+	uint16_t epoch;
+	itsdk_encrypt_speck_getEpoch(ITSDK_SPECK_CTR_DOMAIN_LORAWAN,&epoch);
+	itsdk_encrypt_speck_setEpoch(ITSDK_SPECK_CTR_DOMAIN_LORAWAN,epoch+1);
+}
+#endif
+
 /**
  * Internal function to encrypt the payload.
  * This is E2E encryption not LoRaWan encryption included in the LoRaWan Stack.
@@ -284,6 +336,20 @@ static void __itsdk_lorawan_encrypt_payload(
 		);
 	}
 #endif
+#if ( ITSDK_LORAWAN_ENCRYPTION & __PAYLOAD_ENCRYPT_SPECKCTR ) > 0
+	if ( (encrypt & PAYLOAD_ENCRYPT_SPECKCTR) > 0 ) {
+		if ( ! itsdk_speck_ctr_isOpen(&__lorawan_speck_session) ) {
+			uint64_t masterKey;
+			itsdk_encrypt_speck_getMasterKey(&masterKey);
+			itsdk_speck_ctr_open(&__lorawan_speck_session,masterKey,ITSDK_SPECK_CTR_DOMAIN_LORAWAN);
+			masterKey = 0;
+		}
+		uint16_t epoch;
+		itsdk_encrypt_speck_getEpoch(ITSDK_SPECK_CTR_DOMAIN_LORAWAN,&epoch);
+		itsdk_speck_ctr_setIv(&__lorawan_speck_session,epoch,lorawan_driver_LORA_GetNextUplinkFrameCounter32());
+		itsdk_speck_ctr_encrypt(&__lorawan_speck_session,payload,payload,payloadSize);
+	}
+#endif
 #if (ITSDK_LORAWAN_ENCRYPTION & __PAYLOAD_ENCRYPT_AESCTR) > 0
 	if ( (encrypt & PAYLOAD_ENCRYPT_AESCTR) > 0 ) {
 		uint64_t devId64;
@@ -337,7 +403,7 @@ itsdk_lorawan_send_t itsdk_lorawan_send_sync(
 ) {
 	LOG_INFO_LORAWANSTK(("itsdk_lorawan_send_sync\r\n"));
 	__itsdk_lorawan_encrypt_payload(payload,payloadSize,encrypt);
-	return lorawan_driver_LORA_Send(payload,payloadSize,port,dataRate,confirm,retry,LORAWAN_RUN_SYNC,rPort,rSize,rData);
+	return lorawan_driver_LORA_Send(payload,payloadSize,port,__itsdk_lorawan_selectDr(dataRate),confirm,retry,LORAWAN_RUN_SYNC,rPort,rSize,rData);
 }
 
 static void (*__itsdk_lorawan_send_cb)(itsdk_lorawan_send_t status, uint8_t port, uint8_t size, uint8_t * rxData) = NULL;
@@ -368,6 +434,13 @@ void lorawan_driver_onDataReception(uint8_t port, uint8_t * data, uint8_t size)
 		}
 		LOG_INFO_LORAWANSTK(("\n"));
 	#endif
+	#if ITSDK_LORAWAN_FRAG_STORAGE != __LORAWAN_FRAG_NONE
+	if ( port == ITSDK_LORAWAN_FRAG_PORT ) {
+		// Fragmentation package downlinks are not given to the application
+		itsdk_lorawan_frag_onDownlink(data,size);
+		return;
+	}
+	#endif
 	if (__itsdk_lorawan_send_cb != NULL) {
 		__itsdk_lorawan_send_cb(LORAWAN_SEND_ACKED_WITH_DOWNLINK,port,size,data);
 	}
@@ -397,7 +470,7 @@ itsdk_lorawan_send_t itsdk_lorawan_send_async(
 	} else {
 		__itsdk_lorawan_send_cb = NULL;
 	}
-	return lorawan_driver_LORA_Send(payload,payloadSize,port,dataRate,confirm,retry,LORAWAN_RUN_ASYNC,NULL,NULL,NULL);
+	return lorawan_driver_LORA_Send(payload,payloadSize,port,__itsdk_lorawan_selectDr(dataRate),confirm,retry,LORAWAN_RUN_ASYNC,NULL,NULL,NULL);
 }
 
 /**
@@ -426,6 +499,576 @@ itsdk_lorawan_send_t itsdk_lorawan_getSendState() {
 	}
 }
 
+// =================================================================================
+// TRANSMISSION PLANNER
+// =================================================================================
+
+// Datarates from the slowest to the fastest, index is the DR number
+static const uint8_t __lorawan_drs[] = {
+		__LORAWAN_DR_0, __LORAWAN_DR_1, __LORAWAN_DR_2, __LORAWAN_DR_3,
+		__LORAWAN_DR_4, __LORAWAN_DR_5, __LORAWAN_DR_6, __LORAWAN_DR_7,
+		__LORAWAN_DR_8, __LORAWAN_DR_9, __LORAWAN_DR_10, __LORAWAN_DR_11,
+		__LORAWAN_DR_12, __LORAWAN_DR_13, __LORAWAN_DR_14, __LORAWAN_DR_15
+};
+
+/**
+ * Return the transmission plan for a payload on a given datarate: time to wait before the
+ * duty cycle allows the transmission, time on air, max payload size and estimated charge.
+ */
+itsdk_lorawan_return_t itsdk_lorawan_getTxPlan(
+		uint8_t dataRate,
+		uint8_t payloadSize,
+		itsdk_lorawan_txplan_t * plan
+) {
+	LOG_DEBUG_LORAWANSTK(("itsdk_lorawan_getTxPlan\r\n"));
+	return lorawan_driver_LORA_GetTxPlan(dataRate,payloadSize,plan);
+}
+
+/**
+ * Select the datarate in [minDr,maxDr] with the lowest charge able to carry the payload
+ * and allowed to transmit within deadlineMs. The link budget is the caller responsibility,
+ * minDr must be a datarate reaching the network.
+ * When no datarate meets the deadline, LORAWAN_RETURN_FAILED is returned and the plan
+ * contains the earliest option able to carry the payload (dataRate is __LORAWAN_DR_UNDEFINED
+ * if none).
+ */
+itsdk_lorawan_return_t itsdk_lorawan_planTx(
+		uint8_t payloadSize,
+		uint32_t deadlineMs,
+		uint8_t minDr,
+		uint8_t maxDr,
+		itsdk_lorawan_txplan_t * plan
+) {
+	LOG_DEBUG_LORAWANSTK(("itsdk_lorawan_planTx\r\n"));
+	itsdk_lorawan_txplan_t p;
+	bool inRange = false, found = false;
+
+	plan->dataRate = __LORAWAN_DR_UNDEFINED;
+	for ( uint8_t i = 0 ; i < sizeof(__lorawan_drs) ; i++ ) {
+		if ( __lorawan_drs[i] == minDr ) inRange = true;
+		if ( inRange && itsdk_lorawan_getTxPlan(__lorawan_drs[i],payloadSize,&p) == LORAWAN_RETURN_SUCESS && p.maxSize >= payloadSize ) {
+			if ( p.delayMs <= deadlineMs ) {
+				if ( !found || p.chargeUC < plan->chargeUC || ( p.chargeUC == plan->chargeUC && p.delayMs < plan->delayMs ) ) {
+					*plan = p;
+					found = true;
+				}
+			} else if ( !found && ( plan->dataRate == __LORAWAN_DR_UNDEFINED || p.delayMs < plan->delayMs ) ) {
+				*plan = p;
+			}
+		}
+		if ( __lorawan_drs[i] == maxDr ) break;
+	}
+	return (found)?LORAWAN_RETURN_SUCESS:LORAWAN_RETURN_FAILED;
+}
+
+// =================================================================================
+// LINK QUALITY
+// =================================================================================
+#if ITSDK_LORAWAN_LINK_HISTORY > 0
+
+static uint8_t __lorawan_linkDr = __LORAWAN_DR_UNDEFINED;			// Last datarate selected by the optimizer
+
+/**
+ * Summary of the uplink outcomes on a datarate: acked ratio, average Rssi/Snr of the
+ * downlinks and Snr margin above the demodulation floor.
+ */
+itsdk_lorawan_return_t itsdk_lorawan_getLinkStats(
+		uint8_t dataRate,
+		itsdk_lorawan_linkStats_t * stats
+) {
+	LOG_DEBUG_LORAWANSTK(("itsdk_lorawan_getLinkStats\r\n"));
+	return lorawan_driver_LORA_GetLinkStats(dataRate,stats);
+}
+
+void itsdk_lorawan_clearLinkStats() {
+	LOG_INFO_LORAWANSTK(("itsdk_lorawan_clearLinkStats\r\n"));
+	lorawan_driver_LORA_ClearLinkStats();
+	__lorawan_linkDr = __LORAWAN_DR_UNDEFINED;
+}
+
+/**
+ * Select the fastest datarate in [minDr,maxDr] where the Snr margin is at least
+ * ITSDK_LORAWAN_LINK_MARGIN and the acked ratio at least ITSDK_LORAWAN_LINK_ACKRATE.
+ * A datarate with less than ITSDK_LORAWAN_LINK_MIN_SAMPLES samples is evaluated with the
+ * average Snr measured on all the datarates. Moving to a datarate faster than the previous
+ * selection requires ITSDK_LORAWAN_LINK_HYSTERESIS dB more margin.
+ * The search stops on the first datarate missing the acked ratio target.
+ * Returns minDr when the history is too short or no datarate meets the targets.
+ * The Snr is measured by the device on the downlinks, it estimates the gateway side one.
+ */
+uint8_t itsdk_lorawan_getOptimalDr(uint8_t minDr, uint8_t maxDr) {
+	LOG_DEBUG_LORAWANSTK(("itsdk_lorawan_getOptimalDr\r\n"));
+	itsdk_lorawan_linkStats_t s;
+	int32_t  snr = 0;
+	uint16_t acked = 0;
+	bool inRange = false, faster = false;
+	uint8_t best = minDr;
+
+	// Link Snr all datarates together, the Snr does not depend on the spreading factor
+	for ( uint8_t i = 0 ; i < LORAWAN_DRIVER_LINK_DRS ; i++ ) {
+		if ( lorawan_driver_LORA_GetLinkStats(__lorawan_drs[i],&s) == LORAWAN_RETURN_SUCESS ) {
+			snr += (int32_t)s.snrAvg * s.acked;
+			acked += s.acked;
+		}
+	}
+
+	for ( uint8_t i = 0 ; i < LORAWAN_DRIVER_LINK_DRS ; i++ ) {
+		if ( __lorawan_drs[i] == minDr ) inRange = true;
+		if ( inRange && lorawan_driver_LORA_GetLinkStats(__lorawan_drs[i],&s) == LORAWAN_RETURN_SUCESS ) {
+			int16_t required = ITSDK_LORAWAN_LINK_MARGIN + ((faster)?ITSDK_LORAWAN_LINK_HYSTERESIS:0);
+			bool ok;
+			if ( s.samples >= ITSDK_LORAWAN_LINK_MIN_SAMPLES ) {
+				// Acks lost on a datarate, the faster ones have a lower link budget
+				if ( (uint16_t)s.acked * 100 < (uint16_t)ITSDK_LORAWAN_LINK_ACKRATE * s.samples ) break;
+				ok = ( s.margin >= required );
+			} else {
+				ok = ( acked >= ITSDK_LORAWAN_LINK_MIN_SAMPLES ) && ( snr / acked - s.snrFloor >= required );
+			}
+			if ( ok ) best = __lorawan_drs[i];
+		}
+		if ( __lorawan_drs[i] == __lorawan_linkDr ) faster = true;
+		if ( __lorawan_drs[i] == maxDr ) break;
+	}
+
+	if ( best != __lorawan_linkDr ) {
+		LOG_INFO_LORAWANSTK(("[LoRaWan] Link optimizer selects DR 0x%02X\r\n",best));
+		__lorawan_linkDr = best;
+	}
+	return best;
+}
+
+#if ITSDK_WITH_CONSOLE == __ENABLE
+static itsdk_console_return_e __itsdk_lorawan_consolePriv(char * buffer, uint8_t sz) {
+	if ( sz == 1 ) {
+	  switch(buffer[0]){
+		case '?':
+			// help
+			_itsdk_console_printf("--- LoRaWan\r\n");
+			_itsdk_console_printf("q          : print link quality history\r\n");
+			_itsdk_console_printf("Q          : clear link quality history\r\n");
+		  return ITSDK_CONSOLE_SUCCES;
+		  break;
+		case 'q':
+			{
+				itsdk_lorawan_linkStats_t s;
+				for ( uint8_t i = 0 ; i < LORAWAN_DRIVER_LINK_DRS ; i++ ) {
+					if ( itsdk_lorawan_getLinkStats(__lorawan_drs[i],&s) != LORAWAN_RETURN_SUCESS || s.samples == 0 ) continue;
+					_itsdk_console_printf("DR%d : %d/%d acked",i,s.acked,s.samples);
+					if ( s.acked > 0 ) {
+						_itsdk_console_printf(", rssi %ddBm, snr %ddB (min %d), margin %ddB",s.rssiAvg,s.snrAvg,s.snrMin,s.margin);
+					}
+					_itsdk_console_printf("\r\n");
+				}
+				for ( uint8_t i = 0 ; i < LORAWAN_DRIVER_LINK_DRS ; i++ ) {
+					if ( __lorawan_drs[i] == __lorawan_linkDr ) _itsdk_console_printf("Optimizer selection DR%d\r\n",i);
+				}
+				_itsdk_console_printf("OK\r\n");
+			}
+  		    return ITSDK_CONSOLE_SUCCES;
+			break;
+		case 'Q':
+			itsdk_lorawan_clearLinkStats();
+			_itsdk_console_printf("OK\r\n");
+  		    return ITSDK_CONSOLE_SUCCES;
+			break;
+		default:
+			break;
+	  }
+	} //Sz == 1
+  return ITSDK_CONSOLE_NOTFOUND;
+}
+#endif
+
+#endif // ITSDK_LORAWAN_LINK_HISTORY > 0
+
+// =================================================================================
+// TIME SYNC
+// =================================================================================
+
+static uint64_t __lorawan_timeSyncMs = 0;				// Local time of the last network time sync, 0 when never synced
+static bool __lorawan_timeSyncPending = false;
+
+/**
+ * Request the network time, the DeviceTimeReq is piggybacked on the next uplink,
+ * no uplink is generated for it. The answer updates the EPOC and UTC time.
+ */
+itsdk_lorawan_return_t itsdk_lorawan_requestTime() {
+	LOG_INFO_LORAWANSTK(("itsdk_lorawan_requestTime\r\n"));
+	if ( !itsdk_lorawan_hasjoined() ) return LORAWAN_RETURN_FAILED;
+	if ( lorawan_driver_LORA_DeviceTimeReq() != LORAWAN_RETURN_SUCESS ) return LORAWAN_RETURN_FAILED;
+	__lorawan_timeSyncPending = true;
+	return LORAWAN_RETURN_SUCESS;
+}
+
+/**
+ * Duration in S before the next time sync to keep the clock error under
+ * ITSDK_LORAWAN_TIMESYNC_MAXERR ms with the measured drift
+ */
+uint32_t itsdk_lorawan_getTimeSyncPeriod() {
+	int32_t drift = itsdk_time_get_drift_ppb();
+	if ( drift < 0 ) drift = -drift;
+	if ( drift == 0 ) return ITSDK_LORAWAN_TIMESYNC_MINPERIOD;
+	uint64_t period = ((uint64_t)ITSDK_LORAWAN_TIMESYNC_MAXERR * 1000000) / drift;
+	if ( period < ITSDK_LORAWAN_TIMESYNC_MINPERIOD ) return ITSDK_LORAWAN_TIMESYNC_MINPERIOD;
+	if ( period > ITSDK_LORAWAN_TIMESYNC_MAXPERIOD ) return ITSDK_LORAWAN_TIMESYNC_MAXPERIOD;
+	return (uint32_t)period;
+}
+
+/**
+ * Local time (itsdk_time_get_ms) of the last network time sync, 0 when never synced
+ */
+uint64_t itsdk_lorawan_getLastTimeSync() {
+	return __lorawan_timeSyncMs;
+}
+
+// Override the underlaying callback
+void lorawan_driver_onDeviceTime(bool success, uint32_t epochS, uint16_t ms) {
+	__lorawan_timeSyncPending = false;
+	if ( !success ) {
+		LOG_WARN_LORAWANSTK(("** onDeviceTime failed\r\n"));
+		return;
+	}
+	LOG_INFO_LORAWANSTK(("** onDeviceTime %d.%03d\r\n",epochS,ms));
+	itsdk_time_sync_EPOC_ms(epochS, ms);
+	itsdk_time_sync_UTC_ms(epochS % (24*3600), ms);
+	__lorawan_timeSyncMs = itsdk_time_get_ms();
+	itsdk_lorawan_onTimeSync(epochS);
+}
+
+/**
+ * Called when the EPOC / UTC time has been updated from the network
+ */
+__weak void itsdk_lorawan_onTimeSync(uint32_t epochS) {
+	LOG_INFO_LORAWANSTK(("** Time synced\r\n"));
+}
+
+#if ITSDK_LORAWAN_TIMESYNC == __ENABLE
+/**
+ * Schedule the DeviceTimeReq after join and once the sync period has expired
+ */
+static void __itsdk_lorawan_timeSync_process() {
+	if ( __lorawan_timeSyncPending || !itsdk_lorawan_hasjoined() ) return;
+	if (    __lorawan_timeSyncMs == 0
+		 || (itsdk_time_get_ms() - __lorawan_timeSyncMs) >= (uint64_t)itsdk_lorawan_getTimeSyncPeriod()*1000 ) {
+		itsdk_lorawan_requestTime();
+	}
+}
+#endif
+
+// =================================================================================
+// UPLINK QUEUE
+// =================================================================================
+#if ITSDK_LORAWAN_UPLINK_QUEUE_SZ > 0
+
+#if (ITSDK_LORAWAN_UPLINK_QUEUE_SZ*ITSDK_LORAWAN_UPLINK_QUEUE_MSGSZ) > 242
+#define __LORAWAN_QUEUE_FRAMESZ		242
+#else
+#define __LORAWAN_QUEUE_FRAMESZ		(ITSDK_LORAWAN_UPLINK_QUEUE_SZ*ITSDK_LORAWAN_UPLINK_QUEUE_MSGSZ)
+#endif
+
+#define __LORAWAN_QUEUE_USED		0x01
+#define __LORAWAN_QUEUE_COALESCE	0x02
+#define __LORAWAN_QUEUE_INFLIGHT	0x04
+#define __LORAWAN_QUEUE_PRIMARY		0x08			// Message owning the downlink of the in-flight frame
+
+typedef struct {
+	uint64_t					expireMs;			// Absolute expiration time, 0 for never
+	void (*callback_func)(itsdk_lorawan_send_t status, uint8_t port, uint8_t size, uint8_t * rxData);
+	uint16_t					seq;				// Fifo order for a same priority
+	uint8_t						flags;
+	uint8_t						priority;
+	uint8_t						port;
+	uint8_t						dataRate;
+	uint8_t						retry;
+	uint8_t						size;
+	itsdk_lorawan_sendconf_t	confirm;
+	itdsk_payload_encrypt_t		encrypt;
+	uint8_t						payload[ITSDK_LORAWAN_UPLINK_QUEUE_MSGSZ];
+} itsdk_lorawan_uplink_t;
+
+static struct {
+	itsdk_lorawan_uplink_t	msg[ITSDK_LORAWAN_UPLINK_QUEUE_SZ];
+	uint64_t				nextTryMs;								// No transmission attempt before this time
+	uint16_t				seq;
+	uint8_t					inflight;								// A frame built from the queue is on air
+	uint8_t					rxPending;								// Network server has more downlink
+	uint8_t					rxPort;
+	uint8_t					rxSize;
+	uint8_t				  * rxData;									// Downlink buffer hold until the end of the transmission
+	uint8_t					frame[__LORAWAN_QUEUE_FRAMESZ];		// Must stay unchanged until the end of the transmission
+} __lorawan_queue;
+
+/**
+ * Return true when message a must be sent before message b
+ */
+static bool __itsdk_lorawan_queue_before(itsdk_lorawan_uplink_t * a, itsdk_lorawan_uplink_t * b) {
+	if ( a->priority != b->priority ) return ( a->priority > b->priority );
+	return ( (int16_t)(a->seq - b->seq) < 0 );
+}
+
+/**
+ * Free a queue entry and report the status to its owner
+ */
+static void __itsdk_lorawan_queue_release(
+		uint8_t id,
+		itsdk_lorawan_send_t status,
+		uint8_t port,
+		uint8_t size,
+		uint8_t * rxData
+) {
+	void (*cb)(itsdk_lorawan_send_t status, uint8_t port, uint8_t size, uint8_t * rxData) = __lorawan_queue.msg[id].callback_func;
+	__lorawan_queue.msg[id].flags = 0;
+	if ( cb != NULL ) cb(status,port,size,rxData);
+}
+
+/**
+ * Driver events during a queued transmission, the downlink is kept
+ * until the end of the transmission to be reported to the primary message
+ */
+static void __itsdk_lorawan_queue_onEvent(itsdk_lorawan_send_t status, uint8_t port, uint8_t size, uint8_t * rxData) {
+	switch ( status ) {
+	case LORAWAN_SEND_ACKED_WITH_DOWNLINK:
+		if ( __lorawan_queue.rxData == NULL && itsdk_lorawan_holdDownlink(rxData) ) {
+			__lorawan_queue.rxPort = port;
+			__lorawan_queue.rxSize = size;
+			__lorawan_queue.rxData = rxData;
+		}
+		break;
+	case LORAWAN_SEND_ACKED_WITH_DOWNLINK_PENDING:
+		__lorawan_queue.rxPending = 1;
+		break;
+	default:
+		break;
+	}
+}
+
+/**
+ * Queue an uplink. The message is sent by itsdk_lorawan_loop() as soon as the device
+ * has joined and the MAC accepts a transmission. The payload is copied.
+ * When the queue is full, the lowest priority message is dropped if its priority is
+ * lower than the new one, otherwise the new message is refused.
+ * When coalesce is true, messages with the same port, datarate, confirmation and encryption
+ * modes are concatenated in a single frame, up to the max payload size of the datarate.
+ * The callback is called once per message with the final status. On a coalesced frame the
+ * downlink is only reported to the first message of the frame.
+ * Returns
+ *   - LORAWAN_SEND_QUEUED on success
+ *   - LORAWAN_SEND_FAILED when the message is too large or the queue is full
+ */
+itsdk_lorawan_send_t itsdk_lorawan_send_queue(
+		uint8_t * payload,
+		uint8_t   payloadSize,
+		uint8_t   port,
+		uint8_t	  dataRate,
+		itsdk_lorawan_sendconf_t confirm,
+		uint8_t	  retry,
+		uint8_t	  priority,
+		uint32_t  expireMs,
+		bool	  coalesce,
+		void (*callback_func)(itsdk_lorawan_send_t status, uint8_t port, uint8_t size, uint8_t * rxData),
+		itdsk_payload_encrypt_t encrypt
+) {
+	LOG_INFO_LORAWANSTK(("itsdk_lorawan_send_queue\r\n"));
+	if ( payloadSize > ITSDK_LORAWAN_UPLINK_QUEUE_MSGSZ ) return LORAWAN_SEND_FAILED;
+
+	int id = -1, victim = -1;
+	for ( int i = 0 ; i < ITSDK_LORAWAN_UPLINK_QUEUE_SZ ; i++ ) {
+		itsdk_lorawan_uplink_t * m = &__lorawan_queue.msg[i];
+		if ( (m->flags & __LORAWAN_QUEUE_USED) == 0 ) {
+			id = i;
+			break;
+		}
+		if ( (m->flags & __LORAWAN_QUEUE_INFLIGHT) == 0 && m->priority < priority ) {
+			if ( victim < 0 || __itsdk_lorawan_queue_before(&__lorawan_queue.msg[victim],m) ) victim = i;
+		}
+	}
+	void (*vcb)(itsdk_lorawan_send_t status, uint8_t port, uint8_t size, uint8_t * rxData) = NULL;
+	if ( id < 0 ) {
+		if ( victim < 0 ) {
+			LOG_WARN_LORAWANSTK(("[LoRaWan] Uplink queue full\r\n"));
+			return LORAWAN_SEND_FAILED;
+		}
+		id = victim;
+		vcb = __lorawan_queue.msg[id].callback_func;
+	}
+
+	itsdk_lorawan_uplink_t * m = &__lorawan_queue.msg[id];
+	m->expireMs = ( expireMs > 0 )?itsdk_time_get_ms()+expireMs:0;
+	m->callback_func = callback_func;
+	m->seq = __lorawan_queue.seq++;
+	m->flags = __LORAWAN_QUEUE_USED | ((coalesce)?__LORAWAN_QUEUE_COALESCE:0);
+	m->priority = priority;
+	m->port = port;
+	m->dataRate = dataRate;
+	m->retry = retry;
+	m->size = payloadSize;
+	m->confirm = confirm;
+	m->encrypt = encrypt;
+	bcopy(payload,m->payload,payloadSize);
+
+	if ( vcb != NULL ) {
+		LOG_WARN_LORAWANSTK(("[LoRaWan] Uplink queue full, lower priority message dropped\r\n"));
+		vcb(LORAWAN_SEND_FAILED,0,0,NULL);
+	}
+	return LORAWAN_SEND_QUEUED;
+}
+
+/**
+ * Number of messages waiting in the uplink queue (including the in-flight ones)
+ */
+uint8_t itsdk_lorawan_queue_count() {
+	uint8_t c = 0;
+	for ( int i = 0 ; i < ITSDK_LORAWAN_UPLINK_QUEUE_SZ ; i++ ) {
+		if ( (__lorawan_queue.msg[i].flags & __LORAWAN_QUEUE_USED) > 0 ) c++;
+	}
+	return c;
+}
+
+/**
+ * Drop all the messages not yet transmitted, their callback is called with LORAWAN_SEND_FAILED
+ */
+void itsdk_lorawan_queue_flush() {
+	LOG_INFO_LORAWANSTK(("itsdk_lorawan_queue_flush\r\n"));
+	for ( int i = 0 ; i < ITSDK_LORAWAN_UPLINK_QUEUE_SZ ; i++ ) {
+		uint8_t f = __lorawan_queue.msg[i].flags;
+		if ( (f & __LORAWAN_QUEUE_USED) > 0 && (f & __LORAWAN_QUEUE_INFLIGHT) == 0 ) {
+			__itsdk_lorawan_queue_release(i,LORAWAN_SEND_FAILED,0,0,NULL);
+		}
+	}
+}
+
+/**
+ * Terminate the in-flight frame once the MAC has completed the transmission
+ */
+static void __itsdk_lorawan_queue_complete() {
+	itsdk_lorawan_send_t status;
+	switch ( lorawan_driver_LORA_getSendState() ) {
+	case LORAWAN_SEND_STATE_SENT:
+	case LORAWAN_SEND_STATE_NOTACKED:
+		status = LORAWAN_SEND_SENT;
+		break;
+	case LORAWAN_SEND_STATE_ACKED:
+	case LORAWAN_SEND_STATE_ACKED_NO_DOWNLINK:
+	case LORAWAN_SEND_STATE_ACKED_WITH_DOWNLINK:
+	case LORAWAN_SEND_STATE_ACKED_DOWNLINK_PENDING:
+		status = LORAWAN_SEND_ACKED;
+		break;
+	default:
+		status = LORAWAN_SEND_FAILED;
+		break;
+	}
+	itsdk_lorawan_send_t pstatus = status;
+	if ( status != LORAWAN_SEND_FAILED ) {
+		if ( __lorawan_queue.rxPending ) pstatus = LORAWAN_SEND_ACKED_WITH_DOWNLINK_PENDING;
+		else if ( __lorawan_queue.rxData != NULL ) pstatus = LORAWAN_SEND_ACKED_WITH_DOWNLINK;
+	}
+	__lorawan_queue.inflight = 0;
+	__itsdk_lorawan_send_cb = NULL;
+	for ( int i = 0 ; i < ITSDK_LORAWAN_UPLINK_QUEUE_SZ ; i++ ) {
+		uint8_t f = __lorawan_queue.msg[i].flags;
+		if ( (f & __LORAWAN_QUEUE_INFLIGHT) == 0 ) continue;
+		if ( (f & __LORAWAN_QUEUE_PRIMARY) > 0 ) {
+			__itsdk_lorawan_queue_release(i,pstatus,__lorawan_queue.rxPort,__lorawan_queue.rxSize,__lorawan_queue.rxData);
+		} else {
+			__itsdk_lorawan_queue_release(i,status,0,0,NULL);
+		}
+	}
+	if ( __lorawan_queue.rxData != NULL ) {
+		itsdk_lorawan_releaseDownlink(__lorawan_queue.rxData);
+		__lorawan_queue.rxData = NULL;
+	}
+}
+
+/**
+ * Queue processing, called from itsdk_lorawan_loop()
+ * Drops the expired messages, then builds and sends the next frame when the MAC is free.
+ */
+static void __itsdk_lorawan_queue_process() {
+	if ( __lorawan_queue.inflight ) {
+		if ( lorawan_driver_LORA_getSendState() == LORAWAN_SEND_STATE_RUNNING ) return;
+		__itsdk_lorawan_queue_complete();
+	}
+
+	uint64_t now = itsdk_time_get_ms();
+	int first = -1;
+	for ( int i = 0 ; i < ITSDK_LORAWAN_UPLINK_QUEUE_SZ ; i++ ) {
+		itsdk_lorawan_uplink_t * m = &__lorawan_queue.msg[i];
+		if ( (m->flags & __LORAWAN_QUEUE_USED) == 0 ) continue;
+		if ( m->expireMs > 0 && m->expireMs <= now ) {
+			LOG_WARN_LORAWANSTK(("[LoRaWan] Queued uplink expired\r\n"));
+			__itsdk_lorawan_queue_release(i,LORAWAN_SEND_FAILED,0,0,NULL);
+			continue;
+		}
+		if ( first < 0 || __itsdk_lorawan_queue_before(m,&__lorawan_queue.msg[first]) ) first = i;
+	}
+	if ( first < 0 || now < __lorawan_queue.nextTryMs ) return;
+	if ( !itsdk_lorawan_hasjoined() || lorawan_driver_LORA_getSendState() == LORAWAN_SEND_STATE_RUNNING ) return;
+
+	// Build the frame: the first message then the compatible ones by priority order
+	itsdk_lorawan_uplink_t * p = &__lorawan_queue.msg[first];
+	uint8_t dataRate = __itsdk_lorawan_selectDr(p->dataRate);
+	bcopy(p->payload,__lorawan_queue.frame,p->size);
+	uint8_t size = p->size;
+	p->flags |= __LORAWAN_QUEUE_INFLIGHT | __LORAWAN_QUEUE_PRIMARY;
+	if ( (p->flags & __LORAWAN_QUEUE_COALESCE) > 0 ) {
+		uint8_t maxSz = lorawan_driver_LORA_GetMaxPayloadSize(dataRate);
+		if ( maxSz > __LORAWAN_QUEUE_FRAMESZ ) maxSz = __LORAWAN_QUEUE_FRAMESZ;
+		int next;
+		do {
+			next = -1;
+			for ( int i = 0 ; i < ITSDK_LORAWAN_UPLINK_QUEUE_SZ ; i++ ) {
+				itsdk_lorawan_uplink_t * m = &__lorawan_queue.msg[i];
+				if (    (m->flags & (__LORAWAN_QUEUE_USED|__LORAWAN_QUEUE_COALESCE|__LORAWAN_QUEUE_INFLIGHT)) != (__LORAWAN_QUEUE_USED|__LORAWAN_QUEUE_COALESCE)
+					 || m->port != p->port || m->dataRate != p->dataRate
+					 || m->confirm != p->confirm || m->encrypt != p->encrypt
+					 || size + m->size > maxSz
+				) continue;
+				if ( next < 0 || __itsdk_lorawan_queue_before(m,&__lorawan_queue.msg[next]) ) next = i;
+			}
+			if ( next >= 0 ) {
+				itsdk_lorawan_uplink_t * m = &__lorawan_queue.msg[next];
+				bcopy(m->payload,&__lorawan_queue.frame[size],m->size);
+				size += m->size;
+				m->flags |= __LORAWAN_QUEUE_INFLIGHT;
+			}
+		} while ( next >= 0 );
+	}
+
+	__lorawan_queue.rxPending = 0;
+	__lorawan_queue.rxSize = 0;
+	__lorawan_queue.rxData = NULL;
+	__itsdk_lorawan_encrypt_payload(__lorawan_queue.frame,size,p->encrypt);
+	__itsdk_lorawan_send_cb = __itsdk_lorawan_queue_onEvent;
+	itsdk_lorawan_send_t r = lorawan_driver_LORA_Send(__lorawan_queue.frame,size,p->port,dataRate,p->confirm,p->retry,LORAWAN_RUN_ASYNC,NULL,NULL,NULL);
+	switch ( r ) {
+	case LORAWAN_SEND_RUNNING:
+		__lorawan_queue.inflight = 1;
+		return;
+	case LORAWAN_SEND_FAILED:
+		__lorawan_queue.inflight = 1;
+		__itsdk_lorawan_queue_complete();
+		return;
+	default:
+		// Duty cycle, certification running... keep the messages and retry later
+		__itsdk_lorawan_send_cb = NULL;
+		for ( int i = 0 ; i < ITSDK_LORAWAN_UPLINK_QUEUE_SZ ; i++ ) {
+			__lorawan_queue.msg[i].flags &= ~(__LORAWAN_QUEUE_INFLIGHT|__LORAWAN_QUEUE_PRIMARY);
+		}
+		{
+			// When refused by the duty cycle, wait for the band to be free instead of polling
+			itsdk_lorawan_txplan_t plan;
+			uint32_t wait = ITSDK_LORAWAN_UPLINK_QUEUE_BACKOFF;
+			if ( r == LORAWAN_SEND_DUTYCYCLE && itsdk_lorawan_getTxPlan(dataRate,size,&plan) == LORAWAN_RETURN_SUCESS && plan.delayMs > 0 ) {
+				wait = plan.delayMs;
+			}
+			__lorawan_queue.nextTryMs = now + wait;
+		}
+		return;
+	}
+}
+
+#endif // ITSDK_LORAWAN_UPLINK_QUEUE_SZ > 0
+
 // =================================================================================
 // MISC
 // =================================================================================
@@ -539,11 +1182,13 @@ itsdk_lorawan_return_t itsdk_lorawan_resetFactoryDefaults(bool force) {
 
 		uint8_t appkey[16] = ITSDK_LORAWAN_APPKEY;
 		itsdk_secstore_writeBlock(ITSDK_SS_LORA_OTAA_APPKEY, appkey);
+		itsdk_lorawan_clearNvm();
 	}
 	return LORAWAN_RETURN_SUCESS;
 }
 #else
 itsdk_lorawan_return_t itsdk_lorawan_resetFactoryDefaults(bool force) {
+	if ( force ) itsdk_lorawan_clearNvm();
 	return LORAWAN_RETURN_SUCESS;
 }
 #endif
@@ -598,6 +1243,77 @@ itsdk_lorawan_return_t itsdk_lorawan_getNextUplinkFrameCounter(uint16_t * counte
 	return LORAWAN_RETURN_SUCESS;
 }
 
+// =================================================================================
+// NVM
+// =================================================================================
+
+/**
+ * Return the size of the EEPROM zone reserved for the LoRaMac contexts and the
+ * fragmented data block
+ */
+itsdk_lorawan_return_t itsdk_lorawan_getNvmSize(uint32_t * sz) {
+	*sz = 0;
+	#if ITSDK_LORAWAN_NVM_SOURCE == __LORAWAN_NVM_LOCALEPROM
+	*sz += itdt_align_32b(ITSDK_LORAWAN_NVM_SIZE);
+	#endif
+	#if ITSDK_LORAWAN_FRAG_STORAGE == __LORAWAN_FRAG_LOCALEPROM
+	*sz += itdt_align_32b(ITSDK_LORAWAN_FRAG_MAXSIZE);
+	#endif
+	return LORAWAN_RETURN_SUCESS;
+}
+
+/**
+ * Return the offset of the LoRaMac contexts zone, it follows the
+ * sigfox NVM area
+ */
+itsdk_lorawan_return_t itsdk_lorawan_getNvmOffset(uint32_t * offset) {
+	uint32_t sstore=0, ssError=0, sSigfox=0;
+	#if ITSDK_WITH_SECURESTORE == __ENABLE
+	itsdk_secstore_getStoreSize(&sstore);
+	#endif
+	#if (ITSDK_WITH_ERROR_RPT == __ENABLE) && (ITSDK_ERROR_USE_EPROM == __ENABLE)
+	itsdk_error_getSize(&ssError);
+	#endif
+	#if (ITSDK_WITH_SIGFOX_LIB == __ENABLE)
+	itsdk_sigfox_getNvmSize(&sSigfox);
+	#endif
+	*offset = sstore + ssError + sSigfox;
+	return LORAWAN_RETURN_SUCESS;
+}
+
+/**
+ * Invalidate the saved MAC contexts, next reset will need a new join
+ */
+itsdk_lorawan_return_t itsdk_lorawan_clearNvm() {
+	#if ITSDK_LORAWAN_NVM_SOURCE == __LORAWAN_NVM_LOCALEPROM
+	uint32_t offset;
+	uint32_t magic = 0;
+	itsdk_lorawan_getNvmOffset(&offset);
+	_eeprom_write(ITDT_EEPROM_BANK0, offset, (void *) &magic, sizeof(magic));
+	#endif
+	return LORAWAN_RETURN_SUCESS;
+}
+
+/**
+ * The rxData buffer given to the send callbacks belongs to a pool and is only valid during
+ * the callback. Hold it to process it later, then release it. While hold, the buffer can't
+ * receive a new downlink.
+ */
+bool itsdk_lorawan_holdDownlink(uint8_t * rxData) {
+	return lorawan_driver_downlink_hold(rxData);
+}
+
+void itsdk_lorawan_releaseDownlink(uint8_t * rxData) {
+	lorawan_driver_downlink_release(rxData);
+}
+
+/**
+ * Downlink pool counters: received, dropped (no buffer available), truncated, high water
+ */
+void itsdk_lorawan_getDownlinkStats(itsdk_lorawan_downlinkStats_t * stats) {
+	lorawan_driver_downlink_getStats(stats);
+}
+
 /**
  * This function need to be called in the project_loop function
  * to manage the lorawan stack ( mandatory for async mode )
@@ -605,6 +1321,12 @@ itsdk_lorawan_return_t itsdk_lorawan_getNextUplinkFrameCounter(uint16_t * counte
 void itsdk_lorawan_loop() {
 	LOG_DEBUG_LORAWANSTK(("itsdk_lorawan_loop\r\n"));
 	lorawan_driver_loop();
+	#if ITSDK_LORAWAN_TIMESYNC == __ENABLE
+	__itsdk_lorawan_timeSync_process();
+	#endif
+	#if ITSDK_LORAWAN_UPLINK_QUEUE_SZ > 0
+	__itsdk_lorawan_queue_process();
+	#endif
 }
 
 
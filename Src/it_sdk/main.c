@@ -58,6 +58,7 @@
 #include <it_sdk/sched/scheduler.h>
 #include <it_sdk/time/time.h>
 #include <it_sdk/time/timer.h>
+#include <it_sdk/random/random.h>
 #include <it_sdk/logger/logger.h>
 #include <it_sdk/eeprom/sdk_config.h>
 #include <it_sdk/eeprom/sdk_state.h>
@@ -67,6 +68,9 @@
 #if ITSDK_WITH_SIGFOX_LIB == __ENABLE
   #include <it_sdk/sigfox/sigfox.h>
 #endif
+#if ITSDK_WITH_NETWORK_ARB == __ENABLE
+  #include <it_sdk/network/network.h>
+#endif
 
 #if ITSDK_WITH_SECURESTORE == __ENABLE
 #include <it_sdk/eeprom/securestore.h>
@@ -99,6 +103,7 @@
 void itsdk_setup() {
 
 	itsdk_time_init();
+	itsdk_random_init();
 	#if ITSDK_LOGGER_CONF > 0
 	log_init(ITSDK_LOGGER_CONF);
 	#endif
@@ -126,6 +131,7 @@ void itsdk_setup() {
  		    itsdk_sigfox_resetFactoryDefaults(true);
 		  #endif
 	  } else {
+	     itsdk_secstore_recover();							// restore a block interrupted during a rekey
 	     itsdk_encrypt_resetFactoryDefaults(BOOL_FALSE);	// on first boot init the ss communication credentials
 	  }
 	  itsdk_secStore_RegisterConsole();
@@ -133,6 +139,9 @@ void itsdk_setup() {
 	// load the configuration according to setting
 	itsdk_config_loadConfiguration(CONFIG_NORMAL_LOAD);
 	itsdk_state_init();
+	#if ITSDK_WITH_NETWORK_ARB == __ENABLE
+	  itsdk_network_setup();
+	#endif
 	// Application setup
 	project_setup();
     #if ITSDK_WITH_ERROR_RPT == __ENABLE
@@ -169,6 +178,10 @@ void itsdk_loop() {
 	#if ITSDK_SHEDULER_TASKS > 0
 	   itdt_sched_execute();
 	#endif
+	itsdk_random_loop();
+	#if ITSDK_WITH_SECURESTORE == __ENABLE
+	   bool _ssRunning = itsdk_secstore_loop();
+	#endif
 	#if ITSDK_DRIVERS_WITH_ACCEL_DRIVER == __ENABLE
 	   accel_process_loop();
     #endif
@@ -176,9 +189,19 @@ void itsdk_loop() {
 	   gnss_process_loop(BOOL_FALSE);
 	#endif
 	project_loop();
+	#if ITSDK_WITH_NETWORK_ARB == __ENABLE
+	   itsdk_network_loop();
+	#endif
 	#if ITSDK_WITH_CONSOLE == __ENABLE
 	   itsdk_console_loop();
 	#endif
+	#if ITSDK_WITH_SECURESTORE == __ENABLE
+		if ( _ssRunning ) return;						// rekey job in progress, keep looping
+	#endif
+	#if ITSDK_WITH_SIGFOX_LIB == __ENABLE && ITSDK_SIGFOX_UPLINK_QUEUE_SZ > 0
+		// queued uplink, sent by the next itsdk_sigfox_loop() once the stack is up
+		if ( itsdk_state.sigfox.initialized && itsdk_sigfox_queue_count() > 0 ) return;
+	#endif
 	#if ITSDK_TIMER_SLOTS > 0
 		if ( itsdk_stimer_isLowPowerSwitchAutorized() ) {
 	#endif
@@ -0,0 +1,512 @@
+/* ==========================================================
+ * network.c - LoRaWan / Sigfox arbitration per message
+ * Project : Disk91 SDK
+ * ----------------------------------------------------------
+ * Created on: 18 oct. 2026
+ *     Author: Paul Pinault aka Disk91
+ * ----------------------------------------------------------
+ * Copyright (C) 2026 Disk91
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU LESSER General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ * ----------------------------------------------------------
+ *
+ * One message is in progress at a time. The options of both
+ * networks are built from the stack states (join, duty cycle
+ * planner, Sigfox quota and downlink policy) and the outcome of
+ * the last messages, then itsdk_network_decide() selects one.
+ * Each decision is traced with its inputs for the replay.
+ *
+ * ==========================================================
+ */
+#include <it_sdk/config.h>
+#if ITSDK_WITH_NETWORK_ARB == __ENABLE
+
+#include <string.h>
+#include <it_sdk/itsdk.h>
+#include <it_sdk/network/network.h>
+#include <it_sdk/lorawan/lorawan.h>
+#include <it_sdk/sigfox/sigfox.h>
+#include <it_sdk/eeprom/sdk_state.h>
+#include <it_sdk/eeprom/eeprom.h>
+#include <it_sdk/time/time.h>
+#include <it_sdk/logger/logger.h>
+
+#if ITSDK_LORAWAN_UPLINK_QUEUE_SZ == 0 || ITSDK_SIGFOX_UPLINK_QUEUE_SZ == 0
+#error "The network arbitration needs the LoRaWan and Sigfox uplink queues"
+#endif
+
+#define __NETWORK_HISTORY			8				// Outcomes kept per network for the success rate
+#define __NETWORK_SFX_RXWIN_MS		25000			// Sigfox downlink window
+#define __NETWORK_SFX_QUOTA_MS		(24*3600*1000)
+
+typedef struct {
+	void (*callback_func)(itsdk_network_send_e status, uint8_t network, uint8_t size, uint8_t * rxData);
+	uint64_t				deadline;				// Absolute time
+	uint16_t				seq;
+	uint8_t					used;
+	uint8_t					port;
+	uint8_t					size;
+	uint8_t					reliability;
+	uint8_t					tried;					// Networks already failed
+	itdsk_payload_encrypt_t	encrypt;
+	uint8_t					payload[ITSDK_NETWORK_MSGSZ];
+} itsdk_network_msg_t;
+
+static struct {
+	itsdk_network_msg_t		msg[ITSDK_NETWORK_QUEUE_SZ];
+	uint16_t				seq;
+	int8_t					inflight;				// Message in a stack queue, -1 for none
+	uint8_t					hist[2];				// Last outcomes, bit set on success (0 LoRaWan, 1 Sigfox)
+	uint8_t					histSz[2];
+	uint64_t				sfxWindowMs;			// Start of the current Sigfox quota window
+	uint16_t				sfxCount;				// Sigfox uplinks in the window
+	itsdk_network_trace_t	trace[ITSDK_NETWORK_TRACESZ];
+	uint8_t					traceWr;
+	uint8_t					traceSz;
+} __network = { .inflight = -1 };
+
+static void __itsdk_network_process();
+static void __itsdk_network_sfxQuotaRestore();
+
+#if ITSDK_WITH_CONSOLE == __ENABLE
+#include <it_sdk/console/console.h>
+static itsdk_console_chain_t __console_network;
+static itsdk_console_return_e __itsdk_network_consolePriv(char * buffer, uint8_t sz);
+#endif
+
+/**
+ * Init the arbitration and register the console commands
+ */
+void itsdk_network_setup() {
+	bzero(&__network,sizeof(__network));
+	__network.inflight = -1;
+	__itsdk_network_sfxQuotaRestore();
+	#if ITSDK_WITH_CONSOLE == __ENABLE
+	if ( !itsdk_console_existCommand(&__console_network) ) {
+		__console_network.console_private = __itsdk_network_consolePriv;
+		__console_network.console_public = NULL;
+		__console_network.next = NULL;
+		itsdk_console_registerCommand(&__console_network);
+	}
+	#endif
+}
+
+/**
+ * Retry the messages waiting for an available network, called by itsdk_loop()
+ */
+void itsdk_network_loop() {
+	__itsdk_network_process();
+}
+
+/**
+ * Default activation for two radios: both stacks are running.
+ * With a radio shared by the stacks, overload it to deinit the current stack and
+ * setup the requested one. Returning false makes the message fall back on the other network.
+ */
+__weak bool itsdk_network_activate(uint8_t network) {
+	return true;
+}
+
+// =================================================================================
+// OPTIONS
+// =================================================================================
+
+static uint8_t __itsdk_network_idx(uint8_t network) {
+	return ( network == ITSDK_NETWORK_NET_LORAWAN )?0:1;
+}
+
+static uint8_t __itsdk_network_linkRate(uint8_t network) {
+	uint8_t i = __itsdk_network_idx(network);
+	if ( __network.histSz[i] == 0 ) return ITSDK_NETWORK_LINK_UNKNOWN;
+	uint8_t ok = 0;
+	for ( uint8_t b = 0 ; b < __network.histSz[i] ; b++ ) {
+		if ( (__network.hist[i] & (1 << b)) != 0 ) ok++;
+	}
+	return (uint8_t)(((uint16_t)ok * 100) / __network.histSz[i]);
+}
+
+static void __itsdk_network_addOutcome(uint8_t network, bool success) {
+	uint8_t i = __itsdk_network_idx(network);
+	__network.hist[i] = (__network.hist[i] << 1) | ((success)?1:0);
+	if ( __network.histSz[i] < __NETWORK_HISTORY ) __network.histSz[i]++;
+}
+
+/**
+ * The Sigfox quota window is saved in the Sigfox NVM area on every change of the count.
+ * The time the device was off is unknown, the window is restored as it was at the last
+ * save: it can only end later than the real one.
+ */
+static void __itsdk_network_sfxQuotaSave() {
+	itsdk_sigfox_nvm_quota_t q;
+	uint32_t offset;
+	q.windowS = (uint32_t)((itsdk_time_get_ms() - __network.sfxWindowMs) / 1000);
+	q.count = __network.sfxCount;
+	q.reserved = 0;
+	itsdk_sigfox_getQuotaNvmOffset(&offset);
+	_eeprom_write(ITDT_EEPROM_BANK0, offset, (void *) &q, sizeof(itsdk_sigfox_nvm_quota_t));
+}
+
+static void __itsdk_network_sfxQuotaRestore() {
+	itsdk_sigfox_nvm_quota_t q;
+	uint32_t offset;
+	itsdk_sigfox_getQuotaNvmOffset(&offset);
+	_eeprom_read(ITDT_EEPROM_BANK0, offset, (void *) &q, sizeof(itsdk_sigfox_nvm_quota_t));
+	if ( q.windowS >= __NETWORK_SFX_QUOTA_MS/1000 ) q.windowS = 0;
+	if ( q.count > ITSDK_NETWORK_SFX_QUOTA ) q.count = ITSDK_NETWORK_SFX_QUOTA;
+	__network.sfxCount = q.count;
+	// unsigned arithmetic, the window can start before the boot
+	__network.sfxWindowMs = itsdk_time_get_ms() - (uint64_t)q.windowS * 1000;
+}
+
+/**
+ * Sigfox uplinks left in the current quota window
+ */
+static uint16_t __itsdk_network_sfxQuotaLeft() {
+	uint64_t now = itsdk_time_get_ms();
+	if ( now - __network.sfxWindowMs >= __NETWORK_SFX_QUOTA_MS ) {
+		__network.sfxWindowMs = now;
+		if ( __network.sfxCount > 0 ) {
+			__network.sfxCount = 0;
+			__itsdk_network_sfxQuotaSave();
+		}
+	}
+	return ( __network.sfxCount < ITSDK_NETWORK_SFX_QUOTA )?ITSDK_NETWORK_SFX_QUOTA-__network.sfxCount:0;
+}
+
+/**
+ * Build the LoRaWan and Sigfox options for a request from the current state of the stacks
+ */
+void itsdk_network_getOptions(
+		const itsdk_network_req_t * req,
+		itsdk_network_option_t * lorawan,
+		itsdk_network_option_t * sigfox
+) {
+	// LoRaWan - datarate from the link history, cost from the transmission planner
+	bzero(lorawan,sizeof(itsdk_network_option_t));
+	uint8_t dr = ITSDK_LORAWAN_DEFAULT_DR;
+	#if ITSDK_LORAWAN_LINK_HISTORY > 0
+	dr = itsdk_lorawan_getOptimalDr(ITSDK_LORAWAN_LINK_MIN_DR,ITSDK_LORAWAN_LINK_MAX_DR);
+	#endif
+	itsdk_lorawan_txplan_t plan;
+	if ( itsdk_lorawan_hasjoined() && itsdk_lorawan_getTxPlan(dr,req->size,&plan) == LORAWAN_RETURN_SUCESS ) {
+		lorawan->available = 1;
+		lorawan->maxSize = ( plan.maxSize < ITSDK_LORAWAN_UPLINK_QUEUE_MSGSZ )?plan.maxSize:ITSDK_LORAWAN_UPLINK_QUEUE_MSGSZ;
+		lorawan->delayMs = plan.delayMs;
+		lorawan->toaMs = plan.toaMs;
+		lorawan->chargeUC = plan.chargeUC;
+	}
+	lorawan->param = dr;
+	lorawan->linkRate = __itsdk_network_linkRate(ITSDK_NETWORK_NET_LORAWAN);
+
+	// Sigfox - no duty cycle but a daily quota, the downlink window is the main cost
+	bzero(sigfox,sizeof(itsdk_network_option_t));
+	bool ack = ( req->reliability == ITSDK_NETWORK_REL_ACKED );
+	sigfox->param = ( req->reliability == ITSDK_NETWORK_REL_LOW )?0:2;
+	sigfox->maxSize = 12;
+	// the stack must be up when it is the active one, otherwise itsdk_network_activate() starts it
+	bool up = ( (itsdk_state.activeNetwork & ITSDK_NETWORK_NET_SIGFOX) == 0 || itsdk_state.sigfox.initialized );
+	if (   up
+		&& __itsdk_network_sfxQuotaLeft() > 0
+		&& ( !ack || itsdk_sigfox_isDownlinkAllowed() )
+	) {
+		sigfox->available = 1;
+	}
+	uint32_t speed = itsdk_state.sigfox.current_speed;
+	if ( speed == 0 || speed == SIGFOX_DEFAULT_SPEED ) speed = SIGFOX_SPEED_100;
+	uint32_t frameMs = ((14 + (uint32_t)req->size) * 8 * 1000) / speed;
+	sigfox->toaMs = frameMs * (sigfox->param + 1);
+	sigfox->chargeUC = sigfox->toaMs * ITSDK_NETWORK_SFX_TX_CURRENT;
+	if ( ack ) sigfox->chargeUC += __NETWORK_SFX_RXWIN_MS * ITSDK_NETWORK_SFX_RX_CURRENT;
+	sigfox->linkRate = __itsdk_network_linkRate(ITSDK_NETWORK_NET_SIGFOX);
+}
+
+// =================================================================================
+// QUEUE
+// =================================================================================
+
+/**
+ * Queue a message, it is sent on the network with the lowest expected charge able to
+ * start the transmission within deadlineMs. When no network meets the deadline the
+ * earliest one is used. On failure the message is sent again on the other network.
+ * The callback is called once with the final status and the network used, rxData
+ * is the LoRaWan downlink or the Sigfox 8B downlink when received.
+ */
+itsdk_network_send_e itsdk_network_send(
+		uint8_t * payload,
+		uint8_t   size,
+		uint8_t   port,
+		uint32_t  deadlineMs,
+		itsdk_network_rel_e reliability,
+		itdsk_payload_encrypt_t encrypt,
+		void (*callback_func)(itsdk_network_send_e status, uint8_t network, uint8_t size, uint8_t * rxData)
+) {
+	if ( size > ITSDK_NETWORK_MSGSZ ) return NETWORK_SEND_FAILED;
+	int id = -1;
+	for ( int i = 0 ; i < ITSDK_NETWORK_QUEUE_SZ ; i++ ) {
+		if ( !__network.msg[i].used ) {
+			id = i;
+			break;
+		}
+	}
+	if ( id < 0 ) {
+		log_warn("[Network] Queue full\r\n");
+		return NETWORK_SEND_FAILED;
+	}
+	itsdk_network_msg_t * m = &__network.msg[id];
+	m->callback_func = callback_func;
+	m->deadline = itsdk_time_get_ms() + deadlineMs;
+	m->seq = __network.seq++;
+	m->used = 1;
+	m->port = port;
+	m->size = size;
+	m->reliability = reliability;
+	m->tried = ITSDK_NETWORK_NET_NONE;
+	m->encrypt = encrypt;
+	bcopy(payload,m->payload,size);
+
+	__itsdk_network_process();
+	return NETWORK_SEND_QUEUED;
+}
+
+/**
+ * Number of messages waiting or in progress
+ */
+uint8_t itsdk_network_queue_count() {
+	uint8_t c = 0;
+	for ( int i = 0 ; i < ITSDK_NETWORK_QUEUE_SZ ; i++ ) {
+		if ( __network.msg[i].used ) c++;
+	}
+	return c;
+}
+
+static void __itsdk_network_release(uint8_t id, itsdk_network_send_e status, uint8_t network, uint8_t size, uint8_t * rxData) {
+	void (*cb)(itsdk_network_send_e status, uint8_t network, uint8_t size, uint8_t * rxData) = __network.msg[id].callback_func;
+	__network.msg[id].used = 0;
+	if ( cb != NULL ) cb(status,network,size,rxData);
+}
+
+/**
+ * End of the in-flight message, fall back on the other network on failure
+ */
+static void __itsdk_network_complete(uint8_t network, itsdk_network_send_e status, uint8_t size, uint8_t * rxData) {
+	if ( __network.inflight < 0 ) return;
+	uint8_t id = (uint8_t)__network.inflight;
+	__network.inflight = -1;
+	__itsdk_network_addOutcome(network,( status != NETWORK_SEND_FAILED ));
+
+	itsdk_network_msg_t * m = &__network.msg[id];
+	if ( status == NETWORK_SEND_FAILED ) {
+		m->tried |= network;
+		if ( m->tried != (ITSDK_NETWORK_NET_LORAWAN | ITSDK_NETWORK_NET_SIGFOX) ) {
+			log_warn("[Network] Failed on %d, fallback\r\n",network);
+		} else {
+			__itsdk_network_release(id,NETWORK_SEND_FAILED,network,0,NULL);
+		}
+	} else {
+		__itsdk_network_release(id,status,network,size,rxData);
+	}
+	__itsdk_network_process();
+}
+
+static void __itsdk_network_lorawanCb(itsdk_lorawan_send_t status, uint8_t port, uint8_t size, uint8_t * rxData) {
+	itsdk_network_send_e s = NETWORK_SEND_FAILED;
+	bool acked = ( __network.inflight >= 0 && __network.msg[__network.inflight].reliability == ITSDK_NETWORK_REL_ACKED );
+	switch ( status ) {
+	case LORAWAN_SEND_SENT:
+		s = ( acked )?NETWORK_SEND_FAILED:NETWORK_SEND_SENT;		// confirmed uplink not acked
+		break;
+	case LORAWAN_SEND_ACKED:
+	case LORAWAN_SEND_ACKED_WITH_DOWNLINK:
+	case LORAWAN_SEND_ACKED_WITH_DOWNLINK_PENDING:
+		s = NETWORK_SEND_ACKED;
+		break;
+	default:
+		break;
+	}
+	__itsdk_network_complete(ITSDK_NETWORK_NET_LORAWAN,s,size,rxData);
+}
+
+static void __itsdk_network_sigfoxCb(itdsk_sigfox_txrx_t status, uint8_t * dwn) {
+	itsdk_network_send_e s = NETWORK_SEND_FAILED;
+	bool acked = ( __network.inflight >= 0 && __network.msg[__network.inflight].reliability == ITSDK_NETWORK_REL_ACKED );
+	switch ( status ) {
+	case SIGFOX_TRANSMIT_SUCESS:
+	case SIGFOX_TRANSMIT_DWN_SKIPPED:
+	case SIGFOX_TXRX_NO_DOWNLINK:
+		s = ( acked )?NETWORK_SEND_FAILED:NETWORK_SEND_SENT;		// downlink expected
+		break;
+	case SIGFOX_TXRX_DOWLINK_RECEIVED:
+		s = NETWORK_SEND_ACKED;
+		break;
+	default:
+		break;
+	}
+	if ( status != SIGFOX_TXRX_ERROR && status != SIGFOX_ERROR_PARAMS ) {
+		// the uplink has been transmitted, it consumes the quota
+		__itsdk_network_sfxQuotaLeft();
+		__network.sfxCount++;
+		__itsdk_network_sfxQuotaSave();
+	}
+	__itsdk_network_complete(ITSDK_NETWORK_NET_SIGFOX,s,(dwn != NULL)?8:0,dwn);
+}
+
+static void __itsdk_network_trace(itsdk_network_req_t * req, itsdk_network_option_t * l, itsdk_network_option_t * s, uint8_t exclude, uint8_t network) {
+	itsdk_network_trace_t * t = &__network.trace[__network.traceWr];
+	t->req = *req;
+	t->lorawan = *l;
+	t->sigfox = *s;
+	t->exclude = exclude;
+	t->network = network;
+	__network.traceWr = (__network.traceWr+1) % ITSDK_NETWORK_TRACESZ;
+	if ( __network.traceSz < ITSDK_NETWORK_TRACESZ ) __network.traceSz++;
+}
+
+/**
+ * Submit the oldest message able to be sent to the selected stack queue
+ */
+static void __itsdk_network_process() {
+	if ( __network.inflight >= 0 ) return;
+
+	bool done[ITSDK_NETWORK_QUEUE_SZ] = { false };
+	for (;;) {
+		// oldest message not yet considered
+		int id = -1;
+		for ( int i = 0 ; i < ITSDK_NETWORK_QUEUE_SZ ; i++ ) {
+			itsdk_network_msg_t * m = &__network.msg[i];
+			if ( !m->used || done[i] ) continue;
+			if ( id < 0 || (int16_t)(m->seq - __network.msg[id].seq) < 0 ) id = i;
+		}
+		if ( id < 0 ) return;
+
+		itsdk_network_msg_t * m = &__network.msg[id];
+		uint64_t now = itsdk_time_get_ms();
+		itsdk_network_req_t req;
+		req.deadlineMs = ( m->deadline > now )?(uint32_t)(m->deadline - now):0;
+		req.size = m->size;
+		req.reliability = m->reliability;
+		itsdk_network_option_t l, s;
+		itsdk_network_decision_t d;
+		itsdk_network_getOptions(&req,&l,&s);
+		uint8_t net = itsdk_network_decide(&req,&l,&s,m->tried,&d);
+		__itsdk_network_trace(&req,&l,&s,m->tried,net);
+
+		if ( net == ITSDK_NETWORK_NET_NONE ) {
+			if ( req.deadlineMs == 0 ) {
+				log_warn("[Network] No network before the deadline\r\n");
+				__itsdk_network_release(id,NETWORK_SEND_FAILED,ITSDK_NETWORK_NET_NONE,0,NULL);
+				if ( __network.inflight >= 0 ) return;		// the callback has sent a new message
+			} else {
+				done[id] = true;							// wait for a network to be available
+			}
+			continue;
+		}
+
+		bool queued = false;
+		__network.inflight = id;
+		if ( (itsdk_state.activeNetwork & net) != 0 || itsdk_network_activate(net) ) {
+			if ( net == ITSDK_NETWORK_NET_LORAWAN ) {
+				queued = ( itsdk_lorawan_send_queue(
+							m->payload,
+							m->size,
+							m->port,
+							d.param,
+							( m->reliability == ITSDK_NETWORK_REL_ACKED )?LORAWAN_SEND_CONFIRMED:LORAWAN_SEND_UNCONFIRMED,
+							1,
+							0,
+							( d.late )?0:req.deadlineMs,
+							false,
+							__itsdk_network_lorawanCb,
+							m->encrypt
+						  ) == LORAWAN_SEND_QUEUED );
+			} else {
+				queued = ( itsdk_sigfox_sendFrame_queue(
+							m->payload,
+							m->size,
+							d.param,
+							SIGFOX_SPEED_DEFAULT,
+							SIGFOX_POWER_DEFAULT,
+							m->encrypt,
+							( m->reliability == ITSDK_NETWORK_REL_ACKED ),
+							__itsdk_network_sigfoxCb
+						  ) == SIGFOX_TRANSMIT_QUEUED );
+			}
+		}
+		if ( queued ) return;
+
+		// stack refused the message, try the other network
+		__network.inflight = -1;
+		m->tried |= net;
+		if ( m->tried == (ITSDK_NETWORK_NET_LORAWAN | ITSDK_NETWORK_NET_SIGFOX) ) {
+			__itsdk_network_release(id,NETWORK_SEND_FAILED,net,0,NULL);
+			if ( __network.inflight >= 0 ) return;
+		}
+	}
+}
+
+/**
+ * Copy the last decisions with their inputs, oldest first, up to max entries.
+ * Return the number of entries copied.
+ */
+uint8_t itsdk_network_getTrace(itsdk_network_trace_t * trace, uint8_t max) {
+	uint8_t n = ( __network.traceSz < max )?__network.traceSz:max;
+	uint8_t r = (__network.traceWr + ITSDK_NETWORK_TRACESZ - n) % ITSDK_NETWORK_TRACESZ;
+	for ( uint8_t i = 0 ; i < n ; i++ ) {
+		trace[i] = __network.trace[r];
+		r = (r+1) % ITSDK_NETWORK_TRACESZ;
+	}
+	return n;
+}
+
+#if ITSDK_WITH_CONSOLE == __ENABLE
+static void __itsdk_network_printOption(char n, itsdk_network_option_t * o) {
+	_itsdk_console_printf(" %c %d %d %d %d %d %d %d",n,o->available,o->maxSize,o->param,o->linkRate,o->delayMs,o->toaMs,o->chargeUC);
+}
+
+static itsdk_console_return_e __itsdk_network_consolePriv(char * buffer, uint8_t sz) {
+	if ( sz == 1 ) {
+	  switch(buffer[0]){
+		case '?':
+			// help
+			_itsdk_console_printf("--- Network\r\n");
+			_itsdk_console_printf("N          : print network decisions\r\n");
+		  return ITSDK_CONSOLE_SUCCES;
+		  break;
+		case 'N':
+			{
+				// deadline size rel exclude | L/S available maxSize param linkRate delay toa charge | decision
+				itsdk_network_trace_t t;
+				uint8_t n = __network.traceSz;
+				uint8_t r = (__network.traceWr + ITSDK_NETWORK_TRACESZ - n) % ITSDK_NETWORK_TRACESZ;
+				_itsdk_console_printf("Sfx quota left %d, pending %d\r\n",__itsdk_network_sfxQuotaLeft(),itsdk_network_queue_count());
+				for ( uint8_t i = 0 ; i < n ; i++ ) {
+					t = __network.trace[r];
+					r = (r+1) % ITSDK_NETWORK_TRACESZ;
+					_itsdk_console_printf("R %d %d %d %d",t.req.deadlineMs,t.req.size,t.req.reliability,t.exclude);
+					__itsdk_network_printOption('L',&t.lorawan);
+					__itsdk_network_printOption('S',&t.sigfox);
+					_itsdk_console_printf(" > %d\r\n",t.network);
+				}
+				_itsdk_console_printf("OK\r\n");
+			}
+  		    return ITSDK_CONSOLE_SUCCES;
+			break;
+		default:
+			break;
+	  }
+	} //Sz == 1
+  return ITSDK_CONSOLE_NOTFOUND;
+}
+#endif
+
+#endif // ITSDK_WITH_NETWORK_ARB
@@ -0,0 +1,90 @@
+/* ==========================================================
+ * network_policy.c - LoRaWan / Sigfox selection per message
+ * Project : Disk91 SDK
+ * ----------------------------------------------------------
+ * Created on: 18 oct. 2026
+ *     Author: Paul Pinault aka Disk91
+ * ----------------------------------------------------------
+ * Copyright (C) 2026 Disk91
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU LESSER General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ * ----------------------------------------------------------
+ *
+ * The cost of an option is the charge of one transmission divided
+ * by its success rate: the expected charge to get the message
+ * delivered. The options meeting the deadline are compared on this
+ * cost, then on the delay. When none meets the deadline, the
+ * earliest one is selected and the decision is flagged late.
+ * This file has no configuration or hardware dependency.
+ *
+ * ==========================================================
+ */
+#include <it_sdk/network/network_policy.h>
+
+static uint32_t __itsdk_network_cost(const itsdk_network_option_t * o) {
+	uint32_t rate = ( o->linkRate == ITSDK_NETWORK_LINK_UNKNOWN )?ITSDK_NETWORK_LINK_DEFAULT:o->linkRate;
+	if ( rate == 0 ) rate = 1;
+	if ( rate > 100 ) rate = 100;
+	uint64_t c = ((uint64_t)o->chargeUC * 100) / rate;
+	return ( c > 0xFFFFFFFF )?0xFFFFFFFF:(uint32_t)c;
+}
+
+/**
+ * Select the network for a message. Returns the selected ITSDK_NETWORK_NET_x,
+ * ITSDK_NETWORK_NET_NONE when no available option can carry the payload.
+ */
+uint8_t itsdk_network_decide(
+		const itsdk_network_req_t * req,
+		const itsdk_network_option_t * lorawan,
+		const itsdk_network_option_t * sigfox,
+		uint8_t exclude,
+		itsdk_network_decision_t * decision
+) {
+	const itsdk_network_option_t * opts[2] = { lorawan, sigfox };
+	const uint8_t nets[2] = { ITSDK_NETWORK_NET_LORAWAN, ITSDK_NETWORK_NET_SIGFOX };
+
+	decision->network = ITSDK_NETWORK_NET_NONE;
+	decision->param = 0;
+	decision->late = false;
+	decision->delayMs = 0;
+	decision->costUC = 0;
+
+	int best = -1;
+	bool bestOnTime = false;
+	uint32_t bestCost = 0;
+	for ( int i = 0 ; i < 2 ; i++ ) {
+		const itsdk_network_option_t * o = opts[i];
+		if ( (exclude & nets[i]) != 0 || !o->available || o->maxSize < req->size ) continue;
+		bool onTime = ( o->delayMs <= req->deadlineMs );
+		uint32_t cost = __itsdk_network_cost(o);
+		bool better;
+		if ( best < 0 ) better = true;
+		else if ( onTime != bestOnTime ) better = onTime;
+		else if ( onTime ) better = ( cost < bestCost || ( cost == bestCost && o->delayMs < opts[best]->delayMs ) );
+		else better = ( o->delayMs < opts[best]->delayMs || ( o->delayMs == opts[best]->delayMs && cost < bestCost ) );
+		if ( better ) {
+			best = i;
+			bestOnTime = onTime;
+			bestCost = cost;
+		}
+	}
+	if ( best < 0 ) return ITSDK_NETWORK_NET_NONE;
+
+	decision->network = nets[best];
+	decision->param = opts[best]->param;
+	decision->late = !bestOnTime;
+	decision->delayMs = opts[best]->delayMs;
+	decision->costUC = bestCost;
+	return decision->network;
+}
@@ -21,6 +21,10 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  * ----------------------------------------------------------
  * 
+ * The test sequencer replaces the step by step CW commands sent
+ * by the production test bench: the plan is loaded with a few
+ * console commands then each step is started and ended from the
+ * soft timers, the console and the main loop keep running.
  *
  * ==========================================================
  */
@@ -28,6 +32,8 @@
 #include <it_sdk/itsdk.h>
 #include <it_sdk/config.h>
 #include <it_sdk/radio/certification.h>
+#include <it_sdk/time/timer.h>
+#include <it_sdk/time/time.h>
 
 
 #if ITSDK_LORAWAN_LIB == __LORAWAN_SX1276 || ITSDK_SIGFOX_LIB == __SIGFOX_SX1276
@@ -55,8 +61,271 @@ itsdk_bool_e startContinousWaveTransmission(uint32_t frequency, int8_t power, ui
  */
 itsdk_bool_e stopContinousWaveTransmission( void ) {
 #if ITSDK_LORAWAN_LIB == __LORAWAN_SX1276 || ITSDK_SIGFOX_LIB == __SIGFOX_SX1276
-	return BOOL_FALSE;
+	SX1276SetSleep();
+	return BOOL_TRUE;
 #else
 	return BOOL_FALSE;
 #endif
 }
+
+// ====================================================================================
+// Test sequencer
+// ====================================================================================
+
+#if ( ITSDK_LORAWAN_LIB == __LORAWAN_SX1276 || ITSDK_SIGFOX_LIB == __SIGFOX_SX1276 ) && ITSDK_WITH_CONSOLE == __ENABLE && ITSDK_TIMER_SLOTS > 0
+
+static itsdk_certif_plan_t __certif_plan = {
+	.nbFrequency = 0,
+	.nbPower = 0,
+	.dwellMs = 1000,
+	.rxMs = 0,
+	.minRssi = -100
+};
+
+static struct {
+	itsdk_certif_plan_t	plan;					// Copy of the plan under execution
+	bool				running;
+	uint8_t				freq;					// Current frequency index
+	uint8_t				step;					// Current power index, nbPower for the RX window
+	uint64_t			rxStartMs;
+	int16_t				rssiMax;
+	int32_t				rssiSum;
+	uint16_t			rssiCount;
+	uint8_t				pass;
+	uint8_t				fail;
+} __certif_seq;
+
+static void __itsdk_certif_seq_run();
+
+static void __itsdk_certif_seq_end(char * status) {
+	SX1276SetSleep();
+	__certif_seq.running = false;
+	_itsdk_console_printf("END,%s,%d,%d\r\n",status,__certif_seq.pass,__certif_seq.fail);
+}
+
+static void __itsdk_certif_seq_wait(uint32_t ms, void (*callback_func)(uint32_t value)) {
+	if ( itsdk_stimer_register(ms,callback_func,0,TIMER_REFUSE_LOWPOWER) != TIMER_INIT_SUCCESS ) {
+		__itsdk_certif_seq_end("ERR");
+	}
+}
+
+static void __itsdk_certif_seq_count(bool pass) {
+	if ( pass ) __certif_seq.pass++; else __certif_seq.fail++;
+	__certif_seq.step++;
+}
+
+/**
+ * End of a continuous wave step: pass when the radio is still transmitting
+ */
+static void __itsdk_certif_seq_cwEnd(uint32_t value) {
+	if ( ! __certif_seq.running ) return;
+	bool pass = (    SX1276.Settings.State == RF_TX_RUNNING
+			      && ( SX1276Read(REG_OPMODE) & ~RF_OPMODE_MASK ) == RF_OPMODE_TRANSMITTER );
+	SX1276SetSleep();
+	_itsdk_console_printf("CW,%d,%d,%s\r\n",
+			__certif_seq.plan.frequency[__certif_seq.freq]/1000,
+			__certif_seq.plan.power[__certif_seq.step],
+			(pass)?"PASS":"FAIL"
+	);
+	__itsdk_certif_seq_count(pass);
+	__itsdk_certif_seq_run();
+}
+
+/**
+ * RSSI sample during a RX window, pass when the max RSSI reaches the plan threshold
+ */
+static void __itsdk_certif_seq_rssi(uint32_t value) {
+	if ( ! __certif_seq.running ) return;
+	int16_t rssi = SX1276ReadRssi(MODEM_FSK);
+	if ( rssi > __certif_seq.rssiMax ) __certif_seq.rssiMax = rssi;
+	__certif_seq.rssiSum += rssi;
+	__certif_seq.rssiCount++;
+	if ( itsdk_time_get_ms() - __certif_seq.rxStartMs < __certif_seq.plan.rxMs ) {
+		__itsdk_certif_seq_wait(ITSDK_CERTIF_SEQ_RSSI_MS,__itsdk_certif_seq_rssi);
+		return;
+	}
+	SX1276SetSleep();
+	bool pass = ( __certif_seq.rssiMax >= __certif_seq.plan.minRssi );
+	_itsdk_console_printf("RX,%d,%d,%d,%s\r\n",
+			__certif_seq.plan.frequency[__certif_seq.freq]/1000,
+			__certif_seq.rssiMax,
+			__certif_seq.rssiSum / __certif_seq.rssiCount,
+			(pass)?"PASS":"FAIL"
+	);
+	__itsdk_certif_seq_count(pass);
+	__itsdk_certif_seq_run();
+}
+
+/**
+ * Start the next step of the plan: a continuous wave per power then
+ * the RX window for each of the frequencies.
+ */
+static void __itsdk_certif_seq_run() {
+	itsdk_certif_plan_t * p = &__certif_seq.plan;
+	while ( __certif_seq.freq < p->nbFrequency ) {
+		uint32_t f = p->frequency[__certif_seq.freq];
+		if ( __certif_seq.step < p->nbPower ) {
+			// The radio timeout is set after the dwell, the wave is stopped by the sequencer
+			SX1276SetTxContinuousWave(f,p->power[__certif_seq.step],(p->dwellMs / 1000) + 1);
+			__itsdk_certif_seq_wait(p->dwellMs,__itsdk_certif_seq_cwEnd);
+			return;
+		}
+		if ( __certif_seq.step == p->nbPower && p->rxMs > 0 ) {
+			SX1276SetRxConfig(MODEM_FSK, 50000, 4800, 0, 83333, 5, 0, false, 0, true, false, 0, false, true);
+			SX1276SetChannel(f);
+			SX1276SetRx(0);
+			__certif_seq.rxStartMs = itsdk_time_get_ms();
+			__certif_seq.rssiMax = -255;
+			__certif_seq.rssiSum = 0;
+			__certif_seq.rssiCount = 0;
+			__itsdk_certif_seq_wait(ITSDK_CERTIF_SEQ_RSSI_MS,__itsdk_certif_seq_rssi);
+			return;
+		}
+		__certif_seq.freq++;
+		__certif_seq.step = 0;
+	}
+	__itsdk_certif_seq_end("OK");
+}
+
+/**
+ * Start the execution of a test plan, the results are printed on the console:
+ *   CW,freqKHz,power,PASS|FAIL
+ *   RX,freqKHz,rssiMax,rssiAvg,PASS|FAIL
+ *   END,OK|STOP|ERR,nbPass,nbFail
+ * The radio is initialized for the tests, the device needs a reset to use the
+ * Sigfox or LoRaWan stack after.
+ */
+itsdk_bool_e itsdk_certif_seq_start(const itsdk_certif_plan_t * plan) {
+	if ( __certif_seq.running || plan->nbFrequency == 0 || ( plan->nbPower == 0 && plan->rxMs == 0 ) ) return BOOL_FALSE;
+	bcopy(plan,&__certif_seq.plan,sizeof(itsdk_certif_plan_t));
+	__certif_seq.freq = 0;
+	__certif_seq.step = 0;
+	__certif_seq.pass = 0;
+	__certif_seq.fail = 0;
+	__certif_seq.running = true;
+	SX1276IoInit();
+	SX1276Init( NULL );
+	__itsdk_certif_seq_run();
+	return BOOL_TRUE;
+}
+
+void itsdk_certif_seq_stop() {
+	if ( ! __certif_seq.running ) return;
+	itsdk_stimer_stop(__itsdk_certif_seq_cwEnd,0);
+	itsdk_stimer_stop(__itsdk_certif_seq_rssi,0);
+	__itsdk_certif_seq_end("STOP");
+}
+
+bool itsdk_certif_seq_isRunning() {
+	return __certif_seq.running;
+}
+
+/**
+ * Parse a comma separated list of signed decimal values
+ * return the number of values, -1 on error
+ */
+static int __itsdk_certif_parseList(char * s, uint8_t sz, int32_t * values, int max) {
+	int n = 0;
+	int start = 0;
+	for ( int i = 0 ; i <= sz ; i++ ) {
+		if ( i == sz || s[i] == ',' ) {
+			int l = i - start;
+			bool neg = ( l > 0 && s[start] == '-' );
+			if ( neg ) { start++; l--; }
+			if ( l == 0 || l > 7 || n == max ) return -1;
+			int32_t v = itdt_convertDecCharNInt(&s[start],l);
+			if ( v == ITSDK_INVALID_VALUE_32B ) return -1;
+			values[n++] = ( neg )?-v:v;
+			start = i+1;
+		}
+	}
+	return n;
+}
+
+itsdk_console_return_e itsdk_certif_seq_console(char * buffer, uint8_t sz) {
+	int32_t v[ITSDK_CERTIF_SEQ_MAXFREQ+ITSDK_CERTIF_SEQ_MAXPOWER];
+	int n;
+	uint8_t base;
+
+	if ( sz < 3 || buffer[0] != 'c' || buffer[1] != ':' ) return ITSDK_CONSOLE_NOTFOUND;
+	if ( sz == 3 ) {
+		switch ( buffer[2] ) {
+		case 's':
+			if ( itsdk_certif_seq_start(&__certif_plan) == BOOL_FALSE ) goto failed;
+			goto success;
+		case 'x':
+			itsdk_certif_seq_stop();
+			goto success;
+		case 'l':
+			_itsdk_console_printf("Freq kHz :");
+			for ( int i = 0 ; i < __certif_plan.nbFrequency ; i++ ) _itsdk_console_printf(" %d",__certif_plan.frequency[i]/1000);
+			_itsdk_console_printf("\r\nPower    :");
+			for ( int i = 0 ; i < __certif_plan.nbPower ; i++ ) _itsdk_console_printf(" %d",__certif_plan.power[i]);
+			_itsdk_console_printf("\r\nDwell    : %d ms\r\n",__certif_plan.dwellMs);
+			_itsdk_console_printf("RX       : %d ms, pass >= %d dBm\r\n",__certif_plan.rxMs,__certif_plan.minRssi);
+			_itsdk_console_printf("Running  : %s\r\n",(__certif_seq.running)?"yes":"no");
+			goto success;
+		}
+	} else if ( sz > 4 && buffer[3] == ':' ) {
+		if ( __certif_seq.running ) goto failed;
+		switch ( buffer[2] ) {
+		case 'f':
+		case 'F':
+			// c:f:868100,868300 - frequencies in kHz, c:F: adds them to the list
+			// the console line is too short for the full list
+			base = ( buffer[2] == 'F' )?__certif_plan.nbFrequency:0;
+			n = __itsdk_certif_parseList(&buffer[4],sz-4,v,ITSDK_CERTIF_SEQ_MAXFREQ-base);
+			if ( n < 1 ) goto failed;
+			for ( int i = 0 ; i < n ; i++ ) if ( v[i] < 137000 || v[i] > 1020000 ) goto failed;
+			for ( int i = 0 ; i < n ; i++ ) __certif_plan.frequency[base+i] = (uint32_t)v[i] * 1000;
+			__certif_plan.nbFrequency = base+n;
+			goto success;
+		case 'p':
+		case 'P':
+			// c:p:0,10,14 - powers in dBm, c:P: adds them to the list
+			base = ( buffer[2] == 'P' )?__certif_plan.nbPower:0;
+			n = __itsdk_certif_parseList(&buffer[4],sz-4,v,ITSDK_CERTIF_SEQ_MAXPOWER-base);
+			if ( n < 0 ) goto failed;
+			for ( int i = 0 ; i < n ; i++ ) if ( v[i] < -4 || v[i] > 20 ) goto failed;
+			for ( int i = 0 ; i < n ; i++ ) __certif_plan.power[base+i] = (int8_t)v[i];
+			__certif_plan.nbPower = base+n;
+			goto success;
+		case 't':
+			// c:t:dwellMs,rxMs,minRssi
+			n = __itsdk_certif_parseList(&buffer[4],sz-4,v,3);
+			if ( n != 3 ) goto failed;
+			if ( v[0] < 1 || v[0] > 60000 || v[1] < 0 || v[1] > 60000 || v[2] < -160 || v[2] > 0 ) goto failed;
+			__certif_plan.dwellMs = v[0];
+			__certif_plan.rxMs = v[1];
+			__certif_plan.minRssi = v[2];
+			goto success;
+		}
+	}
+	return ITSDK_CONSOLE_NOTFOUND;
+
+success:
+	_itsdk_console_printf("OK\r\n");
+	return ITSDK_CONSOLE_SUCCES;
+failed:
+	_itsdk_console_printf("KO\r\n");
+	return ITSDK_CONSOLE_FAILED;
+}
+
+#else
+
+itsdk_bool_e itsdk_certif_seq_start(const itsdk_certif_plan_t * plan) {
+	return BOOL_FALSE;
+}
+
+void itsdk_certif_seq_stop() {
+}
+
+bool itsdk_certif_seq_isRunning() {
+	return false;
+}
+
+itsdk_console_return_e itsdk_certif_seq_console(char * buffer, uint8_t sz) {
+	return ITSDK_CONSOLE_NOTFOUND;
+}
+
+#endif
@@ -0,0 +1,208 @@
+/* ==========================================================
+ * random.c - Random number service
+ * Project : Disk91 SDK
+ * ----------------------------------------------------------
+ * Created on: 18 oct. 2020
+ *     Author: Paul Pinault aka Disk91
+ * ----------------------------------------------------------
+ * Copyright (C) 2020 Disk91
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU LESSER General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ * ----------------------------------------------------------
+ * Single random service for the SDK and the radio stacks
+ * - An entropy pool is filled opportunistically from the noise
+ *   sources (ADC noise bits, radio RSSI, user sources) with
+ *   itsdk_random_addEntropy. The pool is mixed with the SPECK
+ *   block function so the sources do not need to be unbiased.
+ * - The output is a SPECK32 counter mode generator. It is rekeyed
+ *   from the pool once enough entropy has been collected or after
+ *   ITSDK_RANDOM_RESEED_OUT outputs.
+ * - itsdk_random_seed gives a deterministic sequence (tests / host)
+ *
+ * ==========================================================
+ */
+#include <string.h>
+#include <it_sdk/itsdk.h>
+#include <it_sdk/wrappers.h>
+#include <it_sdk/time/time.h>
+#include <it_sdk/random/random.h>
+
+static itsdk_random_state_t __itsdk_random = { .ready = 0 };
+
+/**
+ * Mix the pool with a new value. Can be called from an interrupt handler.
+ */
+static void __itsdk_random_mix(uint32_t value) {
+	uint16_t p1 = __itsdk_random.pool[0] ^ (value >> 16);
+	uint16_t p2 = __itsdk_random.pool[1] ^ (value & 0xFFFF);
+	speck32_encryptBlock(&__itsdk_random.ctx,&p1,&p2);
+	__itsdk_random.pool[0] = __itsdk_random.pool[2] ^ p1;
+	__itsdk_random.pool[1] = __itsdk_random.pool[3] ^ p2;
+	__itsdk_random.pool[2] = p1;
+	__itsdk_random.pool[3] = p2;
+}
+
+/**
+ * Change the generator key from the pool content. The previous generator
+ * output is mixed in the pool first, so the new key depends on both.
+ */
+static void __itsdk_random_rekey() {
+	uint8_t key[8];
+	__itsdk_random_mix(__itsdk_random.counter);
+	for ( int i = 0 ; i < 4 ; i++ ) {
+		key[2*i]   = __itsdk_random.pool[i] >> 8;
+		key[2*i+1] = __itsdk_random.pool[i] & 0xFF;
+	}
+	speck32_expandKey(&__itsdk_random.ctx,key);
+	__itsdk_random_mix(~__itsdk_random.counter);
+	bzero(key,8);
+	__itsdk_random.poolBits = 0;
+	__itsdk_random.outputs = 0;
+}
+
+/**
+ * Get one unbiased raw bit from the hardware noise source
+ * with Von Neumann algorithm.
+ */
+static uint8_t __itsdk_random_rawBit() {
+	uint8_t a;
+	do {
+		a = itsdk_randomBit() | (itsdk_randomBit() << 1);
+	} while ( a == 0 || a==3 );
+	return (a >> 1);
+}
+
+/**
+ * Init the generator from the hardware noise sources. This is the only
+ * time the raw bits are collected synchronously.
+ */
+void itsdk_random_init() {
+	uint8_t key[8];
+	uint32_t seed = itsdk_getRandomSeed();
+	for ( int i = 0 ; i < 4 ; i++ ) {
+		key[i] = (seed >> (8*i)) & 0xFF;
+	}
+	uint32_t t = (uint32_t)itsdk_time_get_us();
+	for ( int i = 0 ; i < 4 ; i++ ) {
+		key[4+i] = (t >> (8*i)) & 0xFF;
+	}
+	speck32_expandKey(&__itsdk_random.ctx,key);
+	bzero(key,8);
+	for ( int i = 0 ; i < 4 ; i++ ) {
+		__itsdk_random.pool[i] = (seed >> (i*8)) ^ t;
+	}
+	__itsdk_random.counter = 0;
+	for ( int i = 0 ; i < ITSDK_RANDOM_POOL_BITS / 32 ; i++ ) {
+		uint32_t v = 0;
+		for ( int b = 0 ; b < 32 ; b++ ) v = (v << 1) | __itsdk_random_rawBit();
+		__itsdk_random_mix(v);
+	}
+	__itsdk_random_rekey();
+	__itsdk_random.ready = 1;
+}
+
+/**
+ * Deterministic seeding, the sequence only depends on the seed value.
+ * Only for test purpose, the entropy sources can still be added later.
+ */
+void itsdk_random_seed(uint64_t seed) {
+	uint8_t key[8];
+	for ( int i = 0 ; i < 8 ; i++ ) {
+		key[i] = (seed >> ((64-8)-i*8) ) & 0xFF;
+	}
+	speck32_expandKey(&__itsdk_random.ctx,key);
+	for ( int i = 0 ; i < 4 ; i++ ) {
+		__itsdk_random.pool[i] = (seed >> (i*16)) & 0xFFFF;
+	}
+	__itsdk_random.counter = 0;
+	__itsdk_random.poolBits = 0;
+	__itsdk_random.outputs = 0;
+	__itsdk_random.ready = 1;
+}
+
+/**
+ * Add a value to the entropy pool, bits is the estimated number of
+ * real random bits in this value. Can be called from an interrupt handler.
+ */
+void itsdk_random_addEntropy(uint32_t value, uint8_t bits) {
+	if ( __itsdk_random.ready == 0 ) return;
+	// local mask save / restore, the global critical section does not nest
+	uint32_t mask = itsdk_getIrqMask();
+	itsdk_disableIrq();
+	__itsdk_random_mix(value);
+	if ( __itsdk_random.poolBits < 0xFF00 ) __itsdk_random.poolBits += bits;
+	itsdk_setIrqMask(mask);
+}
+
+/**
+ * Called in the itsdk loop, collect a raw noise bit while the pool is
+ * not full and rekey the generator when enough entropy has been collected.
+ */
+void itsdk_random_loop() {
+	if ( __itsdk_random.ready == 0 ) return;
+	if ( __itsdk_random.poolBits < ITSDK_RANDOM_POOL_BITS ) {
+		#if ( ITSDK_WITH_ADC & __ADC_ENABLED ) > 0
+		itsdk_random_addEntropy(itsdk_randomBit() ^ ((uint32_t)itsdk_time_get_us() << 1),1);
+		#endif
+	}
+}
+
+/**
+ * Return a 32b random value
+ */
+uint32_t itsdk_random_getU32() {
+	if ( __itsdk_random.ready == 0 ) itsdk_random_init();
+
+	uint32_t mask = itsdk_getIrqMask();
+	itsdk_disableIrq();
+	if (   __itsdk_random.poolBits >= ITSDK_RANDOM_POOL_BITS
+		|| __itsdk_random.outputs >= ITSDK_RANDOM_RESEED_OUT
+	) {
+		__itsdk_random_rekey();
+	}
+	uint16_t p1 = __itsdk_random.counter >> 16;
+	uint16_t p2 = __itsdk_random.counter & 0xFFFF;
+	__itsdk_random.counter++;
+	__itsdk_random.outputs++;
+	speck32_encryptBlock(&__itsdk_random.ctx,&p1,&p2);
+	itsdk_setIrqMask(mask);
+	return ((uint32_t)p1 << 16) | p2;
+}
+
+/**
+ * Return a random value in [min,max] without modulo bias
+ */
+int32_t itsdk_random_getRange(int32_t min, int32_t max) {
+	if ( max <= min ) return min;
+	uint32_t span = (uint32_t)(max - min) + 1;
+	if ( span == 0 ) return (int32_t)itsdk_random_getU32();
+	uint32_t limit = 0xFFFFFFFF - (0xFFFFFFFF % span);
+	uint32_t v;
+	do {
+		v = itsdk_random_getU32();
+	} while ( v >= limit );
+	return min + (int32_t)(v % span);
+}
+
+/**
+ * Fill the dest buffer with len random bytes
+ */
+void itsdk_random_getBytes(uint8_t * dest, uint16_t len) {
+	uint32_t v = 0;
+	for ( int i = 0 ; i < len ; i++ ) {
+		if ( (i & 3) == 0 ) v = itsdk_random_getU32();
+		dest[i] = v & 0xFF;
+		v >>= 8;
+	}
+}
@@ -0,0 +1,150 @@
+/* ==========================================================
+ * ring.c - Single producer / single consumer ring buffer
+ * Project : Disk91 SDK
+ * ----------------------------------------------------------
+ * Created on: 18 oct. 2020
+ *     Author: Paul Pinault aka Disk91
+ * ----------------------------------------------------------
+ * Copyright (C) 2020 Disk91
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU LESSER General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ * ----------------------------------------------------------
+ * Lock free ring shared between one producer and one consumer,
+ * typically an interrupt handler and the main loop.
+ * - The producer copies the elements then publishes wr
+ * - The consumer copies the elements then publishes rd
+ * A barrier orders the data copy and the index store so the
+ * other side never sees an index before the related data.
+ * When the ring is full, the new elements are dropped and
+ * counted in overflow.
+ *
+ * ==========================================================
+ */
+#include <string.h>
+#include <it_sdk/ring/ring.h>
+
+/**
+ * Reset the ring and its counters. Producer and consumer must be stopped.
+ */
+void itsdk_ring_init(itsdk_ring_t * ring) {
+	ring->wr = 0;
+	ring->rd = 0;
+	ring->highWater = 0;
+	ring->overflow = 0;
+}
+
+/**
+ * Number of elements available for the consumer
+ */
+uint16_t itsdk_ring_count(itsdk_ring_t * ring) {
+	return (uint16_t)(ring->wr - ring->rd);
+}
+
+/**
+ * Number of elements the producer can push
+ */
+uint16_t itsdk_ring_free(itsdk_ring_t * ring) {
+	return (uint16_t)(ring->mask + 1 - (uint16_t)(ring->wr - ring->rd));
+}
+
+/**
+ * Copy count elements from/to the ring starting at index, handling the wrap
+ */
+static void __itsdk_ring_copyIn(itsdk_ring_t * ring, uint16_t index, const uint8_t * src, uint16_t count) {
+	uint16_t pos = index & ring->mask;
+	uint16_t first = ring->mask + 1 - pos;
+	if ( first > count ) first = count;
+	memcpy(&ring->data[pos*ring->elemSz], src, first*ring->elemSz);
+	if ( count > first ) {
+		memcpy(ring->data, &src[first*ring->elemSz], (count-first)*ring->elemSz);
+	}
+}
+
+static void __itsdk_ring_copyOut(itsdk_ring_t * ring, uint16_t index, uint8_t * dst, uint16_t count) {
+	uint16_t pos = index & ring->mask;
+	uint16_t first = ring->mask + 1 - pos;
+	if ( first > count ) first = count;
+	memcpy(dst, &ring->data[pos*ring->elemSz], first*ring->elemSz);
+	if ( count > first ) {
+		memcpy(&dst[first*ring->elemSz], ring->data, (count-first)*ring->elemSz);
+	}
+}
+
+/**
+ * Producer side - push up to count elements, return the number of elements
+ * pushed. The elements not fitting in the ring are dropped and counted.
+ */
+uint16_t itsdk_ring_push(itsdk_ring_t * ring, const void * elems, uint16_t count) {
+	uint16_t wr = ring->wr;
+	uint16_t used = (uint16_t)(wr - ring->rd);
+	uint16_t space = ring->mask + 1 - used;
+	if ( count > space ) {
+		ring->overflow += (count - space);
+		count = space;
+	}
+	if ( count == 0 ) return 0;
+	__itsdk_ring_copyIn(ring, wr, (const uint8_t *)elems, count);
+	ITSDK_RING_BARRIER();
+	ring->wr = (uint16_t)(wr + count);
+	used += count;
+	if ( used > ring->highWater ) ring->highWater = used;
+	return count;
+}
+
+/**
+ * Consumer side - copy up to count elements without consuming them
+ */
+uint16_t itsdk_ring_peek(itsdk_ring_t * ring, void * elems, uint16_t count) {
+	uint16_t rd = ring->rd;
+	uint16_t avail = (uint16_t)(ring->wr - rd);
+	ITSDK_RING_BARRIER();
+	if ( count > avail ) count = avail;
+	if ( count > 0 ) __itsdk_ring_copyOut(ring, rd, (uint8_t *)elems, count);
+	return count;
+}
+
+/**
+ * Consumer side - pop up to count elements, return the number of elements read
+ */
+uint16_t itsdk_ring_pop(itsdk_ring_t * ring, void * elems, uint16_t count) {
+	count = itsdk_ring_peek(ring, elems, count);
+	ITSDK_RING_BARRIER();
+	ring->rd = (uint16_t)(ring->rd + count);
+	return count;
+}
+
+/**
+ * Consumer side - drop all the pending elements
+ */
+void itsdk_ring_flush(itsdk_ring_t * ring) {
+	ring->rd = ring->wr;
+}
+
+/**
+ * Get the max number of pending elements seen and the number of elements
+ * dropped since the last init / reset
+ */
+void itsdk_ring_getStats(itsdk_ring_t * ring, uint16_t * highWater, uint32_t * overflow) {
+	*highWater = ring->highWater;
+	*overflow = ring->overflow;
+}
+
+/**
+ * Clear the counters. They are updated by the producer, a push running
+ * during the reset may be counted or not.
+ */
+void itsdk_ring_resetStats(itsdk_ring_t * ring) {
+	ring->highWater = itsdk_ring_count(ring);
+	ring->overflow = 0;
+}
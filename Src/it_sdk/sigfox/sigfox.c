@@ -33,6 +33,8 @@
 #include <it_sdk/logger/logger.h>
 #include <it_sdk/logger/error.h>
 #include <it_sdk/encrypt/encrypt.h>
+#include <it_sdk/sigfox/sigfox_mem.h>
+#include <it_sdk/time/time.h>
 
 #if ITSDK_WITH_SIGFOX_LIB > 0
 
@@ -66,11 +68,53 @@
 s2lp_config_t __s2lpConf;
 #endif
 
+#if ( ITSDK_SIGFOX_ENCRYPTION & __PAYLOAD_ENCRYPT_SPECKCTR ) > 0
+static itsdk_speck_session_t __sigfox_speck_session = { .ready = 0 };
+#endif
+
+#if ITSDK_SIGFOX_DOWNLINK_PERIOD_S > 0
+static bool __sigfox_dwnRequested = false;
+static uint64_t __sigfox_lastDwnMs;					// Time of the last downlink request
+#endif
+
+#if ITSDK_SIGFOX_UPLINK_QUEUE_SZ > 0
+#include <it_sdk/ring/ring.h>
+
+#if ( ITSDK_SIGFOX_UPLINK_QUEUE_SZ & (ITSDK_SIGFOX_UPLINK_QUEUE_SZ-1) ) != 0
+#error "ITSDK_SIGFOX_UPLINK_QUEUE_SZ must be a power of 2"
+#endif
+
+#define __SIGFOX_QUEUE_FRAME	0
+#define __SIGFOX_QUEUE_BIT		1
+#define __SIGFOX_QUEUE_OOB		2
+
+typedef struct {
+	void (*callback_func)(itdsk_sigfox_txrx_t status, uint8_t * dwn);
+	uint8_t						type;
+	uint8_t						len;				// Frame size, bit value or oob type
+	uint8_t						repeat;
+	int8_t						power;
+	itdsk_sigfox_speed_t		speed;
+	itdsk_payload_encrypt_t		encrypt;
+	bool						ack;
+	uint8_t						payload[12];
+} itsdk_sigfox_uplink_t;
+
+ITSDK_RING_DECLARE(__sigfox_queue,itsdk_sigfox_uplink_t,ITSDK_SIGFOX_UPLINK_QUEUE_SZ);
+static void __itsdk_sigfox_queue_process();
+#endif
+
 /**
  * Static definitions
  */
 int8_t __itsdk_sigfox_getRealTxPower(int8_t reqPower);
 
+#if ITSDK_WITH_CONSOLE == __ENABLE
+#include <it_sdk/console/console.h>
+static itsdk_console_chain_t __console_sigfox;
+static itsdk_console_return_e __itsdk_sigfox_consolePriv(char * buffer, uint8_t sz);
+#endif
+
 /**
  * All operation needed to initialize the sigfox stack
  */
@@ -140,9 +184,51 @@ itsdk_sigfox_init_t itsdk_sigfox_setup() {
 		itsdk_state.sigfox.initialized = true;
 	}
 
+	#if ITSDK_WITH_CONSOLE == __ENABLE
+	if ( !itsdk_console_existCommand(&__console_sigfox) ) {
+		__console_sigfox.console_private = __itsdk_sigfox_consolePriv;
+		__console_sigfox.console_public = NULL;
+		__console_sigfox.next = NULL;
+		itsdk_console_registerCommand(&__console_sigfox);
+	}
+	#endif
+
 	return ret;
 }
 
+#if ITSDK_WITH_CONSOLE == __ENABLE
+static itsdk_console_return_e __itsdk_sigfox_consolePriv(char * buffer, uint8_t sz) {
+	if ( sz == 1 ) {
+	  switch(buffer[0]){
+		case '?':
+			// help
+			_itsdk_console_printf("--- Sigfox\r\n");
+			_itsdk_console_printf("M          : print sigfox lib memory use\r\n");
+		  return ITSDK_CONSOLE_SUCCES;
+		  break;
+		case 'M':
+			{
+				itsdk_sigfox_memStats_t s;
+				itsdk_sigfox_memTrace_t t[ITSDK_SIGFOX_MEM_TRACESZ];
+				itsdk_sigfox_memGetStats(&s);
+				_itsdk_console_printf("Used %d/%dB, peak %dB (0x%08X), max req %dB\r\n",s.used,s.size,s.peak,s.peakCaller,s.maxReq);
+				_itsdk_console_printf("Allocs %d, failures %d\r\n",s.allocs,s.failures);
+				uint8_t n = itsdk_sigfox_memGetTrace(t,ITSDK_SIGFOX_MEM_TRACESZ);
+				for ( uint8_t i = 0 ; i < n ; i++ ) {
+					_itsdk_console_printf("%c %dB -> %dB (0x%08X)\r\n",(t[i].success)?'+':'!',t[i].size,t[i].used,t[i].caller);
+				}
+				_itsdk_console_printf("OK\r\n");
+			}
+  		    return ITSDK_CONSOLE_SUCCES;
+			break;
+		default:
+			break;
+	  }
+	} //Sz == 1
+  return ITSDK_CONSOLE_NOTFOUND;
+}
+#endif
+
 
 /**
  * This function need to be called in the project_loop function
@@ -150,7 +236,9 @@ itsdk_sigfox_init_t itsdk_sigfox_setup() {
  */
 itsdk_sigfox_init_t itsdk_sigfox_loop() {
 	//LOG_DEBUG_LORAWANSTK(("itsdk_sigfox_loop\r\n"));
-	// Nothing yet to do
+	#if ITSDK_SIGFOX_UPLINK_QUEUE_SZ > 0
+	__itsdk_sigfox_queue_process();
+	#endif
 	return SIGFOX_INIT_SUCESS;
  }
 
@@ -158,16 +246,53 @@ itsdk_sigfox_init_t itsdk_sigfox_loop() {
  * Stop the sigfox stack and be ready for activating another stack
  */
 itsdk_sigfox_init_t itsdk_sigfox_deinit() {
+	// Release the library memory, the blocks left by a failed setup or close are
+	// dropped with the arena reset so the next setup starts from an empty arena
+	if ( itsdk_state.sigfox.initialized ) {
+		uint16_t ret = SIGFOX_API_close();
+		if ( ret != SFX_ERR_NONE ) {
+			log_warn("[Sigfox] Sigfox close error (%04X)\r\n",ret);
+		}
+	}
+	itsdk_sigfox_memReset();
 	#if ITSDK_SIGFOX_LIB ==	__SIGFOX_S2LP
 		#warning "Not yets implemented"
 	#elif ITSDK_SIGFOX_LIB == __SIGFOX_SX1276
 		sx1276_sigfox_deinit();
 	#endif
+	#if ( ITSDK_SIGFOX_ENCRYPTION & __PAYLOAD_ENCRYPT_SPECKCTR ) > 0
+		itsdk_speck_ctr_close(&__sigfox_speck_session);
+	#endif
 	itsdk_state.sigfox.initialized = false;
 	return SIGFOX_INIT_SUCESS;
 }
 
 
+#if ( ITSDK_SIGFOX_ENCRYPTION & __PAYLOAD_ENCRYPT_SPECKCTR ) > 0
+/**
+ * Return the SPECK-CTR epoch for the next frame. The 12b sequence id wraps, the
+ * epoch is incremented for the frame using the sequence id 0. Bit 7 of the stored
+ * value stays set until the sequence id changes so the increment is not repeated
+ * on a retry or after a reset. Called before every uplink, encrypted or not.
+ * The 7b epoch wraps after 128 x 4096 = 524288 frames: 10 years at the 140
+ * uplinks per day of the Sigfox platinum subscription, the key must be changed
+ * before for a higher rate.
+ */
+static uint16_t __itsdk_sigfox_speckEpoch() {
+	uint16_t seqId, e;
+	itsdk_sigfox_getNextSeqId(&seqId);
+	itsdk_encrypt_speck_getEpoch(ITSDK_SPECK_CTR_DOMAIN_SIGFOX,&e);
+	if ( seqId == 0 && (e & 0x80) == 0 ) {
+		e = ((e + 1) & 0x7F) | 0x80;
+		itsdk_encrypt_speck_setEpoch(ITSDK_SPECK_CTR_DOMAIN_SIGFOX,e);
+	} else if ( seqId != 0 && (e & 0x80) != 0 ) {
+		e &= 0x7F;
+		itsdk_encrypt_speck_setEpoch(ITSDK_SPECK_CTR_DOMAIN_SIGFOX,e);
+	}
+	return e & 0x7F;
+}
+#endif
+
 /**
  * Send a frame on sigfox network
  * buf - the buffer containing the data to be transmitted
@@ -210,6 +335,9 @@ itdsk_sigfox_txrx_t itsdk_sigfox_sendFrame(
 	#endif
 
 	// encrypt the frame
+	#if ( ITSDK_SIGFOX_ENCRYPTION & __PAYLOAD_ENCRYPT_SPECKCTR ) > 0
+		uint16_t speckEpoch = __itsdk_sigfox_speckEpoch();
+	#endif
 	#if ( ITSDK_SIGFOX_ENCRYPTION & __PAYLOAD_ENCRYPT_SPECK ) > 0
 		if ( (encrypt & PAYLOAD_ENCRYPT_SPECK) > 0 ) {
 			uint64_t masterKey;
@@ -222,6 +350,20 @@ itdsk_sigfox_txrx_t itsdk_sigfox_sendFrame(
 			);
 		}
 	#endif
+	#if ( ITSDK_SIGFOX_ENCRYPTION & __PAYLOAD_ENCRYPT_SPECKCTR ) > 0
+		if ( (encrypt & PAYLOAD_ENCRYPT_SPECKCTR) > 0 ) {
+			if ( ! itsdk_speck_ctr_isOpen(&__sigfox_speck_session) ) {
+				uint64_t masterKey;
+				itsdk_encrypt_speck_getMasterKey(&masterKey);
+				itsdk_speck_ctr_open(&__sigfox_speck_session,masterKey,ITSDK_SPECK_CTR_DOMAIN_SIGFOX);
+				masterKey = 0;
+			}
+			uint16_t seqId;
+			itsdk_sigfox_getNextSeqId(&seqId);
+			itsdk_speck_ctr_setIv(&__sigfox_speck_session,speckEpoch,seqId);
+			itsdk_speck_ctr_encrypt(&__sigfox_speck_session,buf,buf,len);
+		}
+	#endif
 	#if (ITSDK_SIGFOX_ENCRYPTION & __PAYLOAD_ENCRYPT_AESCTR) > 0
 		if ( (encrypt & PAYLOAD_ENCRYPT_AESCTR) > 0 ) {
 			uint32_t devId;
@@ -253,6 +395,12 @@ itdsk_sigfox_txrx_t itsdk_sigfox_sendFrame(
 	itsdk_sigfox_setTxSpeed(speed);
 
 	itdsk_sigfox_txrx_t result;
+	#if ITSDK_SIGFOX_DOWNLINK_PERIOD_S > 0
+	if ( ack ) {
+		__sigfox_dwnRequested = true;
+		__sigfox_lastDwnMs = itsdk_time_get_ms();
+	}
+	#endif
 #if ITSDK_SIGFOX_LIB ==	__SIGFOX_S2LP || ITSDK_SIGFOX_LIB == __SIGFOX_SX1276
 	uint16_t ret = SIGFOX_API_send_frame(buf,len,dwn,repeat,ack);
 	switch (ret&0xFF) {
@@ -311,8 +459,17 @@ itdsk_sigfox_txrx_t itsdk_sigfox_sendBit(
 
 	itsdk_sigfox_setTxPower(power);
 	itsdk_sigfox_setTxSpeed(speed);
+	#if ( ITSDK_SIGFOX_ENCRYPTION & __PAYLOAD_ENCRYPT_SPECKCTR ) > 0
+	__itsdk_sigfox_speckEpoch();
+	#endif
 
 	itdsk_sigfox_txrx_t result = SIGFOX_TXRX_ERROR;
+	#if ITSDK_SIGFOX_DOWNLINK_PERIOD_S > 0
+	if ( ack ) {
+		__sigfox_dwnRequested = true;
+		__sigfox_lastDwnMs = itsdk_time_get_ms();
+	}
+	#endif
 	#if ITSDK_SIGFOX_LIB ==	__SIGFOX_S2LP || ITSDK_SIGFOX_LIB == __SIGFOX_SX1276
 		sfx_bool value = (bitValue)?SFX_TRUE:SFX_FALSE;
 		uint16_t ret = SIGFOX_API_send_bit( value,dwn,repeat,ack);
@@ -356,6 +513,9 @@ itdsk_sigfox_txrx_t itsdk_sigfox_sendOob(
 	if ( speed == SIGFOX_SPEED_DEFAULT ) speed = itsdk_state.sigfox.current_speed;
 	itsdk_sigfox_setTxPower(power);
 	itsdk_sigfox_setTxSpeed(speed);
+	#if ( ITSDK_SIGFOX_ENCRYPTION & __PAYLOAD_ENCRYPT_SPECKCTR ) > 0
+	__itsdk_sigfox_speckEpoch();
+	#endif
 
 	itdsk_sigfox_txrx_t result = SIGFOX_TXRX_ERROR;
 	#if ITSDK_SIGFOX_LIB ==	__SIGFOX_S2LP || ITSDK_SIGFOX_LIB == __SIGFOX_SX1276
@@ -385,6 +545,173 @@ itdsk_sigfox_txrx_t itsdk_sigfox_sendOob(
 	return result;
 }
 
+/**
+ * Return true when a downlink can be requested according to ITSDK_SIGFOX_DOWNLINK_PERIOD_S
+ * The period starts on every downlink request, queued or not.
+ */
+bool itsdk_sigfox_isDownlinkAllowed() {
+	#if ITSDK_SIGFOX_DOWNLINK_PERIOD_S > 0
+	if ( !__sigfox_dwnRequested ) return true;
+	return ( itsdk_time_get_ms() - __sigfox_lastDwnMs >= (uint64_t)ITSDK_SIGFOX_DOWNLINK_PERIOD_S*1000 );
+	#else
+	return true;
+	#endif
+}
+
+#if ITSDK_SIGFOX_UPLINK_QUEUE_SZ > 0
+
+static itdsk_sigfox_txrx_t __itsdk_sigfox_queue_push(itsdk_sigfox_uplink_t * m) {
+	if ( itsdk_ring_push(&__sigfox_queue,m,1) == 0 ) {
+		LOG_WARN_SIGFOXSTK(("[Sigfox] Uplink queue full\r\n"));
+		return SIGFOX_TXRX_ERROR;
+	}
+	return SIGFOX_TRANSMIT_QUEUED;
+}
+
+/**
+ * Queue a frame. The message is sent by itsdk_sigfox_loop(), blocked during the transmission
+ * and the downlink window like itsdk_sigfox_sendFrame. The payload is copied and
+ * encrypted just before the transmission. The parameters are the ones of itsdk_sigfox_sendFrame.
+ * When ack is set and a downlink has been requested less than ITSDK_SIGFOX_DOWNLINK_PERIOD_S ago,
+ * the frame is sent without downlink request and SIGFOX_TRANSMIT_DWN_SKIPPED is reported.
+ * The callback is called once with the final status, dwn is the downlink buffer when
+ * SIGFOX_TXRX_DOWLINK_RECEIVED is reported.
+ * Returns
+ *   - SIGFOX_TRANSMIT_QUEUED on success
+ *   - SIGFOX_ERROR_PARAMS when the frame is too large
+ *   - SIGFOX_TXRX_ERROR when the queue is full
+ */
+itdsk_sigfox_txrx_t itsdk_sigfox_sendFrame_queue(
+		uint8_t * buf,
+		uint8_t len,
+		uint8_t repeat,
+		itdsk_sigfox_speed_t speed,
+		int8_t power,
+		itdsk_payload_encrypt_t encrypt,
+		bool ack,
+		void (*callback_func)(itdsk_sigfox_txrx_t status, uint8_t * dwn)
+) {
+	LOG_INFO_SIGFOXSTK(("itsdk_sigfox_sendFrame_queue\r\n"));
+	if ( len > 12 ) return SIGFOX_ERROR_PARAMS;
+
+	itsdk_sigfox_uplink_t m;
+	m.callback_func = callback_func;
+	m.type = __SIGFOX_QUEUE_FRAME;
+	m.len = len;
+	m.repeat = repeat;
+	m.power = power;
+	m.speed = speed;
+	m.encrypt = encrypt;
+	m.ack = ack;
+	bcopy(buf,m.payload,len);
+	return __itsdk_sigfox_queue_push(&m);
+}
+
+/**
+ * Queue a bit, same behavior as itsdk_sigfox_sendFrame_queue
+ */
+itdsk_sigfox_txrx_t itsdk_sigfox_sendBit_queue(
+		bool bitValue,
+		uint8_t repeat,
+		itdsk_sigfox_speed_t speed,
+		int8_t power,
+		bool ack,
+		void (*callback_func)(itdsk_sigfox_txrx_t status, uint8_t * dwn)
+) {
+	LOG_INFO_SIGFOXSTK(("itsdk_sigfox_sendBit_queue\r\n"));
+
+	itsdk_sigfox_uplink_t m;
+	m.callback_func = callback_func;
+	m.type = __SIGFOX_QUEUE_BIT;
+	m.len = (bitValue)?1:0;
+	m.repeat = repeat;
+	m.power = power;
+	m.speed = speed;
+	m.encrypt = PAYLOAD_ENCRYPT_NONE;
+	m.ack = ack;
+	return __itsdk_sigfox_queue_push(&m);
+}
+
+/**
+ * Queue an OOB message, same behavior as itsdk_sigfox_sendFrame_queue
+ */
+itdsk_sigfox_txrx_t itsdk_sigfox_sendOob_queue(
+		itdsk_sigfox_oob_t oobType,
+		itdsk_sigfox_speed_t speed,
+		int8_t power,
+		void (*callback_func)(itdsk_sigfox_txrx_t status, uint8_t * dwn)
+) {
+	LOG_INFO_SIGFOXSTK(("itsdk_sigfox_sendOob_queue\r\n"));
+
+	itsdk_sigfox_uplink_t m;
+	m.callback_func = callback_func;
+	m.type = __SIGFOX_QUEUE_OOB;
+	m.len = (uint8_t)oobType;
+	m.repeat = 0;
+	m.power = power;
+	m.speed = speed;
+	m.encrypt = PAYLOAD_ENCRYPT_NONE;
+	m.ack = false;
+	return __itsdk_sigfox_queue_push(&m);
+}
+
+/**
+ * Number of messages waiting in the uplink queue
+ */
+uint8_t itsdk_sigfox_queue_count() {
+	return (uint8_t)itsdk_ring_count(&__sigfox_queue);
+}
+
+/**
+ * Drop all the messages not yet transmitted, their callback is called with SIGFOX_TXRX_ERROR
+ */
+void itsdk_sigfox_queue_flush() {
+	LOG_INFO_SIGFOXSTK(("itsdk_sigfox_queue_flush\r\n"));
+	itsdk_sigfox_uplink_t m;
+	while ( itsdk_ring_pop(&__sigfox_queue,&m,1) > 0 ) {
+		if ( m.callback_func != NULL ) m.callback_func(SIGFOX_TXRX_ERROR,NULL);
+	}
+}
+
+/**
+ * Queue processing, called from itsdk_sigfox_loop()
+ * Sends the oldest message. The sigfox library is blocking during the transmission and
+ * the downlink window, the MCU sleeps during the library waits.
+ */
+static void __itsdk_sigfox_queue_process() {
+	if ( !itsdk_state.sigfox.initialized ) return;
+
+	itsdk_sigfox_uplink_t m;
+	if ( itsdk_ring_pop(&__sigfox_queue,&m,1) == 0 ) return;
+
+	bool skipped = false;
+	if ( m.ack && !itsdk_sigfox_isDownlinkAllowed() ) {
+		LOG_INFO_SIGFOXSTK(("[Sigfox] Downlink request skipped\r\n"));
+		m.ack = false;
+		skipped = true;
+	}
+
+	uint8_t dwn[8];
+	itdsk_sigfox_txrx_t status;
+	switch ( m.type ) {
+	case __SIGFOX_QUEUE_FRAME:
+		status = itsdk_sigfox_sendFrame(m.payload,m.len,m.repeat,m.speed,m.power,m.encrypt,m.ack,dwn);
+		break;
+	case __SIGFOX_QUEUE_BIT:
+		status = itsdk_sigfox_sendBit((m.len > 0),m.repeat,m.speed,m.power,m.ack,dwn);
+		break;
+	default:
+		status = itsdk_sigfox_sendOob((itdsk_sigfox_oob_t)m.len,m.speed,m.power);
+		break;
+	}
+	if ( skipped && status == SIGFOX_TRANSMIT_SUCESS ) status = SIGFOX_TRANSMIT_DWN_SKIPPED;
+	if ( m.callback_func != NULL ) {
+		m.callback_func(status,( status == SIGFOX_TXRX_DOWLINK_RECEIVED )?dwn:NULL);
+	}
+}
+
+#endif // ITSDK_SIGFOX_UPLINK_QUEUE_SZ
+
 /**
  * Get the current RCZ
  */
@@ -676,6 +1003,9 @@ itsdk_sigfox_init_t itsdk_sigfox_getNvmSize(uint32_t * sz) {
 	*sz = (   sizeof(itsdk_sigfox_nvm_header_t)
 			+ itdt_align_32b(SFX_NVMEM_BLOCK_SIZE)
 			+ itdt_align_32b(SFX_SE_NVMEM_BLOCK_SIZE)
+		  #if ITSDK_WITH_NETWORK_ARB == __ENABLE
+			+ sizeof(itsdk_sigfox_nvm_quota_t)
+		  #endif
 		  );
 	return SIGFOX_INIT_SUCESS;
 }
@@ -699,6 +1029,17 @@ itsdk_sigfox_init_t itsdk_sigfox_getSeNvmOffset(uint32_t * offset) {
 	return SIGFOX_INIT_SUCESS;
 }
 
+#if ITSDK_WITH_NETWORK_ARB == __ENABLE
+/**
+ * Return the offset of the Sigfox quota window saved by the network arbitration
+ */
+itsdk_sigfox_init_t itsdk_sigfox_getQuotaNvmOffset(uint32_t * offset) {
+	itsdk_sigfox_getSeNvmOffset(offset);
+	*offset += itdt_align_32b(SFX_SE_NVMEM_BLOCK_SIZE);
+	return SIGFOX_INIT_SUCESS;
+}
+#endif
+
 /**
  * Return the offset of the NVM area for Sigfox
  * Data including the Lib Nvm Offset followed by the
@@ -743,6 +1084,12 @@ itsdk_sigfox_init_t __itsdk_sigfox_resetNvmToFactory(bool force) {
 		uint8_t se_mcu_default[SFX_NVMEM_BLOCK_SIZE];
 		bzero(se_mcu_default,SFX_NVMEM_BLOCK_SIZE);
 		MCU_API_set_nv_mem(se_mcu_default);
+		#if ITSDK_WITH_NETWORK_ARB == __ENABLE
+		itsdk_sigfox_nvm_quota_t quota;
+		bzero(&quota,sizeof(itsdk_sigfox_nvm_quota_t));
+		itsdk_sigfox_getQuotaNvmOffset(&offset);
+		_eeprom_write(ITDT_EEPROM_BANK0, offset, (void *) &quota, sizeof(itsdk_sigfox_nvm_quota_t));
+		#endif
 	} else {
 		LOG_INFO_SIGFOXSTK((".. Skiped\r\n"));
 	}
@@ -828,6 +1175,9 @@ itsdk_sigfox_init_t itsdk_sigfox_resetFactoryDefaults(bool force) {
 		itsdk_secstore_writeBlock(ITSDK_SS_SIGFOXKEY, key);
 		bzero(key,16);
 	}
+  #if ITSDK_SIGFOX_LIB == __SIGFOX_S2LP && ITSDK_S2LP_CNF_CACHE == __ENABLE
+	if ( force ) s2lp_invalidateConfigCache();	// parse the M95640 eeprom again on next init
+  #endif
 	bzero(buffer,16);
 	return SIGFOX_INIT_SUCESS;
 }
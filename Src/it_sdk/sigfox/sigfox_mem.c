@@ -0,0 +1,165 @@
+/* ==========================================================
+ * sigfox_mem.c - Static memory arena for the sigfox libraries
+ * Project : Disk91 SDK
+ * ----------------------------------------------------------
+ * Created on: 18 oct. 2020
+ *     Author: Paul Pinault aka Disk91
+ * ----------------------------------------------------------
+ * Copyright (C) 2020 Disk91
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU LESSER General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ * ----------------------------------------------------------
+ *
+ * The sigfox libraries allocate their working memory through
+ * MCU_API_malloc. The buffer is managed as a stack: the blocks are
+ * allocated on top of the previous one (4B aligned) and released
+ * when freed in the reverse order. The peak use and the caller
+ * reaching it are kept to right-size ITSDK_SIGFOX_MEM_SIZE.
+ *
+ * ==========================================================
+ */
+#include <it_sdk/config.h>
+#if ITSDK_WITH_SIGFOX_LIB == __ENABLE
+
+#include <string.h>
+#include <it_sdk/sigfox/sigfox_mem.h>
+#include <it_sdk/logger/logger.h>
+#include <it_sdk/logger/error.h>
+
+// The new version of the compiler was protecting memory access against static elements
+// Making a hardfault in the sigfox api init function when it tried to write into this zone.
+// Non static declaration solve this issue
+// Next issue was on alignement, if not aligned on 4 it is possible that the first address is out of the
+// authorized area.
+uint8_t __sigfox_mem[ITSDK_SIGFOX_MEM_SIZE] __attribute__((aligned(4)));
+
+static struct {
+	uint16_t	offset[ITSDK_SIGFOX_MEM_MAXALLOC];	// start of the allocated blocks
+	uint8_t		freed;								// bit field, block freed but not on top
+	uint8_t		count;								// number of blocks in the stack
+	uint16_t	used;
+	itsdk_sigfox_memStats_t	stats;
+	itsdk_sigfox_memTrace_t	trace[ITSDK_SIGFOX_MEM_TRACESZ];
+	uint8_t		traceWr;							// next trace entry to write
+	uint8_t		traceSz;							// number of valid trace entries
+} __sfx_mem = { 0 };
+
+static void __itsdk_sigfox_memTrace(uint16_t size, uint32_t caller, bool success) {
+	itsdk_sigfox_memTrace_t * t = &__sfx_mem.trace[__sfx_mem.traceWr];
+	t->size = size;
+	t->used = __sfx_mem.used;
+	t->caller = caller;
+	t->success = success;
+	__sfx_mem.traceWr = (__sfx_mem.traceWr+1) % ITSDK_SIGFOX_MEM_TRACESZ;
+	if ( __sfx_mem.traceSz < ITSDK_SIGFOX_MEM_TRACESZ ) __sfx_mem.traceSz++;
+}
+
+/**
+ * Allocate a block of size bytes on top of the arena.
+ * caller is the return address of MCU_API_malloc, reported in the trace.
+ * Return false and report an error when the arena is too small.
+ */
+bool itsdk_sigfox_memAlloc(uint16_t size, uint32_t caller, uint8_t ** ptr) {
+
+	uint16_t start = (__sfx_mem.used + 3) & ~3;
+	if ( size > __sfx_mem.stats.maxReq ) __sfx_mem.stats.maxReq = size;
+	if (    __sfx_mem.count >= ITSDK_SIGFOX_MEM_MAXALLOC
+		 || (uint32_t)start + size > ITSDK_SIGFOX_MEM_SIZE
+	) {
+		__sfx_mem.stats.failures++;
+		__itsdk_sigfox_memTrace(size, caller, false);
+		log_error("Sigfox mem overflow, req %dB, used %dB / %dB\r\n",size,__sfx_mem.used,ITSDK_SIGFOX_MEM_SIZE);
+		ITSDK_ERROR_REPORT(ITSDK_ERROR_SIGFOX_MEM_OVERFLOW,(uint16_t)(start+size));
+		*ptr = NULL;
+		return false;
+	}
+
+	__sfx_mem.offset[__sfx_mem.count] = start;
+	__sfx_mem.count++;
+	__sfx_mem.used = start + size;
+	__sfx_mem.stats.allocs++;
+	if ( __sfx_mem.used > __sfx_mem.stats.peak ) {
+		__sfx_mem.stats.peak = __sfx_mem.used;
+		__sfx_mem.stats.peakCaller = caller;
+	}
+	__itsdk_sigfox_memTrace(size, caller, true);
+	*ptr = &__sigfox_mem[start];
+	return true;
+}
+
+/**
+ * Release a block. The memory is reused once all the blocks
+ * allocated after it have also been released.
+ * Return false when the pointer has not been allocated by the arena.
+ */
+bool itsdk_sigfox_memFree(uint8_t * ptr) {
+	int i = __sfx_mem.count-1;
+	while ( i >= 0 && &__sigfox_mem[__sfx_mem.offset[i]] != ptr ) i--;
+	if ( i < 0 || ( __sfx_mem.freed & (1 << i) ) != 0 ) {
+		log_error("Sigfox mem free of an unknown block\r\n");
+		return false;
+	}
+	__sfx_mem.freed |= (1 << i);
+	while ( __sfx_mem.count > 0 && ( __sfx_mem.freed & (1 << (__sfx_mem.count-1)) ) != 0 ) {
+		__sfx_mem.count--;
+		__sfx_mem.freed &= ~(1 << __sfx_mem.count);
+		__sfx_mem.used = __sfx_mem.offset[__sfx_mem.count];
+	}
+	return true;
+}
+
+/**
+ * Get the arena use statistics
+ */
+void itsdk_sigfox_memGetStats(itsdk_sigfox_memStats_t * stats) {
+	memcpy(stats,&__sfx_mem.stats,sizeof(itsdk_sigfox_memStats_t));
+	stats->size = ITSDK_SIGFOX_MEM_SIZE;
+	stats->used = __sfx_mem.used;
+}
+
+/**
+ * Copy the last requests, oldest first, up to max entries.
+ * Return the number of entries copied.
+ */
+uint8_t itsdk_sigfox_memGetTrace(itsdk_sigfox_memTrace_t * trace, uint8_t max) {
+	uint8_t n = ( __sfx_mem.traceSz < max )?__sfx_mem.traceSz:max;
+	uint8_t r = (__sfx_mem.traceWr + ITSDK_SIGFOX_MEM_TRACESZ - n) % ITSDK_SIGFOX_MEM_TRACESZ;
+	for ( uint8_t i = 0 ; i < n ; i++ ) {
+		trace[i] = __sfx_mem.trace[r];
+		r = (r+1) % ITSDK_SIGFOX_MEM_TRACESZ;
+	}
+	return n;
+}
+
+/**
+ * Release all the blocks, called when the library is closed.
+ * The statistics and the trace are kept.
+ */
+void itsdk_sigfox_memReset() {
+	__sfx_mem.count = 0;
+	__sfx_mem.freed = 0;
+	__sfx_mem.used = 0;
+}
+
+/**
+ * Clear the peak and the trace, the allocated blocks are kept
+ */
+void itsdk_sigfox_memResetStats() {
+	bzero(&__sfx_mem.stats,sizeof(itsdk_sigfox_memStats_t));
+	__sfx_mem.stats.peak = __sfx_mem.used;
+	__sfx_mem.traceWr = 0;
+	__sfx_mem.traceSz = 0;
+}
+
+#endif // ITSDK_WITH_SIGFOX_LIB
@@ -42,6 +42,22 @@ uint32_t __time_epoc_atreference_S = 0;		// store the UTC time corresponding to
 uint64_t __time_utc_reference_uS = 0;		// store the local time reference corresponding to 00:00:00 utc time
 uint32_t __time_utc_atreference_S = 0;		// store the UTC time corresponding to the local reference
 
+#define __TIME_DRIFT_MIN_PERIOD_S	600			// min duration between two ms precision syncs to estimate the drift
+#define __TIME_DRIFT_MAX_PPB		1000000		// drift over 1000ppm is considered as a wrong time source
+#define __TIME_GPS_EPOC_OFFSET_S	315964800	// EPOC time of the GPS time origin, 06/01/1980 00:00:00 UTC
+int32_t  __time_drift_ppb = 0;				// measured local clock drift, > 0 when the local clock is too fast
+uint64_t __time_drift_reference_uS = 0;		// local time of the sync used as drift base
+uint64_t __time_drift_atreference_mS = 0;	// EPOC time in ms at the drift base, 0 when not set
+
+
+/**
+ * Duration in S between two local time in uS corrected with the measured drift
+ */
+static uint64_t __itsdk_time_elapsed_s(uint64_t from_us, uint64_t to_us) {
+	int64_t t = to_us - from_us;
+	t -= ((t / 1000) * __time_drift_ppb) / 1000000;
+	return t / 1000000;
+}
 
 
 /**
@@ -96,13 +112,22 @@ void itsdk_time_sync_UTC_s( uint32_t utc_s ){
 	__time_utc_atreference_S = utc_s;
 }
 
+/**
+ * Sync the UTC Time reference
+ * With the second count since midnight and the ms part of the current second
+ */
+void itsdk_time_sync_UTC_ms( uint32_t utc_s, uint16_t ms ){
+	__time_utc_reference_uS = itsdk_time_get_us() - (uint32_t)ms*1000;
+	__time_utc_atreference_S = utc_s;
+}
+
 /**
  * Get the current UTC time
  * Return the time in S when utc reference have been set 0 otherwise
  */
 uint32_t itsdk_time_get_UTC_s(){
 	if ( __time_utc_atreference_S == 0 ) return 0;
-	uint64_t t = (itsdk_time_get_us() - __time_utc_reference_uS) / 1000000;
+	uint64_t t = __itsdk_time_elapsed_s(__time_utc_reference_uS,itsdk_time_get_us());
 	return __time_utc_atreference_S + t;
 }
 
@@ -111,7 +136,7 @@ uint32_t itsdk_time_get_UTC_s(){
  */
 uint8_t itsdk_time_get_UTC_hour(){
 	if ( __time_utc_atreference_S == 0 ) return 0;
-	uint64_t t = (itsdk_time_get_us() - __time_utc_reference_uS) / 1000000;
+	uint64_t t = __itsdk_time_elapsed_s(__time_utc_reference_uS,itsdk_time_get_us());
 	t = __time_utc_atreference_S + t;
 
 	t /= 3600;
@@ -125,7 +150,7 @@ uint8_t itsdk_time_get_UTC_hour(){
  */
 uint8_t itsdk_time_get_UTC_min(){
 	if ( __time_utc_atreference_S == 0 ) return 0;
-	uint64_t t = (itsdk_time_get_us() - __time_utc_reference_uS) / 1000000;
+	uint64_t t = __itsdk_time_elapsed_s(__time_utc_reference_uS,itsdk_time_get_us());
 	t = __time_utc_atreference_S + t;
 
 	t /= 60;
@@ -139,7 +164,7 @@ uint8_t itsdk_time_get_UTC_min(){
  */
 uint8_t itsdk_time_get_UTC_sec(){
 	if ( __time_utc_atreference_S == 0 ) return 0;
-	uint64_t t = (itsdk_time_get_us() - __time_utc_reference_uS) / 1000000;
+	uint64_t t = __itsdk_time_elapsed_s(__time_utc_reference_uS,itsdk_time_get_us());
 	t = __time_utc_atreference_S + t;
 	t %= 60;
 	return t;
@@ -156,7 +181,7 @@ uint8_t itsdk_time_get_UTC_sec(){
  */
 itsdk_bool_e itsdk_time_is_UTC_s(uint32_t * destTime) {
 	if ( destTime != NULL ) {
-		uint64_t t = (itsdk_time_get_us() - __time_utc_reference_uS) / 1000000;
+		uint64_t t = __itsdk_time_elapsed_s(__time_utc_reference_uS,itsdk_time_get_us());
 		*destTime = (uint32_t)(__time_utc_atreference_S + t);
 	}
 	if ( __time_utc_atreference_S == 0 ) return BOOL_FALSE;
@@ -176,13 +201,51 @@ void itsdk_time_sync_EPOC_s( uint32_t utc_s ){
 	__time_epoc_atreference_S = utc_s;
 }
 
+/**
+ * Sync the EPOC Time reference
+ * With the second count since EPOC and the ms part of the current second
+ * Time sources with a ms precision (LoRaWAN DeviceTime...) are used to measure
+ * the local clock drift between two syncs, the drift is then compensated.
+ */
+void itsdk_time_sync_EPOC_ms( uint32_t epoc_s, uint16_t ms ){
+	uint64_t now = itsdk_time_get_us();
+	uint64_t epoc_ms = (uint64_t)epoc_s*1000 + ms;
+
+	if ( __time_drift_atreference_mS > 0 && epoc_ms > __time_drift_atreference_mS ) {
+		int64_t real = (int64_t)(epoc_ms - __time_drift_atreference_mS)*1000;
+		if ( real >= (int64_t)__TIME_DRIFT_MIN_PERIOD_S*1000000 ) {
+			int64_t local = now - __time_drift_reference_uS;
+			int64_t drift = ((local - real) * 1000000000) / real;
+			if ( drift < __TIME_DRIFT_MAX_PPB && drift > -__TIME_DRIFT_MAX_PPB ) {
+				__time_drift_ppb = ( __time_drift_ppb == 0 )?(int32_t)drift:(int32_t)((__time_drift_ppb + drift)/2);
+			}
+			__time_drift_reference_uS = now;
+			__time_drift_atreference_mS = epoc_ms;
+		}
+	} else {
+		__time_drift_reference_uS = now;
+		__time_drift_atreference_mS = epoc_ms;
+	}
+
+	__time_epoc_reference_uS = now - (uint32_t)ms*1000;
+	__time_epoc_atreference_S = epoc_s;
+}
+
+/**
+ * Get the measured local clock drift in ppb (part per billion)
+ * > 0 when the local clock is too fast, 0 when not yet measured
+ */
+int32_t itsdk_time_get_drift_ppb() {
+	return __time_drift_ppb;
+}
+
 /**
  * Get the current EPOC time
  * Return the time in S when utc reference have been set 0 otherwise
  */
 uint32_t itsdk_time_get_EPOC_s(){
 	if ( __time_epoc_atreference_S == 0 ) return 0;
-	uint64_t t = (itsdk_time_get_us() - __time_epoc_reference_uS) / 1000000;
+	uint64_t t = __itsdk_time_elapsed_s(__time_epoc_reference_uS,itsdk_time_get_us());
 	return __time_epoc_atreference_S + t;
 }
 
@@ -196,13 +259,37 @@ uint32_t itsdk_time_get_EPOC_s(){
  */
 itsdk_bool_e itsdk_time_is_EPOC_s(uint32_t * destTime) {
 	if ( destTime != NULL ) {
-		uint64_t t = (itsdk_time_get_us() - __time_epoc_reference_uS) / 1000000;
+		uint64_t t = __itsdk_time_elapsed_s(__time_epoc_reference_uS,itsdk_time_get_us());
 		*destTime = (uint32_t)(__time_epoc_atreference_S + t);
 	}
 	if ( __time_epoc_atreference_S == 0 ) return BOOL_FALSE;
 	return BOOL_TRUE;
 }
 
+/**
+ * Get the EPOC time of a local timestamp (itsdk_time_get_ms) taken before or after
+ * the last sync, buffered data can be timestamped once the time is known.
+ * Return 0 when the EPOC reference has not been set
+ */
+uint32_t itsdk_time_get_EPOC_at_ms(uint64_t local_ms) {
+	if ( __time_epoc_atreference_S == 0 ) return 0;
+	uint64_t t = local_ms*1000;
+	if ( t >= __time_epoc_reference_uS ) {
+		return __time_epoc_atreference_S + __itsdk_time_elapsed_s(__time_epoc_reference_uS,t);
+	}
+	uint64_t d = __itsdk_time_elapsed_s(t,__time_epoc_reference_uS);
+	if ( d >= __time_epoc_atreference_S ) return 0;
+	return __time_epoc_atreference_S - d;
+}
+
+
+/**
+ * Convert a GPS time (S since 06/01/1980 00:00:00 UTC) into EPOC time.
+ * The GPS time has no leap second, UTC is ITSDK_GPS_LEAP_SECONDS behind.
+ */
+uint32_t itsdk_time_gps2Epoc_s(uint32_t gps_s) {
+	return gps_s + __TIME_GPS_EPOC_OFFSET_S - ITSDK_GPS_LEAP_SECONDS;
+}
 
 
 /**
@@ -27,23 +27,18 @@
 #include <it_sdk/itsdk.h>
 #include <it_sdk/wrappers.h>
 #include <it_sdk/time/time.h>
+#include <it_sdk/random/random.h>
 #include <stdbool.h>
 
 // =======================================================================================
 // Random stuff
 // =======================================================================================
 
+/**
+ * Return a random byte from the random service (see random.c)
+ */
 uint8_t itsdk_randomByte(void) {
-	// Von Neumann algorithm
-	uint8_t v = 0;
-	for ( int i = 0 ; i < 8 ; i++ ) {
-		uint8_t a;
-		do {
-			a = itsdk_randomBit() | (itsdk_randomBit() << 1);
-		} while ( a == 0 || a==3 );
-		v = (v << 1) + (a >> 1);
-	}
-	return v;
+	return itsdk_random_getU32() & 0xFF;
 }
 
 
@@ -133,31 +128,62 @@ uint32_t itsdk_pgcd(uint32_t a, uint32_t b) {
 // Converters
 // =======================================================================================
 
+static const char __itdt_hexUpper[16] = {
+	'0','1','2','3','4','5','6','7','8','9','A','B','C','D','E','F'
+};
+static const char __itdt_hexLower[16] = {
+	'0','1','2','3','4','5','6','7','8','9','a','b','c','d','e','f'
+};
+
+/* -----------------------------------------------------------
+ * Char to hex value table
+ * 0x00-0x0F : '0'-'9' / 'A'-'F' value
+ * 0x1A-0x1F : 'a'-'f' value with the lower case flag
+ * 0xFF      : not an hex char
+ */
+#define __ITDT_HEX_INVALID	0xFF
+#define __ITDT_HEX_LOWER	0x10
+static const uint8_t __itdt_hexValue[256] = {
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,	// 0x00
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,	// 0x10
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,	// 0x20
+	0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,	// 0x30
+	0xFF, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,	// 0x40
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,	// 0x50
+	0xFF, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,	// 0x60
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,	// 0x70
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,	// 0x80
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,	// 0x90
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,	// 0xA0
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,	// 0xB0
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,	// 0xC0
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,	// 0xD0
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,	// 0xE0
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF	// 0xF0
+};
+
 /* -----------------------------------------------------------
  * Convert a 0-16 value to a upper/lower Char
  */
 char itdt_convertHalfInt2HexChar(uint8_t v,itsdk_bool_e upper) {
-  if ( v >= 0 && v <= 9 ) return '0'+v;
-  if ( v >= 10 && v <= 15 ) return (upper==BOOL_TRUE)?'A'+(v-10):'a'+(v+10);
-  return 0;
+  if ( v > 15 ) return 0;
+  return (upper==BOOL_TRUE)?__itdt_hexUpper[v]:__itdt_hexLower[v];
 }
 
 /* -----------------------------------------------------------
  * Convert 0-9 char to 0-9 value
  */
 uint8_t itdt_convertNumChar2Int(char c) {
-	  if ( c >= '0' && c <= '9' ) return c-'0';
-	  return 0xFF;
+	  uint8_t v = (uint8_t)(c - '0');
+	  return ( v < 10 )?v:0xFF;
 }
 
 /* -----------------------------------------------------------
  * Convert a 0-F char to a 0-16 value
  */
 uint8_t itdt_convertHexChar2HalfInt(char c) {
-  if ( c >= '0' && c <= '9' ) return c-'0';
-  if ( c >= 'a' && c <= 'f' ) return 10+c-'a';
-  if ( c >= 'A' && c <= 'F' ) return 10+c-'A';
-  return 0;
+  uint8_t v = __itdt_hexValue[(uint8_t)c];
+  return ( v == __ITDT_HEX_INVALID )?0:(v & 0x0F);
 }
 
 
@@ -165,32 +191,26 @@ uint8_t itdt_convertHexChar2HalfInt(char c) {
  * Convert a 0-256 value to a 2 byte upper/lower case string
  */
 void itdt_convertInt2HexChar(uint8_t v, char * dest, itsdk_bool_e upper) {
-  uint8_t q0 = (v & 0xF0) >> 4;
-  uint8_t q1 = (v & 0x0F);
-  dest[0] = itdt_convertHalfInt2HexChar(q0,upper);
-  dest[1] = itdt_convertHalfInt2HexChar(q1,upper);
+  const char * t = (upper==BOOL_TRUE)?__itdt_hexUpper:__itdt_hexLower;
+  dest[0] = t[v >> 4];
+  dest[1] = t[v & 0x0F];
 }
 
 /* -----------------------------------------------------------
  * Convert a "0"-"FF" value to 0-255 uint8_t value
  */
 uint8_t itdt_convertHexChar2Int(char * v) {
-  uint8_t q0 = itdt_convertHexChar2HalfInt(v[0]);
-  uint8_t q1 = itdt_convertHexChar2HalfInt(v[1]);
-  return (q0*16)+q1;
+  return (itdt_convertHexChar2HalfInt(v[0]) << 4) | itdt_convertHexChar2HalfInt(v[1]);
 }
 
 /* -----------------------------------------------------------
  *  Convert a 32bit hex string value into uint32_t value
  */
 uint32_t itdt_convertHexChar8Int(char * v) {
-  uint32_t ret = itdt_convertHexChar2Int(&v[0]);
-  ret <<= 8;
-  ret += itdt_convertHexChar2Int(&v[2]);
-  ret <<= 8;
-  ret += itdt_convertHexChar2Int(&v[4]);
-  ret <<= 8;
-  ret += itdt_convertHexChar2Int(&v[6]);
+  uint32_t ret = 0;
+  for ( int i = 0 ; i < 8 ; i++ ) {
+	  ret = (ret << 4) | itdt_convertHexChar2HalfInt(v[i]);
+  }
   return ret;
 }
 
@@ -198,9 +218,10 @@ uint32_t itdt_convertHexChar8Int(char * v) {
  *  Convert a 16bit hex string value into uint16_t value
  */
 uint16_t itdt_convertHexChar4Int(char * v) {
-  uint16_t ret = itdt_convertHexChar2Int(&v[0]);
-  ret <<= 8;
-  ret += itdt_convertHexChar2Int(&v[2]);
+  uint16_t ret = 0;
+  for ( int i = 0 ; i < 4 ; i++ ) {
+	  ret = (ret << 4) | itdt_convertHexChar2HalfInt(v[i]);
+  }
   return ret;
 }
 
@@ -230,76 +251,81 @@ uint16_t itdt_convertDecChar3UInt(char * v) {
  * an Int32 value.
  */
 int32_t itdt_convertDecCharNInt(char * v, int sz) {
-	int sign = 1;
+	int32_t sign = 1;
 	if ( *v == '-' ) {
 	   sign = -1;
 	   v++;
 	   sz--;
 	}
-	uint16_t ret = 0;
+	int32_t ret = 0;
 	for ( int i = 0 ; i < sz ; i++ ) {
-	  ret *= 10;
-	  uint8_t c = itdt_convertNumChar2Int(*v);
-	  if ( c == 0xFF ) return ITSDK_INVALID_VALUE_32B;
-	  v++;
-	  ret+= c;
+	  uint8_t c = (uint8_t)(v[i] - '0');
+	  if ( c > 9 ) return ITSDK_INVALID_VALUE_32B;
+	  ret = ret*10 + c;
 	 }
-	 ret *= sign;
-	 return ret;
+	 return ret * sign;
 }
 
 /* -----------------------------------------------------------
  * Convert a 8bytes table to Upper Hex upper/lower string
  */
 void itdt_convertIntTab2Hex(char * dest, uint8_t * tab, int len, itsdk_bool_e upper) {
-  int i;
-  for ( i = 0; i < len ; i++ ) {
-	  itdt_convertInt2HexChar(tab[i],&dest[2*i],upper);
+  const char * t = (upper==BOOL_TRUE)?__itdt_hexUpper:__itdt_hexLower;
+  for ( int i = 0; i < len ; i++ ) {
+	  uint8_t v = tab[i];
+	  *dest++ = t[v >> 4];
+	  *dest++ = t[v & 0x0F];
   }
-  dest[2*len]='\0';
+  *dest='\0';
 }
 
 /* ----------------------------------------------------------
  * Convert a Char String to a hex value tab entries
  */
 void itdt_convertHexStr2IntTab(char * hexstr,uint8_t * tab, int len) {
-
-  int i;
-  for ( i = 0; i < len ; i++ ) {
-    tab[i] = itdt_convertHexChar2Int(&hexstr[2*i]);
+  for ( int i = 0; i < len ; i++ ) {
+    tab[i] = (itdt_convertHexChar2HalfInt(hexstr[0]) << 4) | itdt_convertHexChar2HalfInt(hexstr[1]);
+    hexstr+=2;
   }
+}
 
+/* ----------------------------------------------------------
+ * Verify and convert a Char String to a hex value tab entries
+ * in a single pass. The string must contain at least 2*len
+ * hex chars (upper case only when upper is true).
+ * Return false when the string is too short or contains
+ * invalid chars, in this case the tab content is undefined.
+ */
+bool itdt_convertHexStr2IntTabChk(char * hexstr,uint8_t * tab, int len, itsdk_bool_e upper) {
+  uint8_t reject = (upper==BOOL_TRUE)?(__ITDT_HEX_INVALID & ~0x0F):(__ITDT_HEX_INVALID & ~0x1F);
+  for ( int i = 0; i < len ; i++ ) {
+	uint8_t h = __itdt_hexValue[(uint8_t)hexstr[0]];
+	uint8_t l = __itdt_hexValue[(uint8_t)hexstr[1]];
+	if ( ((h | l) & reject) != 0 ) return false;
+    tab[i] = ((h & 0x0F) << 4) | (l & 0x0F);
+    hexstr+=2;
+  }
+  return true;
 }
 
 /* ----------------------------------------------------------
  * Verify a char is an Hex Char
  */
 bool itdt_isHexChar(char c, bool upper) {
-  if (    (c >= '0' && c <= '9' )
-       || (c >= 'A' && c <= 'F' )
-     || (!upper   && c >= 'a' && c <= 'f')
-    ) {
-    return true;
-  }
-  return false;
+  uint8_t v = __itdt_hexValue[(uint8_t)c];
+  if ( v == __ITDT_HEX_INVALID ) return false;
+  return ( !upper || (v & __ITDT_HEX_LOWER) == 0 );
 }
 
 /* ----------------------------------------------------------
  * Verify a string is a valid Hex string with given size
  */
 bool itdt_isHexString(char * str,int n,itsdk_bool_e upper) {
-  int i = 0;
-  while ( i < n && str[i] != 0 ) {
-    if (    (str[i] >= '0' && str[i] <= '9' )
-       || (str[i] >= 'A' && str[i] <= 'F' )
-       || (!upper && str[i] >= 'a' && str[i] <= 'f')
-       ) {
-      i++;
-    } else {
-      return false;
-    }
+  uint8_t reject = (upper==BOOL_TRUE)?(__ITDT_HEX_INVALID & ~0x0F):(__ITDT_HEX_INVALID & ~0x1F);
+  for ( int i = 0 ; i < n ; i++ ) {
+	if ( (__itdt_hexValue[(uint8_t)str[i]] & reject) != 0 ) return false;
   }
-  return ( i == n )?true:false;
+  return true;
 }
 
 /* ----------------------------------------------------
@@ -63,6 +63,33 @@ void itsdk_delayMs(uint32_t ms) {
 	HAL_Delay(ms);
 }
 
+/**
+ * Active delay in us for short hardware setup times
+ * The loop takes 4 cycles or more per iteration so the delay is a minimum
+ */
+void itsdk_delayUs(uint32_t us) {
+	volatile uint32_t loops = ((SystemCoreClock / 1000000) * us) / 4 + 1;
+	while ( loops > 0 ) loops--;
+}
+
+/**
+ * Delay in ms with the core in sleep mode between the interrupts.
+ * The clocks, DMA and peripherals are running, the SysTick wakes the core every ms.
+ */
+void itsdk_sleepMs(uint32_t ms) {
+	uint32_t start = HAL_GetTick();
+	while ( (HAL_GetTick() - start) < ms ) {
+		__WFI();
+	}
+}
+
+/**
+ * Core in sleep mode until the next interrupt (SysTick at least)
+ */
+void itsdk_waitForInterrupt() {
+	__WFI();
+}
+
 /**
  * Get the IRQ Mask
  */
@@ -28,6 +28,12 @@
 #if ITSDK_WITH_SPI == __SPI_ENABLED
 #include <stm32l_sdk/spi/spi.h>
 #include <it_sdk/wrappers.h>
+#include <string.h>
+
+static uint32_t __spi_transactions = 0;		// number of HAL transactions
+static uint32_t __spi_bytes = 0;			// number of bytes exchanged
+
+#define __SPI_COUNT(sz)		{ __spi_transactions++; __spi_bytes += (sz); }
 
 /**
  * Read the given SPI
@@ -38,6 +44,7 @@ _SPI_Status spi_rwRegister(
 		uint8_t * toReceive,
 		uint8_t   sizeToTransmit
 ) {
+	__SPI_COUNT(sizeToTransmit);
 	return (_SPI_Status)HAL_SPI_TransmitReceive(
 				spi,
 				toTransmit,
@@ -55,6 +62,7 @@ _SPI_Status spi_readRegister(
 		uint8_t   sizeToTransmit
 ) {
 
+	__SPI_COUNT(sizeToTransmit);
 	return (_SPI_Status)HAL_SPI_TransmitReceive(
 			spi,
 			toTransmit,
@@ -70,9 +78,53 @@ _SPI_Status spi_write_byte(
 		uint8_t Value
 ) {
   spi_wait4TransactionEnd(spi);
+  __SPI_COUNT(1);
   return (_SPI_Status)HAL_SPI_Transmit(spi, (uint8_t*) &Value, 1, ITSDK_SPI_TIMEOUT);
 }
 
+/**
+ * Burst write in a single transaction, the received bytes are ignored
+ */
+_SPI_Status spi_transmit(
+		SPI_HandleTypeDef * spi,
+		uint8_t	* toTransmit,
+		uint16_t  size
+) {
+	__SPI_COUNT(size);
+	return (_SPI_Status)HAL_SPI_Transmit(spi, toTransmit, size, ITSDK_SPI_TIMEOUT);
+}
+
+/**
+ * Burst read in a single transaction, 0x00 is transmitted
+ */
+_SPI_Status spi_receive(
+		SPI_HandleTypeDef * spi,
+		uint8_t	* toReceive,
+		uint16_t  size
+) {
+	// in full duplex the HAL transmits the receive buffer content
+	bzero(toReceive,size);
+	__SPI_COUNT(size);
+	return (_SPI_Status)HAL_SPI_Receive(spi, toReceive, size, ITSDK_SPI_TIMEOUT);
+}
+
+/**
+ * Number of transactions and bytes since the last reset, to measure the
+ * SPI cost of a driver
+ */
+void spi_getStats(
+		uint32_t * transactions,
+		uint32_t * bytes
+) {
+	*transactions = __spi_transactions;
+	*bytes = __spi_bytes;
+}
+
+void spi_resetStats() {
+	__spi_transactions = 0;
+	__spi_bytes = 0;
+}
+
 void spi_wait4TransactionEnd(
 		SPI_HandleTypeDef * spi
 ) {
@@ -128,6 +180,7 @@ _SPI_Status spi_transmit_dma_start(
 	  if (__spi_dma_tranfertHalfCompleteCB != NULL ) {
 		  __HAL_DMA_ENABLE_IT(hdma, DMA_IT_HT);
 	  }
+	  __SPI_COUNT(size);
 	  if ( HAL_SPI_Transmit_DMA(spi, pData, size) == HAL_OK ) {
 	     return __SPI_OK;
 	  } else {
@@ -31,6 +31,7 @@
 #if ITSDK_PLATFORM == __PLATFORM_STM32L0
 #include <it_sdk/logger/logger.h>
 #include <it_sdk/wrappers.h>
+#include <it_sdk/ring/ring.h>
 #include "stm32l0xx_hal.h"
 #include "usart.h"
 
@@ -43,14 +44,12 @@
 // ---------------------------------------------------------------------------
 
 #if ( ITSDK_WITH_UART_RXIRQ & __UART_USART1 ) > 0 || ( ITSDK_WITH_UART_RXIRQ & __UART_LPUART1 ) > 0
-uint8_t __serial1_buffer[ITSDK_WITH_UART_RXIRQ_BUFSZ];
-volatile uint8_t __serial1_bufferRd = 0;
-volatile uint8_t __serial1_bufferWr = 0;
+ITSDK_RING_DECLARE(__serial1_ring,uint8_t,ITSDK_WITH_UART_RXIRQ_BUFSZ);
+uint8_t __serial1_rxByte;						// HAL reception target, pushed to the ring in the Rx callback
 #endif
 #if ( ITSDK_WITH_UART_RXIRQ & __UART_USART2 ) > 0
-uint8_t __serial2_buffer[ITSDK_WITH_UART_RXIRQ_BUFSZ];
-volatile uint8_t __serial2_bufferRd;
-volatile uint8_t __serial2_bufferWr;
+ITSDK_RING_DECLARE(__serial2_ring,uint8_t,ITSDK_WITH_UART_RXIRQ_BUFSZ);
+uint8_t __serial2_rxByte;						// HAL reception target, pushed to the ring in the Rx callback
 #endif
 
 /**
@@ -59,8 +58,7 @@ volatile uint8_t __serial2_bufferWr;
 void serial1_init() {
 #if ( ITSDK_WITH_UART_RXIRQ & __UART_USART1 ) > 0 || ( ITSDK_WITH_UART_RXIRQ & __UART_LPUART1 ) > 0
     // Reset circular buffer
-    __serial1_bufferRd = 0;
-    __serial1_bufferWr = 0;
+    itsdk_ring_init(&__serial1_ring);
 	#if ( ITSDK_WITH_UART_RXIRQ & __UART_LPUART1 ) > 0
 		UART_HandleTypeDef * _uart = &hlpuart1;
 	#elif  ( ITSDK_WITH_UART_RXIRQ & __UART_USART1 ) > 0
@@ -71,7 +69,7 @@ void serial1_init() {
     __HAL_UART_DISABLE_IT(_uart,UART_IT_TC);
     __HAL_UART_DISABLE_IT(_uart,UART_IT_TXE);
     // Clear pending interrupt & co
-    HAL_UART_Receive_IT(_uart, __serial1_buffer, 1);
+    HAL_UART_Receive_IT(_uart, &__serial1_rxByte, 1);
     _uart->Instance->RDR;
     _uart->Instance->ISR;
     _uart->Instance->ICR;
@@ -151,13 +149,9 @@ serial_read_response_e serial1_read(char * ch) {
 
 #if ( ITSDK_WITH_UART_RXIRQ & __UART_USART1 ) > 0 || ( ITSDK_WITH_UART_RXIRQ & __UART_LPUART1 ) > 0
 
-	if ( __serial1_bufferRd != __serial1_bufferWr ) {
+	if ( itsdk_ring_pop(&__serial1_ring,(uint8_t *)ch,1) > 0 ) {
 		// char available
-		*ch = __serial1_buffer[__serial1_bufferRd];
-		itsdk_enterCriticalSection();
-		__serial1_bufferRd = (__serial1_bufferRd + 1) & (ITSDK_WITH_UART_RXIRQ_BUFSZ-1);
-		itsdk_leaveCriticalSection();
-		if ( __serial1_bufferRd != __serial1_bufferWr ) {
+		if ( itsdk_ring_count(&__serial1_ring) > 0 ) {
 			return SERIAL_READ_PENDING_CHAR;
 		} else {
 			return SERIAL_READ_SUCCESS;
@@ -246,6 +240,18 @@ itsdk_bool_e serial1_changeBaudRate(serial_baudrate_e bd) {
 	return BOOL_TRUE;
 }
 
+/**
+ * Get the RX ring buffer max usage and the number of char dropped
+ */
+void serial1_getRxStats(uint16_t * highWater, uint32_t * overflow) {
+#if ( ITSDK_WITH_UART_RXIRQ & __UART_USART1 ) > 0 || ( ITSDK_WITH_UART_RXIRQ & __UART_LPUART1 ) > 0
+	itsdk_ring_getStats(&__serial1_ring,highWater,overflow);
+#else
+	*highWater = 0;
+	*overflow = 0;
+#endif
+}
+
 // ---------------------------------------------------------------------------
 // serial 2 - is mapped to USART2
 // ---------------------------------------------------------------------------
@@ -255,13 +261,12 @@ itsdk_bool_e serial1_changeBaudRate(serial_baudrate_e bd) {
  */
 void serial2_init() {
 #if  ( ITSDK_WITH_UART_RXIRQ & __UART_USART2 ) > 0
-    __serial2_bufferRd = 0;
-    __serial2_bufferWr = 0;
+    itsdk_ring_init(&__serial2_ring);
     __HAL_UART_ENABLE_IT(&huart2,UART_IT_ERR);
     __HAL_UART_ENABLE_IT(&huart2,UART_IT_RXNE);
     __HAL_UART_DISABLE_IT(&huart2,UART_IT_TC);
     __HAL_UART_DISABLE_IT(&huart2,UART_IT_TXE);
-    HAL_UART_Receive_IT(&huart2, __serial2_buffer, 1);
+    HAL_UART_Receive_IT(&huart2, &__serial2_rxByte, 1);
     huart2.Instance->RDR;
     huart2.Instance->ISR;
     huart2.Instance->ICR;
@@ -317,13 +322,9 @@ serial_read_response_e serial2_read(char * ch) {
 
 #if  ( ITSDK_WITH_UART_RXIRQ & __UART_USART2 ) > 0
 
-	if ( __serial2_bufferRd != __serial2_bufferWr ) {
+	if ( itsdk_ring_pop(&__serial2_ring,(uint8_t *)ch,1) > 0 ) {
 		// char available
-		*ch = __serial2_buffer[__serial2_bufferRd];
-		itsdk_enterCriticalSection();
-		__serial2_bufferRd = (__serial2_bufferRd + 1) & (ITSDK_WITH_UART_RXIRQ_BUFSZ-1);
-		itsdk_leaveCriticalSection();
-		if ( __serial2_bufferRd != __serial2_bufferWr ) {
+		if ( itsdk_ring_count(&__serial2_ring) > 0 ) {
 			return SERIAL_READ_PENDING_CHAR;
 		} else {
 			return SERIAL_READ_SUCCESS;
@@ -389,6 +390,18 @@ itsdk_bool_e serial2_changeBaudRate(serial_baudrate_e bd) {
 	return BOOL_TRUE;
 }
 
+/**
+ * Get the RX ring buffer max usage and the number of char dropped
+ */
+void serial2_getRxStats(uint16_t * highWater, uint32_t * overflow) {
+#if  ( ITSDK_WITH_UART_RXIRQ & __UART_USART2 ) > 0
+	itsdk_ring_getStats(&__serial2_ring,highWater,overflow);
+#else
+	*highWater = 0;
+	*overflow = 0;
+#endif
+}
+
 
 // ---------------------------------------------------------------------------
 // Global interrupt management
@@ -424,22 +437,17 @@ void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart) {
 			#endif
 		) {
 			#if ( ITSDK_WITH_UART_RXIRQ & __UART_LPUART1 ) > 0 || ( ITSDK_WITH_UART_RXIRQ & __UART_USART1 ) > 0
-			// at this point the data is in __serial1_buffer[__serial1_bufferWr]
-			// only increment the pointer when we have an available space in the circular buffer
-			if ( ((__serial1_bufferWr+1) & (ITSDK_WITH_UART_RXIRQ_BUFSZ-1)) != __serial1_bufferRd  ) {
-				__serial1_bufferWr = ((__serial1_bufferWr+1) & (ITSDK_WITH_UART_RXIRQ_BUFSZ-1));
-			}
-			HAL_UART_Receive_IT(huart, &__serial1_buffer[__serial1_bufferWr], 1);
+			// at this point the data is in __serial1_rxByte, dropped and counted when the ring is full
+			itsdk_ring_push(&__serial1_ring,&__serial1_rxByte,1);
+			HAL_UART_Receive_IT(huart, &__serial1_rxByte, 1);
 			#endif
 		} else {
 			#if ( ITSDK_WITH_UART & __UART_USART2 ) > 0
 			if ( huart->Instance == USART2 ) {
 				#if ( ITSDK_WITH_UART_RXIRQ & __UART_USART2 ) > 0
-				// at this point the data is in __serial2_buffer[__serial2_bufferWr]
-				if ( ((__serial2_bufferWr+1) & (ITSDK_WITH_UART_RXIRQ_BUFSZ-1)) != __serial2_bufferRd  ) {
-					__serial2_bufferWr = ((__serial2_bufferWr+1) & (ITSDK_WITH_UART_RXIRQ_BUFSZ-1));
-				}
-				HAL_UART_Receive_IT(huart, &__serial2_buffer[__serial2_bufferWr], 1);
+				// at this point the data is in __serial2_rxByte
+				itsdk_ring_push(&__serial2_ring,&__serial2_rxByte,1);
+				HAL_UART_Receive_IT(huart, &__serial2_rxByte, 1);
 				#endif
 			}
 			#endif
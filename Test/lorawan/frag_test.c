@@ -0,0 +1,259 @@
+/* ==========================================================
+ * frag_test.c - Host test of the LoRaWan fragmentation decoder
+ * Project : Disk91 SDK
+ * ----------------------------------------------------------
+ * Created on: 18 oct. 2020
+ *     Author: Paul Pinault aka Disk91
+ * ----------------------------------------------------------
+ * Copyright (C) 2020 Disk91
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU LESSER General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ * ----------------------------------------------------------
+ * Runs fragmentation.c against an independent TS004 encoder
+ * with random and burst losses. The EEPROM stub behaves like
+ * the STM32L0 driver (32b aligned offsets, last word padded)
+ * so unaligned fragment sizes are covered. Reports the number
+ * of downlinks needed compared to the retransmission schemes.
+ *
+ * Build & run from the repository root:
+ *   gcc -O2 -ITest/lorawan/inc -IInc Test/lorawan/frag_test.c Src/it_sdk/lorawan/fragmentation.c -o frag_test
+ *   ./frag_test
+ *
+ * ==========================================================
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <it_sdk/config.h>
+#include <it_sdk/lorawan/lorawan.h>
+#include <it_sdk/lorawan/fragmentation.h>
+
+int test_errors = 0;
+
+// ---------------------------------------------------------------
+// Stubs
+
+static uint8_t __eeprom[8192];
+static int __unaligned = 0;
+
+uint32_t itdt_align_32b(uint32_t v) {
+	return (v + 3) & ~3u;
+}
+
+bool _eeprom_write(uint8_t bank, uint32_t offset, void * data, int len) {
+	(void)bank;
+	if ( (offset & 3) != 0 ) { __unaligned++; return false; }
+	for ( int i = 0 ; i < len ; i += 4 ) {
+		for ( int j = 0 ; j < 4 ; j++ ) {
+			__eeprom[offset+i+j] = ( i+j < len )?((uint8_t *)data)[i+j]:0;
+		}
+	}
+	return true;
+}
+
+bool _eeprom_read(uint8_t bank, uint32_t offset, void * data, int len) {
+	(void)bank;
+	if ( (offset & 3) != 0 ) { __unaligned++; return false; }
+	memcpy(data,&__eeprom[offset],len);
+	return true;
+}
+
+itsdk_lorawan_return_t itsdk_lorawan_getNvmOffset(uint32_t * offset) {
+	*offset = 0;
+	return LORAWAN_RETURN_SUCESS;
+}
+
+static uint8_t __ans[32];
+static int __ansSz;
+itsdk_lorawan_send_t itsdk_lorawan_send_queue(uint8_t * payload, uint8_t size, uint8_t port, uint8_t dr,
+		itsdk_lorawan_sendconf_t conf, uint8_t retry, uint8_t priority, uint32_t expireMs, bool coalesce,
+		void (*cb)(itsdk_lorawan_send_t, uint8_t, uint8_t, uint8_t *), itdsk_payload_encrypt_t encrypt) {
+	(void)port; (void)dr; (void)conf; (void)retry; (void)priority;
+	(void)expireMs; (void)coalesce; (void)cb; (void)encrypt;
+	memcpy(__ans,payload,size);
+	__ansSz = size;
+	return 0;
+}
+
+static int __completed;
+void itsdk_lorawan_frag_onComplete(uint32_t descriptor, uint32_t size) {
+	(void)descriptor; (void)size;
+	__completed = 1;
+}
+
+// ---------------------------------------------------------------
+// Independent encoder, TS004 parity matrix
+
+static uint32_t prbs23(uint32_t x) {
+	return (x >> 1) + ((((x & 1) ^ ((x >> 5) & 1))) << 22);
+}
+
+static void parityLine(int n, int m, uint8_t * l) {
+	int mt = ( (m & (m-1)) == 0 );
+	uint32_t x = 1 + 1001 * n;
+	memset(l,0,m);
+	for ( int k = 0 ; k < m/2 ; k++ ) {
+		uint32_t r = 1 << 16;
+		while ( r >= (uint32_t)m ) {
+			x = prbs23(x);
+			r = x % (m + mt);
+		}
+		l[r] = 1;
+	}
+}
+
+// ---------------------------------------------------------------
+// Loss model, p loss rate and b mean burst length (Gilbert-Elliott)
+
+static int __lossState;
+static double urand() {
+	return rand() / (RAND_MAX + 1.0);
+}
+
+static int isLost(double p, double b) {
+	if ( b <= 1 ) return urand() < p;
+	double bad2Good = 1.0 / b;
+	double good2Bad = p * bad2Good / (1 - p);
+	if ( __lossState ) {
+		if ( urand() < bad2Good ) __lossState = 0;
+	} else {
+		if ( urand() < good2Bad ) __lossState = 1;
+	}
+	return __lossState;
+}
+
+// ---------------------------------------------------------------
+
+#define PADDING	5
+
+/**
+ * Send one block of m fragments of sz bytes through the package with losses.
+ * Return the number of downlinks, 0 when the block has not been recovered,
+ * -1 when the reassembled block is wrong.
+ */
+static int runBlock(int m, int sz, double p, double b) {
+	static uint8_t blk[128*50], out[128*50];
+	uint8_t frag[50+3];
+	uint8_t l[128];
+
+	for ( int i = 0 ; i < m*sz ; i++ ) blk[i] = rand();
+	__lossState = 0;
+	uint8_t setup[11] = { ITSDK_LORAWAN_FRAG_SESSION_SETUP, 0x00, m & 0xFF, m >> 8, sz, 0x00, PADDING, 0x44, 0x33, 0x22, 0x11 };
+	itsdk_lorawan_frag_onDownlink(setup,11);
+	if ( __ansSz != 2 || __ans[1] != 0 ) return -1;
+
+	__completed = 0;
+	int n = 0;
+	while ( !__completed && n < 4*m ) {
+		n++;
+		frag[0] = ITSDK_LORAWAN_FRAG_DATA_FRAGMENT;
+		frag[1] = n & 0xFF;
+		frag[2] = (n >> 8) & 0x3F;
+		if ( n <= m ) {
+			memcpy(&frag[3],&blk[(n-1)*sz],sz);
+		} else {
+			parityLine(n-m,m,l);
+			memset(&frag[3],0,sz);
+			for ( int i = 0 ; i < m ; i++ ) {
+				if ( !l[i] ) continue;
+				for ( int k = 0 ; k < sz ; k++ ) frag[3+k] ^= blk[i*sz+k];
+			}
+		}
+		if ( !isLost(p,b) ) itsdk_lorawan_frag_onDownlink(frag,3+sz);
+		itsdk_lorawan_frag_status_t st;
+		itsdk_lorawan_frag_getStatus(&st);
+		if ( st.state == LORAWAN_FRAG_TOOMANYLOST ) return 0;
+		if ( st.state == LORAWAN_FRAG_STORAGE_ERROR ) return -1;
+	}
+	if ( !__completed ) return 0;
+	if ( !itsdk_lorawan_frag_read(0,out,m*sz-PADDING) || memcmp(out,blk,m*sz-PADDING) != 0 ) return -1;
+	return n;
+}
+
+int main(void) {
+	int failed = 0;
+	srand(1234);
+
+	// Correctness, aligned and unaligned fragment sizes
+	int sizes[] = { 32, 23, 50, 1 };
+	for ( int s = 0 ; s < 4 ; s++ ) {
+		int bad = 0;
+		for ( int r = 0 ; r < 200 ; r++ ) {
+			if ( runBlock(64,sizes[s],0.10,1) < 0 ) bad++;
+		}
+		printf("fragSize %2d : %d corrupted blocks\n",sizes[s],bad);
+		failed += bad;
+	}
+
+	// Downlinks needed, FEC compared to the retransmission schemes
+	double ps[] = { 0.01, 0.05, 0.10, 0.20, 0.30 };
+	int m = 64, sz = 32, runs = 1000;
+	for ( int bi = 0 ; bi < 2 ; bi++ ) {
+		for ( int pi = 0 ; pi < 5 ; pi++ ) {
+			double p = ps[pi], b = ( bi == 0 )?1:4;
+			long dlFec = 0, dlRep = 0, dlArq = 0, rounds = 0;
+			int ok = 0;
+			for ( int r = 0 ; r < runs ; r++ ) {
+				int n = runBlock(m,sz,p,b);
+				if ( n < 0 ) failed++;
+				if ( n > 0 ) { ok++; dlFec += n; }
+
+				// The status answer only gives a count, the block is sent again until complete
+				int got[128] = { 0 }, rem = m;
+				__lossState = 0;
+				while ( rem > 0 ) {
+					for ( int i = 0 ; i < m && rem > 0 ; i++ ) {
+						dlRep++;
+						if ( !isLost(p,b) && !got[i] ) { got[i] = 1; rem--; }
+					}
+				}
+				// Ideal selective repeat, one status request per round
+				int missing = m;
+				__lossState = 0;
+				while ( missing > 0 ) {
+					int nm = 0;
+					for ( int i = 0 ; i < missing ; i++ ) {
+						dlArq++;
+						if ( isLost(p,b) ) nm++;
+					}
+					missing = nm;
+					dlArq++;
+					rounds++;
+				}
+			}
+			double fec = ( ok > 0 )?(double)dlFec/ok:0;
+			printf("loss %2.0f%% burst %.0f : FEC %.1f dl (%d/%d ok) | resend block %.1f dl | selective repeat %.1f dl, %.1f rounds\n",
+					p*100,b,fec,ok,runs,(double)dlRep/runs,(double)dlArq/runs,(double)rounds/runs);
+		}
+	}
+
+	// Package answers
+	uint8_t ver[] = { ITSDK_LORAWAN_FRAG_PKG_VERSION };
+	itsdk_lorawan_frag_onDownlink(ver,1);
+	if ( __ansSz != 3 || __ans[1] != ITSDK_LORAWAN_FRAG_PACKAGE_ID ) failed++;
+	uint8_t del[] = { ITSDK_LORAWAN_FRAG_SESSION_DELETE, 0x00 };
+	itsdk_lorawan_frag_onDownlink(del,2);
+	if ( __ans[1] != 0x00 ) failed++;
+	itsdk_lorawan_frag_onDownlink(del,2);
+	if ( __ans[1] != 0x04 ) failed++;
+
+	// TOOMANYLOST errors are expected at high loss
+	printf("errors reported %d, unaligned eeprom accesses %d\n",test_errors,__unaligned);
+	if ( failed > 0 || __unaligned > 0 ) {
+		printf("FAILED %d\n",failed);
+		return 1;
+	}
+	printf("PASSED\n");
+	return 0;
+}
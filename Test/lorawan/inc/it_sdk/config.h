@@ -0,0 +1,31 @@
+/* Host test configuration for the LoRaWan fragmentation decoder */
+#ifndef TEST_IT_SDK_CONFIG_H_
+#define TEST_IT_SDK_CONFIG_H_
+#include <stdint.h>
+#include <stdbool.h>
+#include <strings.h>
+
+#define __ENABLE						1
+#define __DISABLE						0
+#define __weak							__attribute__((weak))
+#define __LORAWAN_FRAG_NONE				0
+#define __LORAWAN_FRAG_LOCALEPROM		1
+#define __LORAWAN_FRAG_M95640			2
+#define __LORAWAN_NVM_NONE				0
+#define __LORAWAN_NVM_LOCALEPROM		1
+
+#define ITSDK_WITH_LORAWAN_LIB			__ENABLE
+#define ITSDK_LORAWAN_NVM_SOURCE		__LORAWAN_NVM_NONE
+#define ITSDK_LORAWAN_FRAG_STORAGE		__LORAWAN_FRAG_LOCALEPROM
+#define ITSDK_LORAWAN_UPLINK_QUEUE_SZ	4
+#define ITSDK_LORAWAN_UPLINK_QUEUE_MSGSZ 16
+#define ITSDK_LORAWAN_FRAG_PORT			201
+#define ITSDK_LORAWAN_FRAG_MAXSIZE		4096
+#define ITSDK_LORAWAN_FRAG_MAXFRAGS		128
+#define ITSDK_LORAWAN_FRAG_MAXFRAGSZ	50
+#define ITSDK_LORAWAN_FRAG_MAXLOST		40
+#define ITSDK_LORAWAN_DEFAULT_DR		1
+#define ITSDK_LORAWAN_MAX_DWNLNKSZ		64
+#define ITDT_EEPROM_BANK0				0
+
+#endif
@@ -0,0 +1,6 @@
+/* Host test stub, same behavior as the STM32L0 driver: 32b aligned offsets */
+#ifndef TEST_IT_SDK_EEPROM_H_
+#define TEST_IT_SDK_EEPROM_H_
+bool _eeprom_write(uint8_t bank, uint32_t offset, void * data, int len);
+bool _eeprom_read(uint8_t bank, uint32_t offset, void * data, int len);
+#endif
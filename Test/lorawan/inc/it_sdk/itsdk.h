@@ -0,0 +1,5 @@
+/* Host test stub */
+#ifndef TEST_IT_SDK_ITSDK_H_
+#define TEST_IT_SDK_ITSDK_H_
+uint32_t itdt_align_32b(uint32_t v);
+#endif
@@ -0,0 +1,6 @@
+/* Host test stub */
+#ifndef TEST_IT_SDK_LOGGER_H_
+#define TEST_IT_SDK_LOGGER_H_
+static inline void test_log(const char * fmt, ...) { (void)fmt; }
+#define LOG_INFO_LORAWANSTK(x)		test_log x
+#endif
@@ -0,0 +1,13 @@
+/* Host test stub, only what the fragmentation package uses */
+#ifndef TEST_IT_SDK_LORAWAN_H_
+#define TEST_IT_SDK_LORAWAN_H_
+typedef enum { LORAWAN_RETURN_SUCESS } itsdk_lorawan_return_t;
+typedef enum { LORAWAN_SEND_UNCONFIRMED } itsdk_lorawan_sendconf_t;
+typedef int itsdk_lorawan_send_t;
+typedef int itdsk_payload_encrypt_t;
+#define PAYLOAD_ENCRYPT_NONE	0
+itsdk_lorawan_return_t itsdk_lorawan_getNvmOffset(uint32_t * offset);
+itsdk_lorawan_send_t itsdk_lorawan_send_queue(uint8_t * payload, uint8_t size, uint8_t port, uint8_t dr,
+		itsdk_lorawan_sendconf_t conf, uint8_t retry, uint8_t priority, uint32_t expireMs, bool coalesce,
+		void (*cb)(itsdk_lorawan_send_t, uint8_t, uint8_t, uint8_t *), itdsk_payload_encrypt_t encrypt);
+#endif
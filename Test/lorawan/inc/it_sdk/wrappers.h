@@ -0,0 +1,4 @@
+/* Host test stub */
+#ifndef TEST_IT_SDK_WRAPPERS_H_
+#define TEST_IT_SDK_WRAPPERS_H_
+#endif
@@ -0,0 +1,14 @@
+/* Host harness configuration for the LoRaWan MAC */
+#ifndef TEST_IT_SDK_CONFIG_H_
+#define TEST_IT_SDK_CONFIG_H_
+#include <stdint.h>
+#include <stdbool.h>
+#include <it_sdk/config_defines.h>
+
+#define __weak							__attribute__((weak))
+
+#define ITSDK_WITH_LORAWAN_LIB			__ENABLE
+#define ITSDK_LORAWAN_REGION_ALLOWED	( __LORAWAN_REGION_EU868 | __LORAWAN_REGION_US915 | __LORAWAN_REGION_AS923 )
+#define ITSDK_LOGGER_MODULE				0
+
+#endif
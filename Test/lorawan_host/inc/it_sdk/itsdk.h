@@ -0,0 +1,5 @@
+/* Host harness stub */
+#ifndef TEST_IT_SDK_ITSDK_H_
+#define TEST_IT_SDK_ITSDK_H_
+#include <it_sdk/config.h>
+#endif
@@ -0,0 +1,9 @@
+/* Host harness stub, the errors are counted */
+#ifndef TEST_IT_SDK_ERROR_H_
+#define TEST_IT_SDK_ERROR_H_
+#define ITSDK_ERROR_LORAWAN_TIME_NOCALLBACK	0x104
+#define ITSDK_ERROR_LORAWAN_TIME_INITFLD	0x105
+#define ITSDK_ERROR_STIMER_ALREADY_SET		0x011
+extern int sim_errors;
+#define ITSDK_ERROR_REPORT(e,v)		(sim_errors++)
+#endif
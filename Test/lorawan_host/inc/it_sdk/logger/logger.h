@@ -0,0 +1,9 @@
+/* Host harness stub */
+#ifndef TEST_IT_SDK_LOGGER_H_
+#define TEST_IT_SDK_LOGGER_H_
+#include <stdio.h>
+#define log_info(...)
+#define log_warn(...)
+#define log_error(...)
+#define log_debug(...)
+#endif
@@ -0,0 +1,9 @@
+/* Host harness stub, reproducible random */
+#ifndef TEST_IT_SDK_RANDOM_H_
+#define TEST_IT_SDK_RANDOM_H_
+#include <stdint.h>
+void itsdk_random_addEntropy(uint32_t value, uint8_t bits);
+uint32_t itsdk_random_getU32();
+int32_t itsdk_random_getRange(int32_t min, int32_t max);
+void itsdk_random_getBytes(uint8_t * dest, uint16_t len);
+#endif
@@ -0,0 +1,6 @@
+/* Host harness stub, the virtual clock of the simulation */
+#ifndef TEST_IT_SDK_TIME_H_
+#define TEST_IT_SDK_TIME_H_
+#include <stdint.h>
+uint64_t itsdk_time_get_ms();
+#endif
@@ -0,0 +1,11 @@
+/* Host harness stub, the MAC runs in a single thread */
+#ifndef TEST_IT_SDK_WRAPPERS_H_
+#define TEST_IT_SDK_WRAPPERS_H_
+#define itsdk_getIrqMask()				0
+#define itsdk_setIrqMask(m)				((void)(m))
+#define itsdk_disableIrq()
+#define itsdk_enableIrq()
+#define itsdk_enterCriticalSection()
+#define itsdk_leaveCriticalSection()
+#define itsdk_delayMs(n)
+#endif
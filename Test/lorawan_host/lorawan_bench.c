@@ -0,0 +1,370 @@
+/* ==========================================================
+ * lorawan_bench.c - Host harness & benchmark of the LoRaWan MAC
+ * Project : Disk91 SDK
+ * ----------------------------------------------------------
+ * Created on: 18 oct. 2020
+ *     Author: Paul Pinault aka Disk91
+ * ----------------------------------------------------------
+ * Copyright (C) 2020 Disk91
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU LESSER General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ * ----------------------------------------------------------
+ * Runs the unmodified MAC, regions, crypto, timeServer and systime
+ * of the SDK against a simulated radio (sim_radio.c) and a network
+ * server stand-in (sim_ns.c) on a virtual clock. For each region,
+ * datarate and loss rate a set of devices join then send confirmed
+ * uplinks, the report gives:
+ *  - join success, latency and number of join requests
+ *  - uplinks delivered, acked and transmissions per uplink
+ *  - downlinks with MAC commands / application data received
+ *  - RX windows missed while a downlink was on air
+ *  - host CPU time spent in the MAC per radio frame
+ * A second table sweeps the TxDone IRQ latency to show the RX1
+ * window margin at each spreading factor, with the MAC timing the
+ * windows from the TxDone event then from the radio edge time.
+ *
+ * Build & run from the repository root:
+ *   gcc -O2 -DAES_DEC_PREKEYED -ITest/lorawan_host/inc -IInc \
+ *       Test/lorawan_host/lorawan_bench.c Test/lorawan_host/sim_radio.c Test/lorawan_host/sim_ns.c \
+ *       $(find Src/drivers/lorawan/mac Src/drivers/lorawan/crypto -name '*.c') \
+ *       Src/drivers/lorawan/utilities.c Src/drivers/lorawan/timeServer.c Src/drivers/lorawan/systime.c \
+ *       -lm -o lorawan_bench
+ *   ./lorawan_bench [sessions]
+ *
+ * The exit code is not 0 when the MAC fails with a perfect channel.
+ * ==========================================================
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <it_sdk/config.h>
+#include <drivers/lorawan/compiled_region.h>
+#include <drivers/lorawan/mac/LoRaMac.h>
+#include <drivers/lorawan/mac/LoRaMacTest.h>
+#include "sim.h"
+
+static uint8_t __devEui[8]  = { 0x00, 0x04, 0xA3, 0x0B, 0x00, 0x1E, 0x7A, 0x11 };
+static uint8_t __joinEui[8] = { 0x70, 0xB3, 0xD5, 0x7E, 0xD0, 0x00, 0x00, 0x01 };
+static uint8_t __appKey[16] = { 0x2B, 0x7E, 0x15, 0x16, 0x28, 0xAE, 0xD2, 0xA6, 0xAB, 0xF7, 0x15, 0x88, 0x09, 0xCF, 0x4F, 0x3C };
+
+#define BENCH_UPLINKS			20
+#define BENCH_UPLINK_PERIOD		60000
+#define BENCH_JOIN_TIMEOUT		3600000
+#define BENCH_APP_DL_EVERY		5
+#define BENCH_DEVSTATUS_EVERY	7
+
+// ---------------------------------------------------------------
+// MAC primitives
+
+static bool __notify;
+static bool __joinDone;
+static LoRaMacEventInfoStatus_t __joinStatus;
+static bool __txDone;
+static bool __ackReceived;
+static uint32_t __appRx;
+static uint32_t __appRxBad;
+static const bool __never = false;
+
+static void McpsConfirm(McpsConfirm_t * c) {
+	__txDone = true;
+	__ackReceived = c->AckReceived;
+}
+
+static void McpsIndication(McpsIndication_t * i) {
+	if ( i->Status != LORAMAC_EVENT_INFO_STATUS_OK || !i->RxData ) return;
+	if ( i->Port == 2 && i->BufferSize == 4 && i->Buffer[0] == 0xD0 && i->Buffer[1] == 0x0D ) {
+		__appRx++;
+	} else {
+		__appRxBad++;
+	}
+}
+
+static void MlmeConfirm(MlmeConfirm_t * c) {
+	if ( c->MlmeRequest == MLME_JOIN ) {
+		__joinDone = true;
+		__joinStatus = c->Status;
+	}
+}
+
+static void MlmeIndication(MlmeIndication_t * i) {
+}
+
+static uint8_t GetBatteryLevel(void) {
+	return 254;
+}
+
+static uint16_t GetTemperatureLevel(void) {
+	return 20;
+}
+
+static void NvmContextChange(LoRaMacNvmCtxModule_t module) {
+}
+
+static void MacProcessNotify(void) {
+	__notify = true;
+}
+
+static LoRaMacPrimitives_t __primitives = { McpsConfirm, McpsIndication, MlmeConfirm, MlmeIndication };
+static LoRaMacCallback_t __callbacks = { GetBatteryLevel, GetTemperatureLevel, NvmContextChange, MacProcessNotify };
+
+/**
+ * Run the simulation until the flag is set or for maxMs of virtual time
+ */
+static void run(const bool * done, uint32_t maxMs) {
+	uint32_t end = sim_now() + maxMs;
+	while ( !*done ) {
+		if ( __notify ) {
+			__notify = false;
+			sim_cpuEnter();
+			LoRaMacProcess();
+			sim_cpuLeave();
+			continue;
+		}
+		if ( !sim_step(end) ) break;
+	}
+}
+
+/**
+ * Wait for the duty cycle when the MAC refuses the request
+ */
+static bool waitDutyCycle(LoRaMacStatus_t s, int8_t dr) {
+	TimerTime_t delay;
+	if ( s == LORAMAC_STATUS_BUSY ) {
+		run(&__never,100);
+		return true;
+	}
+	if ( s != LORAMAC_STATUS_DUTYCYCLE_RESTRICTED ) return false;
+	if ( LoRaMacQueryNextTxDelay(dr,&delay) != LORAMAC_STATUS_OK ) delay = 1000;
+	run(&__never,delay+1);
+	return true;
+}
+
+// ---------------------------------------------------------------
+// Sessions
+
+typedef struct {
+	const char		* name;
+	LoRaMacRegion_t	region;
+	sim_ns_region_e	nsRegion;
+	int8_t			dr;
+	const char		* drName;
+} bench_cfg_t;
+
+typedef struct {
+	uint32_t	sessions;
+	uint32_t	joined;
+	double		joinMs;
+	uint32_t	joinReq;
+	uint32_t	uplinks;
+	uint32_t	acked;
+	uint32_t	txUplinks;			// transmissions for the uplinks, repetitions included
+	uint32_t	nsNew;
+	uint32_t	macCmds;
+	uint32_t	devStatusReq;
+	uint32_t	devStatusAns;
+	uint32_t	appSent;
+	uint32_t	appRx;
+	uint32_t	appRxBad;
+	uint32_t	rxMissed;
+	uint32_t	frames;				// radio frames sent and received by the device
+	uint32_t	badMic;
+	double		cpuUs;
+} bench_res_t;
+
+static void session(const bench_cfg_t * cfg, uint32_t seed, bench_res_t * r) {
+	MibRequestConfirm_t mib;
+	McpsReq_t mcps;
+	MlmeReq_t mlme;
+	LoRaMacStatus_t s;
+	uint8_t payload[4];
+
+	sim_reset(seed);
+	sim_ns_reset(cfg->nsRegion,__appKey,BENCH_APP_DL_EVERY,BENCH_DEVSTATUS_EVERY);
+	__notify = false;
+	__appRx = 0;
+	__appRxBad = 0;
+	double cpu0 = sim_cpuUs();
+
+	sim_cpuEnter();
+	LoRaMacInitialization(&__primitives,&__callbacks,cfg->region);
+	mib.Type = MIB_APP_KEY;
+	mib.Param.AppKey = __appKey;
+	LoRaMacMibSetRequestConfirm(&mib);
+	mib.Type = MIB_NWK_KEY;
+	mib.Param.NwkKey = __appKey;
+	LoRaMacMibSetRequestConfirm(&mib);
+	mib.Type = MIB_PUBLIC_NETWORK;
+	mib.Param.EnablePublicNetwork = true;
+	LoRaMacMibSetRequestConfirm(&mib);
+	mib.Type = MIB_ADR;
+	mib.Param.AdrEnable = false;
+	LoRaMacMibSetRequestConfirm(&mib);
+	mib.Type = MIB_DEVICE_CLASS;
+	mib.Param.Class = CLASS_A;
+	LoRaMacMibSetRequestConfirm(&mib);
+	if ( cfg->region == LORAMAC_REGION_EU868 ) LoRaMacTestSetDutyCycleOn(true);
+	LoRaMacStart();
+	sim_cpuLeave();
+	r->sessions++;
+
+	// Join
+	bool joined = false;
+	while ( !joined && sim_now() < BENCH_JOIN_TIMEOUT ) {
+		mlme.Type = MLME_JOIN;
+		mlme.Req.Join.DevEui = __devEui;
+		mlme.Req.Join.JoinEui = __joinEui;
+		mlme.Req.Join.Datarate = cfg->dr;
+		__joinDone = false;
+		sim_cpuEnter();
+		s = LoRaMacMlmeRequest(&mlme);
+		sim_cpuLeave();
+		if ( s != LORAMAC_STATUS_OK ) {
+			if ( waitDutyCycle(s,cfg->dr) ) continue;
+			break;
+		}
+		run(&__joinDone,30000);
+		joined = ( __joinDone && __joinStatus == LORAMAC_EVENT_INFO_STATUS_OK );
+	}
+	r->joinReq += sim_ns.joinReq;
+	uint32_t txJoin = sim_radio.txFrames;
+
+	if ( joined ) {
+		r->joined++;
+		r->joinMs += sim_now();
+
+		// Confirmed uplinks
+		mib.Type = MIB_CHANNELS_DATARATE;
+		mib.Param.ChannelsDatarate = cfg->dr;
+		LoRaMacMibSetRequestConfirm(&mib);
+		for ( int k = 0 ; k < BENCH_UPLINKS ; k++ ) {
+			for ( int i = 0 ; i < sizeof(payload) ; i++ ) payload[i] = k + i;
+			do {
+				mcps.Type = MCPS_CONFIRMED;
+				mcps.Req.Confirmed.fPort = 1;
+				mcps.Req.Confirmed.fBuffer = payload;
+				mcps.Req.Confirmed.fBufferSize = sizeof(payload);
+				mcps.Req.Confirmed.Datarate = cfg->dr;
+				mcps.Req.Confirmed.NbTrials = 4;
+				sim_cpuEnter();
+				s = LoRaMacMcpsRequest(&mcps);
+				sim_cpuLeave();
+			} while ( s != LORAMAC_STATUS_OK && waitDutyCycle(s,cfg->dr) );
+			if ( s != LORAMAC_STATUS_OK ) break;
+			__txDone = false;
+			run(&__txDone,BENCH_JOIN_TIMEOUT);
+			r->uplinks++;
+			if ( __txDone && __ackReceived ) r->acked++;
+			run(&__never,BENCH_UPLINK_PERIOD);
+		}
+		r->txUplinks += sim_radio.txFrames - txJoin;
+		r->nsNew += sim_ns.uplinksNew;
+		r->macCmds += sim_ns.macCmds;
+		r->devStatusReq += sim_ns.devStatusReq;
+		r->devStatusAns += sim_ns.devStatusAns;
+		r->appSent += sim_ns.appDownlinks;
+		r->appRx += __appRx;
+		r->appRxBad += __appRxBad;
+	}
+	r->rxMissed += sim_radio.rxMissed;
+	r->frames += sim_radio.txFrames + sim_radio.rxFrames;
+	r->badMic += sim_ns.badMic;
+	r->cpuUs += sim_cpuUs() - cpu0;
+}
+
+static void runConfig(const bench_cfg_t * cfg, int sessions, bench_res_t * r) {
+	bzero(r,sizeof(bench_res_t));
+	for ( int i = 0 ; i < sessions ; i++ ) {
+		session(cfg,0x1234 + 7919*i,r);
+	}
+}
+
+// ---------------------------------------------------------------
+
+static const bench_cfg_t __configs[] = {
+#ifdef REGION_EU868
+	{ "EU868", LORAMAC_REGION_EU868, SIM_NS_EU868, DR_5, "SF7" },
+	{ "EU868", LORAMAC_REGION_EU868, SIM_NS_EU868, DR_0, "SF12" },
+#endif
+#ifdef REGION_US915
+	{ "US915", LORAMAC_REGION_US915, SIM_NS_US915, DR_3, "SF7" },
+	{ "US915", LORAMAC_REGION_US915, SIM_NS_US915, DR_0, "SF10" },
+#endif
+#ifdef REGION_AS923
+	{ "AS923", LORAMAC_REGION_AS923, SIM_NS_AS923, DR_5, "SF7" },
+	{ "AS923", LORAMAC_REGION_AS923, SIM_NS_AS923, DR_2, "SF10" },
+#endif
+};
+
+int main(int argc, char ** argv) {
+	int sessions = ( argc > 1 )?atoi(argv[1]):20;
+	double losses[] = { 0.0, 0.10, 0.30 };
+	int failed = 0;
+	bench_res_t r;
+
+	printf("%d sessions of %d confirmed uplinks per line, same loss rate on uplinks and downlinks\n",sessions,BENCH_UPLINKS);
+	printf("region  dr   loss | join ok  time(s) req | uplinks acked  tx/up | mac dl  status  app dl  | rx missed | cpu us/frame\n");
+	for ( int c = 0 ; c < sizeof(__configs)/sizeof(bench_cfg_t) ; c++ ) {
+		for ( int l = 0 ; l < sizeof(losses)/sizeof(double) ; l++ ) {
+			sim_radio.ulLoss = losses[l];
+			sim_radio.dlLoss = losses[l];
+			sim_radio.wakeupMs = 1;
+			sim_radio.irqLatencyMs = 0;
+			runConfig(&__configs[c],sessions,&r);
+			printf("%s %-4s %3.0f%% | %3d/%-3d %7.1f %4.1f | %3d/%-3d %5.1f%% %5.2f | %3d %3d/%-3d %3d/%-3d | %3d | %6.1f\n",
+					__configs[c].name,__configs[c].drName,losses[l]*100,
+					r.joined,r.sessions,( r.joined > 0 )?r.joinMs/r.joined/1000.0:0,(double)r.joinReq/r.sessions,
+					r.nsNew,r.uplinks,( r.uplinks > 0 )?100.0*r.acked/r.uplinks:0,( r.uplinks > 0 )?(double)r.txUplinks/r.uplinks:0,
+					r.macCmds,r.devStatusAns,r.devStatusReq,r.appRx,r.appSent,
+					r.rxMissed,
+					( r.frames > 0 )?r.cpuUs/r.frames:0
+			);
+			if ( losses[l] == 0.0 ) {
+				// Perfect channel, everything must go through
+				if ( r.joined != r.sessions || r.acked != r.uplinks || r.uplinks != r.sessions*BENCH_UPLINKS
+					 || r.appRx != r.appSent || r.appRxBad > 0 || r.devStatusAns != r.devStatusReq
+					 || r.badMic > 0 || r.rxMissed > 0 ) failed++;
+			}
+		}
+	}
+
+	for ( int e = 0 ; e < 2 ; e++ ) {
+		printf("\nTxDone IRQ latency, RX1 windows catching the downlink, no loss, %s\n",( e == 0 )?"event time":"edge time compensation");
+		printf("region  dr  ");
+		uint32_t lat[] = { 0, 5, 10, 20, 50, 100, 500 };
+		for ( int i = 0 ; i < sizeof(lat)/sizeof(uint32_t) ; i++ ) printf("| %3dms ",lat[i]);
+		printf("\n");
+		for ( int c = 0 ; c < sizeof(__configs)/sizeof(bench_cfg_t) ; c++ ) {
+			printf("%s %-4s ",__configs[c].name,__configs[c].drName);
+			for ( int i = 0 ; i < sizeof(lat)/sizeof(uint32_t) ; i++ ) {
+				sim_radio.ulLoss = 0;
+				sim_radio.dlLoss = 0;
+				sim_radio.irqLatencyMs = lat[i];
+				sim_radio.irqEdge = ( e == 1 );
+				runConfig(&__configs[c],( sessions > 5 )?5:sessions,&r);
+				printf("| %4.0f%% ",( r.uplinks > 0 )?100.0*r.acked/r.uplinks:0);
+				// The compensation must keep the RX1 window up to the RX1 delay
+				if ( e == 1 && lat[i] < 1000 && r.acked < r.uplinks ) failed++;
+			}
+			printf("\n");
+		}
+	}
+
+	printf("\nerrors reported %d\n",sim_errors);
+	if ( failed > 0 || sim_errors > 0 ) {
+		printf("FAILED %d\n",failed);
+		return 1;
+	}
+	printf("PASSED\n");
+	return 0;
+}
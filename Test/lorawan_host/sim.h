@@ -0,0 +1,99 @@
+/* ==========================================================
+ * sim.h - Host simulation of the radio, air and network server
+ * Project : Disk91 SDK
+ * ----------------------------------------------------------
+ * Created on: 18 oct. 2020
+ *     Author: Paul Pinault aka Disk91
+ * ----------------------------------------------------------
+ * Copyright (C) 2020 Disk91
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU LESSER General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ * ----------------------------------------------------------
+ * The MAC runs on a virtual clock in ms. The soft timers and
+ * the radio events are the only sources of time progress, a
+ * simulated hour costs a few ms of CPU.
+ * ==========================================================
+ */
+#ifndef TEST_LORAWAN_HOST_SIM_H_
+#define TEST_LORAWAN_HOST_SIM_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SIM_BW125		0
+#define SIM_BW250		1
+#define SIM_BW500		2
+
+typedef struct {
+	// channel
+	double		ulLoss;				// uplink loss rate 0..1
+	double		dlLoss;				// downlink loss rate 0..1
+	int16_t		rssi;				// dBm of the frames received by the device
+	int8_t		snr;				// dB
+	// device
+	uint32_t	wakeupMs;			// radio wake up time, the MAC opens the RX window earlier by this
+	uint32_t	irqLatencyMs;		// delay between the end of the transmission and the TxDone event
+	bool		irqEdge;			// GetIrqTime reports the end of transmission, not the TxDone event time
+	// stats
+	uint32_t	txFrames;
+	uint32_t	txAirMs;
+	uint32_t	rxWindows;
+	uint32_t	rxFrames;
+	uint32_t	rxMissed;			// a downlink was on air on the listened channel but the window did not catch it
+} sim_radio_t;
+
+extern sim_radio_t sim_radio;
+extern int sim_errors;
+
+// Virtual clock & events
+void sim_reset(uint32_t seed);
+uint32_t sim_now();
+bool sim_step(uint32_t deadline);
+double sim_rand();
+
+// Host CPU time spent in the MAC, the simulation itself is excluded
+void sim_cpuEnter();
+void sim_cpuLeave();
+double sim_cpuUs();
+
+// Air, the network server puts its downlinks on air
+uint32_t sim_timeOnAir(uint8_t sf, uint8_t bw, uint8_t len, bool crc);
+void sim_air_downlink(uint32_t start, uint32_t freq, uint8_t sf, uint8_t bw, uint8_t * payload, uint8_t len);
+
+// Network server stand-in
+typedef struct {
+	uint32_t	joinReq;
+	uint32_t	joinAccept;
+	uint32_t	uplinks;			// valid data uplinks, repetitions included
+	uint32_t	uplinksNew;			// new frame counters
+	uint32_t	badMic;
+	uint32_t	acks;
+	uint32_t	macCmds;			// downlinks with MAC commands
+	uint32_t	devStatusReq;
+	uint32_t	devStatusAns;
+	uint32_t	appDownlinks;
+} sim_ns_t;
+
+extern sim_ns_t sim_ns;
+
+typedef enum {
+	SIM_NS_EU868 = 0,
+	SIM_NS_US915,
+	SIM_NS_AS923
+} sim_ns_region_e;
+
+void sim_ns_reset(sim_ns_region_e region, const uint8_t * appKey, uint32_t appDownlinkEvery, uint32_t devStatusEvery);
+void sim_ns_uplink(uint32_t end, uint32_t freq, uint8_t sf, uint8_t bw, uint8_t * payload, uint8_t len);
+
+#endif // TEST_LORAWAN_HOST_SIM_H_
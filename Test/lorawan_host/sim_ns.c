@@ -0,0 +1,301 @@
+/* ==========================================================
+ * sim_ns.c - Host network server stand-in, LoRaWan 1.0.x
+ * Project : Disk91 SDK
+ * ----------------------------------------------------------
+ * Created on: 18 oct. 2020
+ *     Author: Paul Pinault aka Disk91
+ * ----------------------------------------------------------
+ * Copyright (C) 2020 Disk91
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU LESSER General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ * ----------------------------------------------------------
+ * One device, one gateway. Answers the join requests, checks the
+ * uplink MIC and frame counter, acks the confirmed frames and puts
+ * MAC commands (LinkCheckAns, DevStatusReq) and application data
+ * in the downlinks. Downlinks are only sent in RX1, the message is
+ * built with the crypto of the stack but independently from the
+ * device MAC code.
+ * ==========================================================
+ */
+#include <string.h>
+#include <drivers/lorawan/crypto/aes.h>
+#include <drivers/lorawan/crypto/cmac.h>
+#include "sim.h"
+
+sim_ns_t sim_ns;
+
+#define SIM_NS_NETID			0x000013
+#define SIM_NS_DEVADDR			0x26011234
+#define SIM_NS_JOIN_DELAY		5000
+#define SIM_NS_RX_DELAY			1000
+#define SIM_NS_APP_PORT			2
+
+static struct {
+	sim_ns_region_e	region;
+	uint8_t			appKey[16];
+	uint8_t			nwkSKey[16];
+	uint8_t			appSKey[16];
+	bool			joined;
+	uint32_t		joinNonce;
+	uint32_t		fCntUp;
+	bool			firstUp;
+	uint32_t		fCntDown;
+	uint32_t		appEvery;
+	uint32_t		statusEvery;
+	uint8_t			pendingMac[16];
+	uint8_t			pendingMacSz;
+} __ns;
+
+void sim_ns_reset(sim_ns_region_e region, const uint8_t * appKey, uint32_t appDownlinkEvery, uint32_t devStatusEvery) {
+	bzero(&__ns,sizeof(__ns));
+	bzero(&sim_ns,sizeof(sim_ns));
+	__ns.region = region;
+	memcpy(__ns.appKey,appKey,16);
+	__ns.appEvery = appDownlinkEvery;
+	__ns.statusEvery = devStatusEvery;
+}
+
+// ---------------------------------------------------------------
+// Crypto
+
+static void __cmac(const uint8_t * key, const uint8_t * b0, const uint8_t * msg, uint16_t len, uint8_t * mic) {
+	AES_CMAC_CTX ctx;
+	uint8_t d[16];
+	AES_CMAC_Init(&ctx);
+	AES_CMAC_SetKey(&ctx,key);
+	if ( b0 != NULL ) AES_CMAC_Update(&ctx,b0,16);
+	AES_CMAC_Update(&ctx,msg,len);
+	AES_CMAC_Final(d,&ctx);
+	memcpy(mic,d,4);
+}
+
+static void __block(uint8_t * b, uint8_t type, bool down, uint32_t devAddr, uint32_t fcnt, uint8_t last) {
+	bzero(b,16);
+	b[0] = type;
+	b[5] = ( down )?1:0;
+	for ( int i = 0 ; i < 4 ; i++ ) {
+		b[6+i] = (devAddr >> (8*i)) & 0xFF;
+		b[10+i] = (fcnt >> (8*i)) & 0xFF;
+	}
+	b[15] = last;
+}
+
+static void __payloadCrypt(const uint8_t * key, bool down, uint32_t fcnt, uint8_t * data, uint8_t len) {
+	aes_context ctx;
+	uint8_t a[16], s[16];
+	aes_set_key(key,16,&ctx);
+	for ( int i = 0 ; i < len ; i += 16 ) {
+		__block(a,0x01,down,SIM_NS_DEVADDR,fcnt,(i/16)+1);
+		aes_encrypt(a,s,&ctx);
+		for ( int k = 0 ; k < 16 && i+k < len ; k++ ) data[i+k] ^= s[k];
+	}
+}
+
+static void __deriveKey(uint8_t type, const uint8_t * devNonce, uint8_t * key) {
+	aes_context ctx;
+	uint8_t b[16] = { 0 };
+	b[0] = type;
+	for ( int i = 0 ; i < 3 ; i++ ) {
+		b[1+i] = (__ns.joinNonce >> (8*i)) & 0xFF;
+		b[4+i] = (SIM_NS_NETID >> (8*i)) & 0xFF;
+	}
+	b[7] = devNonce[0];
+	b[8] = devNonce[1];
+	aes_set_key(__ns.appKey,16,&ctx);
+	aes_encrypt(b,key,&ctx);
+}
+
+// ---------------------------------------------------------------
+// RX1 parameters of the supported regions, RX1DROffset is 0
+
+static void __rx1(uint32_t freq, uint8_t sf, uint8_t bw, uint32_t * dlFreq, uint8_t * dlSf, uint8_t * dlBw) {
+	*dlFreq = freq;
+	*dlSf = sf;
+	*dlBw = bw;
+	if ( __ns.region == SIM_NS_US915 ) {
+		if ( bw == SIM_BW125 ) {
+			*dlFreq = 923300000 + ((freq - 902300000) / 200000 % 8) * 600000;
+		} else {
+			*dlFreq = 923300000 + ((freq - 903000000) / 1600000) * 600000;
+			*dlSf = 7;
+		}
+		*dlBw = SIM_BW500;
+	}
+}
+
+static uint8_t __rx2Dr() {
+	switch ( __ns.region ) {
+	case SIM_NS_US915: return 8;
+	case SIM_NS_AS923: return 2;
+	default: return 0;
+	}
+}
+
+// ---------------------------------------------------------------
+
+static void __joinRequest(uint32_t end, uint32_t freq, uint8_t sf, uint8_t bw, uint8_t * p, uint8_t len) {
+	uint8_t mic[4], ja[17];
+	aes_context ctx;
+
+	if ( len != 23 ) return;
+	sim_ns.joinReq++;
+	__cmac(__ns.appKey,NULL,p,19,mic);
+	if ( memcmp(mic,&p[19],4) != 0 ) {
+		sim_ns.badMic++;
+		return;
+	}
+	__ns.joinNonce++;
+	__deriveKey(0x01,&p[17],__ns.nwkSKey);
+	__deriveKey(0x02,&p[17],__ns.appSKey);
+	__ns.joined = true;
+	__ns.firstUp = true;
+	__ns.fCntUp = 0;
+	__ns.fCntDown = 0;
+	__ns.pendingMacSz = 0;
+
+	ja[0] = 0x20;
+	for ( int i = 0 ; i < 3 ; i++ ) {
+		ja[1+i] = (__ns.joinNonce >> (8*i)) & 0xFF;
+		ja[4+i] = (SIM_NS_NETID >> (8*i)) & 0xFF;
+	}
+	for ( int i = 0 ; i < 4 ; i++ ) ja[7+i] = (SIM_NS_DEVADDR >> (8*i)) & 0xFF;
+	ja[11] = __rx2Dr();
+	ja[12] = 1;
+	__cmac(__ns.appKey,NULL,ja,13,&ja[13]);
+	aes_set_key(__ns.appKey,16,&ctx);
+	aes_decrypt(&ja[1],&ja[1],&ctx);
+
+	uint32_t dlFreq;
+	uint8_t dlSf, dlBw;
+	__rx1(freq,sf,bw,&dlFreq,&dlSf,&dlBw);
+	sim_air_downlink(end + SIM_NS_JOIN_DELAY,dlFreq,dlSf,dlBw,ja,17);
+	sim_ns.joinAccept++;
+}
+
+static void __macCommands(uint8_t * c, uint8_t len) {
+	int i = 0;
+	while ( i < len ) {
+		switch ( c[i] ) {
+		case 0x02:	// LinkCheckReq
+			if ( __ns.pendingMacSz + 3 <= sizeof(__ns.pendingMac) ) {
+				__ns.pendingMac[__ns.pendingMacSz++] = 0x02;
+				__ns.pendingMac[__ns.pendingMacSz++] = 20;
+				__ns.pendingMac[__ns.pendingMacSz++] = 1;
+			}
+			i += 1;
+			break;
+		case 0x06:	// DevStatusAns
+			sim_ns.devStatusAns++;
+			i += 3;
+			break;
+		case 0x03: case 0x05: case 0x07: case 0x0A:
+			i += 2;
+			break;
+		case 0x04: case 0x08: case 0x09:
+			i += 1;
+			break;
+		default:
+			return;
+		}
+	}
+}
+
+static void __dataUplink(uint32_t end, uint32_t freq, uint8_t sf, uint8_t bw, uint8_t * p, uint8_t len) {
+	uint8_t b0[16], mic[4];
+
+	if ( !__ns.joined || len < 12 ) return;
+	uint32_t devAddr = p[1] | (p[2] << 8) | (p[3] << 16) | ((uint32_t)p[4] << 24);
+	if ( devAddr != SIM_NS_DEVADDR ) return;
+	uint8_t fOptsLen = p[5] & 0x0F;
+	uint32_t fCnt = ( __ns.fCntUp & 0xFFFF0000 ) | p[6] | (p[7] << 8);
+	if ( !__ns.firstUp && fCnt < __ns.fCntUp ) fCnt += 0x10000;
+
+	__block(b0,0x49,false,devAddr,fCnt,len-4);
+	__cmac(__ns.nwkSKey,b0,p,len-4,mic);
+	if ( memcmp(mic,&p[len-4],4) != 0 ) {
+		sim_ns.badMic++;
+		return;
+	}
+	bool isNew = ( __ns.firstUp || fCnt != __ns.fCntUp );
+	__ns.firstUp = false;
+	__ns.fCntUp = fCnt;
+	sim_ns.uplinks++;
+	if ( !isNew ) {
+		if ( (p[0] >> 5) != 4 ) return;
+	} else {
+		sim_ns.uplinksNew++;
+		__macCommands(&p[8],fOptsLen);
+		if ( len - 4 > 8 + fOptsLen && p[8+fOptsLen] == 0 ) {
+			uint8_t * fp = &p[9+fOptsLen];
+			uint8_t fpLen = len - 4 - 9 - fOptsLen;
+			__payloadCrypt(__ns.nwkSKey,false,fCnt,fp,fpLen);
+			__macCommands(fp,fpLen);
+		}
+		if ( __ns.statusEvery > 0 && sim_ns.uplinksNew % __ns.statusEvery == 0 && __ns.pendingMacSz < sizeof(__ns.pendingMac) ) {
+			__ns.pendingMac[__ns.pendingMacSz++] = 0x06;
+			sim_ns.devStatusReq++;
+		}
+	}
+
+	bool ack = ( (p[0] >> 5) == 4 );
+	bool app = ( isNew && __ns.appEvery > 0 && sim_ns.uplinksNew % __ns.appEvery == 0 );
+	if ( !ack && !app && __ns.pendingMacSz == 0 ) return;
+
+	uint8_t dl[32];
+	uint8_t sz = 0;
+	dl[sz++] = 0x60;
+	for ( int i = 0 ; i < 4 ; i++ ) dl[sz++] = (SIM_NS_DEVADDR >> (8*i)) & 0xFF;
+	dl[sz++] = ( ack?0x20:0x00 ) | __ns.pendingMacSz;
+	dl[sz++] = __ns.fCntDown & 0xFF;
+	dl[sz++] = (__ns.fCntDown >> 8) & 0xFF;
+	memcpy(&dl[sz],__ns.pendingMac,__ns.pendingMacSz);
+	sz += __ns.pendingMacSz;
+	sim_ns.macCmds += ( __ns.pendingMacSz > 0 );
+	__ns.pendingMacSz = 0;
+	if ( app ) {
+		dl[sz++] = SIM_NS_APP_PORT;
+		dl[sz++] = 0xD0;
+		dl[sz++] = 0x0D;
+		dl[sz++] = fCnt & 0xFF;
+		dl[sz++] = (fCnt >> 8) & 0xFF;
+		__payloadCrypt(__ns.appSKey,true,__ns.fCntDown,&dl[sz-4],4);
+		sim_ns.appDownlinks++;
+	}
+	__block(b0,0x49,true,SIM_NS_DEVADDR,__ns.fCntDown,sz);
+	__cmac(__ns.nwkSKey,b0,dl,sz,&dl[sz]);
+	sz += 4;
+	__ns.fCntDown++;
+	if ( ack ) sim_ns.acks++;
+
+	uint32_t dlFreq;
+	uint8_t dlSf, dlBw;
+	__rx1(freq,sf,bw,&dlFreq,&dlSf,&dlBw);
+	sim_air_downlink(end + SIM_NS_RX_DELAY,dlFreq,dlSf,dlBw,dl,sz);
+}
+
+void sim_ns_uplink(uint32_t end, uint32_t freq, uint8_t sf, uint8_t bw, uint8_t * payload, uint8_t len) {
+	uint8_t p[256];
+	memcpy(p,payload,len);
+	switch ( p[0] >> 5 ) {
+	case 0:
+		__joinRequest(end,freq,sf,bw,p,len);
+		break;
+	case 2:
+	case 4:
+		__dataUplink(end,freq,sf,bw,p,len);
+		break;
+	default:
+		break;
+	}
+}
@@ -0,0 +1,470 @@
+/* ==========================================================
+ * sim_radio.c - Host simulation of the clock, timers and radio
+ * Project : Disk91 SDK
+ * ----------------------------------------------------------
+ * Created on: 18 oct. 2020
+ *     Author: Paul Pinault aka Disk91
+ * ----------------------------------------------------------
+ * Copyright (C) 2020 Disk91
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU LESSER General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ * ----------------------------------------------------------
+ * Replaces the it_sdk services the LoRaWan MAC uses (time, soft
+ * timers, random) and the SX1276 driver by a Radio table working
+ * on the virtual clock. The timeServer.c and systime.c of the
+ * SDK run on top of the simulated soft timers.
+ *
+ * A RX window catches a downlink when the receiver is listening
+ * no later than 4 symbols after the preamble start and the
+ * preamble starts before the symbol timeout, like the SX1276.
+ * ==========================================================
+ */
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <it_sdk/config.h>
+#include <it_sdk/time/time.h>
+#include <it_sdk/time/timer.h>
+#include <it_sdk/random/random.h>
+#include <drivers/lorawan/phy/radio.h>
+#include "sim.h"
+
+sim_radio_t sim_radio;
+int sim_errors = 0;
+
+// ---------------------------------------------------------------
+// Virtual clock, soft timers & random
+
+#define SIM_STIMER_SLOTS	8
+
+static uint64_t __now;
+static itsdk_stimer_slot_t __stimers[SIM_STIMER_SLOTS];
+static uint32_t __rand;
+
+uint64_t itsdk_time_get_ms() {
+	return __now;
+}
+
+uint32_t sim_now() {
+	return (uint32_t)__now;
+}
+
+itsdk_timer_return_t itsdk_stimer_register(
+		uint32_t ms,
+		void (*callback_func)(uint32_t value),
+		uint32_t value,
+		itsdk_timer_lpAccept allowLowPower
+) {
+	for ( int i = 0 ; i < SIM_STIMER_SLOTS ; i++ ) {
+		if ( !__stimers[i].inUse ) {
+			__stimers[i].inUse = true;
+			__stimers[i].timeoutMs = __now + ms;
+			__stimers[i].callback_func = callback_func;
+			__stimers[i].customValue = value;
+			return TIMER_INIT_SUCCESS;
+		}
+	}
+	return TIMER_LIST_FULL;
+}
+
+itsdk_timer_return_t itsdk_stimer_stop(
+		void (*callback_func)(uint32_t value),
+		uint32_t value
+) {
+	for ( int i = 0 ; i < SIM_STIMER_SLOTS ; i++ ) {
+		if ( __stimers[i].inUse && __stimers[i].callback_func == callback_func && __stimers[i].customValue == value ) {
+			__stimers[i].inUse = false;
+			return TIMER_INIT_SUCCESS;
+		}
+	}
+	return TIMER_NOT_FOUND;
+}
+
+uint32_t itsdk_random_getU32() {
+	// xorshift32, reproducible runs
+	__rand ^= __rand << 13;
+	__rand ^= __rand >> 17;
+	__rand ^= __rand << 5;
+	return __rand;
+}
+
+int32_t itsdk_random_getRange(int32_t min, int32_t max) {
+	return min + (int32_t)(itsdk_random_getU32() % (uint32_t)(max - min + 1));
+}
+
+void itsdk_random_addEntropy(uint32_t value, uint8_t bits) {
+}
+
+void itsdk_random_getBytes(uint8_t * dest, uint16_t len) {
+	while ( len-- ) *dest++ = (uint8_t)itsdk_random_getU32();
+}
+
+double sim_rand() {
+	return (itsdk_random_getU32() >> 8) / (double)(1 << 24);
+}
+
+// ---------------------------------------------------------------
+// CPU accounting
+
+static int __cpuDepth;
+static struct timespec __cpuStart;
+static double __cpuUs;
+
+static double __elapsedUs(struct timespec * s) {
+	struct timespec e;
+	clock_gettime(CLOCK_MONOTONIC,&e);
+	return (e.tv_sec - s->tv_sec)*1e6 + (e.tv_nsec - s->tv_nsec)/1e3;
+}
+
+void sim_cpuEnter() {
+	if ( __cpuDepth++ == 0 ) clock_gettime(CLOCK_MONOTONIC,&__cpuStart);
+}
+
+void sim_cpuLeave() {
+	if ( --__cpuDepth == 0 ) __cpuUs += __elapsedUs(&__cpuStart);
+}
+
+double sim_cpuUs() {
+	return __cpuUs;
+}
+
+static void __cpuPause() {
+	if ( __cpuDepth > 0 ) __cpuUs += __elapsedUs(&__cpuStart);
+}
+
+static void __cpuResume() {
+	if ( __cpuDepth > 0 ) clock_gettime(CLOCK_MONOTONIC,&__cpuStart);
+}
+
+// ---------------------------------------------------------------
+// Air
+
+#define SIM_AIR_SLOTS		8
+#define SIM_DETECT_SYMB		4		// latest receiver start after the preamble start, in symbols
+
+typedef struct {
+	bool		inUse;
+	uint32_t	start;
+	uint32_t	freq;
+	uint8_t		sf;
+	uint8_t		bw;
+	uint8_t		len;
+	uint8_t		payload[256];
+} sim_frame_t;
+
+static sim_frame_t __air[SIM_AIR_SLOTS];
+
+static double __symbMs(uint8_t sf, uint8_t bw) {
+	return (double)(1 << sf) / (125.0 * (1 << bw));
+}
+
+/**
+ * SX1276 LoRa time on air, 8 symbols preamble, explicit header, CR 4/5
+ */
+uint32_t sim_timeOnAir(uint8_t sf, uint8_t bw, uint8_t len, bool crc) {
+	double ts = __symbMs(sf,bw);
+	int de = ( ts > 16.0 )?1:0;
+	int num = 8*len - 4*sf + 28 + ( crc?16:0 );
+	int den = 4*(sf - 2*de);
+	int nb = ( num > 0 )?((num + den - 1) / den)*5:0;
+	double toa = (8 + 4.25 + 8 + nb) * ts;
+	return (uint32_t)(toa + 0.999);
+}
+
+void sim_air_downlink(uint32_t start, uint32_t freq, uint8_t sf, uint8_t bw, uint8_t * payload, uint8_t len) {
+	for ( int i = 0 ; i < SIM_AIR_SLOTS ; i++ ) {
+		// slots of the frames already over are reused
+		if ( !__air[i].inUse || (int32_t)(__air[i].start + sim_timeOnAir(__air[i].sf,__air[i].bw,__air[i].len,false) - sim_now()) < 0 ) {
+			__air[i].inUse = true;
+			__air[i].start = start;
+			__air[i].freq = freq;
+			__air[i].sf = sf;
+			__air[i].bw = bw;
+			__air[i].len = len;
+			memcpy(__air[i].payload,payload,len);
+			return;
+		}
+	}
+	sim_errors++;
+}
+
+// ---------------------------------------------------------------
+// Radio
+
+typedef enum {
+	SIM_EV_NONE = 0,
+	SIM_EV_TXDONE,
+	SIM_EV_RXDONE,
+	SIM_EV_RXTIMEOUT
+} sim_event_e;
+
+static struct {
+	RadioEvents_t	* events;
+	RadioState_t	state;
+	uint32_t		freq;
+	uint8_t			txSf;
+	uint8_t			txBw;
+	uint8_t			rxSf;
+	uint8_t			rxBw;
+	uint16_t		symbTimeout;
+	bool			rxContinuous;
+	sim_event_e		ev;
+	uint64_t		evTime;
+	uint64_t		irqTime;			// radio edge of the event being processed
+	uint8_t			rxBuffer[256];
+	uint8_t			rxLen;
+} __radio;
+
+static uint32_t sim_radioInit(RadioEvents_t * events) {
+	__radio.events = events;
+	__radio.state = RF_IDLE;
+	__radio.ev = SIM_EV_NONE;
+	return 0;
+}
+
+static RadioState_t sim_radioGetStatus(void) {
+	return __radio.state;
+}
+
+static void sim_radioSetModem(RadioModems_t modem) {
+}
+
+static void sim_radioSetChannel(uint32_t freq) {
+	__radio.freq = freq;
+}
+
+static bool sim_radioIsChannelFree(RadioModems_t modem, uint32_t freq, int16_t rssiThresh, uint32_t maxCarrierSenseTime) {
+	return true;
+}
+
+static uint32_t sim_radioRandom(void) {
+	return itsdk_random_getU32();
+}
+
+static void sim_radioSetRxConfig(RadioModems_t modem, uint32_t bandwidth, uint32_t datarate, uint8_t coderate,
+		uint32_t bandwidthAfc, uint16_t preambleLen, uint16_t symbTimeout, bool fixLen, uint8_t payloadLen,
+		bool crcOn, bool freqHopOn, uint8_t hopPeriod, bool iqInverted, bool rxContinuous) {
+	__radio.rxSf = datarate;
+	__radio.rxBw = bandwidth;
+	__radio.symbTimeout = symbTimeout;
+	__radio.rxContinuous = rxContinuous;
+}
+
+static void sim_radioSetTxConfig(RadioModems_t modem, int8_t power, uint32_t fdev, uint32_t bandwidth,
+		uint32_t datarate, uint8_t coderate, uint16_t preambleLen, bool fixLen, bool crcOn, bool freqHopOn,
+		uint8_t hopPeriod, bool iqInverted, uint32_t timeout) {
+	__radio.txSf = datarate;
+	__radio.txBw = bandwidth;
+}
+
+static bool sim_radioCheckRfFrequency(uint32_t frequency) {
+	return true;
+}
+
+static uint32_t sim_radioTimeOnAir(RadioModems_t modem, uint8_t pktLen) {
+	return sim_timeOnAir(__radio.txSf,__radio.txBw,pktLen,true);
+}
+
+static void sim_radioSend(uint8_t * buffer, uint8_t size) {
+	uint32_t toa = sim_timeOnAir(__radio.txSf,__radio.txBw,size,true);
+	sim_radio.txFrames++;
+	sim_radio.txAirMs += toa;
+	if ( sim_rand() >= sim_radio.ulLoss ) {
+		__cpuPause();
+		sim_ns_uplink(sim_now() + toa,__radio.freq,__radio.txSf,__radio.txBw,buffer,size);
+		__cpuResume();
+	}
+	__radio.state = RF_TX_RUNNING;
+	__radio.ev = SIM_EV_TXDONE;
+	__radio.evTime = __now + toa + sim_radio.irqLatencyMs;
+}
+
+static void sim_radioSleep(void) {
+	__radio.state = RF_IDLE;
+	__radio.ev = SIM_EV_NONE;
+}
+
+static void sim_radioRx(uint32_t timeout) {
+	double ts = __symbMs(__radio.rxSf,__radio.rxBw);
+	double listen = (double)(__now + sim_radio.wakeupMs);
+	double last = ( __radio.rxContinuous )?(( timeout > 0 )?(double)(__now + timeout):1e18):(listen + __radio.symbTimeout * ts);
+
+	sim_radio.rxWindows++;
+	__radio.state = RF_RX_RUNNING;
+	__radio.ev = SIM_EV_NONE;
+	for ( int i = 0 ; i < SIM_AIR_SLOTS ; i++ ) {
+		sim_frame_t * f = &__air[i];
+		if ( !f->inUse || f->freq != __radio.freq || f->sf != __radio.rxSf || f->bw != __radio.rxBw ) continue;
+		double start = (double)f->start;
+		if ( listen <= start + SIM_DETECT_SYMB * ts && start <= last ) {
+			f->inUse = false;
+			if ( sim_rand() >= sim_radio.dlLoss ) {
+				memcpy(__radio.rxBuffer,f->payload,f->len);
+				__radio.rxLen = f->len;
+				__radio.ev = SIM_EV_RXDONE;
+				__radio.evTime = f->start + sim_timeOnAir(f->sf,f->bw,f->len,false);
+				return;
+			}
+		} else if ( start > listen - 1000.0 && start < listen + 1000.0 ) {
+			sim_radio.rxMissed++;
+		}
+	}
+	if ( last < 1e18 ) {
+		__radio.ev = SIM_EV_RXTIMEOUT;
+		__radio.evTime = (uint64_t)(last + 0.999);
+	}
+}
+
+static void sim_radioStartCad(void) {
+}
+
+static void sim_radioSetTxContinuousWave(uint32_t freq, int8_t power, uint16_t time) {
+}
+
+static int16_t sim_radioRssi(RadioModems_t modem) {
+	return -120;
+}
+
+static void sim_radioWrite(uint16_t addr, uint8_t data) {
+}
+
+static uint8_t sim_radioRead(uint16_t addr) {
+	return 0;
+}
+
+static void sim_radioWriteBuffer(uint16_t addr, uint8_t * buffer, uint8_t size) {
+}
+
+static void sim_radioReadBuffer(uint16_t addr, uint8_t * buffer, uint8_t size) {
+}
+
+static void sim_radioSetMaxPayloadLength(RadioModems_t modem, uint8_t max) {
+}
+
+static void sim_radioSetPublicNetwork(bool enable) {
+}
+
+static uint32_t sim_radioGetWakeupTime(void) {
+	return sim_radio.wakeupMs;
+}
+
+static void sim_radioSetRxDutyCycle(uint32_t rxTime, uint32_t sleepTime) {
+}
+
+static uint32_t sim_radioGetIrqTime(void) {
+	return (uint32_t)__radio.irqTime;
+}
+
+const struct Radio_s Radio = {
+	NULL,
+	NULL,
+	sim_radioInit,
+	sim_radioGetStatus,
+	sim_radioSetModem,
+	sim_radioSetChannel,
+	sim_radioIsChannelFree,
+	sim_radioRandom,
+	sim_radioSetRxConfig,
+	sim_radioSetTxConfig,
+	sim_radioCheckRfFrequency,
+	sim_radioTimeOnAir,
+	sim_radioSend,
+	sim_radioSleep,
+	sim_radioSleep,
+	sim_radioRx,
+	sim_radioStartCad,
+	sim_radioSetTxContinuousWave,
+	sim_radioRssi,
+	sim_radioWrite,
+	sim_radioRead,
+	sim_radioWriteBuffer,
+	sim_radioReadBuffer,
+	sim_radioSetMaxPayloadLength,
+	sim_radioSetPublicNetwork,
+	sim_radioGetWakeupTime,
+	NULL,
+	sim_radioGetIrqTime,
+	sim_radioRx,
+	sim_radioSetRxDutyCycle
+};
+
+// ---------------------------------------------------------------
+// Event loop
+
+void sim_reset(uint32_t seed) {
+	__now = 0;
+	__rand = ( seed != 0 )?seed:1;
+	bzero(__stimers,sizeof(__stimers));
+	bzero(__air,sizeof(__air));
+	__radio.state = RF_IDLE;
+	__radio.ev = SIM_EV_NONE;
+	uint32_t wakeup = sim_radio.wakeupMs, irq = sim_radio.irqLatencyMs;
+	bool edge = sim_radio.irqEdge;
+	double ul = sim_radio.ulLoss, dl = sim_radio.dlLoss;
+	bzero(&sim_radio,sizeof(sim_radio));
+	sim_radio.wakeupMs = wakeup;
+	sim_radio.irqLatencyMs = irq;
+	sim_radio.irqEdge = edge;
+	sim_radio.ulLoss = ul;
+	sim_radio.dlLoss = dl;
+	sim_radio.rssi = -90;
+	sim_radio.snr = 5;
+}
+
+/**
+ * Run the next timer or radio event when it is due before the deadline,
+ * otherwise move the clock to the deadline and return false.
+ */
+bool sim_step(uint32_t deadline) {
+	int next = -1;
+	for ( int i = 0 ; i < SIM_STIMER_SLOTS ; i++ ) {
+		if ( __stimers[i].inUse && ( next < 0 || __stimers[i].timeoutMs < __stimers[next].timeoutMs ) ) next = i;
+	}
+	bool radio = ( __radio.ev != SIM_EV_NONE && ( next < 0 || __radio.evTime <= __stimers[next].timeoutMs ) );
+	uint64_t t = ( radio )?__radio.evTime:(( next >= 0 )?__stimers[next].timeoutMs:UINT64_MAX);
+	uint64_t limit = ( __now & ~0xFFFFFFFFull ) | deadline;
+	if ( limit < __now ) limit += 0x100000000ull;
+	if ( t > limit ) {
+		__now = limit;
+		return false;
+	}
+	if ( t > __now ) __now = t;
+
+	sim_cpuEnter();
+	if ( radio ) {
+		sim_event_e ev = __radio.ev;
+		__radio.ev = SIM_EV_NONE;
+		__radio.state = RF_IDLE;
+		__radio.irqTime = ( ev == SIM_EV_TXDONE && sim_radio.irqEdge )?__now - sim_radio.irqLatencyMs:__now;
+		switch ( ev ) {
+		case SIM_EV_TXDONE:
+			__radio.events->TxDone();
+			break;
+		case SIM_EV_RXDONE:
+			sim_radio.rxFrames++;
+			__radio.events->RxDone(__radio.rxBuffer,__radio.rxLen,sim_radio.rssi,sim_radio.snr);
+			break;
+		case SIM_EV_RXTIMEOUT:
+			__radio.events->RxTimeout();
+			break;
+		default:
+			break;
+		}
+	} else {
+		__stimers[next].inUse = false;
+		__stimers[next].callback_func(__stimers[next].customValue);
+	}
+	sim_cpuLeave();
+	return true;
+}
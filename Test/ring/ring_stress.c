@@ -0,0 +1,105 @@
+/* ==========================================================
+ * ring_stress.c - Host stress test of the SPSC ring buffer
+ * Project : Disk91 SDK
+ * ----------------------------------------------------------
+ * Created on: 18 oct. 2020
+ *     Author: Paul Pinault aka Disk91
+ * ----------------------------------------------------------
+ * Copyright (C) 2020 Disk91
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU LESSER General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ * ----------------------------------------------------------
+ * One producer and one consumer thread exchange numbered 8 bytes
+ * elements through a 64 slots ring with random burst sizes. The
+ * consumer checks the order and the content, the producer retries
+ * the dropped elements so the overflow counter is also exercised.
+ *
+ * Build & run from the repository root:
+ *   gcc -O2 -pthread -IInc Test/ring/ring_stress.c Src/it_sdk/ring/ring.c -o ring_stress
+ *   ./ring_stress [elements]
+ *
+ * ==========================================================
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sched.h>
+#include <it_sdk/ring/ring.h>
+
+typedef struct {
+	uint32_t	seq;
+	uint32_t	check;
+} elem_t;
+
+#define CHECK(s)	((s) * 2654435761u)
+
+ITSDK_RING_DECLARE(__ring,elem_t,64);
+static uint32_t __total = 20000000;
+static uint32_t __errors = 0;
+
+static void * producer(void * arg) {
+	(void)arg;
+	unsigned int seed = 1;
+	uint32_t seq = 0;
+	elem_t b[8];
+	while ( seq < __total ) {
+		uint16_t n = 1 + rand_r(&seed) % 7;
+		if ( n > __total - seq ) n = __total - seq;
+		for ( int i = 0 ; i < n ; i++ ) {
+			b[i].seq = seq + i;
+			b[i].check = CHECK(seq + i);
+		}
+		uint16_t w = itsdk_ring_push(&__ring,b,n);
+		if ( w == 0 ) sched_yield();
+		seq += w;
+	}
+	return NULL;
+}
+
+static void * consumer(void * arg) {
+	(void)arg;
+	unsigned int seed = 2;
+	uint32_t seq = 0;
+	elem_t b[8];
+	while ( seq < __total ) {
+		uint16_t n = itsdk_ring_pop(&__ring,b,1 + rand_r(&seed) % 5);
+		if ( n == 0 ) sched_yield();
+		for ( int i = 0 ; i < n ; i++ ) {
+			if ( b[i].seq != seq || b[i].check != CHECK(seq) ) __errors++;
+			seq++;
+		}
+	}
+	return NULL;
+}
+
+int main(int argc, char ** argv) {
+	pthread_t p, c;
+	if ( argc > 1 ) __total = strtoul(argv[1],NULL,10);
+	itsdk_ring_init(&__ring);
+	pthread_create(&c,NULL,consumer,NULL);
+	pthread_create(&p,NULL,producer,NULL);
+	pthread_join(p,NULL);
+	pthread_join(c,NULL);
+
+	uint16_t hw;
+	uint32_t ov;
+	itsdk_ring_getStats(&__ring,&hw,&ov);
+	printf("elements %u errors %u highWater %u dropped %u\n",__total,__errors,hw,ov);
+	if ( __errors > 0 || hw > 64 || itsdk_ring_count(&__ring) != 0 ) {
+		printf("FAILED\n");
+		return 1;
+	}
+	printf("PASSED\n");
+	return 0;
+}
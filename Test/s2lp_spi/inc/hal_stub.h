@@ -0,0 +1,37 @@
+/* Host test stub of the STM32 HAL, the SPI is simulated by the test */
+#ifndef TEST_HAL_STUB_H_
+#define TEST_HAL_STUB_H_
+#include <stdint.h>
+
+typedef enum { HAL_OK = 0, HAL_ERROR, HAL_BUSY, HAL_TIMEOUT } HAL_StatusTypeDef;
+typedef enum { RESET = 0, SET = !RESET } FlagStatus;
+typedef struct { int dummy; } DMA_HandleTypeDef;
+typedef struct { DMA_HandleTypeDef * hdmatx; } SPI_HandleTypeDef;
+
+#define GPIO_PIN_0						((uint16_t)0x0001)
+#define GPIO_PIN_1						((uint16_t)0x0002)
+
+HAL_StatusTypeDef HAL_SPI_Transmit(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size, uint32_t Timeout);
+HAL_StatusTypeDef HAL_SPI_Receive(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size, uint32_t Timeout);
+HAL_StatusTypeDef HAL_SPI_TransmitReceive(SPI_HandleTypeDef *hspi, uint8_t *pTxData, uint8_t *pRxData, uint16_t Size, uint32_t Timeout);
+
+// Not used by the test, the transfers are synchronous
+#define SPI_FLAG_TXE					1
+#define DMA_IT_TC						1
+#define DMA_IT_HT						2
+#define __HAL_SPI_GET_FLAG(h,f)			((void)(h),SET)
+#define __HAL_DMA_GET_TC_FLAG_INDEX(h)	0
+#define __HAL_DMA_GET_HT_FLAG_INDEX(h)	0
+#define __HAL_DMA_CLEAR_FLAG(h,f)		((void)(h))
+#define __HAL_DMA_ENABLE_IT(h,i)		((void)(h))
+#define __HAL_DMA_DISABLE_IT(h,i)		((void)(h))
+static inline HAL_StatusTypeDef HAL_SPI_Init(SPI_HandleTypeDef *hspi) { (void)hspi; return HAL_OK; }
+static inline HAL_StatusTypeDef HAL_SPI_DeInit(SPI_HandleTypeDef *hspi) { (void)hspi; return HAL_OK; }
+static inline HAL_StatusTypeDef HAL_SPI_DMAStop(SPI_HandleTypeDef *hspi) { (void)hspi; return HAL_OK; }
+static inline HAL_StatusTypeDef HAL_SPI_Transmit_DMA(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size) {
+	(void)hspi; (void)pData; (void)Size; return HAL_ERROR;
+}
+
+extern SPI_HandleTypeDef hspi1;
+
+#endif
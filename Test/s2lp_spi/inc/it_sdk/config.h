@@ -0,0 +1,28 @@
+/* Host test configuration for the S2LP SPI access */
+#ifndef TEST_IT_SDK_CONFIG_H_
+#define TEST_IT_SDK_CONFIG_H_
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <it_sdk/config_defines.h>
+#include "hal_stub.h"
+
+#define __weak							__attribute__((weak))
+
+#define ITSDK_PLATFORM					__PLATFORM_STM32L0
+#define ITSDK_WITH_LORAWAN_LIB			__DISABLE
+#define ITSDK_WITH_SIGFOX_LIB			__ENABLE
+#define ITSDK_SIGFOX_LIB				__SIGFOX_S2LP
+#define ITSDK_LOGGER_MODULE				0
+
+#define ITSDK_WITH_SPI					__SPI_ENABLED
+#define ITSDK_SPI_HANDLER_TYPE			SPI_HandleTypeDef
+#define ITSDK_SPI_TIMEOUT				100
+
+#define ITSDK_S2LP_SPI					hspi1
+#define ITSDK_S2LP_CS_BANK				__BANK_A
+#define ITSDK_S2LP_CS_PIN				__LP_GPIO_1
+#define ITSDK_S2LP_GPIO3_BANK			__BANK_C
+#define ITSDK_S2LP_GPIO3_PIN			__LP_GPIO_0
+
+#endif
@@ -0,0 +1,298 @@
+/* ==========================================================
+ * s2lp_spi_test.c - Host check of the S2LP register accesses
+ * Project : Disk91 SDK
+ * ----------------------------------------------------------
+ * Created on: 18 oct. 2020
+ *     Author: Paul Pinault aka Disk91
+ * ----------------------------------------------------------
+ * Copyright (C) 2020 Disk91
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU LESSER General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ * ----------------------------------------------------------
+ * Runs the unmodified s2lp_spi.c and spi.c against a simulated chip
+ * behind the HAL SPI functions, then the previous byte per byte
+ * register access (ref_accessRegisters below) on the same chip. The
+ * chip returns the MC_STATE status bytes during the header and the
+ * address, then auto-increments the register address. For random
+ * reads and writes the test checks:
+ *  - the MOSI bytes between CS low and CS high are the same as the
+ *    previous implementation, 0xFF is clocked out on reads
+ *  - the registers read, the chip registers written and the status
+ *    bytes returned are the same
+ *  - the transfers are done with CS low and the GPIO3 interrupt
+ *    masked, it is unmasked after CS high
+ *  - the number of HAL calls is one per S2LP_SPI_BURST_SZ bytes
+ *
+ * Build & run from the repository root:
+ *   gcc -O2 -fshort-enums -ITest/s2lp_spi/inc -IInc Test/s2lp_spi/s2lp_spi_test.c \
+ *       Src/stm32l_sdk/spi/spi.c Src/drivers/s2lp/s2lp_spi.c -o s2lp_spi_test
+ *   ./s2lp_spi_test
+ *
+ * The status bytes are returned in a bitfield structure with an enum
+ * member, -fshort-enums gives it the 2 bytes size of the ARM EABI.
+ * The exit code is not 0 when a check fails.
+ * ==========================================================
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <it_sdk/config.h>
+#include <it_sdk/wrappers.h>
+#include <drivers/s2lp/s2lp_spi.h>
+
+// ---------------------------------------------------------------
+// Simulated chip
+
+#define MAX_BYTES		300
+
+typedef struct {
+	uint8_t		mosi[MAX_BYTES];	// bytes sent during the last CS low period
+	uint16_t	len;
+	uint16_t	frames;				// CS low periods
+	uint32_t	halCalls;
+} bus_t;
+
+static struct {
+	uint8_t		regs[256];
+	uint8_t		mcState1;
+	uint8_t		mcState0;
+	bool		selected;
+	bool		irqMasked;
+	uint16_t	pos;				// byte position in the frame
+	bool		read;
+	uint8_t		addr;
+	bus_t		bus;
+} __chip;
+
+SPI_HandleTypeDef hspi1;
+static int __errors = 0;
+
+static uint8_t chipByte(uint8_t tx) {
+	uint8_t rx = 0;
+	if ( __chip.bus.len < MAX_BYTES ) __chip.bus.mosi[__chip.bus.len] = tx;
+	__chip.bus.len++;
+	switch ( __chip.pos ) {
+	case 0:
+		__chip.read = ( tx == READ_HEADER );
+		rx = __chip.mcState1;
+		break;
+	case 1:
+		__chip.addr = tx;
+		rx = __chip.mcState0;
+		break;
+	default:
+		if ( __chip.read ) rx = __chip.regs[__chip.addr];
+		else __chip.regs[__chip.addr] = tx;
+		__chip.addr++;
+		break;
+	}
+	__chip.pos++;
+	return rx;
+}
+
+static void chipHal() {
+	if ( !__chip.selected || !__chip.irqMasked ) {
+		printf("SPI transfer with CS high or GPIO3 unmasked\n");
+		__errors++;
+	}
+	__chip.bus.halCalls++;
+}
+
+HAL_StatusTypeDef HAL_SPI_Transmit(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size, uint32_t Timeout) {
+	(void)hspi; (void)Timeout;
+	chipHal();
+	for ( int i = 0 ; i < Size ; i++ ) chipByte(pData[i]);
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_SPI_Receive(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size, uint32_t Timeout) {
+	(void)hspi; (void)Timeout;
+	chipHal();
+	for ( int i = 0 ; i < Size ; i++ ) pData[i] = chipByte(pData[i]);
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_SPI_TransmitReceive(SPI_HandleTypeDef *hspi, uint8_t *pTxData, uint8_t *pRxData, uint16_t Size, uint32_t Timeout) {
+	(void)hspi; (void)Timeout;
+	chipHal();
+	for ( int i = 0 ; i < Size ; i++ ) pRxData[i] = chipByte(pTxData[i]);
+	return HAL_OK;
+}
+
+// CS framing
+void gpio_reset(uint8_t bank, uint16_t id) {
+	if ( bank != ITSDK_S2LP_CS_BANK || id != ITSDK_S2LP_CS_PIN ) return;
+	__chip.selected = true;
+	__chip.pos = 0;
+	__chip.bus.len = 0;
+	__chip.bus.frames++;
+}
+
+void gpio_set(uint8_t bank, uint16_t id) {
+	if ( bank != ITSDK_S2LP_CS_BANK || id != ITSDK_S2LP_CS_PIN ) return;
+	__chip.selected = false;
+}
+
+void gpio_interruptDisable(uint8_t bank, uint16_t id) {
+	if ( bank != ITSDK_S2LP_GPIO3_BANK || id != ITSDK_S2LP_GPIO3_PIN ) return;
+	__chip.irqMasked = true;
+}
+
+void gpio_interruptEnable(uint8_t bank, uint16_t id) {
+	if ( bank != ITSDK_S2LP_GPIO3_BANK || id != ITSDK_S2LP_GPIO3_PIN ) return;
+	if ( __chip.selected ) {
+		printf("GPIO3 unmasked with CS low\n");
+		__errors++;
+	}
+	__chip.irqMasked = false;
+}
+
+// ---------------------------------------------------------------
+// Stubs
+
+void gpio_interruptPriority(uint8_t bank, uint16_t id, uint8_t nPreemption, uint8_t nSubpriority) {
+	(void)bank; (void)id; (void)nPreemption; (void)nSubpriority;
+}
+void itsdk_delayMs(uint32_t ms) { (void)ms; }
+void itsdk_delayUs(uint32_t us) { (void)us; }
+void log_error(char *format, ...) { (void)format; }
+
+// ---------------------------------------------------------------
+// Reference, the previous implementation
+
+static S2LP_SPI_StatusBytes ref_accessRegisters(
+		ITSDK_SPI_HANDLER_TYPE * spi,
+		uint8_t  cRegAddress,
+        uint8_t  cNbBytes,
+        uint8_t* pcBuffer,
+		S2LP_ACCESS	 access
+) {
+  uint8_t v=0;
+  uint8_t r=0;
+  uint16_t status = 0x0000;
+  S2LP_SPI_StatusBytes *pStatus=(S2LP_SPI_StatusBytes *)&status;
+
+  gpio_interruptPriority(ITSDK_S2LP_GPIO3_BANK, ITSDK_S2LP_GPIO3_PIN, 4, 4);
+  gpio_interruptDisable(ITSDK_S2LP_GPIO3_BANK, ITSDK_S2LP_GPIO3_PIN);
+
+  s2lp_spi_setCsLow();
+  itsdk_delayMs(2);
+
+  v = (access==S2LP_READ_REGISTER)?READ_HEADER:WRITE_HEADER;
+  spi_readRegister(spi,(uint8_t *)&v,(uint8_t *)&(r),1);
+  status = r << 8;
+
+  v = cRegAddress;
+  spi_readRegister(spi,(uint8_t *)&v,(uint8_t *)&(r),1);
+  status+=r;
+
+  v=0xFF;
+  for (int index = 0; index < cNbBytes; index++) {
+	  if ( access==S2LP_READ_REGISTER ) {
+		  spi_readRegister(spi,(uint8_t *)&v,(uint8_t *)&(pcBuffer)[index],1);
+	  } else {
+		  spi_write_byte(spi,pcBuffer[index]);
+	  }
+  }
+
+  spi_wait4TransactionEnd(spi);
+  s2lp_spi_setCsHigh();
+
+  gpio_interruptPriority(ITSDK_S2LP_GPIO3_BANK, ITSDK_S2LP_GPIO3_PIN, 4, 4);
+  gpio_interruptEnable(ITSDK_S2LP_GPIO3_BANK, ITSDK_S2LP_GPIO3_PIN);
+
+  return *pStatus;
+}
+
+// ---------------------------------------------------------------
+// Checks
+
+static uint32_t __halNew = 0;
+static uint32_t __halRef = 0;
+
+static void compare(uint8_t addr, uint8_t len, bool read) {
+	uint8_t init[256], regsNew[256];
+	uint8_t bufNew[256], bufRef[256], data[256];
+	bus_t busNew;
+	S2LP_SPI_StatusBytes stNew, stRef;
+
+	for ( int i = 0 ; i < 256 ; i++ ) {
+		init[i] = rand();
+		data[i] = rand();
+	}
+	__chip.mcState1 = rand();
+	__chip.mcState0 = rand();
+
+	// Current implementation
+	memcpy(__chip.regs,init,256);
+	memcpy(bufNew,data,256);
+	bzero(&__chip.bus,sizeof(bus_t));
+	if ( read ) stNew = s2lp_spi_readRegisters(&hspi1,addr,len,bufNew);
+	else stNew = s2lp_spi_writeRegisters(&hspi1,addr,len,bufNew);
+	busNew = __chip.bus;
+	memcpy(regsNew,__chip.regs,256);
+
+	// Previous implementation
+	memcpy(__chip.regs,init,256);
+	memcpy(bufRef,data,256);
+	bzero(&__chip.bus,sizeof(bus_t));
+	stRef = ref_accessRegisters(&hspi1,addr,len,bufRef,(read)?S2LP_READ_REGISTER:S2LP_WRITE_REGISTER);
+
+	__halNew += busNew.halCalls;
+	__halRef += __chip.bus.halCalls;
+
+	int err = 0;
+	if ( busNew.frames != 1 || busNew.len != __chip.bus.len || memcmp(busNew.mosi,__chip.bus.mosi,busNew.len) != 0 ) err |= 1;
+	if ( memcmp(bufNew,bufRef,256) != 0 ) err |= 2;
+	if ( memcmp(regsNew,__chip.regs,256) != 0 ) err |= 4;
+	if ( memcmp(&stNew,&stRef,sizeof(S2LP_SPI_StatusBytes)) != 0 ) err |= 8;
+	if ( busNew.halCalls != ( len + 2 + S2LP_SPI_BURST_SZ - 1 ) / S2LP_SPI_BURST_SZ ) err |= 16;
+	if ( __chip.selected || __chip.irqMasked ) err |= 32;
+	if ( err != 0 ) {
+		printf("%s 0x%02X %3dB : %s%s%s%s%s%s\n",(read)?"read ":"write",addr,len,
+				(err & 1)?"bus bytes differ ":"",
+				(err & 2)?"buffer differs ":"",
+				(err & 4)?"registers differ ":"",
+				(err & 8)?"status differs ":"",
+				(err & 16)?"HAL calls ":"",
+				(err & 32)?"CS low or GPIO3 masked after access":"");
+		__errors++;
+	}
+}
+
+int main(void) {
+	srand(1234);
+	if ( sizeof(S2LP_SPI_StatusBytes) != 2 ) {
+		printf("S2LP_SPI_StatusBytes is not 2 bytes, build with -fshort-enums\n");
+		return 1;
+	}
+
+	// All the sizes, burst limits included, then random accesses
+	for ( int len = 0 ; len < 256 ; len++ ) {
+		compare(0x00,len,true);
+		compare(0x00,len,false);
+	}
+	for ( int i = 0 ; i < 20000 ; i++ ) {
+		compare(rand(),rand(),( rand() & 1 ) != 0);
+	}
+	printf("HAL calls %u, previous %u\n",__halNew,__halRef);
+
+	printf("errors %d\n",__errors);
+	if ( __errors > 0 ) {
+		printf("FAILED\n");
+		return 1;
+	}
+	printf("PASSED\n");
+	return 0;
+}
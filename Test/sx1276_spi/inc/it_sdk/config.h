@@ -0,0 +1,29 @@
+/* Host test configuration for the SX1276 SPI access */
+#ifndef TEST_IT_SDK_CONFIG_H_
+#define TEST_IT_SDK_CONFIG_H_
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <it_sdk/config_defines.h>
+#include "hal_stub.h"
+
+#define __weak							__attribute__((weak))
+
+#define ITSDK_WITH_LORAWAN_LIB			__ENABLE
+#define ITSDK_LORAWAN_LIB				__LORAWAN_SX1276
+#define ITSDK_WITH_SIGFOX_LIB			__DISABLE
+#define ITSDK_LOGGER_MODULE				0
+
+#define ITSDK_WITH_SPI					__SPI_ENABLED
+#define ITSDK_SPI_HANDLER_TYPE			SPI_HandleTypeDef
+#define ITSDK_SPI_TIMEOUT				100
+
+#define ITSDK_SX1276_SPI				hspi1
+#define ITSDK_SX1276_NSS_BANK			__BANK_A
+#define ITSDK_SX1276_NSS_PIN			__LP_GPIO_15
+#define ITSDK_SX1276_RESET_BANK			__BANK_C
+#define ITSDK_SX1276_RESET_PIN			__LP_GPIO_0
+#define ITSDK_SX1276_DEFERRED_IRQ		__DISABLE
+#define ITSDK_MURATA_WAKEUP_TIME		63
+
+#endif
@@ -0,0 +1,370 @@
+/* ==========================================================
+ * sx1276_spi_test.c - Host check of the SX1276 SPI accesses
+ * Project : Disk91 SDK
+ * ----------------------------------------------------------
+ * Created on: 18 oct. 2020
+ *     Author: Paul Pinault aka Disk91
+ * ----------------------------------------------------------
+ * Copyright (C) 2020 Disk91
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU LESSER General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ * ----------------------------------------------------------
+ * Runs the unmodified sx1276.c and spi.c against a simulated chip
+ * behind the HAL SPI functions. The chip decodes the byte stream
+ * (address byte, auto-increment, FIFO) framed by NSS and logs each
+ * frame. The test checks:
+ *  - the spi_getStats() transaction and byte counters against the
+ *    HAL calls seen by the chip, for every access type
+ *  - the register shadow: cached reads and unchanged writes don't
+ *    reach the chip, status registers always do, the shadow is
+ *    cleared on modem change and never differs from the chip
+ *  - the burst writes: a register block is sent in one frame limited
+ *    to the span of registers changing (channel, modem config)
+ *
+ * Build & run from the repository root:
+ *   gcc -O2 -ITest/sx1276_spi/inc -IInc Test/sx1276_spi/sx1276_spi_test.c \
+ *       Src/stm32l_sdk/spi/spi.c Src/drivers/sx1276/sx1276.c Src/drivers/lorawan/utilities.c \
+ *       -lm -o sx1276_spi_test
+ *   ./sx1276_spi_test
+ *
+ * The exit code is not 0 when a check fails.
+ * ==========================================================
+ */
+#include <stdio.h>
+#include <string.h>
+#include <it_sdk/config.h>
+#include <it_sdk/wrappers.h>
+#include <drivers/sx1276/sx1276.h>
+#include <drivers/lorawan/timeServer.h>
+
+// sx1276.c internal accesses
+void SX1276WriteFifo( uint8_t *buffer, uint8_t size );
+void SX1276ReadFifo( uint8_t *buffer, uint8_t size );
+
+// ---------------------------------------------------------------
+// Simulated chip
+
+#define MAX_FRAMES		64
+
+typedef struct {
+	uint8_t		addr;				// first register accessed
+	bool		write;
+	uint16_t	len;				// data bytes, address excluded
+	uint16_t	halCalls;
+} frame_t;
+
+static struct {
+	uint8_t		regs[128];
+	uint8_t		fifo[256];
+	uint8_t		fifoPtr;
+	bool		selected;
+	bool		hasAddr;
+	uint8_t		addr;
+	bool		write;
+	uint32_t	halCalls;			// all the HAL transactions
+	uint32_t	halBytes;
+	frame_t		cur;
+	frame_t		frames[MAX_FRAMES];
+	int			nFrames;
+} __chip;
+
+SPI_HandleTypeDef hspi1;
+static int __errors = 0;
+
+static void chipByte(uint8_t tx, uint8_t * rx) {
+	if ( !__chip.hasAddr ) {
+		__chip.hasAddr = true;
+		__chip.addr = tx & 0x7F;
+		__chip.write = ( (tx & 0x80) != 0 );
+		__chip.cur.addr = __chip.addr;
+		__chip.cur.write = __chip.write;
+		if ( rx != NULL ) *rx = 0;
+		return;
+	}
+	__chip.cur.len++;
+	if ( __chip.addr == REG_FIFO ) {
+		if ( __chip.write ) __chip.fifo[__chip.fifoPtr++] = tx;
+		else if ( rx != NULL ) *rx = __chip.fifo[__chip.fifoPtr++];
+		return;
+	}
+	if ( __chip.write ) __chip.regs[__chip.addr] = tx;
+	else if ( rx != NULL ) *rx = __chip.regs[__chip.addr];
+	__chip.addr = ( __chip.addr + 1 ) & 0x7F;
+}
+
+static void chipHal(uint16_t size) {
+	if ( !__chip.selected ) {
+		printf("SPI transfer with NSS high\n");
+		__errors++;
+	}
+	__chip.halCalls++;
+	__chip.halBytes += size;
+	__chip.cur.halCalls++;
+}
+
+HAL_StatusTypeDef HAL_SPI_Transmit(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size, uint32_t Timeout) {
+	(void)hspi; (void)Timeout;
+	chipHal(Size);
+	for ( int i = 0 ; i < Size ; i++ ) chipByte(pData[i],NULL);
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_SPI_Receive(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size, uint32_t Timeout) {
+	(void)hspi; (void)Timeout;
+	chipHal(Size);
+	for ( int i = 0 ; i < Size ; i++ ) chipByte(pData[i],&pData[i]);
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_SPI_TransmitReceive(SPI_HandleTypeDef *hspi, uint8_t *pTxData, uint8_t *pRxData, uint16_t Size, uint32_t Timeout) {
+	(void)hspi; (void)Timeout;
+	chipHal(Size);
+	for ( int i = 0 ; i < Size ; i++ ) chipByte(pTxData[i],&pRxData[i]);
+	return HAL_OK;
+}
+
+// NSS framing
+void gpio_reset(uint8_t bank, uint16_t id) {
+	if ( bank != ITSDK_SX1276_NSS_BANK || id != ITSDK_SX1276_NSS_PIN ) return;
+	__chip.selected = true;
+	__chip.hasAddr = false;
+	bzero(&__chip.cur,sizeof(frame_t));
+}
+
+void gpio_set(uint8_t bank, uint16_t id) {
+	if ( bank != ITSDK_SX1276_NSS_BANK || id != ITSDK_SX1276_NSS_PIN || !__chip.selected ) return;
+	__chip.selected = false;
+	if ( __chip.nFrames < MAX_FRAMES ) __chip.frames[__chip.nFrames] = __chip.cur;
+	__chip.nFrames++;
+}
+
+static void chipClearLog() {
+	__chip.nFrames = 0;
+	__chip.halCalls = 0;
+	__chip.halBytes = 0;
+	spi_resetStats();
+}
+
+// ---------------------------------------------------------------
+// Stubs
+
+void gpio_configure(uint8_t bank, uint16_t id, itsdk_gpio_type_t type ) { (void)bank; (void)id; (void)type; }
+void itsdk_delayMs(uint32_t ms) { (void)ms; }
+void itsdk_random_addEntropy(uint32_t value, uint8_t bits) { (void)value; (void)bits; }
+uint32_t itsdk_random_getU32() { return 4; }
+int32_t itsdk_random_getRange(int32_t min, int32_t max) { (void)max; return min; }
+void TimerInit( TimerEvent_t *obj, void ( *callback )( void *context ) ) { (void)obj; (void)callback; }
+void TimerStart( TimerEvent_t *obj ) { (void)obj; }
+void TimerStop( TimerEvent_t *obj ) { (void)obj; }
+void TimerSetValue( TimerEvent_t *obj, uint32_t value ) { (void)obj; (void)value; }
+TimerTime_t TimerGetCurrentTime( void ) { return 0; }
+TimerTime_t TimerGetElapsedTime( TimerTime_t savedTime ) { (void)savedTime; return 0; }
+
+static void boardSetXO( uint8_t state ) { (void)state; }
+static uint32_t boardGetWakeTime( void ) { return 0; }
+static void boardIoIrqInit( DioIrqHandler **irqHandlers ) { (void)irqHandlers; }
+static void boardSetRfTxPower( int8_t power ) { (void)power; }
+static void boardSetAntSwLowPower( bool status ) { (void)status; }
+static void boardSetAntSw( uint8_t opMode ) { (void)opMode; }
+
+static LoRaBoardCallback_t __board = {
+	.SX1276BoardSetXO = boardSetXO,
+	.SX1276BoardGetWakeTime = boardGetWakeTime,
+	.SX1276BoardIoIrqInit = boardIoIrqInit,
+	.SX1276BoardSetRfTxPower = boardSetRfTxPower,
+	.SX1276BoardSetAntSwLowPower = boardSetAntSwLowPower,
+	.SX1276BoardSetAntSw = boardSetAntSw,
+};
+
+// ---------------------------------------------------------------
+// Checks
+
+#define CHECK(name,v,e)	{															\
+		int32_t _v = (v), _e = (e);													\
+		if ( _v != _e ) {															\
+			printf("%-40s : %d expected %d\n",name,_v,_e);							\
+			__errors++;																\
+		}																			\
+	}
+
+// The SPI counters must match the HAL calls seen by the chip
+static void checkCounters(const char * name, uint32_t transactions, uint32_t bytes) {
+	uint32_t tr, by;
+	spi_getStats(&tr,&by);
+	if ( tr != __chip.halCalls || by != __chip.halBytes || tr != transactions || by != bytes ) {
+		printf("%-40s : counters %u / %uB, chip %u / %uB, expected %u / %uB\n",name,tr,by,__chip.halCalls,__chip.halBytes,transactions,bytes);
+		__errors++;
+	}
+}
+
+static void checkFrame(const char * name, int i, uint8_t addr, bool write, uint16_t len) {
+	if ( i >= __chip.nFrames || __chip.frames[i].addr != addr || __chip.frames[i].write != write || __chip.frames[i].len != len ) {
+		printf("%-40s : frame %d is not %s 0x%02X %dB\n",name,i,(write)?"write":"read",addr,len);
+		__errors++;
+	}
+}
+
+// Every register read through the driver (shadow or chip) equals the chip
+static void checkShadowCoherent(const char * name) {
+	for ( uint8_t a = 1 ; a < 0x50 ; a++ ) {
+		if ( SX1276Read(a) != __chip.regs[a] ) {
+			printf("%-40s : register 0x%02X differs from the chip\n",name,a);
+			__errors++;
+		}
+	}
+}
+
+static void testAccesses() {
+	uint8_t b[64];
+
+	// Single register write, one transfer address + data
+	chipClearLog();
+	SX1276Write(REG_LR_IRQFLAGS,0xFF);
+	checkCounters("write 1 register",1,2);
+	checkFrame("write 1 register",0,REG_LR_IRQFLAGS,true,1);
+
+	// FIFO write, address then data in two transfers of the same frame
+	for ( int i = 0 ; i < 40 ; i++ ) b[i] = i;
+	chipClearLog();
+	__chip.fifoPtr = 0;
+	SX1276WriteFifo(b,40);
+	checkCounters("write fifo 40B",2,41);
+	checkFrame("write fifo 40B",0,REG_FIFO,true,40);
+	CHECK("write fifo 40B content",memcmp(__chip.fifo,b,40),0);
+
+	// FIFO read
+	chipClearLog();
+	__chip.fifoPtr = 0;
+	bzero(b,sizeof(b));
+	SX1276ReadFifo(b,40);
+	checkCounters("read fifo 40B",2,41);
+	checkFrame("read fifo 40B",0,REG_FIFO,false,40);
+	CHECK("read fifo 40B content",b[39],39);
+
+	// Status registers are never cached
+	chipClearLog();
+	__chip.regs[REG_LR_IRQFLAGS] = 0x48;
+	CHECK("read irq flags",SX1276Read(REG_LR_IRQFLAGS),0x48);
+	__chip.regs[REG_LR_IRQFLAGS] = 0x40;
+	CHECK("read irq flags again",SX1276Read(REG_LR_IRQFLAGS),0x40);
+	checkCounters("read irq flags twice",4,4);
+	CHECK("read irq flags frames",__chip.nFrames,2);
+}
+
+static void testShadow() {
+	// LoRa registers are cached
+	chipClearLog();
+	SX1276Write(REG_LR_SYNCWORD,0x34);
+	CHECK("syncword write frames",__chip.nFrames,1);
+	CHECK("syncword read",SX1276Read(REG_LR_SYNCWORD),0x34);
+	SX1276Write(REG_LR_SYNCWORD,0x34);
+	CHECK("syncword cached read / same write",__chip.nFrames,1);
+	checkCounters("syncword",1,2);
+
+	// Chip changed out of the driver, after invalidation the modem is
+	// known again from RegOpMode and a read fills the shadow
+	SX1276ShadowInvalidate();
+	chipClearLog();
+	__chip.regs[REG_LR_PREAMBLELSB] = 0x0A;
+	SX1276Read(REG_OPMODE);
+	CHECK("preamble read",SX1276Read(REG_LR_PREAMBLELSB),0x0A);
+	CHECK("preamble read again",SX1276Read(REG_LR_PREAMBLELSB),0x0A);
+	CHECK("preamble frames",__chip.nFrames,2);
+	checkShadowCoherent("shadow after invalidation");
+
+	// Modem change, the LoRa values are not valid in FSK
+	chipClearLog();
+	SX1276SetModem(MODEM_FSK);
+	int n = __chip.nFrames;
+	__chip.regs[REG_LR_SYNCWORD] = 0x91;
+	CHECK("FSK register after modem change",SX1276Read(REG_LR_SYNCWORD),0x91);
+	CHECK("FSK register read reaches the chip",__chip.nFrames,n+1);
+	SX1276SetModem(MODEM_LORA);
+	checkShadowCoherent("shadow after modem changes");
+}
+
+static void testBursts() {
+	// Channel, FRF MSB..LSB in one frame then only the registers changing
+	chipClearLog();
+	SX1276SetChannel(868100000);
+	CHECK("channel frames",__chip.nFrames,1);
+	checkFrame("channel",0,REG_FRFMSB,true,3);
+	checkCounters("channel",1,4);
+	chipClearLog();
+	SX1276SetChannel(868300000);
+	CHECK("channel change frames",__chip.nFrames,1);
+	checkFrame("channel change, MSB unchanged",0,REG_FRFMID,true,2);
+	chipClearLog();
+	SX1276SetChannel(868300000);
+	CHECK("same channel frames",__chip.nFrames,0);
+
+	// LoRa RX config, the second identical call only touches uncached registers
+	chipClearLog();
+	SX1276SetRxConfig(MODEM_LORA,0,7,1,0,8,5,false,0,true,false,0,false,false);
+	uint32_t tr1, by1;
+	spi_getStats(&tr1,&by1);
+	chipClearLog();
+	SX1276SetRxConfig(MODEM_LORA,0,7,1,0,8,5,false,0,true,false,0,false,false);
+	uint32_t tr2, by2;
+	spi_getStats(&tr2,&by2);
+	if ( tr2 >= tr1 || by2 >= by1 ) {
+		printf("%-40s : %u / %uB then %u / %uB\n","rx config repeated",tr1,by1,tr2,by2);
+		__errors++;
+	}
+	for ( int i = 0 ; i < __chip.nFrames && i < MAX_FRAMES ; i++ ) {
+		if ( __chip.frames[i].write && __chip.frames[i].addr >= REG_LR_MODEMCONFIG1 && __chip.frames[i].addr <= REG_LR_PAYLOADLENGTH ) {
+			printf("%-40s : modem config written again\n","rx config repeated");
+			__errors++;
+		}
+	}
+
+	// SF change, the modem config burst is limited to ModemConfig2
+	chipClearLog();
+	SX1276SetRxConfig(MODEM_LORA,0,9,1,0,8,5,false,0,true,false,0,false,false);
+	bool found = false;
+	for ( int i = 0 ; i < __chip.nFrames && i < MAX_FRAMES ; i++ ) {
+		frame_t * f = &__chip.frames[i];
+		if ( f->write && f->addr >= REG_LR_MODEMCONFIG1 && f->addr <= REG_LR_PAYLOADLENGTH ) {
+			if ( f->addr != REG_LR_MODEMCONFIG2 || f->len != 1 || f->halCalls != 1 ) {
+				printf("%-40s : burst 0x%02X %dB in %d transfers\n","rx config SF change",f->addr,f->len,f->halCalls);
+				__errors++;
+			}
+			found = true;
+		}
+	}
+	CHECK("rx config SF change written",found,true);
+	CHECK("rx config SF in the chip",__chip.regs[REG_LR_MODEMCONFIG2] >> 4,9);
+	checkShadowCoherent("shadow after configurations");
+}
+
+int main(void) {
+	static RadioEvents_t events;
+
+	SX1276BoardInit(&__board);
+	SX1276Init(&events);
+	SX1276SetModem(MODEM_LORA);
+	checkShadowCoherent("shadow after init");
+
+	testAccesses();
+	testShadow();
+	testBursts();
+
+	printf("errors %d\n",__errors);
+	if ( __errors > 0 ) {
+		printf("FAILED\n");
+		return 1;
+	}
+	printf("PASSED\n");
+	return 0;
+}
@@ -0,0 +1,16 @@
+/* Host test configuration for the time service */
+#ifndef TEST_IT_SDK_CONFIG_H_
+#define TEST_IT_SDK_CONFIG_H_
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <it_sdk/config_defines.h>
+
+#define __weak							__attribute__((weak))
+
+#define ITSDK_PLATFORM					__PLATFORM_STM32L0
+#define ITSDK_WITH_RTC					__RTC_NONE
+#define ITSDK_CLK_CORRECTION			0
+#define ITSDK_GPS_LEAP_SECONDS			18
+
+#endif
@@ -0,0 +1,4 @@
+/* Host test stub, no RTC */
+#ifndef TEST_STM32L_SDK_RTC_H_
+#define TEST_STM32L_SDK_RTC_H_
+#endif
@@ -0,0 +1,5 @@
+/* Host test stub */
+#ifndef TEST_STM32L_SDK_TIME_H_
+#define TEST_STM32L_SDK_TIME_H_
+void systick_adjustTime();
+#endif
@@ -0,0 +1,100 @@
+/* ==========================================================
+ * time_test.c - Host check of the GPS to EPOC time conversion
+ * Project : Disk91 SDK
+ * ----------------------------------------------------------
+ * Created on: 18 oct. 2020
+ *     Author: Paul Pinault aka Disk91
+ * ----------------------------------------------------------
+ * Copyright (C) 2020 Disk91
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU LESSER General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ * ----------------------------------------------------------
+ * Checks itsdk_time_gps2Epoc_s() against UTC dates computed from
+ * the calendar, then replays a LoRaWan DeviceTimeAns the way the
+ * driver does: the MAC adds UNIX_GPS_EPOCH_OFFSET to the GPS time,
+ * the EPOC and UTC time synced from it must not be ahead of UTC by
+ * the leap seconds.
+ *
+ * Build & run from the repository root:
+ *   gcc -O2 -ITest/time/inc -IInc Test/time/time_test.c Src/it_sdk/time/time.c -o time_test
+ *   ./time_test
+ *
+ * The exit code is not 0 when a check fails.
+ * ==========================================================
+ */
+#include <stdio.h>
+#include <it_sdk/itsdk.h>
+#include <it_sdk/time/time.h>
+#include <drivers/lorawan/systime.h>
+
+// ---------------------------------------------------------------
+// Stubs
+
+void systick_adjustTime() {
+}
+
+// ---------------------------------------------------------------
+
+static int __errors = 0;
+
+#define CHECK(name,v,e)	{															\
+		uint32_t _v = (v), _e = (e);												\
+		if ( _v != _e ) {															\
+			printf("%-28s : %u expected %u\n",name,_v,_e);							\
+			__errors++;																\
+		}																			\
+	}
+
+// Days since 01/01/1970 of a calendar date, independent from the SDK
+static uint32_t days(int y, int m, int d) {
+	static const int cumul[12] = { 0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334 };
+	uint32_t n = 0;
+	for ( int i = 1970 ; i < y ; i++ ) n += ( (i % 4 == 0 && i % 100 != 0) || i % 400 == 0 )?366:365;
+	n += cumul[m-1] + d - 1;
+	if ( m > 2 && ( (y % 4 == 0 && y % 100 != 0) || y % 400 == 0 ) ) n++;
+	return n;
+}
+
+// GPS time of an UTC date, the GPS time is ahead by the leap seconds
+static uint32_t gpsOf(int y, int m, int d, uint32_t s) {
+	return (days(y,m,d) - days(1980,1,6))*86400 + s + ITSDK_GPS_LEAP_SECONDS;
+}
+
+int main(void) {
+
+	// Conversion
+	CHECK("2020-10-18 00:00:00",itsdk_time_gps2Epoc_s(gpsOf(2020,10,18,0)),1602979200);
+	CHECK("2021-03-17 07:06:22",itsdk_time_gps2Epoc_s(1300000000),days(2021,3,17)*86400+7*3600+6*60+22);
+	CHECK("2024-02-29 23:59:59",itsdk_time_gps2Epoc_s(gpsOf(2024,2,29,86399)),days(2024,2,29)*86400+86399);
+
+	// DeviceTimeAns, the MAC system time is the GPS time + UNIX_GPS_EPOCH_OFFSET
+	uint32_t gps = gpsOf(2020,10,18,12*3600+34*60+56);
+	uint32_t sysTime = gps + UNIX_GPS_EPOCH_OFFSET;
+	itsdk_time_set_ms(5000);
+	uint32_t epoc = itsdk_time_gps2Epoc_s(sysTime - UNIX_GPS_EPOCH_OFFSET);
+	itsdk_time_sync_EPOC_ms(epoc, 250);
+	itsdk_time_sync_UTC_ms(epoc % (24*3600), 250);
+	itsdk_time_add_us(10750000);
+	CHECK("EPOC after sync + 10.75s",itsdk_time_get_EPOC_s(),days(2020,10,18)*86400+12*3600+34*60+56+11);
+	CHECK("UTC after sync + 10.75s",itsdk_time_get_UTC_s(),12*3600+34*60+56+11);
+	CHECK("UTC seconds",itsdk_time_get_UTC_sec(),7);
+
+	printf("errors %d\n",__errors);
+	if ( __errors > 0 ) {
+		printf("FAILED\n");
+		return 1;
+	}
+	printf("PASSED\n");
+	return 0;
+}
@@ -0,0 +1,10 @@
+/* Host benchmark configuration for the conversion helpers */
+#ifndef TEST_IT_SDK_CONFIG_H_
+#define TEST_IT_SDK_CONFIG_H_
+#include <stdint.h>
+#include <stdbool.h>
+#include <it_sdk/config_defines.h>
+
+#define __weak							__attribute__((weak))
+
+#endif
@@ -0,0 +1,228 @@
+/* ==========================================================
+ * tool_bench.c - Host check & benchmark of the conversion helpers
+ * Project : Disk91 SDK
+ * ----------------------------------------------------------
+ * Created on: 18 oct. 2020
+ *     Author: Paul Pinault aka Disk91
+ * ----------------------------------------------------------
+ * Copyright (C) 2020 Disk91
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU LESSER General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Lesser Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ * ----------------------------------------------------------
+ * Compares the table driven itdt_convert* helpers of tool.c with
+ * the previous char by char implementation (ref_* below) on random
+ * buffers and strings, valid or not, then reports the time per
+ * byte of both for the hex encoding, the check + decoding and the
+ * decimal parsing.
+ *
+ * Build & run from the repository root:
+ *   gcc -O2 -fno-tree-vectorize -ITest/tool/inc -IInc Test/tool/tool_bench.c Src/it_sdk/tool.c -o tool_bench
+ *   ./tool_bench [rounds]
+ *
+ * The STM32L0 has no SIMD, -fno-tree-vectorize keeps the compiler
+ * from vectorizing the arithmetic encoder of the reference on x86.
+ * The exit code is not 0 when a result differs from the reference.
+ *
+ * ==========================================================
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <it_sdk/itsdk.h>
+
+// ---------------------------------------------------------------
+// Stubs
+
+uint32_t itsdk_random_getU32() {
+	return (uint32_t)rand();
+}
+
+// ---------------------------------------------------------------
+// Reference, the previous implementation
+
+static char ref_halfInt2HexChar(uint8_t v, itsdk_bool_e upper) {
+	if ( v < 10 ) return '0'+v;
+	if ( v < 16 ) return (( upper == BOOL_TRUE )?'A':'a')+(v-10);
+	return 0;
+}
+
+static uint8_t ref_hexChar2HalfInt(char c) {
+	if ( c >= '0' && c <= '9' ) return c-'0';
+	if ( c >= 'a' && c <= 'f' ) return 10+c-'a';
+	if ( c >= 'A' && c <= 'F' ) return 10+c-'A';
+	return 0;
+}
+
+__attribute__((noinline)) static void ref_intTab2Hex(char * dest, uint8_t * tab, int len, itsdk_bool_e upper) {
+	for ( int i = 0 ; i < len ; i++ ) {
+		dest[2*i] = ref_halfInt2HexChar(tab[i] >> 4,upper);
+		dest[2*i+1] = ref_halfInt2HexChar(tab[i] & 0x0F,upper);
+	}
+	dest[2*len] = '\0';
+}
+
+__attribute__((noinline)) static bool ref_isHexString(char * str, int n, itsdk_bool_e upper) {
+	int i = 0;
+	while ( i < n && str[i] != 0 ) {
+		if (    (str[i] >= '0' && str[i] <= '9' )
+			 || (str[i] >= 'A' && str[i] <= 'F' )
+			 || (upper != BOOL_TRUE && str[i] >= 'a' && str[i] <= 'f')
+		) {
+			i++;
+		} else {
+			return false;
+		}
+	}
+	return ( i == n );
+}
+
+__attribute__((noinline)) static void ref_hexStr2IntTab(char * hexstr, uint8_t * tab, int len) {
+	for ( int i = 0 ; i < len ; i++ ) {
+		tab[i] = (ref_hexChar2HalfInt(hexstr[2*i]) << 4) + ref_hexChar2HalfInt(hexstr[2*i+1]);
+	}
+}
+
+__attribute__((noinline)) static int32_t ref_decCharNInt(char * v, int sz) {
+	int32_t sign = 1;
+	if ( *v == '-' ) {
+		sign = -1;
+		v++;
+		sz--;
+	}
+	int32_t ret = 0;
+	for ( int i = 0 ; i < sz ; i++ ) {
+		if ( v[i] < '0' || v[i] > '9' ) return ITSDK_INVALID_VALUE_32B;
+		ret = ret*10 + (v[i] - '0');
+	}
+	return ret * sign;
+}
+
+// ---------------------------------------------------------------
+
+#define BUFSZ		256
+
+static int __errors = 0;
+static volatile uint32_t __sink;
+
+static double nowNs() {
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC,&t);
+	return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+static void randomHex(char * s, int n, bool lower) {
+	const char * u = "0123456789ABCDEF";
+	const char * l = "0123456789abcdef";
+	for ( int i = 0 ; i < n ; i++ ) s[i] = ( lower && (rand() & 1) )?l[rand() & 15]:u[rand() & 15];
+	s[n] = '\0';
+}
+
+static void checkConversions(int runs) {
+	uint8_t tab[BUFSZ], out[BUFSZ], ref[BUFSZ];
+	char s1[2*BUFSZ+1], s2[2*BUFSZ+1];
+
+	for ( int r = 0 ; r < runs ; r++ ) {
+		int len = 1 + rand() % BUFSZ;
+		for ( int i = 0 ; i < len ; i++ ) tab[i] = rand();
+
+		// Encoding
+		for ( int u = 0 ; u < 2 ; u++ ) {
+			itdt_convertIntTab2Hex(s1,tab,len,(u)?BOOL_TRUE:BOOL_FALSE);
+			ref_intTab2Hex(s2,tab,len,(u)?BOOL_TRUE:BOOL_FALSE);
+			if ( strcmp(s1,s2) != 0 ) __errors++;
+		}
+
+		// Valid strings, mixed case
+		randomHex(s1,2*len,true);
+		bool hasLower = false;
+		for ( int i = 0 ; i < 2*len ; i++ ) if ( s1[i] >= 'a' ) hasLower = true;
+		ref_hexStr2IntTab(s1,ref,len);
+		itdt_convertHexStr2IntTab(s1,out,len);
+		if ( memcmp(out,ref,len) != 0 ) __errors++;
+		if ( !itdt_convertHexStr2IntTabChk(s1,out,len,BOOL_FALSE) || memcmp(out,ref,len) != 0 ) __errors++;
+		if ( itdt_convertHexStr2IntTabChk(s1,out,len,BOOL_TRUE) == hasLower ) __errors++;
+		if ( itdt_isHexString(s1,2*len,BOOL_FALSE) != ref_isHexString(s1,2*len,BOOL_FALSE) ) __errors++;
+		if ( itdt_isHexString(s1,2*len,BOOL_TRUE) != ref_isHexString(s1,2*len,BOOL_TRUE) ) __errors++;
+
+		// One invalid char
+		int p = rand() % (2*len);
+		const char bad[] = { 'g', 'G', 'z', ' ', '/', ':', '@', '`', (char)0x80, (char)0xC1 };
+		s1[p] = bad[rand() % sizeof(bad)];
+		if ( itdt_convertHexStr2IntTabChk(s1,out,len,BOOL_FALSE) ) __errors++;
+		if ( itdt_isHexString(s1,2*len,BOOL_FALSE) != ref_isHexString(s1,2*len,BOOL_FALSE) ) __errors++;
+
+		// Decimal, signed, up to 7 digits
+		char d[10];
+		int n = 1 + rand() % 7;
+		int o = 0;
+		if ( rand() & 1 ) d[o++] = '-';
+		for ( int i = 0 ; i < n ; i++ ) d[o++] = '0' + rand() % 10;
+		if ( (rand() & 7) == 0 ) d[rand() % o] = 'x';
+		if ( itdt_convertDecCharNInt(d,o) != ref_decCharNInt(d,o) ) __errors++;
+	}
+	if ( itdt_convertDecCharNInt("-123",4) != -123 ) __errors++;
+	if ( itdt_convertHexChar8Int("DEADbeef") != 0xDEADBEEF ) __errors++;
+	if ( itdt_convertHexChar4Int("0a1F") != 0x0A1F ) __errors++;
+	if ( itdt_convertHalfInt2HexChar(11,BOOL_FALSE) != 'b' ) __errors++;
+}
+
+// Best of 5 runs, the host scheduler only adds time
+#define TIME_BEST(res,loop)	{															\
+	res = 1e30;																			\
+	for ( int k = 0 ; k < 5 ; k++ ) {													\
+		double t0 = nowNs();															\
+		loop;																			\
+		double dt = nowNs() - t0;														\
+		if ( dt < res ) res = dt;														\
+	}																					\
+}
+
+static void bench(int rounds) {
+	uint8_t tab[BUFSZ], out[BUFSZ];
+	char s[2*BUFSZ+1];
+	char d[] = "-1234567";
+	double tNew, tRef;
+	double bytes = (double)rounds * BUFSZ;
+
+	for ( int i = 0 ; i < BUFSZ ; i++ ) tab[i] = rand();
+
+	TIME_BEST(tNew,for ( int r = 0 ; r < rounds ; r++ ) { itdt_convertIntTab2Hex(s,tab,BUFSZ,BOOL_TRUE); __sink += s[r % BUFSZ]; });
+	TIME_BEST(tRef,for ( int r = 0 ; r < rounds ; r++ ) { ref_intTab2Hex(s,tab,BUFSZ,BOOL_TRUE); __sink += s[r % BUFSZ]; });
+	printf("encode         : %5.2f ns/B, previous %5.2f ns/B\n",tNew/bytes,tRef/bytes);
+
+	TIME_BEST(tNew,for ( int r = 0 ; r < rounds ; r++ ) { __sink += itdt_convertHexStr2IntTabChk(s,out,BUFSZ,BOOL_TRUE); __sink += out[r % BUFSZ]; });
+	TIME_BEST(tRef,for ( int r = 0 ; r < rounds ; r++ ) { if ( ref_isHexString(s,2*BUFSZ,BOOL_TRUE) ) ref_hexStr2IntTab(s,out,BUFSZ); __sink += out[r % BUFSZ]; });
+	printf("check + decode : %5.2f ns/B, previous %5.2f ns/B\n",tNew/bytes,tRef/bytes);
+
+	TIME_BEST(tNew,for ( int r = 0 ; r < rounds * 32 ; r++ ) { d[7] = '0' + (r % 10); __sink += itdt_convertDecCharNInt(d,8); });
+	TIME_BEST(tRef,for ( int r = 0 ; r < rounds * 32 ; r++ ) { d[7] = '0' + (r % 10); __sink += ref_decCharNInt(d,8); });
+	printf("decimal 8 chars: %5.2f ns/B, previous %5.2f ns/B\n",tNew/(rounds*32.0*8),tRef/(rounds*32.0*8));
+}
+
+int main(int argc, char ** argv) {
+	int rounds = ( argc > 1 )?atoi(argv[1]):50000;
+	srand(1234);
+
+	checkConversions(100000);
+	bench(rounds);
+
+	printf("errors %d\n",__errors);
+	if ( __errors > 0 ) {
+		printf("FAILED\n");
+		return 1;
+	}
+	printf("PASSED\n");
+	return 0;
+}